@@ -27,6 +27,13 @@
 #include <chrono>
 #include <vector>
 #include <string>
+#include <cstdlib>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <new>
+#include <unordered_map>
 #include "../include/dict/dict.h"
 
 // If nlohmann/json is available, uncomment to compare
@@ -36,6 +43,39 @@ using json = nlohmann::json;
 
 using namespace std::chrono;
 
+// Heap accounting: every operator new in this binary is counted so that
+// benchmarks can report allocations and bytes, not only time
+static size_t g_alloc_count = 0;
+static size_t g_alloc_bytes = 0;
+
+void* operator new(std::size_t n) {
+    g_alloc_count++;
+    g_alloc_bytes += n;
+    void* p = std::malloc(n ? n : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+class AllocCounter {
+private:
+    size_t start_count;
+    size_t start_bytes;
+    
+public:
+    AllocCounter() : start_count(g_alloc_count), start_bytes(g_alloc_bytes) {}
+    
+    size_t count() const { return g_alloc_count - start_count; }
+    size_t bytes() const { return g_alloc_bytes - start_bytes; }
+};
+
 class Timer {
 private:
     high_resolution_clock::time_point start_time;
@@ -52,16 +92,40 @@ public:
     }
 };
 
-void print_result(const std::string& test_name, double dict_time, double other_time = 0) {
+// Node-based table dict_s::map_t used before the flat hash table, kept to
+// show the difference on insertion and lookup
+typedef std::unordered_map<key_s, val_s, json_key_hash> node_map_t;
+
+key_s make_string_key(const std::string& s) {
+    return key_s(str_view_s(s));
+}
+
+void print_result(const std::string& test_name, double dict_time, double other_time = 0,
+                  const char* unit = "ms") {
     std::cout << std::left << std::setw(40) << test_name;
     
     if (other_time > 0) {
-        std::cout << std::right << std::setw(12) << std::fixed << std::setprecision(2) << other_time << " ms";
-        std::cout << std::setw(14) << std::fixed << std::setprecision(2) << dict_time << " ms";
+        std::cout << std::right << std::setw(12) << std::fixed << std::setprecision(2) << other_time << " " << unit;
+        std::cout << std::setw(14) << std::fixed << std::setprecision(2) << dict_time << " " << unit;
         double speedup = other_time / dict_time;
         std::cout << std::setw(12) << std::fixed << std::setprecision(2) << speedup << "x";
     } else {
-        std::cout << std::right << std::setw(12) << std::fixed << std::setprecision(2) << dict_time << " ms";
+        std::cout << std::right << std::setw(12) << std::fixed << std::setprecision(2) << dict_time << " " << unit;
+    }
+    std::cout << std::endl;
+}
+
+// Like print_result, for rates where higher is better
+void print_throughput(const std::string& test_name, double dict_rate, double other_rate = 0,
+                      const char* unit = "GB/s") {
+    std::cout << std::left << std::setw(40) << test_name;
+    
+    if (other_rate > 0) {
+        std::cout << std::right << std::setw(10) << std::fixed << std::setprecision(2) << other_rate << " " << unit;
+        std::cout << std::setw(12) << std::fixed << std::setprecision(2) << dict_rate << " " << unit;
+        std::cout << std::setw(12) << std::fixed << std::setprecision(2) << dict_rate / other_rate << "x";
+    } else {
+        std::cout << std::right << std::setw(10) << std::fixed << std::setprecision(2) << dict_rate << " " << unit;
     }
     std::cout << std::endl;
 }
@@ -94,6 +158,16 @@ void benchmark_simple_insertions() {
 #endif
     
     print_result("Simple insertions (10k items)", dict_time, json_time);
+    
+    {
+        Timer timer;
+        node_map_t m;
+        for (int i = 0; i < N; i++) {
+            std::string key = "key_" + std::to_string(i);
+            m[make_string_key(key)] = i;
+        }
+        print_result("  std::unordered_map map_t", timer.elapsed_ms(), dict_time);
+    }
 }
 
 void benchmark_integer_keys() {
@@ -180,6 +254,21 @@ void benchmark_nested_objects() {
     print_result("Nested objects (1k items)", dict_time, json_time);
 }
 
+// API-response-like document: strings, doubles, nested objects, arrays
+std::string make_response_json() {
+    std::string response = "{\"status\":\"ok\",\"items\":[";
+    for (int i = 0; i < 200; i++) {
+        if (i) response += ',';
+        response += "{\"id\":" + std::to_string(i) +
+                    ",\"name\":\"item number " + std::to_string(i) + "\"" +
+                    ",\"price\":" + std::to_string(i * 1.37 + 0.01) +
+                    ",\"ratio\":0." + std::to_string(123456789 + i * 7919) +
+                    ",\"tags\":[\"a\",\"b\"],\"dims\":[1.5,2.25,3.125]}";
+    }
+    response += "]}";
+    return response;
+}
+
 void benchmark_serialization() {
     const int N = 1000;
     
@@ -212,6 +301,44 @@ void benchmark_serialization() {
 #endif
     
     print_result("Serialization (1k items)", dict_time, json_time);
+    
+    std::string response = make_response_json();
+    
+    const int REPS = 1000;
+    dict_t rd(response);
+    size_t bytes = 0;
+    {
+        Timer timer;
+        for (int i = 0; i < REPS; i++) {
+            bytes += rd.dump().size();
+        }
+        dict_time = timer.elapsed_ms();
+    }
+    double stream_time;
+    {
+        Timer timer;
+        for (int i = 0; i < REPS; i++) {
+            std::ostringstream oss;
+            oss << rd;
+            bytes += oss.str().size();
+        }
+        stream_time = timer.elapsed_ms();
+    }
+    
+#ifdef HAVE_NLOHMANN
+    json rj = json::parse(response);
+    {
+        Timer timer;
+        for (int i = 0; i < REPS; i++) {
+            bytes += rj.dump().size();
+        }
+        json_time = timer.elapsed_ms();
+    }
+#endif
+    
+    print_result("Serialization, response (1000x)", dict_time, json_time);
+    print_result("  operator<< (1000x)", stream_time, json_time);
+    if (bytes == 0) std::cout << "";     // Keep the loops observable
 }
 
 void benchmark_parsing() {
@@ -225,27 +352,91 @@ void benchmark_parsing() {
         }
     })";
     
-    double dict_time, json_time = 0;
+    double dict_time, doc_time, json_time = 0;
+    double dict_allocs, doc_allocs, json_allocs = 0;
     
     {
+        AllocCounter counter;
         Timer timer;
         for (int i = 0; i < 1000; i++) {
             dict_t d(json_str);
         }
         dict_time = timer.elapsed_ms();
+        dict_allocs = counter.count() / 1000.0;
+    }
+    
+    {
+        // Arena-backed document, re-parsed in place so its blocks are reused
+        AllocCounter counter;
+        Timer timer;
+        doc_s doc;
+        for (int i = 0; i < 1000; i++) {
+            doc.parse(json_str);
+        }
+        doc_time = timer.elapsed_ms();
+        doc_allocs = counter.count() / 1000.0;
     }
     
 #ifdef HAVE_NLOHMANN
     {
+        AllocCounter counter;
         Timer timer;
         for (int i = 0; i < 1000; i++) {
             json j = json::parse(json_str);
         }
         json_time = timer.elapsed_ms();
+        json_allocs = counter.count() / 1000.0;
     }
 #endif
     
     print_result("JSON parsing (1000x)", dict_time, json_time);
+    print_result("JSON parsing, arena doc (1000x)", doc_time, json_time);
+    print_result("Allocations per parse", dict_allocs, json_allocs, "  ");
+    print_result("Allocations per parse, arena doc", doc_allocs, json_allocs, "  ");
+    
+    // Request-sized body with strings past the small-string buffer, parsed
+    // into a reused doc with owned, borrowed and in-situ strings. The in-situ
+    // run copies the body into a scratch buffer first, as a server would
+    // receive it.
+    std::string request = "{\"user\":{\"id\":184467,\"email\":\"alice.anderson@example.com\","
+                          "\"display_name\":\"Alice \\\"Al\\\" Anderson\"},\"items\":[";
+    for (int i = 0; i < 20; i++) {
+        if (i) request += ',';
+        request += "{\"sku\":\"SKU-000000000" + std::to_string(1000 + i) + "\",\"qty\":" + std::to_string(i % 5 + 1) +
+                   ",\"note\":\"gift wrap requested, deliver after 5pm\"}";
+    }
+    request += "],\"comment\":\"Please ring the bell twice.\\nThanks!\"}";
+    
+    const char* modes[] = { "Request parse, owned strings", "Request parse, borrowed strings",
+                            "Request parse, in-situ" };
+    double request_time[3], request_allocs[3];
+    std::vector<char> scratch(request.size());
+    for (int m = 0; m < 3; m++) {
+        request_time[m] = 1e300;
+        for (int run = 0; run < 5; run++) {          // Best of 5
+            doc_s doc;
+            AllocCounter counter;
+            Timer timer;
+            for (int i = 0; i < 10000; i++) {
+                if (m == 0) {
+                    doc.parse(request);
+                } else if (m == 1) {
+                    doc.parse_borrowed(request.data(), request.size());
+                } else {
+                    std::memcpy(scratch.data(), request.data(), request.size());
+                    doc.parse_insitu(scratch.data(), scratch.size());
+                }
+            }
+            request_time[m] = std::min(request_time[m], timer.elapsed_ms());
+            request_allocs[m] = counter.count() / 10000.0;
+        }
+    }
+    for (int m = 0; m < 3; m++) {
+        print_result(std::string(modes[m]) + " (10000x)", request_time[m], m ? request_time[0] : 0);
+    }
+    for (int m = 0; m < 3; m++) {
+        print_result(std::string("  allocations per parse"), request_allocs[m], m ? request_allocs[0] : 0, "  ");
+    }
 }
 
 void benchmark_array_operations() {
@@ -265,6 +456,44 @@ void benchmark_array_operations() {
         }
         print_result("Array operations (1k x 100 items)", timer.elapsed_ms());
     }
+    
+    // Telemetry-style numeric array: parse time and heap bytes per element
+    const int M = 100000;
+    std::string json_str = "{\"samples\":[";
+    for (int i = 0; i < M; i++) {
+        if (i > 0) json_str += ',';
+        json_str += std::to_string(i * 7);
+    }
+    json_str += "]}";
+    
+    double dict_time, json_time = 0;
+    double dict_bytes, json_bytes = 0;
+    
+    {
+        AllocCounter counter;
+        Timer timer;
+        dict_t d(json_str);
+        dict_time = timer.elapsed_ms();
+        dict_bytes = static_cast<double>(counter.bytes()) / M;
+        
+        volatile int64_t sum = 0;
+        for (size_t i = 0; i < d["samples"].size(); i++) {
+            sum += d["samples"].int_at(i);
+        }
+    }
+    
+#ifdef HAVE_NLOHMANN
+    {
+        AllocCounter counter;
+        Timer timer;
+        json j = json::parse(json_str);
+        json_time = timer.elapsed_ms();
+        json_bytes = static_cast<double>(counter.bytes()) / M;
+    }
+#endif
+    
+    print_result("Numeric array parse (100k ints)", dict_time, json_time);
+    print_result("Heap bytes per array element", dict_bytes, json_bytes, "B");
 }
 
 void benchmark_copy_operations() {
@@ -305,6 +534,41 @@ void benchmark_copy_operations() {
 #endif
     
     print_result("Copy operations (100x500 items)", dict_time, json_time);
+    
+    // Copy a config tree per request and override one nested setting. The
+    // config was filled through operator[], so each copy copies its top
+    // level, but the sections stay shared until one is written.
+    dict_t config;
+    for (int s = 0; s < 20; s++) {
+        dict_t section;
+        for (int i = 0; i < 50; i++) {
+            section["option_" + std::to_string(i)] = "value_" + std::to_string(i);
+        }
+        config["section_" + std::to_string(s)] = section;
+    }
+    
+    {
+        Timer timer;
+        for (int i = 0; i < 10000; i++) {
+            dict_t ctx = config;
+            ctx["section_3"]["option_7"] = i;
+        }
+        dict_time = timer.elapsed_ms();
+    }
+    
+#ifdef HAVE_NLOHMANN
+    json j_config = json::parse(config.dump());
+    {
+        Timer timer;
+        for (int i = 0; i < 10000; i++) {
+            json ctx = j_config;
+            ctx["section_3"]["option_7"] = i;
+        }
+        json_time = timer.elapsed_ms();
+    }
+#endif
+    
+    print_result("Copy + one write (10000x 20x50 tree)", dict_time, json_time);
 }
 
 void benchmark_move_operations() {
@@ -363,6 +627,975 @@ void benchmark_random_access() {
 #endif
     
     print_result("Random access (5k lookups)", dict_time, json_time);
+    
+    {
+        node_map_t m;
+        for (int i = 0; i < N; i++) {
+            m[make_string_key("key_" + std::to_string(i))] = i;
+        }
+        Timer timer;
+        volatile int sum = 0;
+        for (int i = 0; i < N; i++) {
+            std::string key = "key_" + std::to_string(i);
+            sum += m[make_string_key(key)].intg;
+        }
+        print_result("  std::unordered_map map_t", timer.elapsed_ms(), dict_time);
+    }
+    
+    {
+        // Read-only probes through const dict_t& with precomputed C strings
+        std::vector<std::string> keys;
+        for (int i = 0; i < N; i++) {
+            keys.push_back("key_" + std::to_string(i));
+        }
+        const dict_t& cd = d;
+        AllocCounter counter;
+        Timer timer;
+        volatile int64_t sum = 0;
+        for (int rep = 0; rep < 10; rep++) {
+            for (int i = 0; i < N; i++) {
+                const val_t* v = cd.find(keys[i].c_str());
+                if (v) sum += v->intg;
+            }
+        }
+        double find_time = timer.elapsed_ms() / 10;
+        print_result("  find() via const dict_t&", find_time, dict_time);
+        print_result("  Allocations per find()", counter.count() / (10.0 * N), 0, "  ");
+        
+        // Same probes against the frozen copy: one perfect-hash slot each
+        Timer freeze_timer;
+        dict_frozen_t f = cd.freeze();
+        print_result("  freeze() (5k keys)", freeze_timer.elapsed_ms(), 0);
+        Timer frozen_timer;
+        for (int rep = 0; rep < 10; rep++) {
+            for (int i = 0; i < N; i++) {
+                frozen_val_s v = f.find(keys[i].c_str());
+                if (v) sum += v.intg();
+            }
+        }
+        print_result("  find() via dict_frozen_t", frozen_timer.elapsed_ms() / 10, find_time);
+    }
+    
+    {
+        // Past the caches, where the frozen entries (32 bytes, short keys
+        // inline) cost fewer misses than map slots
+        const int M = 200000;
+        dict_t big;
+        std::vector<std::string> keys;
+        for (int i = 0; i < M; i++) {
+            keys.push_back("key_" + std::to_string(i));
+            big[keys.back()] = i;
+        }
+        const dict_t& cb = big;
+        dict_frozen_t f = cb.freeze();
+        volatile int64_t sum = 0;
+        Timer find_timer;
+        for (int i = 0; i < M; i++) {
+            const val_t* v = cb.find(keys[i * 7919 % M]);   // Strided, not insertion order
+            if (v) sum += v->intg;
+        }
+        double find_time = find_timer.elapsed_ms();
+        Timer frozen_timer;
+        for (int i = 0; i < M; i++) {
+            frozen_val_s v = f.find(keys[i * 7919 % M]);
+            if (v) sum += v.intg();
+        }
+        print_result("  find() 200k keys via const dict_t&", find_time, 0);
+        print_result("  find() 200k keys via dict_frozen_t", frozen_timer.elapsed_ms(), find_time);
+    }
+}
+
+// Layout of val_s before it became a tagged union (every payload member
+// present at once), kept here to report the per-node saving
+struct legacy_val_layout {
+    json_value_types t;
+    std::shared_ptr<dict_s> obj;
+    std::string str;
+    int64_t intg;
+    double dbl;
+    bool boolean;
+    std::vector<std::shared_ptr<val_s>> arr;
+};
+
+void benchmark_memory_footprint() {
+    const int N = 10000;
+    
+    double dict_bytes, json_bytes = 0;
+    
+    std::cout << "  sizeof(val_s): " << sizeof(legacy_val_layout) << " B legacy layout -> "
+              << sizeof(val_s) << " B tagged union" << std::endl;
+    
+    {
+        AllocCounter counter;
+        dict_t d;
+        for (int i = 0; i < N; i++) {
+            d[i] = i;
+        }
+        dict_bytes = static_cast<double>(counter.bytes()) / N;
+    }
+    
+#ifdef HAVE_NLOHMANN
+    {
+        std::vector<std::string> keys;
+        for (int i = 0; i < N; i++) {
+            keys.push_back(std::to_string(i));
+        }
+        AllocCounter counter;
+        json j;
+        for (int i = 0; i < N; i++) {
+            j[keys[i]] = i;
+        }
+        json_bytes = static_cast<double>(counter.bytes()) / N;
+    }
+#endif
+    
+    print_result("Heap bytes per int node (10k)", dict_bytes, json_bytes, "B");
+    
+    // Arrays of objects repeat the same field names in every element; short
+    // names are stored inline and long ones share one interned atom
+    std::cout << "  sizeof(key_s): " << sizeof(key_s) << " B" << std::endl;
+    
+    const int ROWS = 10000;
+    std::string rows = "{\"rows\":[";
+    for (int i = 0; i < ROWS; i++) {
+        if (i) rows += ',';
+        rows += "{\"id\":" + std::to_string(i) +
+                ",\"ts\":" + std::to_string(1700000000 + i) +
+                ",\"name\":\"user" + std::to_string(i) + "\"" +
+                ",\"account_created_at\":" + std::to_string(i * 7) +
+                ",\"last_login_address\":\"10.0.0.1\"}";
+    }
+    rows += "]}";
+    
+    double doc_bytes, tree_bytes;
+    json_bytes = 0;
+    {
+        AllocCounter counter;
+        dict_t d(rows);
+        tree_bytes = static_cast<double>(counter.bytes()) / ROWS;
+    }
+    {
+        AllocCounter counter;
+        doc_s doc(rows);
+        doc_bytes = static_cast<double>(counter.bytes()) / ROWS;
+    }
+#ifdef HAVE_NLOHMANN
+    {
+        AllocCounter counter;
+        json j = json::parse(rows);
+        json_bytes = static_cast<double>(counter.bytes()) / ROWS;
+    }
+#endif
+    
+    print_result("Heap bytes per object (parse)", tree_bytes, json_bytes, "B");
+    print_result("Heap bytes per object (doc)", doc_bytes, json_bytes, "B");
+}
+
+// Parsing throughput on multi-megabyte, string-heavy input. Most bytes are
+// inside long string values or indentation, which the parser scans in blocks.
+template<typename ParseFn>
+double best_throughput(const std::string& input, ParseFn parse) {
+    double best_ms = 1e300;
+    for (int run = 0; run < 5; run++) {
+        Timer timer;
+        parse(input);
+        best_ms = std::min(best_ms, timer.elapsed_ms());
+    }
+    return input.size() / (best_ms / 1000.0) / 1e9;
+}
+
+// Metrics feed: timestamps, counters and latency samples
+std::string make_metrics_json(int samples) {
+    std::string metrics = "{\"samples\":[";
+    uint64_t seed = 88172645463325252ULL;
+    for (int i = 0; i < samples; i++) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        if (i) metrics += ',';
+        metrics += "{\"ts\":" + std::to_string(1700000000000LL + i) +
+                   ",\"bytes\":" + std::to_string(seed % 100000000) +
+                   ",\"cpu\":" + std::to_string((seed % 10000) / 100.0) +
+                   ",\"lat\":[" + std::to_string((seed >> 20) % 1000 * 0.001234) +
+                   "," + std::to_string((seed >> 30) % 1000) + ".25e-3]}";
+    }
+    metrics += "]}";
+    return metrics;
+}
+
+void benchmark_parse_throughput() {
+    const int ROWS = 20000;
+    const std::string words = "lorem ipsum dolor sit amet consectetur adipiscing elit sed do eiusmod "
+                              "tempor incididunt ut labore et dolore magna aliqua ut enim ad minim ";
+    // The pretty-printed input is dumped from a copy without escapes
+    std::string compact = "{\"rows\":[", plain = compact;
+    for (int i = 0; i < ROWS; i++) {
+        if (i) {
+            compact += ',';
+            plain += ',';
+        }
+        std::string head = "{\"id\":" + std::to_string(i) +
+                           ",\"title\":\"" + words.substr(i % 40, 60) + "\"" +
+                           ",\"tags\":[\"alpha\",\"beta\",\"gamma\"]";
+        compact += head + ",\"body\":\"" + words + words + "\\n" + words + words + "\\t" + words + "\"}";
+        plain += head + ",\"body\":\"" + words + words + words + words + words + "\"}";
+    }
+    compact += "]}";
+    plain += "]}";
+    std::string pretty = dict_t(plain).dump(4);
+    
+    std::string metrics = make_metrics_json(ROWS * 10);
+    
+    struct input_s { const char* name; const std::string* text; } inputs[] = {
+        { "Parse throughput, strings", &compact },
+        { "Parse throughput, pretty-printed", &pretty },
+        { "Parse throughput, numbers", &metrics }
+    };
+    std::cout << "  Input sizes: " << compact.size() / (1024 * 1024) << " MB compact, "
+              << pretty.size() / (1024 * 1024) << " MB pretty, "
+              << metrics.size() / (1024 * 1024) << " MB numbers" << std::endl;
+    
+    for (const input_s& in : inputs) {
+        double dict_rate = best_throughput(*in.text, [](const std::string& s) { dict_t d(s); });
+        double doc_rate = best_throughput(*in.text, [](const std::string& s) { doc_s doc(s); });
+        double json_rate = 0;
+#ifdef HAVE_NLOHMANN
+        json_rate = best_throughput(*in.text, [](const std::string& s) { json j = json::parse(s); });
+#endif
+        // The tape parser reuses its buffers, as an ingest loop would
+        json_tape_s tape;
+        double tape_rate = best_throughput(*in.text, [&tape](const std::string& s) { tape.parse(s); });
+        print_throughput(in.name, dict_rate, json_rate);
+        print_throughput(std::string("  arena doc"), doc_rate, json_rate);
+        print_throughput(std::string("  tape"), tape_rate, json_rate);
+    }
+}
+
+// Streaming serialization of a large document to a file: dump() followed by
+// fwrite() against dump_to() on a FILE* and on a raw descriptor. Besides time,
+// reports how much the resident set grows while writing (Linux only).
+size_t read_status_kb(const char* field) {
+    size_t kb = 0;
+#ifdef __linux__
+    if (FILE* f = std::fopen("/proc/self/status", "r")) {
+        char line[256];
+        size_t len = std::strlen(field);
+        while (std::fgets(line, sizeof(line), f)) {
+            if (std::strncmp(line, field, len) == 0) kb = std::strtoul(line + len, nullptr, 10);
+        }
+        std::fclose(f);
+    }
+#else
+    (void)field;
+#endif
+    return kb;
+}
+
+// Resets the peak (VmHWM) to the current resident set and returns it
+size_t reset_peak_rss_kb() {
+#ifdef __linux__
+    if (FILE* f = std::fopen("/proc/self/clear_refs", "w")) {
+        std::fputs("5", f);
+        std::fclose(f);
+    }
+#endif
+    return read_status_kb("VmRSS:");
+}
+
+void benchmark_streaming_serialization() {
+    const int ROWS = 500000;
+    doc_s doc;
+    val_s& rows = doc["rows"];
+    for (int i = 0; i < ROWS; i++) {
+        dict_t row;
+        row["id"] = i;
+        row["name"] = "user_" + std::to_string(i);
+        row["score"] = i * 0.25;
+        row["active"] = (i % 3) != 0;
+        row["tags"] = std::vector<int>{i, i + 1, i + 2};
+        rows.push_back(std::move(row));
+    }
+    
+    FILE* out = std::tmpfile();
+    if (!out) return;
+    size_t bytes = 0;
+    auto run = [&](int mode) {
+        std::rewind(out);
+        size_t baseline_kb = reset_peak_rss_kb();
+        Timer timer;
+        if (mode == 0) {
+            std::string s = doc.dump();
+            std::fwrite(s.data(), 1, s.size(), out);
+            bytes = s.size();
+        } else if (mode == 1) {
+            doc.dump_to(out);
+        } else {
+            std::fflush(out);
+            doc.dump_to(fileno(out));
+        }
+        std::fflush(out);
+        double ms = timer.elapsed_ms();
+        size_t peak_kb = read_status_kb("VmHWM:");
+        size_t growth_kb = peak_kb > baseline_kb ? peak_kb - baseline_kb : 0;
+        return std::make_pair(ms, growth_kb);
+    };
+    
+    run(0);   // Warm-up: page in the file and the allocator
+    std::pair<double, size_t> full = run(0);
+    std::pair<double, size_t> file = run(1);
+    std::pair<double, size_t> fd = run(2);
+    std::fclose(out);
+    
+    double mb = bytes / (1024.0 * 1024.0);
+    std::cout << "  Output size: " << static_cast<int>(mb) << " MB" << std::endl;
+    print_throughput("dump() + fwrite", mb / (full.first / 1000.0), 0, "MB/s");
+    print_throughput("dump_to(FILE*)", mb / (file.first / 1000.0), mb / (full.first / 1000.0), "MB/s");
+    print_throughput("dump_to(fd)", mb / (fd.first / 1000.0), mb / (full.first / 1000.0), "MB/s");
+#ifdef __linux__
+    // Growth can be zero when the chunk buffer fits in already-resident pages
+    print_result("Peak RSS growth, dump() + fwrite", static_cast<double>(full.second), 0, "KB");
+    print_result("Peak RSS growth, dump_to(FILE*)", static_cast<double>(file.second), 0, "KB");
+    print_result("Peak RSS growth, dump_to(fd)", static_cast<double>(fd.second), 0, "KB");
+#endif
+}
+
+// Sparse access: read 4 fields out of a 200-field payload. dict_t and doc_s
+// build the whole tree first; the lazy document validates and indexes the
+// input, then materializes only what is looked up.
+void benchmark_lazy_access() {
+    std::string payload = "{";
+    for (int i = 0; i < 200; i++) {
+        if (i) payload += ',';
+        std::string key = "\"field_" + std::to_string(i) + "\":";
+        switch (i % 4) {
+            case 0: payload += key + "\"value number " + std::to_string(i) + " with some padding text\""; break;
+            case 1: payload += key + std::to_string(i * 1000003LL); break;
+            case 2: payload += key + "{\"id\":" + std::to_string(i) + ",\"label\":\"nested label\",\"ok\":true}"; break;
+            default: payload += key + "[1.5,2.5,3.5,4.5,5.5,6.5]"; break;
+        }
+    }
+    payload += "}";
+    const int N = 10000;
+    int64_t sink = 0;
+    
+    double dict_time, doc_time, lazy_time, json_time = 0;
+    {
+        Timer timer;
+        for (int i = 0; i < N; i++) {
+            dict_t d(payload);
+            sink += d["field_1"].intg + d["field_42"]["id"].intg;
+            sink += d["field_120"].str.size() + static_cast<int64_t>(d["field_199"].dbl_at(2));
+        }
+        dict_time = timer.elapsed_ms();
+    }
+    {
+        doc_s doc;
+        Timer timer;
+        for (int i = 0; i < N; i++) {
+            doc.parse(payload);
+            sink += doc["field_1"].intg + doc["field_42"]["id"].intg;
+            sink += doc["field_120"].str.size() + static_cast<int64_t>(doc["field_199"].dbl_at(2));
+        }
+        doc_time = timer.elapsed_ms();
+    }
+    {
+        Timer timer;
+        for (int i = 0; i < N; i++) {
+            dict_lazy_t lazy(payload);
+            sink += lazy["field_1"].get().intg + lazy["field_42"]["id"].get().intg;
+            sink += lazy["field_120"].get().str_view().size + static_cast<int64_t>(lazy["field_199"].get().dbl_at(2));
+        }
+        lazy_time = timer.elapsed_ms();
+    }
+#ifdef HAVE_NLOHMANN
+    {
+        Timer timer;
+        for (int i = 0; i < N; i++) {
+            json j = json::parse(payload);
+            sink += j["field_1"].get<int64_t>() + j["field_42"]["id"].get<int64_t>();
+            sink += j["field_120"].get<std::string>().size() + static_cast<int64_t>(j["field_199"][2].get<double>());
+        }
+        json_time = timer.elapsed_ms();
+    }
+#endif
+    
+    std::cout << "  Payload: " << payload.size() << " bytes, 200 fields, 4 read (checksum " << sink % 10 << ")" << std::endl;
+    print_result("Parse + 4 lookups, dict_t (10000x)", dict_time, json_time);
+    print_result("Parse + 4 lookups, doc_s (10000x)", doc_time, json_time);
+    print_result("Parse + 4 lookups, lazy (10000x)", lazy_time, json_time);
+    print_result("  lazy vs dict_t", lazy_time, dict_time);
+}
+
+// Loading a large document from disk: reading it into a std::string first
+// against parsing straight from a memory mapping (dict_t and doc_s, the
+// latter keeping strings as views into the mapping). The file is written
+// once, so all runs read from a warm page cache.
+void benchmark_file_loading() {
+    const char* path = "dict_bench_load.json";
+    {
+        dict_t doc;
+        val_s& rows = doc["rows"];
+        for (int i = 0; i < 200000; i++) {
+            dict_t row;
+            row["id"] = i;
+            row["name"] = "user_" + std::to_string(i);
+            row["email"] = "user_" + std::to_string(i) + "@example.com";
+            row["score"] = i * 0.25;
+            row["tags"] = std::vector<std::string>{"alpha", "beta", "gamma"};
+            rows.push_back(std::move(row));
+        }
+        if (!doc.save_file(path)) return;
+    }
+    
+    size_t bytes = 0;
+    auto run = [&](int mode) {
+        double best = 1e300;
+        for (int rep = 0; rep < 5; rep++) {
+            Timer timer;
+            if (mode == 0) {
+                std::ifstream in(path, std::ios::binary | std::ios::ate);
+                std::string text(static_cast<size_t>(in.tellg()), '\0');
+                in.seekg(0);
+                in.read(&text[0], static_cast<std::streamsize>(text.size()));
+                bytes = text.size();
+                dict_t d(text);
+            } else if (mode == 1) {
+                dict_t d;
+                d.load_file(path);
+            } else {
+                doc_s doc;
+                doc.load_file(path);
+            }
+            best = std::min(best, timer.elapsed_ms());
+        }
+        return best;
+    };
+    double copy = run(0);
+    double mapped = run(1);
+    double doc = run(2);
+    std::remove(path);
+    
+    std::cout << "  File size: " << bytes / (1024 * 1024) << " MB" << std::endl;
+    print_result("Read into string + parse", copy);
+    print_result("dict_t::load_file (mmap)", mapped, copy);
+    print_result("doc_s::load_file (mmap, borrowed)", doc, copy);
+}
+
+// NDJSON ingest: splitting lines and parsing them one by one on the calling
+// thread, against ndjson_reader_s with 1..N workers (N is at least 4, so the
+// rows exist even on small machines; beyond the core count they show the
+// pool's overhead rather than scaling).
+void benchmark_ndjson() {
+    std::string text;
+    uint64_t seed = 88172645463325252ULL;
+    for (int i = 0; i < 200000; i++) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        text += "{\"ts\":" + std::to_string(1700000000000LL + i) +
+                ",\"level\":\"" + (seed % 4 ? "info" : "error") + "\"" +
+                ",\"service\":\"checkout-api\",\"latency_ms\":" + std::to_string((seed % 100000) / 100.0) +
+                ",\"message\":\"request completed for user " + std::to_string(seed % 100000) + "\"" +
+                ",\"tags\":[\"eu-west\",\"canary\"]}\n";
+    }
+    double mb = text.size() / (1024.0 * 1024.0);
+    size_t records = 0;
+    
+    double serial = 1e300;
+    for (int rep = 0; rep < 3; rep++) {
+        Timer timer;
+        size_t start = 0;
+        records = 0;
+        while (start < text.size()) {
+            size_t nl = text.find('\n', start);
+            if (nl == std::string::npos) nl = text.size();
+            dict_t d(text.substr(start, nl - start));
+            records += d.valid;
+            start = nl + 1;
+        }
+        serial = std::min(serial, timer.elapsed_ms());
+    }
+    std::cout << "  Input: " << static_cast<int>(mb) << " MB, " << records << " lines, "
+              << std::thread::hardware_concurrency() << " hardware threads" << std::endl;
+    print_throughput("Serial split + dict_t", mb / (serial / 1000.0), 0, "MB/s");
+    
+    size_t max_threads = std::max<size_t>(4, std::thread::hardware_concurrency());
+    double one_thread = 0;
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        for (int ordered = 1; ordered >= 0; ordered--) {
+            double best = 1e300;
+            for (int rep = 0; rep < 3; rep++) {
+                ndjson_options_s options;
+                options.threads = threads;
+                options.ordered = ordered != 0;
+                Timer timer;
+                ndjson_reader_s reader(text, options);
+                ndjson_record_s rec;
+                records = 0;
+                while (reader.next(rec)) records += rec.doc.valid;
+                best = std::min(best, timer.elapsed_ms());
+            }
+            double rate = mb / (best / 1000.0);
+            if (threads == 1 && ordered) one_thread = rate;
+            std::string name = "ndjson_reader_s, " + std::to_string(threads) + (threads == 1 ? " thread" : " threads") +
+                               (ordered ? "" : ", unordered");
+            print_throughput(name, rate, one_thread, "MB/s");
+        }
+    }
+}
+
+// One large document parsed with dict_t::parse_parallel on 1..N threads
+// (N at least 4, as in the NDJSON benchmark). The 1-thread row is parse().
+void benchmark_parallel_parse() {
+    std::string rows = "{\"meta\":{\"source\":\"export\"},\"rows\":[";
+    std::string members = "{";
+    uint64_t seed = 88172645463325252ULL;
+    for (int i = 0; i < 400000; i++) {
+        seed ^= seed << 13; seed ^= seed >> 7; seed ^= seed << 17;
+        std::string sep = i ? "," : "";
+        std::string row = "{\"id\":" + std::to_string(i) + ",\"name\":\"user " + std::to_string(seed % 100000) +
+                          "\",\"score\":" + std::to_string((seed % 10000) / 100.0) +
+                          ",\"tags\":[\"a\",\"b\"],\"active\":" + (seed % 2 ? "true" : "false") + "}";
+        rows += sep + row;
+        members += sep + "\"user_" + std::to_string(i) + "\":" + row;
+    }
+    rows += "]}";
+    members += "}";
+    
+    struct input_s { const char* name; const std::string* text; } inputs[] = {
+        { "array of objects", &rows },
+        { "root object", &members }
+    };
+    size_t max_threads = std::max<size_t>(4, std::thread::hardware_concurrency());
+    for (const input_s& in : inputs) {
+        std::cout << "  " << in.name << ": " << in.text->size() / (1024 * 1024) << " MB" << std::endl;
+        double one_thread = 0;
+        for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+            double rate = 1000 * best_throughput(*in.text, [threads](const std::string& s) {
+                dict_t d;
+                d.parse_parallel(s, threads);
+            });
+            if (threads == 1) one_thread = rate;
+            print_throughput("  " + std::to_string(threads) + (threads == 1 ? " thread" : " threads"),
+                             rate, one_thread, "MB/s");
+        }
+    }
+}
+
+// Binary encoding against JSON text on the documents used above: the API
+// response from the serialization benchmark and the metrics feed from the
+// throughput benchmark. Rows compare against dump()/parse() of the same dict.
+void benchmark_binary_format() {
+    struct input_s { const char* name; std::string json; int reps; } inputs[] = {
+        { "API response", make_response_json(), 1000 },
+        { "Metrics feed", make_metrics_json(20000), 5 }
+    };
+    for (const input_s& in : inputs) {
+        dict_t d(in.json);
+        std::string text = d.dump(), bin = d.dump_binary();
+        size_t sink = 0;
+        double json_encode, bin_encode, json_decode, bin_decode, bin_open;
+        {
+            Timer timer;
+            for (int i = 0; i < in.reps; i++) sink += d.dump().size();
+            json_encode = timer.elapsed_ms();
+        }
+        {
+            Timer timer;
+            for (int i = 0; i < in.reps; i++) sink += d.dump_binary().size();
+            bin_encode = timer.elapsed_ms();
+        }
+        {
+            Timer timer;
+            for (int i = 0; i < in.reps; i++) sink += dict_t(text).obj->size();
+            json_decode = timer.elapsed_ms();
+        }
+        {
+            Timer timer;
+            for (int i = 0; i < in.reps; i++) {
+                dict_t b;
+                b.parse_binary(bin);
+                sink += b.obj->size();
+            }
+            bin_decode = timer.elapsed_ms();
+        }
+        {
+            // Checking the buffer is all bin_doc_s does before reads
+            Timer timer;
+            for (int i = 0; i < in.reps; i++) sink += bin_doc_s(bin).valid;
+            bin_open = timer.elapsed_ms();
+        }
+        std::string reps = " (" + std::to_string(in.reps) + "x)";
+        print_result(std::string(in.name) + ", encode" + reps, bin_encode, json_encode);
+        print_result("  decode to dict_t" + reps, bin_decode, json_decode);
+        print_result("  bin_doc_s, read in place" + reps, bin_open, json_decode);
+        print_result("  size", static_cast<double>(bin.size()), static_cast<double>(text.size()), "B");
+        if (sink == 0) std::cout << "";
+    }
+}
+
+// MessagePack and CBOR against JSON text on the same documents. The JSON
+// rows are the conversion these formats replace: dump() then parse().
+void benchmark_msgpack_cbor() {
+    struct input_s { const char* name; std::string json; int reps; } inputs[] = {
+        { "API response", make_response_json(), 1000 },
+        { "Metrics feed", make_metrics_json(20000), 5 }
+    };
+    for (const input_s& in : inputs) {
+        dict_t d(in.json);
+        std::string text = d.dump();
+        size_t sink = 0;
+        double json_encode, json_decode;
+        {
+            Timer timer;
+            for (int i = 0; i < in.reps; i++) sink += d.dump().size();
+            json_encode = timer.elapsed_ms();
+        }
+        {
+            Timer timer;
+            for (int i = 0; i < in.reps; i++) sink += dict_t(text).obj->size();
+            json_decode = timer.elapsed_ms();
+        }
+        std::string reps = " (" + std::to_string(in.reps) + "x)";
+        std::cout << "  " << in.name << ": " << text.size() << " B of JSON" << std::endl;
+        for (int cbor = 0; cbor < 2; cbor++) {
+            std::string bytes = cbor ? d.dump_cbor() : d.dump_msgpack();
+            double encode, decode;
+            {
+                Timer timer;
+                for (int i = 0; i < in.reps; i++) sink += (cbor ? d.dump_cbor() : d.dump_msgpack()).size();
+                encode = timer.elapsed_ms();
+            }
+            {
+                Timer timer;
+                for (int i = 0; i < in.reps; i++) {
+                    dict_t b;
+                    if (cbor) b.parse_cbor(bytes); else b.parse_msgpack(bytes);
+                    sink += b.obj->size();
+                }
+                decode = timer.elapsed_ms();
+            }
+            std::string format = cbor ? "  CBOR" : "  MessagePack";
+            print_result(format + ", encode" + reps, encode, json_encode);
+            print_result(format + ", decode" + reps, decode, json_decode);
+            print_result(format + ", size", static_cast<double>(bytes.size()), static_cast<double>(text.size()), "B");
+        }
+        if (sink == 0) std::cout << "";
+    }
+}
+
+void benchmark_persistent_versions() {
+    const int N = 10000;
+    const int versions = 1000;
+    
+    dict_t config;
+    std::vector<std::string> keys;
+    for (int i = 0; i < N; i++) {
+        keys.push_back("setting_" + std::to_string(i));
+        config[keys.back()] = "value_" + std::to_string(i);
+    }
+    std::cout << "  " << N << " keys, " << versions << " versions of one change each, all kept" << std::endl;
+    
+    double copy_time, copy_bytes, persistent_time, persistent_bytes;
+    {
+        std::vector<dict_t> history;
+        history.reserve(versions + 1);
+        history.push_back(config);
+        AllocCounter alloc;
+        Timer timer;
+        for (int i = 0; i < versions; i++) {
+            dict_t next = history.back();
+            next[keys[(i * 7919) % N]] = i;
+            history.push_back(std::move(next));
+        }
+        copy_time = timer.elapsed_ms();
+        copy_bytes = static_cast<double>(alloc.bytes()) / versions;
+    }
+    
+    persistent_dict_s root(config);
+    size_t sink = 0;
+    {
+        std::vector<persistent_dict_s> history;
+        history.reserve(versions + 1);
+        history.push_back(root);
+        AllocCounter alloc;
+        Timer timer;
+        for (int i = 0; i < versions; i++) {
+            history.push_back(history.back().set(keys[(i * 7919) % N], i));
+        }
+        persistent_time = timer.elapsed_ms();
+        persistent_bytes = static_cast<double>(alloc.bytes()) / versions;
+        sink += history.back().size();
+    }
+    print_result("dict_t copy + set (1000x)", copy_time);
+    print_result("persistent_dict_s::set (1000x)", persistent_time, copy_time);
+    print_result("  heap bytes per version", persistent_bytes, copy_bytes, "B");
+    
+    double dict_find, persistent_find;
+    {
+        Timer timer;
+        const dict_t& cd = config;
+        for (int r = 0; r < 10; r++) {
+            for (const std::string& k : keys) sink += cd.find(k) != nullptr;
+        }
+        dict_find = timer.elapsed_ms();
+    }
+    {
+        Timer timer;
+        for (int r = 0; r < 10; r++) {
+            for (const std::string& k : keys) sink += root.find(k) != nullptr;
+        }
+        persistent_find = timer.elapsed_ms();
+    }
+    print_result("  find(), 100k lookups", persistent_find, dict_find);
+    
+    {
+        Timer timer;
+        dict_t back = root.to_dict();
+        sink += back.obj->size();
+        print_result("  to_dict()", timer.elapsed_ms());
+    }
+    if (sink == 0) std::cout << "";
+}
+
+// Runs `threads` workers doing `ops` operations each on `keys` preloaded
+// keys, `read_pct` percent of them lookups and the rest writes; returns
+// millions of operations per second
+template<typename Read, typename Write>
+double run_mixed_workload(int threads, int ops, const std::vector<std::string>& keys, int read_pct,
+                          Read read, Write write) {
+    std::vector<std::thread> pool;
+    Timer timer;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t]() {
+            uint64_t seed = 0x9E3779B97F4A7C15ULL * (t + 1);
+            for (int i = 0; i < ops; i++) {
+                seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+                const std::string& key = keys[(seed >> 33) % keys.size()];
+                if (static_cast<int>((seed >> 20) % 100) < read_pct) {
+                    read(key);
+                } else {
+                    write(key, i);
+                }
+            }
+        });
+    }
+    for (std::thread& th : pool) th.join();
+    return static_cast<double>(threads) * ops / 1000.0 / timer.elapsed_ms();
+}
+
+void benchmark_concurrent_dict() {
+    const int N = 100000;
+    const int ops = 400000;
+    std::vector<std::string> keys;
+    for (int i = 0; i < N; i++) keys.push_back("user:" + std::to_string(i));
+    std::cout << "  " << N << " keys, " << std::thread::hardware_concurrency()
+              << " hardware threads; baseline is dict_t behind one std::mutex" << std::endl;
+    
+    const int ratios[] = { 100, 95, 50 };
+    const int thread_counts[] = { 1, 2, 4, 8 };
+    for (int read_pct : ratios) {
+        for (int threads : thread_counts) {
+            dict_t locked;
+            std::mutex mutex;
+            concurrent_dict_s shared;
+            for (int i = 0; i < N; i++) {
+                locked[keys[i]] = i;
+                shared.set(keys[i], i);
+            }
+            std::atomic<int64_t> sink(0);
+            double baseline = run_mixed_workload(threads, ops, keys, read_pct,
+                [&](const std::string& k) {
+                    std::lock_guard<std::mutex> guard(mutex);
+                    const val_s* v = static_cast<const dict_t&>(locked).find(k);
+                    if (v) sink.fetch_add(v->intg, std::memory_order_relaxed);
+                },
+                [&](const std::string& k, int v) {
+                    std::lock_guard<std::mutex> guard(mutex);
+                    locked[k] = v;
+                });
+            double rate = run_mixed_workload(threads, ops, keys, read_pct,
+                [&](const std::string& k) {
+                    val_s v;
+                    if (shared.find(k, v)) sink.fetch_add(v.intg, std::memory_order_relaxed);
+                },
+                [&](const std::string& k, int v) { shared.set(k, v); });
+            std::string name = "  " + std::to_string(read_pct) + "% reads, " + std::to_string(threads) +
+                               (threads == 1 ? " thread" : " threads");
+            print_throughput(name, rate, baseline, "Mops/s");
+        }
+    }
+    
+    // Readers only, against a const dict_t read with no synchronization at
+    // all: the most that optimistic (seqlock) reads could reach. With one
+    // hot key every reader takes the same shard's lock, the worst case for
+    // the shared lock's reader count.
+    std::cout << "  readers only; baseline is an unlocked const dict_t" << std::endl;
+    dict_t plain;
+    concurrent_dict_s shared;
+    for (int i = 0; i < N; i++) {
+        plain.set(keys[i], i);
+        shared.set(keys[i], i);
+    }
+    const dict_t& cplain = plain;
+    std::vector<std::string> hot(1, keys[0]);
+    for (int spread = 0; spread < 2; spread++) {
+        const std::vector<std::string>& read_keys = spread == 0 ? keys : hot;
+        for (int threads : thread_counts) {
+            std::atomic<int64_t> sink(0);
+            auto no_write = [](const std::string&, int) {};
+            double unlocked = run_mixed_workload(threads, ops, read_keys, 100,
+                [&](const std::string& k) {
+                    const val_s* v = cplain.find(k);
+                    if (v) sink.fetch_add(v->intg, std::memory_order_relaxed);
+                }, no_write);
+            double rate = run_mixed_workload(threads, ops, read_keys, 100,
+                [&](const std::string& k) {
+                    val_s v;
+                    if (shared.find(k, v)) sink.fetch_add(v.intg, std::memory_order_relaxed);
+                }, no_write);
+            std::string name = std::string(spread == 0 ? "  all keys, " : "  one hot key, ") +
+                               std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+            print_throughput(name, rate, unlocked, "Mops/s");
+        }
+    }
+}
+
+void benchmark_snapshot_reads() {
+    const int keys = 1000;
+    const int reads_per_thread = 500000;
+    auto make_config = [&](int version) {
+        dict_t d;
+        for (int i = 0; i < keys; i++) d["flag_" + std::to_string(i)] = version;
+        return d;
+    };
+    std::vector<std::string> names;
+    for (int i = 0; i < keys; i++) names.push_back("flag_" + std::to_string(i));
+    std::cout << "  " << keys << "-key config, republished continuously by one writer" << std::endl;
+    
+    const int thread_counts[] = { 1, 4, 8 };
+    for (int threads : thread_counts) {
+        std::atomic<int64_t> sink(0);
+        double rates[2];
+        for (int mode = 0; mode < 2; mode++) {
+            dict_t locked = make_config(0);
+            std::mutex mutex;
+            snapshot_holder_s holder(make_config(0));
+            std::atomic<bool> done(false);
+            int published = 0;
+            std::thread writer([&]() {
+                while (!done.load()) {
+                    dict_t next = make_config(++published);
+                    if (mode == 0) {
+                        std::lock_guard<std::mutex> guard(mutex);
+                        locked = std::move(next);
+                    } else {
+                        holder.publish(std::move(next));
+                    }
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+            std::vector<std::thread> pool;
+            Timer timer;
+            for (int t = 0; t < threads; t++) {
+                pool.emplace_back([&, t]() {
+                    snapshot_reader_s reader(holder);
+                    int64_t local = 0;
+                    for (int i = 0; i < reads_per_thread; i++) {
+                        const std::string& key = names[(i * 31 + t) % keys];
+                        if (mode == 0) {
+                            std::lock_guard<std::mutex> guard(mutex);
+                            local += static_cast<const dict_t&>(locked)[key].intg;
+                        } else {
+                            snapshot_pin_s snap = reader.pin();
+                            local += (*snap)[key].intg;
+                        }
+                    }
+                    sink += local;
+                });
+            }
+            for (std::thread& th : pool) th.join();
+            rates[mode] = static_cast<double>(threads) * reads_per_thread / 1000.0 / timer.elapsed_ms();
+            done = true;
+            writer.join();
+        }
+        std::string name = "  pinned reads, " + std::to_string(threads) + (threads == 1 ? " thread" : " threads");
+        print_throughput(name, rates[1], rates[0], "Mops/s");
+    }
+}
+
+// Message of the benchmark_nested_objects() shape, mapped field by field
+struct nested_item_s {
+    int64_t id;
+    std::string name;
+};
+DICT_FIELDS(nested_item_s, id, name)
+
+void benchmark_struct_mapping() {
+    const int N = 1000;
+    const int reps = 20;
+    std::vector<std::string> plain, extended;
+    for (int i = 0; i < N; i++) {
+        std::string members = "\"id\":" + std::to_string(i) + ",\"name\":\"item_" + std::to_string(i) + "\"";
+        plain.push_back("{" + members + "}");
+        extended.push_back("{" + members + ",\"meta\":{\"tags\":[\"a\",\"b\"],\"score\":1.5,\"source\":\"feed\"}}");
+    }
+    std::cout << "  " << N << " {id, name} messages, " << reps << "x" << std::endl;
+    
+    std::vector<nested_item_s> items(N);
+    size_t sink = 0;
+    for (int pass = 0; pass < 2; pass++) {
+        const std::vector<std::string>& in = pass ? extended : plain;
+        double copy_time, direct_time;
+        size_t copy_allocs, direct_allocs;
+        {
+            AllocCounter counter;
+            Timer timer;
+            for (int r = 0; r < reps; r++) {
+                for (int i = 0; i < N; i++) {
+                    dict_t d(in[i]);
+                    items[i].id = d["id"].intg;
+                    items[i].name = d["name"].str;
+                }
+            }
+            copy_time = timer.elapsed_ms();
+            copy_allocs = counter.count();
+        }
+        {
+            AllocCounter counter;
+            Timer timer;
+            for (int r = 0; r < reps; r++) {
+                for (int i = 0; i < N; i++) sink += dict_parse_struct(in[i], items[i]);
+            }
+            direct_time = timer.elapsed_ms();
+            direct_allocs = counter.count();
+        }
+        std::string shape = pass ? "  With an unknown member: " : "  ";
+        double messages = static_cast<double>(reps) * N;
+        print_result(shape + "parse + copy", copy_time, 0);
+        print_result(shape + "parse_struct()", direct_time, copy_time);
+        print_result("    Allocations per message, copy", copy_allocs / messages, 0, "  ");
+        print_result("    Allocations per message, direct", direct_allocs / messages, 0, "  ");
+    }
+    
+    double dump_time;
+    {
+        Timer timer;
+        for (int r = 0; r < reps; r++) {
+            for (int i = 0; i < N; i++) {
+                dict_t d;
+                d["id"] = items[i].id;
+                d["name"] = items[i].name;
+                sink += d.dump().size();
+            }
+        }
+        dump_time = timer.elapsed_ms();
+    }
+    print_result("  copy into dict_t + dump()", dump_time, 0);
+    {
+        Timer timer;
+        for (int r = 0; r < reps; r++) {
+            for (int i = 0; i < N; i++) sink += dict_dump_struct(items[i]).size();
+        }
+        print_result("  dict_dump_struct()", timer.elapsed_ms(), dump_time);
+    }
+    if (sink == 0) std::cout << "";
 }
 
 int main() {
@@ -384,41 +1617,80 @@ int main() {
     std::cout << std::endl;
     std::cout << std::string(70, '-') << std::endl;
     
-    std::cout << "\n[1/10] Simple insertions..." << std::endl;
+    std::cout << "\n[1/23] Simple insertions..." << std::endl;
     benchmark_simple_insertions();
     
-    std::cout << "\n[2/10] Integer key insertions..." << std::endl;
+    std::cout << "\n[2/23] Integer key insertions..." << std::endl;
     benchmark_integer_keys();
     
-    std::cout << "\n[3/10] Mixed value types..." << std::endl;
+    std::cout << "\n[3/23] Mixed value types..." << std::endl;
     benchmark_mixed_types();
     
-    std::cout << "\n[4/10] Nested objects..." << std::endl;
+    std::cout << "\n[4/23] Nested objects..." << std::endl;
     benchmark_nested_objects();
     
-    std::cout << "\n[5/10] Serialization..." << std::endl;
+    std::cout << "\n[5/23] Serialization..." << std::endl;
     benchmark_serialization();
     
-    std::cout << "\n[6/10] JSON parsing..." << std::endl;
+    std::cout << "\n[6/23] JSON parsing..." << std::endl;
     benchmark_parsing();
     
-    std::cout << "\n[7/10] Array operations..." << std::endl;
+    std::cout << "\n[7/23] Array operations..." << std::endl;
     benchmark_array_operations();
     
-    std::cout << "\n[8/10] Copy operations..." << std::endl;
+    std::cout << "\n[8/23] Copy operations..." << std::endl;
     benchmark_copy_operations();
     
-    std::cout << "\n[9/10] Move operations..." << std::endl;
+    std::cout << "\n[9/23] Move operations..." << std::endl;
     benchmark_move_operations();
     
-    std::cout << "\n[10/10] Random access..." << std::endl;
+    std::cout << "\n[10/23] Random access..." << std::endl;
     benchmark_random_access();
     
+    std::cout << "\n[11/23] Memory footprint..." << std::endl;
+    benchmark_memory_footprint();
+    
+    std::cout << "\n[12/23] Parsing throughput..." << std::endl;
+    benchmark_parse_throughput();
+    
+    std::cout << "\n[13/23] Streaming serialization..." << std::endl;
+    benchmark_streaming_serialization();
+    
+    std::cout << "\n[14/23] Lazy sparse access..." << std::endl;
+    benchmark_lazy_access();
+    
+    std::cout << "\n[15/23] File loading..." << std::endl;
+    benchmark_file_loading();
+    
+    std::cout << "\n[16/23] NDJSON ingest..." << std::endl;
+    benchmark_ndjson();
+    
+    std::cout << "\n[17/23] Parallel parsing..." << std::endl;
+    benchmark_parallel_parse();
+    
+    std::cout << "\n[18/23] Binary format..." << std::endl;
+    benchmark_binary_format();
+    
+    std::cout << "\n[19/23] MessagePack / CBOR..." << std::endl;
+    benchmark_msgpack_cbor();
+    
+    std::cout << "\n[20/23] Persistent versions..." << std::endl;
+    benchmark_persistent_versions();
+    
+    std::cout << "\n[21/23] Concurrent dict..." << std::endl;
+    benchmark_concurrent_dict();
+    
+    std::cout << "\n[22/23] Snapshot publishing..." << std::endl;
+    benchmark_snapshot_reads();
+    
+    std::cout << "\n[23/23] Struct mapping..." << std::endl;
+    benchmark_struct_mapping();
+    
     std::cout << "\n" << std::string(70, '=') << std::endl;
     std::cout << "\n✓ Benchmarks completed!\n" << std::endl;
     
     std::cout << "Notes:\n";
-    std::cout << "  • Times are in milliseconds (ms)\n";
+    std::cout << "  • Times are in milliseconds (ms), sizes in bytes (B), throughput in GB/s\n";
     std::cout << "  • Results may vary based on system load\n";
 #ifdef HAVE_NLOHMANN
     std::cout << "  • Speedup shows how many times faster dict-cpp is\n";
@@ -36,10 +36,67 @@
 #include <cstdlib>
 #include <cstring>
 #include <algorithm>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <cstddef>
+#include <functional>
+#include <tuple>
+#include <utility>
+#include <iterator>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cfloat>
+#include <climits>
+#include <clocale>
+#include <limits>
+#include <cstdio>
+#include <cerrno>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <system_error>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+
+// SIMD group probing in the flat hash table and block scanning in the parser.
+// AVX2 is used when the compiler targets it (-mavx2), NEON on little-endian
+// ARM. Define DICT_NO_SIMD to force the portable code paths.
+#if !defined(DICT_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define DICT_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if !defined(DICT_NO_SIMD) && defined(__AVX2__)
+#define DICT_HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+#if !defined(DICT_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__)) && \
+    defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define DICT_HAVE_NEON 1
+#include <arm_neon.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 // Forward declarations
 struct dict_s;
 struct val_s;
+struct json_key_hash;
+template<typename Hash> class frozen_dict_hashed_s;
+typedef frozen_dict_hashed_s<json_key_hash> frozen_dict_s;
 
 typedef enum {
     json_object_t,
@@ -51,22 +108,725 @@ typedef enum {
     json_null_t
 } json_value_types;
 
+// Storage used by a json_array value. Homogeneous int/double/bool arrays are
+// packed into a flat vector of the scalar type; anything else is generic.
+typedef enum : uint8_t {
+    json_array_generic,
+    json_array_int,
+    json_array_double,
+    json_array_bool
+} json_array_layouts;
+
 typedef enum {
     json_k_integer_t,
     json_k_string_t,
 } json_key_types;
 
+// Non-owning view of a character range, used for lookups that must not
+// allocate. Converts implicitly from std::string, C strings and, in C++17,
+// std::string_view; the viewed characters must outlive the call.
+struct str_view_s {
+    const char* data;
+    size_t size;
+    
+    str_view_s(const char* s) : data(s), size(std::strlen(s)) {}
+    str_view_s(const char* s, size_t n) : data(s), size(n) {}
+    str_view_s(const std::string& s) : data(s.data()), size(s.size()) {}
+#if __cplusplus >= 201703L
+    str_view_s(std::string_view s) : data(s.data()), size(s.size()) {}
+#endif
+    
+    std::string to_string() const { return std::string(data, size); }
+};
+
+inline bool operator==(str_view_s a, str_view_s b) {
+    return a.size == b.size && (a.size == 0 || std::memcmp(a.data, b.data, a.size) == 0);
+}
+
+// Random seed for key hashes, drawn once per process from the clock and
+// addresses that ASLR moves. Without the seed, inputs whose keys collide in
+// the hash tables cannot be worked out in advance.
+inline uint64_t dict_make_hash_seed() {
+    uint64_t x = static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+    x ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&x)) << 16;
+    x ^= static_cast<uint64_t>(reinterpret_cast<uintptr_t>(&dict_make_hash_seed));
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+inline uint64_t dict_hash_seed() {
+    static const uint64_t seed = dict_make_hash_seed();
+    return seed;
+}
+
+// Seeded hash of a byte range, 8 bytes at a time. The seed enters the first
+// round and the final one, so neither the state after a word nor the result
+// can be inverted without it. Values differ between processes and between
+// little- and big-endian hosts, which is fine as they are never persisted.
+inline uint64_t dict_hash_bytes(const char* p, size_t n) {
+    const uint64_t seed = dict_hash_seed();
+    uint64_t h = seed ^ 0x9e3779b97f4a7c15ULL ^ n;
+    while (n >= 8) {
+        uint64_t w;
+        std::memcpy(&w, p, 8);
+        h = (h ^ w) * 0xbf58476d1ce4e5b9ULL;
+        h ^= h >> 31;
+        p += 8;
+        n -= 8;
+    }
+    uint64_t w = 0;
+    std::memcpy(&w, p, n);
+    h = (h ^ w) * 0x94d049bb133111ebULL;
+    h ^= h >> 29;
+    h = (h ^ seed) * 0xbf58476d1ce4e5b9ULL;
+    return h ^ (h >> 32);
+}
+
+// Monotonic bump allocator backing one parsed document (see doc_s).
+// Memory is handed out from large blocks and only released all at once,
+// when the arena is reset or destroyed.
+class dict_arena {
+public:
+    explicit dict_arena(size_t initial_block = 4096);
+    ~dict_arena();
+    
+    void* allocate(size_t n, size_t align);
+    void reset();                       // Releases everything but the largest block
+    
+    size_t bytes_used() const { return used; }
+    size_t bytes_reserved() const { return reserved; }
+    
+private:
+    struct block_s {
+        block_s* next;
+        size_t size;
+    };
+    
+    block_s* head;
+    char* cursor;
+    char* limit;
+    size_t next_block;
+    size_t used;
+    size_t reserved;
+    
+    void grow(size_t min_size);
+    
+    dict_arena(const dict_arena&);              // Non-copyable
+    dict_arena& operator=(const dict_arena&);
+};
+
+// Allocator used by every dict_s map and val_s array. It draws from an arena
+// when one is attached and from the global heap otherwise. Copies of a
+// container select the heap allocator, so copying a value out of a document
+// always yields an independent heap-owned tree.
+template<typename T>
+struct dict_allocator {
+    typedef T value_type;
+    typedef std::true_type propagate_on_container_move_assignment;
+    typedef std::true_type propagate_on_container_swap;
+    
+    dict_arena* arena;
+    
+    dict_allocator() noexcept : arena(nullptr) {}
+    explicit dict_allocator(dict_arena* a) noexcept : arena(a) {}
+    template<typename U>
+    dict_allocator(const dict_allocator<U>& other) noexcept : arena(other.arena) {}
+    
+    T* allocate(size_t n) {
+        if (arena) {
+            return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T)));
+        }
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+    
+    void deallocate(T* p, size_t) noexcept {
+        if (!arena) {
+            ::operator delete(p);
+        }
+    }
+    
+    dict_allocator select_on_container_copy_construction() const {
+        return dict_allocator();
+    }
+};
+
+template<typename T, typename U>
+inline bool operator==(const dict_allocator<T>& a, const dict_allocator<U>& b) {
+    return a.arena == b.arena;
+}
+
+template<typename T, typename U>
+inline bool operator!=(const dict_allocator<T>& a, const dict_allocator<U>& b) {
+    return a.arena != b.arena;
+}
+
+// ==================== Flat Hash Table ====================
+//
+// Open-addressing hash table in the style of Swiss tables, used as the default
+// dict_s::map_t. Elements live in one flat slot array; a parallel array holds
+// one control byte per slot: empty, deleted, or the low 7 bits of the hash of
+// the key stored there. A lookup compares a whole 16-byte group of control
+// bytes against those 7 bits at once (SSE2 on x86, a portable loop elsewhere)
+// and only compares keys for the few slots that match.
+//
+// Tables smaller than a group (4 or 8 slots, enough for the handful of keys
+// most JSON objects have) still get a full group of control bytes; the bytes
+// past the last slot stay empty and are never handed out by find_free.
+//
+// Iteration order is slot order. It is unspecified, unrelated to insertion
+// order, and changes whenever the table grows or is rehashed. An insert that
+// grows the table invalidates all iterators and references into it; erase
+// and lookups never move elements.
+
+static const int8_t flat_ctrl_empty = -128;
+static const int8_t flat_ctrl_deleted = -2;
+static const size_t flat_group_width = 16;
+static const size_t flat_min_capacity = 4;
+
+inline unsigned flat_ctz(uint32_t x) {
+#ifdef _MSC_VER
+    unsigned long i;
+    _BitScanForward(&i, x);
+    return static_cast<unsigned>(i);
+#else
+    return static_cast<unsigned>(__builtin_ctz(x));
+#endif
+}
+
+// 16 control bytes; each match_* returns a bitmask with bit i set when
+// control byte i satisfies the predicate
+struct flat_group {
+    const int8_t* ctrl;
+    
+    explicit flat_group(const int8_t* p) : ctrl(p) {}
+    
+#ifdef DICT_HAVE_SSE2
+    uint32_t match(int8_t h2) const {
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), g)));
+    }
+    uint32_t match_empty() const {
+        return match(flat_ctrl_empty);
+    }
+    uint32_t match_empty_or_deleted() const {
+        // Empty and deleted are the only negative control bytes
+        __m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        return static_cast<uint32_t>(_mm_movemask_epi8(g));
+    }
+#else
+    uint32_t match(int8_t h2) const {
+        uint32_t m = 0;
+        for (size_t i = 0; i < flat_group_width; i++) {
+            if (ctrl[i] == h2) m |= 1u << i;
+        }
+        return m;
+    }
+    uint32_t match_empty() const {
+        return match(flat_ctrl_empty);
+    }
+    uint32_t match_empty_or_deleted() const {
+        uint32_t m = 0;
+        for (size_t i = 0; i < flat_group_width; i++) {
+            if (ctrl[i] < 0) m |= 1u << i;
+        }
+        return m;
+    }
+#endif
+};
+
+// Control bytes of a table with no storage, so lookups need no special case
+inline const int8_t* flat_empty_group() {
+    static const int8_t group[flat_group_width] = {
+        flat_ctrl_empty, flat_ctrl_empty, flat_ctrl_empty, flat_ctrl_empty,
+        flat_ctrl_empty, flat_ctrl_empty, flat_ctrl_empty, flat_ctrl_empty,
+        flat_ctrl_empty, flat_ctrl_empty, flat_ctrl_empty, flat_ctrl_empty,
+        flat_ctrl_empty, flat_ctrl_empty, flat_ctrl_empty, flat_ctrl_empty
+    };
+    return group;
+}
+
+template<typename K, typename V, typename Hash, typename Eq, typename Alloc>
+class flat_map_s {
+public:
+    typedef K key_type;
+    typedef V mapped_type;
+    typedef std::pair<const K, V> value_type;
+    typedef Alloc allocator_type;
+    typedef size_t size_type;
+    
+    template<bool Const>
+    class iter_s {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef typename flat_map_s::value_type value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef typename std::conditional<Const, const value_type, value_type>::type* pointer;
+        typedef typename std::conditional<Const, const value_type, value_type>::type& reference;
+        
+        iter_s() : ctrl(nullptr), slot(nullptr), ctrl_end(nullptr) {}
+        template<bool C, typename = typename std::enable_if<Const && !C>::type>
+        iter_s(const iter_s<C>& other) : ctrl(other.ctrl), slot(other.slot), ctrl_end(other.ctrl_end) {}
+        
+        reference operator*() const { return *slot; }
+        pointer operator->() const { return slot; }
+        iter_s& operator++() { ++ctrl; ++slot; skip_free(); return *this; }
+        iter_s operator++(int) { iter_s tmp(*this); ++(*this); return tmp; }
+        bool operator==(const iter_s& other) const { return slot == other.slot; }
+        bool operator!=(const iter_s& other) const { return slot != other.slot; }
+        
+    private:
+        friend class flat_map_s;
+        template<bool> friend class iter_s;
+        
+        const int8_t* ctrl;
+        pointer slot;
+        const int8_t* ctrl_end;
+        
+        iter_s(const int8_t* c, pointer s, const int8_t* e) : ctrl(c), slot(s), ctrl_end(e) {}
+        void skip_free() {
+            while (ctrl != ctrl_end && *ctrl < 0) { ++ctrl; ++slot; }
+        }
+    };
+    
+    typedef iter_s<false> iterator;
+    typedef iter_s<true> const_iterator;
+    
+    flat_map_s() : ctrl_(const_cast<int8_t*>(flat_empty_group())), slots_(nullptr),
+                   capacity_(0), size_(0), growth_left_(0) {}
+    
+    explicit flat_map_s(const allocator_type& alloc)
+        : ctrl_(const_cast<int8_t*>(flat_empty_group())), slots_(nullptr),
+          capacity_(0), size_(0), growth_left_(0), alloc_(alloc) {}
+    
+    flat_map_s(const flat_map_s& other)
+        : ctrl_(const_cast<int8_t*>(flat_empty_group())), slots_(nullptr),
+          capacity_(0), size_(0), growth_left_(0),
+          alloc_(std::allocator_traits<Alloc>::select_on_container_copy_construction(other.alloc_)) {
+        copy_from(other);
+    }
+    
+    flat_map_s(flat_map_s&& other) noexcept
+        : ctrl_(other.ctrl_), slots_(other.slots_), capacity_(other.capacity_),
+          size_(other.size_), growth_left_(other.growth_left_), alloc_(other.alloc_) {
+        other.reset_empty();
+    }
+    
+    // Copy and swap: if copying an element throws, this map is unchanged
+    flat_map_s& operator=(const flat_map_s& other) {
+        if (this != &other) {
+            flat_map_s tmp(alloc_);
+            tmp.copy_from(other);
+            swap(tmp);
+        }
+        return *this;
+    }
+    
+    // The allocator travels with the elements (dict_allocator propagates on
+    // move assignment), so no element is moved one by one
+    flat_map_s& operator=(flat_map_s&& other) noexcept {
+        if (this != &other) {
+            destroy_storage();
+            ctrl_ = other.ctrl_;
+            slots_ = other.slots_;
+            capacity_ = other.capacity_;
+            size_ = other.size_;
+            growth_left_ = other.growth_left_;
+            alloc_ = other.alloc_;
+            other.reset_empty();
+        }
+        return *this;
+    }
+    
+    ~flat_map_s() { destroy_storage(); }
+    
+    // Iteration
+    iterator begin() { iterator it(ctrl_, slots_, ctrl_ + capacity_); it.skip_free(); return it; }
+    iterator end() { return iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_); }
+    const_iterator begin() const { const_iterator it(ctrl_, slots_, ctrl_ + capacity_); it.skip_free(); return it; }
+    const_iterator end() const { return const_iterator(ctrl_ + capacity_, slots_ + capacity_, ctrl_ + capacity_); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+    
+    // Capacity
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+    size_t capacity() const { return capacity_; }
+    float load_factor() const { return capacity_ ? static_cast<float>(size_) / capacity_ : 0.0f; }
+    float max_load_factor() const { return 7.0f / 8.0f; }
+    allocator_type get_allocator() const { return alloc_; }
+    
+    // Makes room for `n` elements without further growth
+    void reserve(size_t n) {
+        size_t cap = capacity_for(n);
+        if (cap > capacity_) resize(cap);
+    }
+    
+    // Rebuilds the table with room for max(n, size()) elements, dropping
+    // tombstones left by erase; rehash(0) shrinks to fit
+    void rehash(size_t n) {
+        size_t cap = capacity_for(n > size_ ? n : size_);
+        if (size_ == 0 && n == 0) {
+            destroy_storage();
+            reset_empty();
+        } else if (cap != capacity_ || growth_left_ != max_growth(capacity_) - size_) {
+            resize(cap);
+        }
+    }
+    
+    void clear() {
+        if (capacity_ == 0) return;
+        for (size_t i = 0; i < capacity_; i++) {
+            if (ctrl_[i] >= 0) slots_[i].~value_type();
+        }
+        std::memset(ctrl_, static_cast<unsigned char>(flat_ctrl_empty), capacity_);
+        size_ = 0;
+        growth_left_ = max_growth(capacity_);
+    }
+    
+    // Lookup. Besides K, every lookup accepts any type Q that Hash and Eq
+    // are overloaded for (str_view_s and int32_t for key_s), so a probe never
+    // has to build a key; Hash must give equal keys equal hashes across types.
+    template<typename Q>
+    iterator find(const Q& key) {
+        size_t i = find_index(key, hash_of(key));
+        return i == npos ? end() : iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+    }
+    
+    template<typename Q>
+    const_iterator find(const Q& key) const {
+        size_t i = find_index(key, hash_of(key));
+        return i == npos ? end() : const_iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+    }
+    
+    // Same, with `hash` already computed by the table's Hash
+    template<typename Q>
+    const_iterator find(const Q& key, size_t hash) const {
+        size_t i = find_index(key, spread(hash));
+        return i == npos ? end() : const_iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+    }
+    
+    template<typename Q>
+    size_t count(const Q& key) const {
+        return find_index(key, hash_of(key)) == npos ? 0 : 1;
+    }
+    
+    template<typename Q>
+    V& at(const Q& key) {
+        size_t i = find_index(key, hash_of(key));
+        if (i == npos) throw std::out_of_range("Key not found");
+        return slots_[i].second;
+    }
+    
+    template<typename Q>
+    const V& at(const Q& key) const {
+        size_t i = find_index(key, hash_of(key));
+        if (i == npos) throw std::out_of_range("Key not found");
+        return slots_[i].second;
+    }
+    
+    // Insertion
+    V& operator[](const K& key) {
+        return emplace_key(key, hash_of(key)).first->second;
+    }
+    
+    V& operator[](K&& key) {
+        size_t hash = hash_of(key);
+        return emplace_key(std::move(key), hash).first->second;
+    }
+    
+    // Finds `key`, or inserts K(key) with a default value after a single
+    // probe; K is only constructed when the key is missing
+    template<typename Q>
+    std::pair<iterator, bool> try_emplace(const Q& key) {
+        return emplace_key(key, hash_of(key));
+    }
+    
+    // Same, with `hash` already computed by the table's Hash
+    template<typename Q>
+    std::pair<iterator, bool> try_emplace(const Q& key, size_t hash) {
+        return emplace_key(key, spread(hash));
+    }
+    
+    std::pair<iterator, bool> insert(const value_type& value) {
+        size_t hash = hash_of(value.first);
+        size_t i = find_index(value.first, hash);
+        if (i != npos) return std::make_pair(iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_), false);
+        i = prepare_insert(hash);
+        new (slots_ + i) value_type(value);
+        set_ctrl(i, hash);
+        return std::make_pair(iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_), true);
+    }
+    
+    // Erasure leaves a tombstone; other elements do not move
+    template<typename Q>
+    size_t erase(const Q& key) {
+        size_t i = find_index(key, hash_of(key));
+        if (i == npos) return 0;
+        erase_slot(i);
+        return 1;
+    }
+    
+    iterator erase(const_iterator pos) {
+        size_t i = static_cast<size_t>(pos.ctrl - ctrl_);
+        erase_slot(i);
+        iterator it(ctrl_ + i, slots_ + i, ctrl_ + capacity_);
+        it.skip_free();
+        return it;
+    }
+    
+    iterator erase(iterator pos) {
+        return erase(const_iterator(pos));
+    }
+    
+    void swap(flat_map_s& other) noexcept {
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(growth_left_, other.growth_left_);
+        std::swap(alloc_, other.alloc_);
+    }
+    
+private:
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<value_type> slot_alloc_t;
+    typedef typename std::allocator_traits<Alloc>::template rebind_alloc<int8_t> ctrl_alloc_t;
+    static const size_t npos = static_cast<size_t>(-1);
+    
+    int8_t* ctrl_;
+    value_type* slots_;
+    size_t capacity_;           // 0 or a power of two >= flat_min_capacity
+    size_t size_;
+    size_t growth_left_;        // Inserts into empty slots before the next resize
+    Alloc alloc_;
+    Hash hasher_;
+    Eq eq_;
+    
+    // Spreads the user hash over all bits: the low 7 select the control byte,
+    // the rest select the first group to probe
+    template<typename Q>
+    size_t hash_of(const Q& key) const {
+        return spread(hasher_(key));
+    }
+    
+    static size_t spread(size_t hash) {
+        uint64_t x = static_cast<uint64_t>(hash);
+        x ^= x >> 33;
+        x *= 0xff51afd7ed558ccdULL;
+        x ^= x >> 33;
+        return static_cast<size_t>(x);
+    }
+    
+    static int8_t h2(size_t hash) { return static_cast<int8_t>(hash & 0x7F); }
+    // Control bytes allocated for `cap` slots: at least one whole group
+    static size_t ctrl_bytes(size_t cap) { return cap < flat_group_width ? flat_group_width : cap; }
+    // Index of the last group, used as the probe mask
+    size_t last_group() const {
+        return capacity_ <= flat_group_width ? 0 : capacity_ / flat_group_width - 1;
+    }
+    static size_t max_growth(size_t cap) { return cap - cap / 8; }
+    
+    static size_t capacity_for(size_t n) {
+        if (n == 0) return 0;
+        size_t cap = flat_min_capacity;
+        while (max_growth(cap) < n) cap *= 2;
+        return cap;
+    }
+    
+    // Triangular probing over groups visits every group of a power-of-two table
+    template<typename Q>
+    size_t find_index(const Q& key, size_t hash) const {
+        if (capacity_ == 0) return npos;
+        size_t group_mask = last_group();
+        size_t g = (hash >> 7) & group_mask;
+        for (size_t step = 1; ; step++) {
+            flat_group group(ctrl_ + g * flat_group_width);
+            for (uint32_t m = group.match(h2(hash)); m; m &= m - 1) {
+                size_t i = g * flat_group_width + flat_ctz(m);
+                if (eq_(slots_[i].first, key)) return i;
+            }
+            if (group.match_empty()) return npos;
+            if (step > group_mask) return npos;
+            g = (g + step) & group_mask;
+        }
+    }
+    
+    // First empty or deleted slot on the probe sequence of `hash`
+    size_t find_free(size_t hash) const {
+        size_t group_mask = last_group();
+        // Small tables: ignore the padding bytes past the last slot
+        uint32_t valid = capacity_ < flat_group_width ? (1u << capacity_) - 1 : ~0u;
+        size_t g = (hash >> 7) & group_mask;
+        for (size_t step = 1; ; step++) {
+            uint32_t m = flat_group(ctrl_ + g * flat_group_width).match_empty_or_deleted() & valid;
+            if (m) return g * flat_group_width + flat_ctz(m);
+            g = (g + step) & group_mask;
+        }
+    }
+    
+    size_t prepare_insert(size_t hash) {
+        if (growth_left_ == 0) {
+            // Many tombstones: rebuild in place; otherwise double
+            size_t cap = capacity_ == 0 ? flat_min_capacity :
+                         (size_ * 2 < max_growth(capacity_) ? capacity_ : capacity_ * 2);
+            resize(cap);
+        }
+        size_t i = find_free(hash);
+        if (ctrl_[i] == flat_ctrl_empty) growth_left_--;
+        size_++;
+        return i;
+    }
+    
+    void set_ctrl(size_t i, size_t hash) { ctrl_[i] = h2(hash); }
+    
+    template<typename KK>
+    std::pair<iterator, bool> emplace_key(KK&& key, size_t hash) {
+        size_t i = find_index(key, hash);
+        if (i == npos) {
+            i = prepare_insert(hash);
+            new (slots_ + i) value_type(std::piecewise_construct,
+                                        std::forward_as_tuple(std::forward<KK>(key)),
+                                        std::forward_as_tuple());
+            set_ctrl(i, hash);
+            return std::make_pair(iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_), true);
+        }
+        return std::make_pair(iterator(ctrl_ + i, slots_ + i, ctrl_ + capacity_), false);
+    }
+    
+    void erase_slot(size_t i) {
+        slots_[i].~value_type();
+        ctrl_[i] = flat_ctrl_deleted;
+        size_--;
+    }
+    
+    // Leaves the map unchanged if either allocation throws
+    void allocate(size_t cap) {
+        ctrl_alloc_t ca(alloc_);
+        slot_alloc_t sa(alloc_);
+        int8_t* ctrl = std::allocator_traits<ctrl_alloc_t>::allocate(ca, ctrl_bytes(cap));
+        try {
+            slots_ = std::allocator_traits<slot_alloc_t>::allocate(sa, cap);
+        } catch (...) {
+            std::allocator_traits<ctrl_alloc_t>::deallocate(ca, ctrl, ctrl_bytes(cap));
+            throw;
+        }
+        ctrl_ = ctrl;
+        std::memset(ctrl_, static_cast<unsigned char>(flat_ctrl_empty), ctrl_bytes(cap));
+        capacity_ = cap;
+        growth_left_ = max_growth(cap);
+    }
+    
+    void deallocate(int8_t* ctrl, value_type* slots, size_t cap) {
+        if (cap == 0) return;
+        ctrl_alloc_t ca(alloc_);
+        slot_alloc_t sa(alloc_);
+        std::allocator_traits<ctrl_alloc_t>::deallocate(ca, ctrl, ctrl_bytes(cap));
+        std::allocator_traits<slot_alloc_t>::deallocate(sa, slots, cap);
+    }
+    
+    // Moves every element into fresh storage of capacity `cap`. Keys are
+    // const in value_type, but the old slot is destroyed right after, so
+    // moving out of it is safe.
+    void resize(size_t cap) {
+        int8_t* old_ctrl = ctrl_;
+        value_type* old_slots = slots_;
+        size_t old_cap = capacity_;
+        
+        allocate(cap);
+        for (size_t i = 0; i < old_cap; i++) {
+            if (old_ctrl[i] >= 0) {
+                size_t hash = hash_of(old_slots[i].first);
+                size_t j = find_free(hash);
+                new (slots_ + j) value_type(std::move(const_cast<K&>(old_slots[i].first)),
+                                            std::move(old_slots[i].second));
+                set_ctrl(j, hash);
+                old_slots[i].~value_type();
+            }
+        }
+        growth_left_ -= size_;
+        deallocate(old_ctrl, old_slots, old_cap);
+    }
+    
+    // Copies keep the source layout slot for slot, tombstones included. Only
+    // called on an empty map. A control byte is set once its slot holds an
+    // element, so if a copy throws, exactly the elements made so far are
+    // destroyed and the map is left empty.
+    void copy_from(const flat_map_s& other) {
+        if (other.size_ == 0) {
+            reset_empty();
+            return;
+        }
+        allocate(other.capacity_);
+        try {
+            for (size_t i = 0; i < capacity_; i++) {
+                if (other.ctrl_[i] >= 0) new (slots_ + i) value_type(other.slots_[i]);
+                ctrl_[i] = other.ctrl_[i];
+            }
+        } catch (...) {
+            destroy_storage();
+            reset_empty();
+            throw;
+        }
+        size_ = other.size_;
+        growth_left_ = other.growth_left_;
+    }
+    
+    void destroy_storage() {
+        if (capacity_ == 0) return;
+        for (size_t i = 0; i < capacity_; i++) {
+            if (ctrl_[i] >= 0) slots_[i].~value_type();
+        }
+        deallocate(ctrl_, slots_, capacity_);
+    }
+    
+    void reset_empty() {
+        ctrl_ = const_cast<int8_t*>(flat_empty_group());
+        slots_ = nullptr;
+        capacity_ = 0;
+        size_ = 0;
+        growth_left_ = 0;
+    }
+};
+
 // Value structure with generic array support
+//
+// val_s is a tagged union: `t` selects which payload member is alive and only
+// that member occupies storage, so scalar leaves (int, double, bool, null)
+// cost sizeof(val_s) and nothing else. Read the member matching `t` (check
+// with is_*() first); assign through operator= or set_type() to switch types.
+//
+// Arrays keep their elements contiguously. While every element is an int, a
+// double or a bool the array stays packed (`layout` says which member holds
+// it) and costs 8 or 1 bytes per element. Reading with int_at()/dbl_at()/
+// bool_at() never changes the layout, and neither do the const at() and
+// operator[], which return the element by value. The non-const ones hand
+// out val_s references, so they first unpack the array into the generic
+// layout.
 struct val_s {
-    json_value_types t;
-    std::shared_ptr<dict_s> obj;
-    std::string str;
-    int64_t intg;
-    double dbl;
-    bool boolean;
+    typedef std::vector<val_s, dict_allocator<val_s>> array_t;
+    typedef std::vector<int64_t, dict_allocator<int64_t>> int_array_t;
+    typedef std::vector<double, dict_allocator<double>> double_array_t;
+    typedef std::vector<uint8_t, dict_allocator<uint8_t>> bool_array_t;
     
-    // Generic array - can hold any value type
-    std::vector<std::shared_ptr<val_s>> arr;
+    json_value_types t;
+    json_array_layouts layout;          // Only meaningful when t == json_array
+    bool borrowed;                      // json_string_t held in `ref`, not `str`
+    union {
+        int64_t intg;
+        double dbl;
+        bool boolean;
+        std::string str;
+        str_view_s ref;                 // Characters owned by someone else
+        std::shared_ptr<dict_s> obj;
+        
+        // Generic array - can hold any value type
+        array_t arr;
+        
+        // Packed homogeneous arrays
+        int_array_t arr_intg;
+        double_array_t arr_dbl;
+        bool_array_t arr_bool;
+    };
     
     // Constructors
     val_s();
@@ -81,6 +841,7 @@ struct val_s {
     val_s& operator=(int64_t assign);
     val_s& operator=(int assign);  // For convenience
     val_s& operator=(const std::string& assign);
+    val_s& operator=(std::string&& assign);
     val_s& operator=(const char* assign);  // For convenience
     val_s& operator=(double assign);
     val_s& operator=(bool assign);
@@ -90,19 +851,53 @@ struct val_s {
     template<typename T>
     val_s& operator=(const std::vector<T>& assign);
     
-    // Subscript operators
-    val_s& operator[](const std::string& key);
+    // Switch the active member: destroys the old payload and default
+    // constructs the new one (0, 0.0, false, "", empty object/array).
+    // A no-op when the value already has type `nt`, except that a borrowed
+    // string becomes an empty owned one.
+    void set_type(json_value_types nt);
+    
+    // Makes this a string that views `s` without copying it; the characters
+    // must outlive the value. Copies of a borrowed string own their text.
+    void borrow(str_view_s s);
+    // Characters of a string value, owned or borrowed. Prefer this to `.str`,
+    // which is only valid when !borrowed.
+    str_view_s str_view() const { return borrowed ? ref : str_view_s(str); }
+    
+    // Subscript operators. On a const value, key lookups throw
+    // std::out_of_range for a missing key or a non-object value.
+    val_s& operator[](str_view_s key);
     val_s& operator[](int32_t i);
     val_s& operator[](size_t i);
+    const val_s& operator[](str_view_s key) const;
+    const val_s& operator[](int32_t i) const;
+    const val_s operator[](size_t i) const { return at(i); }
+    
+    // Read-only member lookups on object values; see dict_s::find()
+    val_s* find(str_view_s key);
+    const val_s* find(str_view_s key) const;
+    val_s* find(int32_t key);
+    const val_s* find(int32_t key) const;
+    bool contains(str_view_s key) const { return find(key) != nullptr; }
+    bool contains(int32_t key) const { return find(key) != nullptr; }
     
     // Array access
     val_s& at(size_t index);
-    const val_s& at(size_t index) const;
+    const val_s at(size_t index) const;   // A copy; the layout is left alone
     size_t size() const;
     void push_back(const val_s& val);
+    void push_back(val_s&& val);
     template<typename T>
     void push_back(const T& val);
     
+    // Packed-aware element reads; throw std::domain_error on a type mismatch
+    int64_t int_at(size_t index) const;
+    double dbl_at(size_t index) const;
+    bool bool_at(size_t index) const;
+    
+    // Converts a packed array to the generic layout (no-op otherwise)
+    void unpack();
+    
     // Type checking
     bool is_null() const { return t == json_null_t; }
     bool is_bool() const { return t == json_bool_t; }
@@ -114,35 +909,246 @@ struct val_s {
     
     // Destructor
     ~val_s();
+    
+private:
+    void destroy();
+    void destroy_array();
+    void construct_from(const val_s& other);
+    void construct_from(val_s&& other);
+    dict_arena* array_arena() const;
+    void set_layout(json_array_layouts l);
+    
+    template<typename T>
+    void assign_array(const std::vector<T>& items, std::integral_constant<json_array_layouts, json_array_generic>);
+    template<typename T>
+    void assign_array(const std::vector<T>& items, std::integral_constant<json_array_layouts, json_array_int>);
+    template<typename T>
+    void assign_array(const std::vector<T>& items, std::integral_constant<json_array_layouts, json_array_double>);
+    template<typename T>
+    void assign_array(const std::vector<T>& items, std::integral_constant<json_array_layouts, json_array_bool>);
+};
+
+// Packed layout a std::vector<T> is stored in
+template<typename T>
+struct val_packing {
+    static const json_array_layouts layout =
+        std::is_same<T, bool>::value ? json_array_bool :
+        std::is_integral<T>::value ? json_array_int :
+        std::is_floating_point<T>::value ? json_array_double :
+        json_array_generic;
+};
+
+// Immutable, reference-counted key string. Every key_s interned from the same
+// key_pool_s shares one atom, so equal long keys compare by pointer and hash
+// without touching the characters. The characters follow the header in the
+// same allocation.
+struct key_atom_s {
+    std::atomic<uint32_t> refs;
+    uint32_t size;
+    uint64_t hash;                       // dict_hash_bytes(data(), size)
+    
+    const char* data() const { return reinterpret_cast<const char*>(this + 1); }
+    
+    static key_atom_s* create(str_view_s s);   // Returns an atom with one reference
+    void retain() { refs.fetch_add(1, std::memory_order_relaxed); }
+    void release();
 };
 
-// Key structure
+// Key structure. String keys of up to inline_capacity bytes are stored in
+// place; longer ones hold a reference to a key_atom_s. In both cases the
+// 16-byte buffer identifies the key, so equality is a fixed-size compare.
 struct key_s {
+    static const size_t inline_capacity = 15;
+    
     json_key_types t;
-    std::string str;
     int32_t intg;
     
-    key_s() : t(json_k_string_t), intg(0) {}
+    key_s() : t(json_k_string_t), intg(0) { std::memset(buf_, 0, sizeof(buf_)); }
+    explicit key_s(str_view_s s);
+    explicit key_s(int32_t i) : t(json_k_integer_t), intg(i) { std::memset(buf_, 0, sizeof(buf_)); }
+    explicit key_s(key_atom_s* atom);    // Shares `atom`, taking a new reference
+    key_s(const key_s& other);
+    key_s(key_s&& other) noexcept;
+    key_s& operator=(const key_s& other);
+    key_s& operator=(key_s&& other) noexcept;
+    ~key_s() { release_atom(); }
+    
+    // Characters of a string key; empty for integer keys
+    str_view_s str() const;
+    // The same characters copied into a std::string, as the `str` member of
+    // earlier releases held them
+    std::string to_string() const { return str().to_string(); }
+    // Same value json_key_hash gives for str(); precomputed for atoms
+    uint64_t hash() const;
+    // Shared atom of a long key, nullptr for inline and integer keys
+    key_atom_s* atom() const;
+    bool is_inline() const { return static_cast<unsigned char>(buf_[inline_capacity]) != atom_tag; }
+    
+    friend bool operator==(const key_s& first, const key_s& second);
+    
+private:
+    static const unsigned char atom_tag = 0xFF;   // Stored in the length byte
+    
+    // Inline: bytes, zero padding, length in the last byte.
+    // Atom:   key_atom_s* in the first bytes, atom_tag in the last byte.
+    char buf_[16];
+    
+    void set_atom(key_atom_s* atom);
+    void release_atom();
 };
 
-// Hash function for keys
+// Hash function for keys. The str_view_s and int32_t overloads hash exactly
+// like the equivalent key_s, so the map can be probed without building a key.
 struct json_key_hash {
     std::size_t operator()(const key_s& k) const;
+    std::size_t operator()(str_view_s s) const;
+    std::size_t operator()(int32_t i) const;
+};
+
+// Key equality, with the same heterogeneous overloads as json_key_hash
+struct json_key_equal {
+    bool operator()(const key_s& a, const key_s& b) const;
+    bool operator()(const key_s& a, str_view_s b) const;
+    bool operator()(const key_s& a, int32_t b) const;
+};
+
+// Interns long string keys: each distinct name gets one atom, shared by every
+// key_s the pool hands out for it. Keys short enough to live inline never
+// enter the pool. Not thread-safe; use one pool per parsing thread.
+class key_pool_s {
+public:
+    key_s intern(str_view_s s);
+    size_t size() const { return atoms.size(); }
+    // Drops the pool's references; keys already handed out stay valid
+    void clear() { atoms.clear(); }
+    
+private:
+    flat_map_s<key_s, char, json_key_hash, json_key_equal,
+               std::allocator<std::pair<const key_s, char>>> atoms;
+};
+
+// Destination for dump_to(): a file descriptor, a FILE*, a std::ostream or
+// a callback. The callback returns false to report an error, which stops the
+// dump. The serializer hands over chunks of about chunk_size bytes.
+class dict_sink_s {
+public:
+    typedef std::function<bool(const char* data, size_t size)> callback_t;
+    
+    size_t chunk_size;
+    
+    dict_sink_s(int fd);
+    dict_sink_s(FILE* file);
+    dict_sink_s(std::ostream& os);
+    dict_sink_s(callback_t callback);
+    
+    bool write(const char* data, size_t size) const { return callback(data, size); }
+    
+private:
+    callback_t callback;
+};
+
+// Why a file could not be loaded or saved. For parse errors, `offset` is the
+// byte offset in the file where parsing stopped, and `line`/`column` (1-based,
+// columns counted in bytes) locate it; `sys_errno` is set for I/O errors.
+struct json_error_s {
+    std::string message;
+    size_t offset;
+    size_t line;
+    size_t column;
+    int sys_errno;
+    
+    json_error_s() : offset(0), line(0), column(0), sys_errno(0) {}
+};
+
+// Read-only view of a whole file. Regular files are memory-mapped, with
+// sequential readahead requested from the kernel, so parsing reads the page
+// cache directly instead of a private copy. Pipes and other special files,
+// and platforms without mmap, are read into a buffer instead. The view is
+// valid until close() or destruction.
+class dict_mapped_file_s {
+public:
+    dict_mapped_file_s() : data_(""), size_(0), mapped(false) {}
+    ~dict_mapped_file_s() { close(); }
+    
+    bool open(const std::string& path, json_error_s* error = nullptr);
+    void close();
+    
+    const char* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool is_mapped() const { return mapped; }
+    
+private:
+    const char* data_;
+    size_t size_;
+    bool mapped;
+    std::string buffer;                  // Contents when not mapped
+    
+    dict_mapped_file_s(const dict_mapped_file_s&);
+    dict_mapped_file_s& operator=(const dict_mapped_file_s&);
+};
+
+// Output buffer of the serializer. Values are formatted straight into `buf`
+// (integers and doubles without going through iostreams), and dump() returns
+// it by move. With a sink, the buffer is flushed whenever it fills a chunk,
+// so memory stays bounded by the chunk size plus the largest single string.
+class json_writer_s {
+public:
+    std::string buf;
+    
+    json_writer_s() : sink(nullptr), failed(false) {}
+    explicit json_writer_s(const dict_sink_s& s) : sink(&s), failed(false) {
+        buf.reserve(s.chunk_size + 64);
+    }
+    
+    void put(char c) { buf.push_back(c); }
+    void write(const char* p, size_t n) { buf.append(p, n); }
+    void write(str_view_s s) { buf.append(s.data, s.size); }
+    void write_int(int64_t v);
+    void write_uint(uint64_t v);
+    void write_double(double v);          // Shortest form that round-trips
+    void write_string(str_view_s s);      // Quoted, with JSON escapes
+    void write_newline(int spaces);       // '\n' followed by indentation
+    
+    // Called between values: hands a full chunk to the sink, if any
+    void maybe_flush() {
+        if (sink && buf.size() >= sink->chunk_size) flush();
+    }
+    // Writes out everything buffered; false once the sink has failed
+    bool flush();
+    
+private:
+    const dict_sink_s* sink;
+    bool failed;                          // Later output is discarded
 };
 
+// Serializes `val` at nesting `level`; indent < 0 gives compact output
+void json_write_value(json_writer_s& w, const val_s& val, int indent, int level);
+
 // Dictionary structure
 struct dict_s {
+    typedef dict_allocator<std::pair<const key_s, val_s>> allocator_type;
 #ifdef JSON_ORDERED
-    typedef std::map<key_s, val_s> map_t;
+    typedef std::map<key_s, val_s, std::less<key_s>, allocator_type> map_t;
 #else
-    typedef std::unordered_map<key_s, val_s, json_key_hash> map_t;
+    typedef flat_map_s<key_s, val_s, json_key_hash, json_key_equal, allocator_type> map_t;
 #endif
     
+    // Copies share the map until one of them writes: non-const operator[]
+    // and find() call detach() first, which copies the map if it is shared.
+    // Copying a map copies the dicts of its object values, which share their
+    // maps in turn, so a write copies only the maps on the path to the value
+    // written. A dict that has handed out a reference into its map is marked
+    // `leaked`, and its copies copy the map at once so that later writes
+    // through the reference cannot show through them; set() stores a value
+    // without handing one out. Maps in an arena are always copied to the
+    // heap. Code that writes through `obj` directly must call detach() itself.
     std::shared_ptr<map_t> obj;
     bool valid;
+    bool leaked;                         // References into `obj` may be live
     
     // Constructors
     dict_s();
+    explicit dict_s(dict_arena* arena);      // Empty dict whose map lives in `arena`
     dict_s(const std::string& json_str);    // JSON parsing constructor
     dict_s(const dict_s& other);             // Copy constructor
     dict_s(dict_s&& other) noexcept;         // Move constructor
@@ -151,568 +1157,7943 @@ struct dict_s {
     dict_s& operator=(const dict_s& other);        // Copy assignment
     dict_s& operator=(dict_s&& other) noexcept;    // Move assignment
     
-    // Subscript operators
-    val_s& operator[](const std::string& s);
+    // Subscript operators. The non-const forms insert a null value for a
+    // missing key; the const forms throw std::out_of_range instead.
+    val_s& operator[](str_view_s s);
     val_s& operator[](int32_t i);
+    const val_s& operator[](str_view_s s) const;
+    const val_s& operator[](int32_t i) const;
+    // Inserts with a prebuilt key, e.g. one interned by a key_pool_s
+    val_s& operator[](const key_s& k);
+    // Stores `value` under `key`. No reference escapes, so unlike operator[]
+    // this keeps the dict's copies O(1).
+    void set(str_view_s key, val_s value);
+    void set(int32_t key, val_s value);
+    void set(const key_s& key, val_s value);
+    template<typename T>
+    void set(str_view_s key, const T& value) { val_s v; v = value; set(key, std::move(v)); }
+    template<typename T>
+    void set(int32_t key, const T& value) { val_s v; v = value; set(key, std::move(v)); }
+    
+    // Read-only lookups: never insert and never allocate, except that the
+    // non-const find() detaches a map shared with a copy. find() returns
+    // nullptr for a missing key, get() throws std::out_of_range.
+    val_s* find(str_view_s key);
+    const val_s* find(str_view_s key) const;
+    val_s* find(int32_t key);
+    const val_s* find(int32_t key) const;
+    bool contains(str_view_s key) const { return find(key) != nullptr; }
+    bool contains(int32_t key) const { return find(key) != nullptr; }
+    const val_s& get(str_view_s key) const { return (*this)[key]; }
+    const val_s& get(int32_t key) const { return (*this)[key]; }
+    
+    // Gives this dict a map of its own, copying it if another dict shares
+    // it, and marks it leaked
+    void detach();
+    // detach() on every dict in the tree
+    void detach_all();
     
     // JSON parsing
     bool parse(const std::string& json_str);
+    // Parses with `threads` workers (0 = hardware concurrency). A parallel
+    // pre-scan finds the outermost container spanning most of the input;
+    // its members or elements are cut into slices, parsed concurrently and
+    // stitched in order. The result is the same as parse(). Inputs under
+    // 1 MB, and inputs the pre-scan finds malformed, are parsed sequentially.
+    bool parse_parallel(const std::string& json_str, size_t threads = 0);
+    bool parse_parallel(const char* data, size_t size, size_t threads);
+    // Replaces the contents with the document in `path`, parsed straight from
+    // a memory mapping of the file. On failure `valid` is false and `error`,
+    // if given, says why and where.
+    bool load_file(const std::string& path, json_error_s* error = nullptr);
+    // Replaces the contents with a document in the binary format written by
+    // dump_binary(); false, with `valid` cleared, if the bytes are malformed
+    bool parse_binary(const std::string& data) { return parse_binary(data.data(), data.size()); }
+    bool parse_binary(const char* data, size_t size);
+    // Replaces the contents with a MessagePack or CBOR message whose
+    // top-level item is a map. Integer map keys in int32 range become integer
+    // keys; see wire_decoder_s for messages that arrive in pieces.
+    bool parse_msgpack(const std::string& data) { return parse_msgpack(data.data(), data.size()); }
+    bool parse_msgpack(const char* data, size_t size);
+    bool parse_cbor(const std::string& data) { return parse_cbor(data.data(), data.size()); }
+    bool parse_cbor(const char* data, size_t size);
     
     // Optimized serialization
     std::string dump(int indent = -1) const;
-    void dump_internal(std::ostringstream& oss, int indent, int current_level) const;
+    // Streams the document to `sink` chunk by chunk, never holding the whole
+    // text in memory; false if the sink reported an error
+    bool dump_to(const dict_sink_s& sink, int indent = -1) const;
+    // Streams the document into `path`, creating or truncating it
+    bool save_file(const std::string& path, int indent = -1, json_error_s* error = nullptr) const;
+    // Binary encoding (see bin_doc_s): keeps integer keys, the int/double
+    // distinction and packed array layouts, with a fixed byte order
+    std::string dump_binary() const;
+    // MessagePack / CBOR encodings, with integer keys as integer map keys and
+    // doubles as floats (4 bytes when exact, else 8)
+    std::string dump_msgpack() const;
+    std::string dump_cbor() const;
+    // Immutable copy with perfect-hash lookups; see frozen_dict_s
+    frozen_dict_s freeze() const;
+    void dump_internal(json_writer_s& w, int indent, int current_level) const;
     
     // Destructor
     ~dict_s();
 };
 
+// Parsed document that owns an arena: every map, array and nested object
+// created while parsing is carved out of it and released in one shot when the
+// document is destroyed or re-parsed. Values moved out of `root` still point
+// into the arena and must not outlive the document; copy them instead
+// (copies always allocate from the heap).
+struct doc_s {
+    std::unique_ptr<dict_arena> arena;   // Declared first: destroyed after root
+    key_pool_s keys;                     // Long keys, shared across re-parses
+    std::unique_ptr<dict_mapped_file_s> file;  // Input of load_file(), outlives root
+    dict_s root;
+    bool valid;
+    
+    doc_s();
+    explicit doc_s(const std::string& json_str);
+    doc_s(doc_s&& other) noexcept;
+    doc_s& operator=(doc_s&& other) noexcept;
+    
+    // Parses into a fresh root, reusing the arena's memory
+    bool parse(const std::string& json_str);
+    // Zero-copy parsing for input that outlives the document: string values
+    // are views into `json` (see val_s::str_view()) rather than copies.
+    // parse_borrowed decodes escaped strings into the arena; parse_insitu
+    // decodes them in place, overwriting parts of `json`.
+    bool parse_borrowed(const char* json, size_t size);
+    bool parse_insitu(char* json, size_t size);
+    // Maps `path` and parses it with borrowed strings: string values point
+    // into the mapping, which the document keeps until it is re-parsed
+    bool load_file(const std::string& path, json_error_s* error = nullptr);
+    
+    val_s& operator[](str_view_s s) { return root[s]; }
+    val_s& operator[](int32_t i) { return root[i]; }
+    const val_s* find(str_view_s s) const { return root.find(s); }
+    const val_s* find(int32_t i) const { return root.find(i); }
+    std::string dump(int indent = -1) const { return root.dump(indent); }
+    bool dump_to(const dict_sink_s& sink, int indent = -1) const { return root.dump_to(sink, indent); }
+    bool save_file(const std::string& path, int indent = -1, json_error_s* error = nullptr) const {
+        return root.save_file(path, indent, error);
+    }
+    
+private:
+    void reset_root();
+    
+    doc_s(const doc_s&);                 // Non-copyable, copy `root` instead
+    doc_s& operator=(const doc_s&);
+};
+
 typedef dict_s dict_t;
 typedef val_s val_t;
 typedef key_s dict_key_t;
+typedef doc_s dict_doc_t;
+
+// Comparison operators
+#ifdef JSON_ORDERED
+bool operator<(const key_s& first, const key_s& second);
+#endif
+
+// Stream operators
+std::ostream& operator<<(std::ostream& os, const dict_t& dict);
+std::ostream& operator<<(std::ostream& os, const val_t& val);
+std::ostream& operator<<(std::ostream& os, const dict_key_t& k);
+
+// Template implementations for generic arrays
+
+template<typename T>
+val_s& val_s::operator=(const std::vector<T>& assign) {
+    set_type(json_array);
+    set_layout(val_packing<T>::layout);
+    assign_array(assign, std::integral_constant<json_array_layouts, val_packing<T>::layout>());
+    return *this;
+}
+
+template<typename T>
+void val_s::assign_array(const std::vector<T>& items, std::integral_constant<json_array_layouts, json_array_generic>) {
+    arr.clear();
+    arr.reserve(items.size());
+    for (const auto& item : items) {
+        arr.emplace_back();
+        arr.back() = item;
+    }
+}
+
+template<typename T>
+void val_s::assign_array(const std::vector<T>& items, std::integral_constant<json_array_layouts, json_array_int>) {
+    arr_intg.assign(items.begin(), items.end());
+}
+
+template<typename T>
+void val_s::assign_array(const std::vector<T>& items, std::integral_constant<json_array_layouts, json_array_double>) {
+    arr_dbl.assign(items.begin(), items.end());
+}
+
+template<typename T>
+void val_s::assign_array(const std::vector<T>& items, std::integral_constant<json_array_layouts, json_array_bool>) {
+    arr_bool.assign(items.begin(), items.end());
+}
+
+template<typename T>
+void val_s::push_back(const T& val) {
+    val_s v;
+    v = val;
+    push_back(std::move(v));
+}
+
+// JSON Parser class
+// How the parser stores string values. The zero-copy modes leave views into
+// the input in val_s::ref, so the input must outlive the parsed values.
+typedef enum {
+    json_strings_copy,           // Owned std::string per value
+    json_strings_borrow,         // Views; escaped strings are decoded into the arena
+    json_strings_insitu          // Views; escaped strings are decoded in place
+} json_string_modes;
+
+class JSONParser {
+private:
+    const char* begin;
+    const char* cursor;
+    const char* end;
+    dict_arena* arena;
+    key_pool_s* pool;
+    key_pool_s local_pool;       // Used when the caller supplies no pool
+    json_string_modes mode;
+    std::string key_buf;         // Scratch for unescaping keys and borrowed strings
+    const char* splice_at;       // See splice()
+    const char* splice_end;
+    val_s* splice_val;
+    
+    std::shared_ptr<dict_s> make_dict();
+    void skip_whitespace();
+    bool parse_value(val_s& val);
+    bool parse_object(dict_s& dict);
+    bool parse_member(dict_s& dict);
+    bool parse_array(val_s& val);
+    bool parse_string(std::string& str);
+    bool parse_borrowed_string(val_s& val);
+    bool parse_unicode_escape(uint32_t& cp);
+    bool parse_number(val_s& val);
+    bool parse_literal(val_s& val);
+    
+    // Struct fields (see parse_struct). A null member leaves the field as is,
+    // except in val_s fields, which take the null.
+    struct field_matcher_s;
+    bool parse_null();
+    bool parse_field(bool& out);
+    bool parse_field(std::string& out);
+    bool parse_field(val_s& out) { return parse_value(out); }
+    bool parse_field(dict_s& out);
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value, bool>::type parse_field(T& out);
+    template<typename T>
+    typename std::enable_if<std::is_floating_point<T>::value, bool>::type parse_field(T& out);
+    template<typename T>
+    typename std::enable_if<std::is_class<T>::value, bool>::type parse_field(T& out);
+    template<typename T>
+    bool parse_field(std::vector<T>& out);
+    
+public:
+    JSONParser(const std::string& json, dict_arena* arena = nullptr, key_pool_s* pool = nullptr);
+    // With json_strings_insitu, `data` must be writable: escaped strings are
+    // rewritten in place (they only ever shrink)
+    JSONParser(const char* data, size_t size, dict_arena* arena, key_pool_s* pool,
+               json_string_modes mode);
+    bool parse(dict_s& dict);
+    bool parse(val_s& val);
+    // Parses an object straight into a struct described with DICT_FIELDS,
+    // without building a dict_s. Members are matched to fields by name,
+    // members the struct does not have are validated and skipped without
+    // allocating, and fields without a member keep their value.
+    template<typename T>
+    bool parse_struct(T& out);
+    // Byte offset where parsing stopped; after a failure, at or just past
+    // the offending input
+    size_t offset() const { return static_cast<size_t>(cursor - begin); }
+    
+    // The contents of an object or array without the brackets: one or more
+    // members or elements separated by commas, filling the whole input.
+    // Used by dict_s::parse_parallel on slices of a large container.
+    bool parse_members(dict_s& dict);
+    bool parse_elements(val_s& val);
+    // When a value starts at `at`, moves *val in instead of parsing it and
+    // resumes at `after`; the caller has already parsed that value
+    void splice(const char* at, const char* after, val_s* val) {
+        splice_at = at;
+        splice_end = after;
+        splice_val = val;
+    }
+};
+
+// Compile-time field mapping for JSONParser::parse_struct() and
+// json_write_struct(). At namespace scope, in the struct's namespace:
+//
+//     struct point_s { int64_t x; double y; std::string label; };
+//     DICT_FIELDS(point_s, x, y, label)
+//
+// Fields may be bool, integers, floating point, std::string, val_s,
+// dict_s, other mapped structs and std::vectors of any of these. The JSON
+// member names are the field names. Up to 32 fields.
+#define DICT_FIELDS(type, ...) \
+    template<typename V> \
+    inline void dict_visit_fields(type& dict_obj, V& dict_visit) { \
+        DICT_FIELDS_FOR_EACH(DICT_FIELDS_VISIT, __VA_ARGS__) \
+    } \
+    template<typename V> \
+    inline void dict_visit_fields(const type& dict_obj, V& dict_visit) { \
+        DICT_FIELDS_FOR_EACH(DICT_FIELDS_VISIT, __VA_ARGS__) \
+    }
+
+#define DICT_FIELDS_VISIT(field) dict_visit(str_view_s(#field, sizeof(#field) - 1), dict_obj.field);
+#define DICT_FIELDS_EXPAND(x) x
+#define DICT_FIELDS_FOR_EACH(f, ...) \
+    DICT_FIELDS_EXPAND(DICT_FIELDS_PICK(__VA_ARGS__, \
+        DICT_FIELDS_32, DICT_FIELDS_31, DICT_FIELDS_30, DICT_FIELDS_29, DICT_FIELDS_28, DICT_FIELDS_27, \
+        DICT_FIELDS_26, DICT_FIELDS_25, DICT_FIELDS_24, DICT_FIELDS_23, DICT_FIELDS_22, DICT_FIELDS_21, \
+        DICT_FIELDS_20, DICT_FIELDS_19, DICT_FIELDS_18, DICT_FIELDS_17, DICT_FIELDS_16, DICT_FIELDS_15, \
+        DICT_FIELDS_14, DICT_FIELDS_13, DICT_FIELDS_12, DICT_FIELDS_11, DICT_FIELDS_10, DICT_FIELDS_9, \
+        DICT_FIELDS_8, DICT_FIELDS_7, DICT_FIELDS_6, DICT_FIELDS_5, DICT_FIELDS_4, DICT_FIELDS_3, \
+        DICT_FIELDS_2, DICT_FIELDS_1)(f, __VA_ARGS__))
+#define DICT_FIELDS_PICK( \
+    _1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, \
+    _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, \
+    name, ...) name
+#define DICT_FIELDS_1(f, x) f(x)
+#define DICT_FIELDS_2(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_1(f, __VA_ARGS__))
+#define DICT_FIELDS_3(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_2(f, __VA_ARGS__))
+#define DICT_FIELDS_4(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_3(f, __VA_ARGS__))
+#define DICT_FIELDS_5(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_4(f, __VA_ARGS__))
+#define DICT_FIELDS_6(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_5(f, __VA_ARGS__))
+#define DICT_FIELDS_7(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_6(f, __VA_ARGS__))
+#define DICT_FIELDS_8(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_7(f, __VA_ARGS__))
+#define DICT_FIELDS_9(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_8(f, __VA_ARGS__))
+#define DICT_FIELDS_10(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_9(f, __VA_ARGS__))
+#define DICT_FIELDS_11(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_10(f, __VA_ARGS__))
+#define DICT_FIELDS_12(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_11(f, __VA_ARGS__))
+#define DICT_FIELDS_13(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_12(f, __VA_ARGS__))
+#define DICT_FIELDS_14(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_13(f, __VA_ARGS__))
+#define DICT_FIELDS_15(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_14(f, __VA_ARGS__))
+#define DICT_FIELDS_16(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_15(f, __VA_ARGS__))
+#define DICT_FIELDS_17(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_16(f, __VA_ARGS__))
+#define DICT_FIELDS_18(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_17(f, __VA_ARGS__))
+#define DICT_FIELDS_19(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_18(f, __VA_ARGS__))
+#define DICT_FIELDS_20(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_19(f, __VA_ARGS__))
+#define DICT_FIELDS_21(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_20(f, __VA_ARGS__))
+#define DICT_FIELDS_22(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_21(f, __VA_ARGS__))
+#define DICT_FIELDS_23(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_22(f, __VA_ARGS__))
+#define DICT_FIELDS_24(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_23(f, __VA_ARGS__))
+#define DICT_FIELDS_25(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_24(f, __VA_ARGS__))
+#define DICT_FIELDS_26(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_25(f, __VA_ARGS__))
+#define DICT_FIELDS_27(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_26(f, __VA_ARGS__))
+#define DICT_FIELDS_28(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_27(f, __VA_ARGS__))
+#define DICT_FIELDS_29(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_28(f, __VA_ARGS__))
+#define DICT_FIELDS_30(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_29(f, __VA_ARGS__))
+#define DICT_FIELDS_31(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_30(f, __VA_ARGS__))
+#define DICT_FIELDS_32(f, x, ...) f(x) DICT_FIELDS_EXPAND(DICT_FIELDS_31(f, __VA_ARGS__))
+
+// Serializes a struct described with DICT_FIELDS as a JSON object, laid out
+// as dict_s::dump() would lay out the same members
+template<typename T>
+void json_write_struct(json_writer_s& w, const T& obj, int indent, int level);
+template<typename T>
+std::string dict_dump_struct(const T& obj, int indent = -1);
+// Parses `json` into `out` with JSONParser::parse_struct()
+template<typename T>
+bool dict_parse_struct(const std::string& json, T& out);
+
+// Result of json_push_parser_s::feed()
+typedef enum {
+    json_push_more,              // Needs more input
+    json_push_done,              // The root object is complete
+    json_push_error              // Malformed input; see offset()
+} json_push_status;
+
+// Resumable parser for input that arrives in pieces. Each feed() parses as
+// far as the bytes allow and keeps its position on an explicit stack of open
+// containers, so no call ever waits for or re-reads earlier input; only a
+// string, number or literal cut by a chunk boundary is buffered until it
+// completes. The grammar and the resulting dict_s are the same as
+// JSONParser's. Bytes after the root object's closing brace are not
+// consumed.
+class json_push_parser_s {
+public:
+    dict_s root;
+    
+    json_push_parser_s() { reset(); }
+    
+    json_push_status feed(const char* data, size_t size);
+    json_push_status feed(const std::string& chunk) { return feed(chunk.data(), chunk.size()); }
+    json_push_status status() const { return state; }
+    // Bytes consumed so far; on error, the offset of the offending byte
+    size_t offset() const { return consumed; }
+    // Starts over with an empty root, keeping the interned keys
+    void reset();
+    
+private:
+    enum expect_e : uint8_t {
+        expect_first_key,        // After '{'
+        expect_key,              // After ',' in an object
+        expect_colon,
+        expect_value,            // After ':' or ',' in an array
+        expect_first_value,      // After '['
+        expect_next              // After a value: ',' or the closing bracket
+    };
+    enum token_e : uint8_t { token_none, token_string, token_number, token_literal };
+    
+    // One open object or array
+    struct frame_s {
+        val_s value;             // The array, or the object holding `dict`
+        dict_s* dict;            // Object being filled; nullptr for arrays
+        key_s key;               // Key of the member being parsed
+        expect_e expect;
+    };
+    
+    std::vector<frame_s> stack;
+    json_push_status state;
+    size_t consumed;
+    token_e token;               // Token cut by the end of the last chunk
+    bool token_escape;           // ... which ended on a backslash
+    size_t token_offset;         // Where it started, for errors
+    std::string pending;         // Its bytes so far
+    std::string scratch;
+    key_pool_s pool;
+    
+    const char* scan_token(const char* p, const char* end, bool resumed);
+    bool finish_token(const char* begin, const char* end);
+    void deliver(val_s&& val);
+    void open(bool is_object);
+    void close();
+};
+
+class lazy_doc_s;
+
+// Handle to one value inside a lazy_doc_s: its byte range in the input and,
+// for objects and arrays, its slot in the document's structural index.
+// Handles are cheap to copy and valid for as long as the document. A
+// default-constructed (empty) handle is what find() returns for a miss.
+class lazy_val_s {
+public:
+    lazy_val_s() : doc(nullptr), begin(0), end(0), node(0) {}
+    explicit operator bool() const { return doc != nullptr; }
+    
+    json_value_types type() const;       // json_null_t for an empty handle
+    bool is_object() const { return doc && type() == json_object_t; }
+    bool is_array() const { return doc && type() == json_array; }
+    
+    // Object members; operator[] throws std::out_of_range when the key is
+    // missing or the value is not an object, find() returns an empty handle
+    lazy_val_s operator[](str_view_s key) const;
+    lazy_val_s operator[](int32_t key) const;
+    lazy_val_s find(str_view_s key) const;
+    lazy_val_s find(int32_t key) const;
+    bool contains(str_view_s key) const { return static_cast<bool>(find(key)); }
+    
+    // Array elements; throws std::out_of_range past the end or on non-arrays
+    lazy_val_s at(size_t index) const;
+    lazy_val_s operator[](size_t index) const { return at(index); }
+    size_t size() const;                 // Members or elements, 0 for scalars
+    
+    // The value, parsed on first use and cached in the document. Strings
+    // borrow from the document's copy of the input.
+    const val_s& get() const;
+    // Independent, heap-owned dict_s of an object value (std::domain_error
+    // otherwise), as dict_t(raw()) would build it
+    dict_s to_dict() const;
+    // The value's JSON text
+    str_view_s raw() const;
+    
+private:
+    friend class lazy_doc_s;
+    
+    const lazy_doc_s* doc;
+    size_t begin;                        // Offsets into the document's text
+    size_t end;
+    size_t node;                         // Index slot of an object or array
+};
+
+// Lazily materialized document for reading a few fields out of large
+// payloads. Construction keeps a copy of the input and makes one validating
+// pass that records where each object and array ends, so lookups can step
+// over whole subtrees. An object's member table and a value's val_s are
+// only built when first reached, then cached. Not thread-safe, even for
+// concurrent reads, since lookups fill the caches. Neither copyable nor
+// movable: handles point at the document. Unlike JSONParser, which stops at
+// the root object's closing brace, the validating pass rejects anything but
+// whitespace after the root value.
+class lazy_doc_s {
+public:
+    bool valid;
+    
+    explicit lazy_doc_s(const std::string& json);
+    explicit lazy_doc_s(std::string&& json);
+    
+    lazy_val_s root() const;             // Empty when !valid
+    lazy_val_s operator[](str_view_s key) const { return root()[key]; }
+    lazy_val_s operator[](int32_t key) const { return root()[key]; }
+    lazy_val_s find(str_view_s key) const { return root().find(key); }
+    lazy_val_s find(int32_t key) const { return root().find(key); }
+    dict_s to_dict() const { return root().to_dict(); }
+    
+    // Object and array member tables built so far
+    size_t indexed_containers() const { return tables.size(); }
+    
+private:
+    friend class lazy_val_s;
+    static const size_t npos = static_cast<size_t>(-1);
+    
+    struct node_s {
+        size_t end;                      // Offset just past the closing bracket
+        size_t next;                     // First node after this subtree
+        size_t count;                    // Members or elements
+    };
+    
+    // Children of one object or array, in document order. Objects are
+    // searched linearly, which beats hashing every key when only a few are
+    // read; an object with more than hash_after keys gets a hash index once
+    // it has been searched more than hash_after times.
+    struct table_s {
+        static const size_t hash_after = 8;
+        
+        std::vector<key_s> keys;         // Objects only, parallel to items
+        std::vector<lazy_val_s> items;
+        flat_map_s<key_s, size_t, json_key_hash, json_key_equal,
+                   std::allocator<std::pair<const key_s, size_t>>> index;
+        size_t lookups;
+        
+        table_s() : lookups(0) {}
+        template<typename Q>
+        lazy_val_s find(const Q& key);
+        void build_index();
+        // Distinct members (duplicate keys count once) or elements
+        size_t size() {
+            if (keys.empty()) return items.size();
+            build_index();
+            return index.size();
+        }
+    };
+    
+    std::string text;
+    std::vector<node_s> nodes;           // Objects and arrays in document order
+    size_t root_begin;
+    size_t root_end;
+    std::unique_ptr<dict_arena> arena;   // Declared before the caches it backs
+    mutable key_pool_s keys;
+    mutable std::unordered_map<size_t, table_s> tables;     // By node
+    mutable std::unordered_map<size_t, val_s> values;       // By begin offset
+    
+    void build_index();
+    const char* index_value(const char* p, const char* end);
+    table_s& table(const lazy_val_s& v) const;
+    lazy_val_s make(size_t begin, size_t end, size_t node) const;
+    
+    lazy_doc_s(const lazy_doc_s&);
+    lazy_doc_s& operator=(const lazy_doc_s&);
+};
+
+typedef lazy_doc_s dict_lazy_t;
+
+// Entry types of a json_tape_s, stored in the top byte of each tape word
+typedef enum {
+    json_tape_object = '{',      // Payload: index after the matching '}', count << 32
+    json_tape_object_end = '}',  // Payload: index of the matching '{'
+    json_tape_array = '[',
+    json_tape_array_end = ']',
+    json_tape_string = '"',      // Payload: offset in json_tape_s::strings
+    json_tape_int = 'l',         // Value in the next word
+    json_tape_double = 'd',      // Value (bit pattern) in the next word
+    json_tape_true = 't',
+    json_tape_false = 'f',
+    json_tape_null = 'n'
+} json_tape_types;
+
+class json_tape_s;
+
+// Handle to one value on a json_tape_s; valid until the tape is re-parsed.
+// Lookups mirror lazy_val_s, and the scalar accessors throw
+// std::domain_error on a type mismatch.
+class tape_val_s {
+public:
+    tape_val_s() : tape(nullptr), index(0) {}
+    tape_val_s(const json_tape_s* t, size_t i) : tape(t), index(i) {}
+    explicit operator bool() const { return tape != nullptr; }
+    
+    json_value_types type() const;       // json_null_t for an empty handle
+    bool is_object() const { return tape && type() == json_object_t; }
+    bool is_array() const { return tape && type() == json_array; }
+    
+    tape_val_s operator[](str_view_s key) const;
+    tape_val_s operator[](int32_t key) const;
+    tape_val_s find(str_view_s key) const;
+    tape_val_s find(int32_t key) const;
+    bool contains(str_view_s key) const { return static_cast<bool>(find(key)); }
+    tape_val_s at(size_t index) const;
+    tape_val_s operator[](size_t index) const { return at(index); }
+    size_t size() const;                 // Members (duplicates included) or elements
+    
+    int64_t intg() const;
+    double dbl() const;                  // Integers are converted
+    bool boolean() const;
+    str_view_s str_view() const;         // Points into the tape's string buffer
+    
+    // Heap-owned copies, as the recursive parser would build them
+    val_s to_val() const;
+    dict_s to_dict() const;              // std::domain_error unless an object
+    
+    size_t tape_index() const { return index; }
+    
+private:
+    const json_tape_s* tape;
+    size_t index;
+    
+    size_t next() const;                 // Tape index after this value
+};
+
+// Two-stage parser producing a flat tape, for bulk ingest.
+//   Stage 1 classifies the input 64 bytes at a time with SIMD and records
+//   the offset of every structural character ({}[]:,) and of the first byte
+//   of every string and scalar outside strings.
+//   Stage 2 walks that index once, checks the grammar (the same one as
+//   JSONParser, integer keys included) and appends one tagged 64-bit word per
+//   value, two for numbers. Strings are unescaped into `strings`.
+// Unlike JSONParser, which stops at the root object's closing brace, the
+// tape rejects anything but whitespace after the root value.
+// Containers on the tape know where they end, so queries step over whole
+// subtrees. Buffers are reused across parse() calls.
+class json_tape_s {
+public:
+    bool valid;
+    std::vector<uint64_t> tape;          // Type in the top byte, payload below
+    std::vector<char> strings;           // Per string: uint32_t size, bytes, '\0'
+    std::vector<uint32_t> structurals;   // Stage 1 output, offsets into the input
+    size_t structural_count;
+    
+    json_tape_s() : valid(false), structural_count(0), string_bytes(0) {}
+    explicit json_tape_s(const std::string& json) : valid(false), structural_count(0), string_bytes(0) {
+        parse(json);
+    }
+    
+    // Documents are limited to 4 GB (32-bit offsets)
+    bool parse(const std::string& json) { return parse(json.data(), json.size()); }
+    bool parse(const char* data, size_t size);
+    
+    tape_val_s root() const { return valid ? tape_val_s(this, 0) : tape_val_s(); }
+    tape_val_s operator[](str_view_s key) const { return root()[key]; }
+    tape_val_s find(str_view_s key) const { return root().find(key); }
+    dict_s to_dict() const { return root().to_dict(); }
+    
+    static json_tape_types type_of(uint64_t word) { return static_cast<json_tape_types>(word >> 56); }
+    static uint64_t payload_of(uint64_t word) { return word & ((uint64_t(1) << 56) - 1); }
+    str_view_s string_at(size_t offset) const;
+    
+private:
+    friend class tape_val_s;
+    
+    size_t string_bytes;                 // Used part of `strings`
+    std::vector<size_t> open;            // Stage 2 stack of open containers
+    std::vector<uint32_t> counts;
+    
+    bool stage1(const char* data, size_t size);
+    bool stage2(const char* data, size_t size);
+    const char* write_string(const char* p, const char* end, size_t limit);
+    void close_container(char type);
+    size_t build(size_t i, val_s& out, key_pool_s& pool) const;
+};
+
+// Binary format written by dict_s::dump_binary(). Every number is stored
+// little-endian whatever the host, so documents move between machines
+// unchanged. A document is the magic "DCB", a version byte (1) and the root
+// object. Each value starts with a dict_bin_types tag; sizes and counts are
+// LEB128 varints unless noted:
+//   null, false, true       tag only
+//   int8 .. int64           tag, 1/2/4/8 bytes two's complement (smallest fit)
+//   float32, double         tag, 4/8 bytes IEEE-754 (float32 when exact)
+//   string                  tag, varint size, bytes
+//   object                  tag, u32 body size, varint count, count x (key, value)
+//   array                   tag, u32 body size, varint count, count x value
+//   int array               tag, varint count, width (1/2/4/8), count x width bytes
+//   double array            tag, varint count, width (4/8), count x width bytes
+//   bool array              tag, varint count, count x byte (0/1)
+// A key is a string (string tag, size, bytes) or an int32 (int32 tag, 4
+// bytes). The body size of a container counts the bytes after it, so readers
+// step over whole subtrees; containers are limited to 4 GB.
+typedef enum : uint8_t {
+    dict_bin_null = 0x00,
+    dict_bin_false = 0x01,
+    dict_bin_true = 0x02,
+    dict_bin_int8 = 0x03,
+    dict_bin_int16 = 0x04,
+    dict_bin_int32 = 0x05,
+    dict_bin_int64 = 0x06,
+    dict_bin_float32 = 0x07,
+    dict_bin_double = 0x08,
+    dict_bin_string = 0x09,
+    dict_bin_object = 0x0A,
+    dict_bin_array = 0x0B,
+    dict_bin_int_array = 0x0C,
+    dict_bin_double_array = 0x0D,
+    dict_bin_bool_array = 0x0E
+} dict_bin_types;
+
+// Handle to one value of a bin_doc_s, read in place from the buffer; valid as
+// long as the buffer is. Elements of packed arrays have handles too. Lookups
+// mirror tape_val_s, and the scalar accessors throw std::domain_error on a
+// type mismatch.
+class bin_val_s {
+public:
+    bin_val_s() : p(nullptr), index(0) {}
+    explicit operator bool() const { return p != nullptr; }
+    
+    json_value_types type() const;       // json_null_t for an empty handle
+    bool is_object() const { return p && type() == json_object_t; }
+    bool is_array() const { return p && type() == json_array; }
+    // Layout the array was encoded with; json_array_generic for non-arrays
+    json_array_layouts layout() const;
+    
+    bin_val_s operator[](str_view_s key) const;
+    bin_val_s operator[](int32_t key) const;
+    bin_val_s find(str_view_s key) const;
+    bin_val_s find(int32_t key) const;
+    bool contains(str_view_s key) const { return static_cast<bool>(find(key)); }
+    bool contains(int32_t key) const { return static_cast<bool>(find(key)); }
+    bin_val_s at(size_t index) const;    // Constant time on packed arrays
+    bin_val_s operator[](size_t index) const { return at(index); }
+    size_t size() const;                 // Members (duplicates included) or elements
+    
+    int64_t intg() const;
+    double dbl() const;                  // Integers are converted
+    bool boolean() const;
+    str_view_s str_view() const;         // Points into the buffer
+    
+    // Heap-owned copies, as dict_s::parse_binary() builds them
+    val_s to_val() const;
+    dict_s to_dict() const;              // std::domain_error unless an object
+    
+private:
+    friend class bin_doc_s;
+    
+    static const size_t npos = static_cast<size_t>(-1);
+    
+    const char* p;                       // Tag of the value, or of its packed array
+    size_t index;                        // Element of a packed array, npos otherwise
+    
+    bin_val_s(const char* at, size_t i) : p(at), index(i) {}
+    dict_bin_types tag() const { return static_cast<dict_bin_types>(static_cast<uint8_t>(*p)); }
+    bin_val_s member(const char* key, size_t size, int32_t intg, bool is_int) const;
+};
+
+// Read-only view of a binary document. The constructor checks the whole
+// buffer once (tags, sizes, counts and bounds), after which every bin_val_s
+// access is a direct read with no further checks. Nothing is copied: the
+// buffer must outlive the document and its handles.
+class bin_doc_s {
+public:
+    bool valid;
+    
+    bin_doc_s(const char* data, size_t size);
+    explicit bin_doc_s(const std::string& data) : bin_doc_s(data.data(), data.size()) {}
+    bin_doc_s(std::string&&) = delete;   // Would dangle
+    
+    bin_val_s root() const { return valid ? bin_val_s(data + 4, bin_val_s::npos) : bin_val_s(); }
+    bin_val_s operator[](str_view_s key) const { return root()[key]; }
+    bin_val_s find(str_view_s key) const { return root().find(key); }
+    dict_s to_dict() const { return root().to_dict(); }
+    
+private:
+    const char* data;
+};
+
+typedef bin_doc_s dict_bin_t;
+
+// Interchange formats read by wire_decoder_s
+typedef enum {
+    dict_format_msgpack,
+    dict_format_cbor
+} dict_wire_formats;
+
+// Structural check of one MessagePack or CBOR message, resumable at any byte.
+// Item headers are walked with an explicit stack of open containers, so when
+// the bytes run out scan() can be called again later with more of them. It
+// rejects what a dict_s cannot hold: a top-level item other than a map, map
+// keys that are neither text nor int32 integers, and extension types or
+// simple values without a JSON counterpart.
+struct dict_wire_scanner_s {
+    struct frame_s {
+        uint64_t remaining;              // Items left, unless indefinite
+        uint64_t index;                  // Items seen; even ones are map keys
+        bool is_map;
+        bool indefinite;                 // CBOR indefinite length, ends with a break
+        int chunks;                      // Major type of an indefinite CBOR string's chunks, else -1
+    };
+    
+    dict_wire_formats format;
+    std::vector<frame_s> stack;
+    size_t pos;                          // Offset of the next item header
+    bool started;
+    
+    explicit dict_wire_scanner_s(dict_wire_formats f) : format(f), pos(0), started(false) {}
+    void reset() { stack.clear(); pos = 0; started = false; }
+    // Continues over data[pos, size): json_push_done once the message ends
+    // (at `pos`), json_push_more if it needs more bytes, json_push_error at
+    // the malformed item starting at `pos`
+    json_push_status scan(const char* data, size_t size);
+    
+private:
+    template<dict_wire_formats F>
+    json_push_status scan_items(const char* data, size_t size);
+};
+
+// Decodes a stream of MessagePack or CBOR messages, each a map, from input
+// that arrives in pieces. feed() only buffers; next() checks as far as the
+// new bytes allow, resuming where the last call stopped, and builds a dict_s
+// once a whole message is there. Consumed messages are dropped from the
+// buffer.
+class wire_decoder_s {
+public:
+    explicit wire_decoder_s(dict_wire_formats format) : scanner(format), start(0), dropped(0), state(json_push_more) {}
+    
+    void feed(const char* data, size_t size);
+    void feed(const std::string& chunk) { feed(chunk.data(), chunk.size()); }
+    // json_push_done with the next message in `out`, json_push_more until one
+    // is complete, or json_push_error for good once the input is malformed
+    json_push_status next(dict_s& out);
+    // Stream offset of the next message, or of the malformed item
+    size_t offset() const { return dropped + start + (state == json_push_error ? scanner.pos : 0); }
+    size_t buffered() const { return buf.size() - start; }
+    
+private:
+    dict_wire_scanner_s scanner;
+    std::string buf;
+    size_t start;                        // Next message in `buf`
+    size_t dropped;                      // Stream bytes erased from the front of `buf`
+    json_push_status state;
+};
+
+// Node of a persistent_dict_s. A branch holds up to 32 children, indexed
+// by 5 bits of the key hash at its depth and packed in bitmap order. A leaf
+// holds the entries whose keys share the full hash `hash`: one, unless
+// hashes collide. Nodes are never modified once published.
+struct pdict_node_s {
+    typedef std::shared_ptr<const pdict_node_s> ptr_t;
+    
+    uint32_t bitmap;                     // Branch: occupied slots; 0 for a leaf
+    uint64_t hash;                       // Leaf: hash of every key in `items`
+    std::vector<ptr_t> children;         // Branch
+    std::vector<std::pair<key_s, val_s>> items;   // Leaf
+    
+    pdict_node_s() : bitmap(0), hash(0) {}
+    bool is_leaf() const { return bitmap == 0; }
+};
+
+// Persistent map from keys to values: a hash array mapped trie. set() and
+// erase() leave the map unchanged and return a new version that shares every
+// node off the path to the changed key, so a version costs O(log32 n) nodes
+// of time and memory however large the map is. Versions are immutable and
+// can be read from any number of threads.
+//
+// Values are val_s. Leaves are shared between versions by pointer, so a
+// new version copies only the values in the leaf it changes.
+class persistent_dict_s {
+public:
+    persistent_dict_s() : count(0) {}
+    explicit persistent_dict_s(const dict_s& d);
+    
+    // New version with `key` set to `value`
+    persistent_dict_s set(str_view_s key, val_s value) const { return set(key_s(key), std::move(value)); }
+    persistent_dict_s set(int32_t key, val_s value) const { return set(key_s(key), std::move(value)); }
+    persistent_dict_s set(const key_s& key, val_s value) const;
+    // Same, for anything val_s can be assigned from (ints, strings, ...)
+    template<typename T>
+    persistent_dict_s set(str_view_s key, const T& value) const { val_s v; v = value; return set(key, std::move(v)); }
+    template<typename T>
+    persistent_dict_s set(int32_t key, const T& value) const { val_s v; v = value; return set(key, std::move(v)); }
+    // New version without `key`; shares everything if the key is missing
+    persistent_dict_s erase(str_view_s key) const;
+    persistent_dict_s erase(int32_t key) const;
+    
+    const val_s* find(str_view_s key) const;
+    const val_s* find(int32_t key) const;
+    bool contains(str_view_s key) const { return find(key) != nullptr; }
+    bool contains(int32_t key) const { return find(key) != nullptr; }
+    // Throws std::out_of_range for a missing key
+    const val_s& operator[](str_view_s key) const;
+    const val_s& operator[](int32_t key) const;
+    
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // Calls f(const key_s&, const val_s&) for every entry, in hash order
+    template<typename F>
+    void for_each(F f) const;
+    
+    dict_s to_dict() const;
+    std::string dump(int indent = -1) const { return to_dict().dump(indent); }
+    
+private:
+    pdict_node_s::ptr_t root;
+    size_t count;
+    
+    persistent_dict_s(pdict_node_s::ptr_t r, size_t n) : root(std::move(r)), count(n) {}
+    template<typename K>
+    const val_s* find_key(const K& key, uint64_t hash) const;
+    template<typename K>
+    persistent_dict_s erase_key(const K& key, uint64_t hash) const;
+};
+
+typedef persistent_dict_s dict_persistent_t;
+
+// Reader-writer spin lock for short critical sections. Any number of readers
+// share it; a waiting writer blocks new readers, then waits for the current
+// ones to leave. Spinning backs off to yield(), so it degrades gracefully
+// when threads outnumber cores.
+class dict_rw_lock_s {
+public:
+    dict_rw_lock_s() : state(0) {}
+    
+    void lock_shared();
+    void unlock_shared() { state.fetch_sub(1, std::memory_order_release); }
+    void lock();
+    void unlock() { state.store(0, std::memory_order_release); }
+    
+private:
+    static const uint32_t writer = 0x80000000u;
+    std::atomic<uint32_t> state;         // writer bit | reader count
+    
+    dict_rw_lock_s(const dict_rw_lock_s&);
+    dict_rw_lock_s& operator=(const dict_rw_lock_s&);
+};
+
+// Dictionary that many threads may read and write at once. Keys are spread
+// over power-of-two shards by hash, each a dict_s behind its own
+// dict_rw_lock_s, so threads touching different shards never contend and
+// lookups in the same shard share the lock. Lookups never insert.
+//
+// Values are copied in and out: no reference into the map escapes a lock.
+// Lookups hold the lock shared rather than reading optimistically and
+// validating afterwards, since copying a value out follows its strings and
+// maps, which a concurrent writer could free. Use update() to modify a value
+// in place. A copied object value shares its map (see dict_s) unless
+// update() has leaked it by writing into it.
+class concurrent_dict_s {
+public:
+    // `shards` is rounded up to a power of two; 0 picks 16 per hardware thread
+    explicit concurrent_dict_s(size_t shards = 0);
+    
+    // Copies the value into `out`; false if the key is missing
+    bool find(str_view_s key, val_s& out) const;
+    bool find(int32_t key, val_s& out) const;
+    bool contains(str_view_s key) const;
+    bool contains(int32_t key) const;
+    // Copy of the value; throws std::out_of_range for a missing key
+    val_s get(str_view_s key) const;
+    val_s get(int32_t key) const;
+    
+    // Inserts or overwrites
+    void set(str_view_s key, val_s value);
+    void set(int32_t key, val_s value);
+    template<typename T>
+    void set(str_view_s key, const T& value) { val_s v; v = value; set(key, std::move(v)); }
+    template<typename T>
+    void set(int32_t key, const T& value) { val_s v; v = value; set(key, std::move(v)); }
+    // Inserts only if the key is missing; true if it inserted
+    bool insert(str_view_s key, val_s value);
+    bool insert(int32_t key, val_s value);
+    bool erase(str_view_s key);
+    bool erase(int32_t key);
+    // Calls f(val_s&) with the shard locked, inserting a null value first if
+    // the key is missing. `f` must not touch this dict.
+    template<typename F>
+    void update(str_view_s key, F f);
+    template<typename F>
+    void update(int32_t key, F f);
+    
+    // Entry count; concurrent writers make it approximate
+    size_t size() const;
+    size_t shard_count() const { return shards.size(); }
+    // Calls f(const key_s&, const val_s&) for each entry, one shard locked at
+    // a time: not a snapshot of the whole dict if writers are running
+    template<typename F>
+    void for_each(F f) const;
+    dict_s to_dict() const;
+    
+private:
+    struct shard_fields_s {
+        mutable dict_rw_lock_s lock;
+        dict_s map;
+    };
+    // Padded so that neighbouring shards' locks are a cache line apart
+    // (alignas would not be honoured by std::vector before C++17)
+    struct shard_s : shard_fields_s {
+        char pad[64 - sizeof(shard_fields_s)];
+    };
+    static_assert(sizeof(shard_s) == 64, "a shard must fill exactly one cache line");
+    
+    std::vector<shard_s> shards;
+    
+    shard_s& shard_for(size_t hash) const;
+    template<typename K>
+    bool find_key(const K& key, val_s* out) const;
+    template<typename K>
+    bool erase_key(const K& key);
+    template<typename K>
+    void set_key(const K& key, val_s&& value);
+    template<typename K>
+    bool insert_key(const K& key, val_s&& value);
+    template<typename K, typename F>
+    void update_key(const K& key, F& f);
+};
+
+typedef concurrent_dict_s dict_concurrent_t;
+
+class snapshot_reader_s;
+class snapshot_pin_s;
+
+// One published document and its bookkeeping
+struct snapshot_version_s {
+    dict_s doc;
+    uint64_t number;                     // 1 for the initial document, then 2, 3, ...
+    uint64_t retired_at;                 // Epoch at which it was replaced
+    snapshot_version_s* next;            // Retired list
+    
+    snapshot_version_s(dict_s&& d, uint64_t n) : doc(std::move(d)), number(n), retired_at(0), next(nullptr) {}
+};
+
+struct snapshot_slot_s;
+
+// Reader slot: the epoch a reader pinned at, 0 while it holds no pin
+struct snapshot_slot_fields_s {
+    std::atomic<uint64_t> epoch;
+    std::atomic<bool> owned;
+    snapshot_slot_s* next;               // Slots are only ever added
+    
+    snapshot_slot_fields_s() : epoch(0), owned(true), next(nullptr) {}
+};
+
+// Padded to a cache line, so readers do not write to each other's lines
+struct snapshot_slot_s : snapshot_slot_fields_s {
+    char pad[64 - sizeof(snapshot_slot_fields_s)];
+};
+static_assert(sizeof(snapshot_slot_s) == 64, "a reader slot must fill exactly one cache line");
+
+// Publishes immutable versions of a document to many reader threads. A
+// writer builds a new dict_s and publish()es it; each reader thread holds a
+// snapshot_reader_s and pins the current version with pin(), which is
+// wait-free: two atomic loads and a store, no locks, no retries, no shared
+// reference count. The pinned version stays alive and unchanged until the
+// pin is released, however many versions are published meanwhile.
+//
+// Replaced versions are reclaimed by epochs: publishing advances a global
+// epoch, and a retired version is freed once every reader slot is idle or
+// pinned at a later epoch. Reclamation runs on publish() and reclaim(), so
+// readers never free anything. Writers are serialized by a mutex.
+//
+// All readers must be destroyed before the holder.
+class snapshot_holder_s {
+public:
+    explicit snapshot_holder_s(dict_s initial = dict_s());
+    ~snapshot_holder_s();
+    
+    // Makes `doc` the current version; returns its number
+    uint64_t publish(dict_s doc);
+    // Parses `json` and publishes it; the current version is kept (and 0
+    // returned) if the text does not parse
+    uint64_t publish_json(const std::string& json);
+    // Frees retired versions no reader can still see; returns how many
+    // remain retired
+    size_t reclaim();
+    
+    // Number of the current version
+    uint64_t version() const { return latest.load(std::memory_order_acquire); }
+    size_t retired_count() const;
+    
+private:
+    friend class snapshot_reader_s;
+    
+    std::atomic<snapshot_version_s*> current;
+    std::atomic<uint64_t> epoch;
+    std::atomic<uint64_t> latest;        // current->number, readable without a pin
+    std::atomic<snapshot_slot_s*> slots;
+    mutable std::mutex writer;           // Serializes publish() and reclaim()
+    snapshot_version_s* retired;         // Guarded by `writer`
+    size_t retired_size;
+    uint64_t next_number;
+    
+    snapshot_slot_s* acquire_slot();
+    size_t reclaim_locked();
+    
+    snapshot_holder_s(const snapshot_holder_s&);
+    snapshot_holder_s& operator=(const snapshot_holder_s&);
+};
+
+// A pinned version: a const view of the document that stays valid until the
+// pin is destroyed. Keep pins short; a pin held forever keeps every later
+// retired version alive too. Copy the document to keep it longer; the copy
+// shares every map that is not leaked (see dict_s).
+class snapshot_pin_s {
+public:
+    snapshot_pin_s(snapshot_pin_s&& other) noexcept : reader(other.reader), version(other.version) {
+        other.reader = nullptr;
+    }
+    ~snapshot_pin_s();
+    
+    const dict_s& operator*() const { return version->doc; }
+    const dict_s* operator->() const { return &version->doc; }
+    const dict_s& get() const { return version->doc; }
+    uint64_t number() const { return version->number; }
+    
+private:
+    friend class snapshot_reader_s;
+    snapshot_reader_s* reader;
+    const snapshot_version_s* version;
+    
+    snapshot_pin_s(snapshot_reader_s* r, const snapshot_version_s* v) : reader(r), version(v) {}
+    snapshot_pin_s(const snapshot_pin_s&);
+    snapshot_pin_s& operator=(const snapshot_pin_s&);
+};
+
+// Per-thread reader handle. Registering claims a reader slot (reusing one a
+// destroyed reader left, or adding one); pin() and the pin's destruction
+// only touch that slot. Not shared between threads. Pins may nest; inner
+// pins see the current version, possibly newer than the outer one.
+class snapshot_reader_s {
+public:
+    explicit snapshot_reader_s(snapshot_holder_s& h) : holder(h), slot(h.acquire_slot()), depth(0) {}
+    ~snapshot_reader_s() { slot->owned.store(false, std::memory_order_release); }
+    
+    snapshot_pin_s pin();
+    
+private:
+    friend class snapshot_pin_s;
+    snapshot_holder_s& holder;
+    snapshot_slot_s* slot;
+    unsigned depth;                      // Live pins
+    
+    void unpin();
+    
+    snapshot_reader_s(const snapshot_reader_s&);
+    snapshot_reader_s& operator=(const snapshot_reader_s&);
+};
+
+// Handle to a value in a frozen_dict_s, valid while the dict lives. Reads
+// follow bin_val_s: an empty handle for a missing key from find(),
+// std::out_of_range from operator[] and at(), std::domain_error for a type
+// mismatch.
+template<typename Hash>
+class frozen_val_hashed_s {
+public:
+    frozen_val_hashed_s() : words(nullptr), slot(0), index(npos) {}
+    explicit operator bool() const { return words != nullptr; }
+    
+    json_value_types type() const;       // json_null_t for an empty handle
+    bool is_null() const { return type() == json_null_t; }
+    bool is_bool() const { return type() == json_bool_t; }
+    bool is_int() const { return type() == json_integer_t; }
+    bool is_double() const { return type() == json_double_t; }
+    bool is_string() const { return type() == json_string_t; }
+    bool is_array() const { return type() == json_array; }
+    bool is_object() const { return type() == json_object_t; }
+    json_array_layouts layout() const;   // json_array_generic for non-arrays
+    
+    frozen_val_hashed_s operator[](str_view_s key) const;
+    frozen_val_hashed_s operator[](int32_t key) const;
+    frozen_val_hashed_s find(str_view_s key) const;
+    frozen_val_hashed_s find(int32_t key) const;
+    bool contains(str_view_s key) const { return static_cast<bool>(find(key)); }
+    bool contains(int32_t key) const { return static_cast<bool>(find(key)); }
+    frozen_val_hashed_s at(size_t index) const;
+    frozen_val_hashed_s operator[](size_t index) const { return at(index); }
+    size_t size() const;                 // Members or elements
+    
+    int64_t intg() const;
+    double dbl() const;                  // Integers are converted
+    bool boolean() const;
+    str_view_s str_view() const;         // Points into the frozen buffer
+    
+    val_s to_val() const;
+    dict_s to_dict() const;              // std::domain_error unless an object
+    
+private:
+    friend class frozen_dict_hashed_s<Hash>;
+    
+    static const size_t npos = static_cast<size_t>(-1);
+    
+    const uint64_t* words;               // Buffer of the frozen dict
+    size_t slot;                         // Word offset of the value's slot, or of its packed array's
+    size_t index;                        // Element of a packed array, npos otherwise
+    
+    frozen_val_hashed_s(const uint64_t* w, size_t s, size_t i) : words(w), slot(s), index(i) {}
+    frozen_val_hashed_s member(uint64_t hash, const char* probe, str_view_s long_key) const;
+    bool entry_matches(size_t e, const char* probe, str_view_s long_key) const;
+    const char* bytes(uint64_t offset) const { return reinterpret_cast<const char*>(words) + offset; }
+};
+
+typedef frozen_val_hashed_s<json_key_hash> frozen_val_s;
+
+// Immutable, compact copy of a dict_s tree in one allocation. Each object
+// is a minimal perfect hash table (hash and displace): the key hash picks a
+// bucket, the bucket's displacement picks the member's slot, and one
+// comparison confirms it, with no probing. Member entries, strings, keys and
+// arrays (packed layouts stay packed) follow each other in a single buffer
+// of 64-bit words. Nothing can change after freeze(), so any number of
+// threads can read a frozen_dict_s without synchronization.
+//
+// `Hash` hashes the keys, as for flat_map_s, and must agree between a key_s
+// and its str_view_s or int32_t form. frozen_dict_s uses json_key_hash;
+// other hashers exist for tests that need colliding keys.
+template<typename Hash>
+class frozen_dict_hashed_s {
+public:
+    frozen_dict_hashed_s();
+    explicit frozen_dict_hashed_s(const dict_s& d);
+    
+    frozen_val_hashed_s<Hash> root() const {
+        return frozen_val_hashed_s<Hash>(words.data(), 0, frozen_val_hashed_s<Hash>::npos);
+    }
+    frozen_val_hashed_s<Hash> operator[](str_view_s key) const { return root()[key]; }
+    frozen_val_hashed_s<Hash> operator[](int32_t key) const { return root()[key]; }
+    frozen_val_hashed_s<Hash> find(str_view_s key) const { return root().find(key); }
+    frozen_val_hashed_s<Hash> find(int32_t key) const { return root().find(key); }
+    bool contains(str_view_s key) const { return root().contains(key); }
+    bool contains(int32_t key) const { return root().contains(key); }
+    size_t size() const { return root().size(); }
+    
+    dict_s to_dict() const { return root().to_dict(); }
+    std::string dump(int indent = -1) const { return to_dict().dump(indent); }
+    size_t bytes() const { return words.size() * sizeof(uint64_t); }
+    
+private:
+    std::vector<uint64_t> words;
+    
+    void freeze_value(const val_s& v, size_t slot);
+    void freeze_object(const dict_s& d, size_t slot);
+    uint64_t append_bytes(str_view_s s);  // Returns the byte offset
+};
+
+typedef frozen_dict_s dict_frozen_t;
+
+// Options for ndjson_reader_s
+struct ndjson_options_s {
+    size_t threads;                      // Parsing workers; 0 = hardware concurrency
+    size_t batch_bytes;                  // Input handed to a worker at a time, rounded up to a line end
+    size_t max_pending;                  // Parsed batches buffered ahead of the consumer; 0 = 4 per worker
+    bool ordered;                        // Yield records in input order
+    
+    ndjson_options_s() : threads(0), batch_bytes(256 * 1024), max_pending(0), ordered(true) {}
+};
+
+// One line of NDJSON input. `doc.valid` is false if the line is not a JSON
+// object followed only by whitespace.
+struct ndjson_record_s {
+    dict_t doc;
+    size_t line;                         // 1-based line number
+    size_t offset;                       // Byte offset of the line in the input
+    
+    ndjson_record_s() : line(0), offset(0) {}
+};
+
+// Parses newline-delimited JSON (JSON Lines) on a pool of worker threads.
+// The input is cut into batches of about batch_bytes at line boundaries;
+// each worker claims the next batch, parses its lines into dict_t records
+// and queues them for next(). Records come back in input order, or with
+// options.ordered = false in whatever order batches complete (lines within
+// a batch stay in order). Blank lines are skipped; a trailing '\r' is
+// treated as whitespace.
+//
+// The input must stay alive and unchanged until the reader is destroyed,
+// e.g. a std::string or a dict_mapped_file_s. next() must be called from
+// one thread at a time. Exceptions thrown by a worker (std::bad_alloc) are
+// rethrown from next().
+class ndjson_reader_s {
+public:
+    ndjson_reader_s(const char* data, size_t size, const ndjson_options_s& options = ndjson_options_s());
+    explicit ndjson_reader_s(const std::string& text, const ndjson_options_s& options = ndjson_options_s())
+        : ndjson_reader_s(text.data(), text.size(), options) {}
+    ndjson_reader_s(std::string&& text, const ndjson_options_s& options = ndjson_options_s()) = delete;
+    ~ndjson_reader_s();                  // Stops and joins the workers
+    
+    // Moves the next record into `record`; false once the input is exhausted
+    bool next(ndjson_record_s& record);
+    
+    size_t threads() const { return workers.size(); }
+    
+private:
+    struct batch_s {
+        size_t index;
+        std::vector<ndjson_record_s> records;
+    };
+    
+    const char* data;
+    const char* end;
+    ndjson_options_s options;
+    
+    std::mutex mutex;
+    std::condition_variable work_cv;     // Workers wait here when too far ahead
+    std::condition_variable ready_cv;    // next() waits here for a batch
+    const char* split;                   // Start of the next unclaimed batch
+    size_t split_line;                   // Its line number
+    size_t claimed;                      // Batches handed to workers
+    size_t consumed;                     // Batches taken by next()
+    size_t running;                      // Workers still claiming batches
+    bool stopping;
+    std::exception_ptr failure;
+    std::deque<batch_s> done;            // Parsed, waiting for next()
+    
+    batch_s current;                     // Batch being drained by next()
+    size_t current_pos;
+    std::vector<std::thread> workers;
+    
+    void work();
+    void parse_batch(const char* p, const char* stop, size_t line, batch_s& batch, key_pool_s& pool);
+    
+    ndjson_reader_s(const ndjson_reader_s&);
+    ndjson_reader_s& operator=(const ndjson_reader_s&);
+};
+
+// ==================== dict_arena Implementation ====================
+
+inline dict_arena::dict_arena(size_t initial_block)
+    : head(nullptr), cursor(nullptr), limit(nullptr),
+      next_block(initial_block < 256 ? 256 : initial_block), used(0), reserved(0) {}
+
+inline dict_arena::~dict_arena() {
+    while (head) {
+        block_s* next = head->next;
+        ::operator delete(head);
+        head = next;
+    }
+}
+
+inline void dict_arena::grow(size_t min_size) {
+    size_t size = next_block;
+    while (size < min_size + sizeof(block_s)) size *= 2;
+    
+    block_s* b = static_cast<block_s*>(::operator new(size));
+    b->next = head;
+    b->size = size;
+    head = b;
+    cursor = reinterpret_cast<char*>(b) + sizeof(block_s);
+    limit = reinterpret_cast<char*>(b) + size;
+    reserved += size;
+    
+    // Geometric growth keeps the block count logarithmic in document size
+    if (next_block < (size_t(1) << 24)) next_block *= 2;
+}
+
+inline void* dict_arena::allocate(size_t n, size_t align) {
+    uintptr_t p = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+    if (!cursor || p + n > reinterpret_cast<uintptr_t>(limit)) {
+        grow(n + align);
+        p = (reinterpret_cast<uintptr_t>(cursor) + align - 1) & ~(uintptr_t)(align - 1);
+    }
+    cursor = reinterpret_cast<char*>(p + n);
+    used += n;
+    return reinterpret_cast<void*>(p);
+}
+
+inline void dict_arena::reset() {
+    // Keep the newest block (always the largest) for the next document
+    if (head) {
+        block_s* b = head->next;
+        while (b) {
+            block_s* next = b->next;
+            reserved -= b->size;
+            ::operator delete(b);
+            b = next;
+        }
+        head->next = nullptr;
+        cursor = reinterpret_cast<char*>(head) + sizeof(block_s);
+        limit = reinterpret_cast<char*>(head) + head->size;
+    }
+    used = 0;
+}
+
+// ==================== val_s Implementation ====================
+
+inline val_s::val_s() : t(json_null_t), layout(json_array_generic), borrowed(false), intg(0) {}
+
+inline val_s::val_s(const val_s& other) : t(json_null_t), layout(json_array_generic), borrowed(false), intg(0) {
+    construct_from(other);
+}
+
+// Move constructor - OPTIMIZATION #1: Move Semantics
+inline val_s::val_s(val_s&& other) noexcept : t(json_null_t), layout(json_array_generic), borrowed(false), intg(0) {
+    construct_from(std::move(other));
+}
+
+inline val_s::~val_s() {
+    destroy();
+}
+
+// Destroys the active member; leaves the value as null
+inline void val_s::destroy() {
+    typedef std::shared_ptr<dict_s> obj_t;
+    switch (t) {
+        case json_string_t: if (!borrowed) str.~basic_string(); break;
+        case json_object_t: obj.~obj_t(); break;
+        case json_array: destroy_array(); break;
+        default: break;
+    }
+    t = json_null_t;
+    layout = json_array_generic;
+    borrowed = false;
+    intg = 0;
+}
+
+inline void val_s::destroy_array() {
+    switch (layout) {
+        case json_array_int: arr_intg.~int_array_t(); break;
+        case json_array_double: arr_dbl.~double_array_t(); break;
+        case json_array_bool: arr_bool.~bool_array_t(); break;
+        default: arr.~array_t(); break;
+    }
+}
+
+// Both construct_from overloads expect *this to be null (freshly constructed
+// or destroyed)
+inline void val_s::construct_from(const val_s& other) {
+    switch (other.t) {
+        case json_string_t:
+            if (other.borrowed) {
+                new (&str) std::string(other.ref.data, other.ref.size);
+            } else {
+                new (&str) std::string(other.str);
+            }
+            break;
+        case json_object_t:
+            new (&obj) std::shared_ptr<dict_s>();
+            if (other.obj) {
+                obj = std::make_shared<dict_s>(*other.obj);
+            }
+            break;
+        case json_array:
+            // Deep copy array; copies select the heap allocator
+            switch (other.layout) {
+                case json_array_int: new (&arr_intg) int_array_t(other.arr_intg); break;
+                case json_array_double: new (&arr_dbl) double_array_t(other.arr_dbl); break;
+                case json_array_bool: new (&arr_bool) bool_array_t(other.arr_bool); break;
+                default: new (&arr) array_t(other.arr); break;
+            }
+            layout = other.layout;
+            break;
+        case json_double_t:
+            dbl = other.dbl;
+            break;
+        case json_bool_t:
+            boolean = other.boolean;
+            break;
+        default:
+            intg = other.intg;
+            break;
+    }
+    t = other.t;
+}
+
+inline void val_s::construct_from(val_s&& other) {
+    switch (other.t) {
+        case json_string_t:
+            if (other.borrowed) {
+                new (&ref) str_view_s(other.ref);
+                borrowed = true;
+            } else {
+                new (&str) std::string(std::move(other.str));
+            }
+            break;
+        case json_object_t:
+            new (&obj) std::shared_ptr<dict_s>(std::move(other.obj));
+            break;
+        case json_array:
+            switch (other.layout) {
+                case json_array_int: new (&arr_intg) int_array_t(std::move(other.arr_intg)); break;
+                case json_array_double: new (&arr_dbl) double_array_t(std::move(other.arr_dbl)); break;
+                case json_array_bool: new (&arr_bool) bool_array_t(std::move(other.arr_bool)); break;
+                default: new (&arr) array_t(std::move(other.arr)); break;
+            }
+            layout = other.layout;
+            break;
+        case json_double_t:
+            dbl = other.dbl;
+            break;
+        case json_bool_t:
+            boolean = other.boolean;
+            break;
+        default:
+            intg = other.intg;
+            break;
+    }
+    t = other.t;
+    other.destroy();
+}
+
+inline void val_s::set_type(json_value_types nt) {
+    if (t == nt && !borrowed) return;
+    destroy();
+    switch (nt) {
+        case json_string_t: new (&str) std::string(); break;
+        case json_object_t: new (&obj) std::shared_ptr<dict_s>(); break;
+        case json_array: new (&arr) array_t(); break;
+        default: break;
+    }
+    t = nt;
+}
+
+inline void val_s::borrow(str_view_s s) {
+    destroy();
+    new (&ref) str_view_s(s);
+    borrowed = true;
+    t = json_string_t;
+}
+
+// Arena the current array storage draws from (null for the heap). Layout
+// changes keep it, so arrays parsed into a doc_s stay in its arena.
+inline dict_arena* val_s::array_arena() const {
+    switch (layout) {
+        case json_array_int: return arr_intg.get_allocator().arena;
+        case json_array_double: return arr_dbl.get_allocator().arena;
+        case json_array_bool: return arr_bool.get_allocator().arena;
+        default: return arr.get_allocator().arena;
+    }
+}
+
+// Replaces the array storage with an empty container of layout `l`
+inline void val_s::set_layout(json_array_layouts l) {
+    dict_arena* arena = array_arena();
+    destroy_array();
+    switch (l) {
+        case json_array_int: new (&arr_intg) int_array_t(dict_allocator<int64_t>(arena)); break;
+        case json_array_double: new (&arr_dbl) double_array_t(dict_allocator<double>(arena)); break;
+        case json_array_bool: new (&arr_bool) bool_array_t(dict_allocator<uint8_t>(arena)); break;
+        default: new (&arr) array_t(dict_allocator<val_s>(arena)); break;
+    }
+    layout = l;
+}
+
+inline void val_s::unpack() {
+    if (t != json_array || layout == json_array_generic) return;
+    
+    dict_allocator<val_s> alloc(array_arena());
+    array_t items(alloc);
+    items.reserve(size());
+    switch (layout) {
+        case json_array_int:
+            for (int64_t x : arr_intg) {
+                items.emplace_back();
+                items.back() = x;
+            }
+            break;
+        case json_array_double:
+            for (double x : arr_dbl) {
+                items.emplace_back();
+                items.back() = x;
+            }
+            break;
+        case json_array_bool:
+            for (uint8_t x : arr_bool) {
+                items.emplace_back();
+                items.back() = (x != 0);
+            }
+            break;
+        default:
+            break;
+    }
+    set_layout(json_array_generic);
+    arr.swap(items);
+}
+
+// Copy assignment. Copying into a temporary first keeps `v = v.at(0)` safe.
+inline val_s& val_s::operator=(const val_s& other) {
+    if (this != &other) {
+        val_s tmp(other);
+        destroy();
+        construct_from(std::move(tmp));
+    }
+    return *this;
+}
+
+// Move assignment - OPTIMIZATION #1: Move Semantics
+inline val_s& val_s::operator=(val_s&& other) noexcept {
+    if (this != &other) {
+        val_s tmp(std::move(other));
+        destroy();
+        construct_from(std::move(tmp));
+    }
+    return *this;
+}
+
+// Type-specific assignments
+inline val_s& val_s::operator=(int64_t assign) {
+    set_type(json_integer_t);
+    intg = assign;
+    return *this;
+}
+
+inline val_s& val_s::operator=(int assign) {
+    return (*this) = static_cast<int64_t>(assign);
+}
+
+inline val_s& val_s::operator=(const std::string& assign) {
+    set_type(json_string_t);
+    str = assign;
+    return *this;
+}
+
+inline val_s& val_s::operator=(std::string&& assign) {
+    set_type(json_string_t);
+    str = std::move(assign);
+    return *this;
+}
+
+inline val_s& val_s::operator=(const char* assign) {
+    return (*this) = std::string(assign);
+}
+
+inline val_s& val_s::operator=(double assign) {
+    set_type(json_double_t);
+    dbl = assign;
+    return *this;
+}
+
+inline val_s& val_s::operator=(bool assign) {
+    set_type(json_bool_t);
+    boolean = assign;
+    return *this;
+}
+
+inline val_s& val_s::operator=(const dict_s& assign) {
+    // Copy before switching type: `assign` may own this value
+    std::shared_ptr<dict_s> copy = std::make_shared<dict_s>(assign);
+    set_type(json_object_t);
+    obj = std::move(copy);
+    return *this;
+}
+
+// Subscripting a null value turns it into an empty object, so that
+// d["user"]["name"] = "Alice" works on a fresh key
+inline val_s& val_s::operator[](str_view_s key) {
+    if (t == json_null_t) {
+        set_type(json_object_t);
+    }
+    if (t != json_object_t) {
+        throw std::domain_error("Value is not an object");
+    }
+    if (!obj) {
+        obj = std::make_shared<dict_s>();
+    }
+    return (*obj)[key];
+}
+
+inline val_s& val_s::operator[](int32_t i) {
+    if (t == json_null_t) {
+        set_type(json_object_t);
+    }
+    if (t != json_object_t) {
+        throw std::domain_error("Value is not an object");
+    }
+    if (!obj) {
+        obj = std::make_shared<dict_s>();
+    }
+    return (*obj)[i];
+}
+
+inline const val_s& val_s::operator[](str_view_s key) const {
+    const val_s* v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return *v;
+}
+
+inline const val_s& val_s::operator[](int32_t i) const {
+    const val_s* v = find(i);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return *v;
+}
+
+inline val_s* val_s::find(str_view_s key) {
+    return (t == json_object_t && obj) ? obj->find(key) : nullptr;
+}
+
+inline const val_s* val_s::find(str_view_s key) const {
+    return (t == json_object_t && obj) ? static_cast<const dict_s&>(*obj).find(key) : nullptr;
+}
+
+inline val_s* val_s::find(int32_t key) {
+    return (t == json_object_t && obj) ? obj->find(key) : nullptr;
+}
+
+inline const val_s* val_s::find(int32_t key) const {
+    return (t == json_object_t && obj) ? static_cast<const dict_s&>(*obj).find(key) : nullptr;
+}
+
+inline val_s& val_s::operator[](size_t i) {
+    return at(i);
+}
+
+// OPTIMIZATION #2: Generic Arrays - Array access methods
+inline val_s& val_s::at(size_t index) {
+    if (t != json_array || index >= size()) {
+        throw std::out_of_range("Array index out of range");
+    }
+    unpack();
+    return arr[index];
+}
+
+// A packed array holds no val_s to refer to, and unpacking it here would
+// write to a value other threads may be reading, so the element is built
+// on the fly.
+inline const val_s val_s::at(size_t index) const {
+    if (t != json_array || index >= size()) {
+        throw std::out_of_range("Array index out of range");
+    }
+    val_s v;
+    switch (layout) {
+        case json_array_int: v = arr_intg[index]; break;
+        case json_array_double: v = arr_dbl[index]; break;
+        case json_array_bool: v = arr_bool[index] != 0; break;
+        default: v = arr[index]; break;
+    }
+    return v;
+}
+
+inline size_t val_s::size() const {
+    if (t == json_array) {
+        switch (layout) {
+            case json_array_int: return arr_intg.size();
+            case json_array_double: return arr_dbl.size();
+            case json_array_bool: return arr_bool.size();
+            default: return arr.size();
+        }
+    }
+    return 0;
+}
+
+inline void val_s::push_back(const val_s& val) {
+    val_s copy(val);                    // `val` may live in this array
+    push_back(std::move(copy));
+}
+
+// Appending keeps a packed layout while the new element matches it. The first
+// element of an empty array picks the layout.
+inline void val_s::push_back(val_s&& val) {
+    set_type(json_array);
+    if (size() == 0) {
+        switch (val.t) {
+            case json_integer_t: set_layout(json_array_int); break;
+            case json_double_t: set_layout(json_array_double); break;
+            case json_bool_t: set_layout(json_array_bool); break;
+            default: set_layout(json_array_generic); break;
+        }
+    }
+    switch (layout) {
+        case json_array_int:
+            if (val.t == json_integer_t) {
+                arr_intg.push_back(val.intg);
+                return;
+            }
+            break;
+        case json_array_double:
+            if (val.t == json_double_t) {
+                arr_dbl.push_back(val.dbl);
+                return;
+            }
+            break;
+        case json_array_bool:
+            if (val.t == json_bool_t) {
+                arr_bool.push_back(val.boolean ? 1 : 0);
+                return;
+            }
+            break;
+        default:
+            break;
+    }
+    unpack();
+    arr.push_back(std::move(val));
+}
+
+inline int64_t val_s::int_at(size_t index) const {
+    if (t != json_array || index >= size()) {
+        throw std::out_of_range("Array index out of range");
+    }
+    if (layout == json_array_int) return arr_intg[index];
+    if (layout == json_array_generic && arr[index].t == json_integer_t) return arr[index].intg;
+    throw std::domain_error("Array element is not an integer");
+}
+
+inline double val_s::dbl_at(size_t index) const {
+    if (t != json_array || index >= size()) {
+        throw std::out_of_range("Array index out of range");
+    }
+    if (layout == json_array_double) return arr_dbl[index];
+    if (layout == json_array_generic && arr[index].t == json_double_t) return arr[index].dbl;
+    throw std::domain_error("Array element is not a double");
+}
+
+inline bool val_s::bool_at(size_t index) const {
+    if (t != json_array || index >= size()) {
+        throw std::out_of_range("Array index out of range");
+    }
+    if (layout == json_array_bool) return arr_bool[index] != 0;
+    if (layout == json_array_generic && arr[index].t == json_bool_t) return arr[index].boolean;
+    throw std::domain_error("Array element is not a bool");
+}
+
+// ==================== key_s Implementation ====================
+
+inline key_atom_s* key_atom_s::create(str_view_s s) {
+    if (s.size > UINT32_MAX) {
+        throw std::length_error("Key too long");
+    }
+    void* mem = ::operator new(sizeof(key_atom_s) + s.size);
+    key_atom_s* atom = new (mem) key_atom_s;
+    atom->refs.store(1, std::memory_order_relaxed);
+    atom->size = static_cast<uint32_t>(s.size);
+    atom->hash = dict_hash_bytes(s.data, s.size);
+    if (s.size) std::memcpy(static_cast<char*>(mem) + sizeof(key_atom_s), s.data, s.size);
+    return atom;
+}
+
+inline void key_atom_s::release() {
+    if (refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        this->~key_atom_s();
+        ::operator delete(this);
+    }
+}
+
+inline key_s::key_s(str_view_s s) : t(json_k_string_t), intg(0) {
+    std::memset(buf_, 0, sizeof(buf_));
+    if (s.size <= inline_capacity) {
+        if (s.size) std::memcpy(buf_, s.data, s.size);
+        buf_[inline_capacity] = static_cast<char>(s.size);
+    } else {
+        set_atom(key_atom_s::create(s));
+    }
+}
+
+inline key_s::key_s(key_atom_s* atom) : t(json_k_string_t), intg(0) {
+    std::memset(buf_, 0, sizeof(buf_));
+    atom->retain();
+    set_atom(atom);
+}
+
+inline key_s::key_s(const key_s& other) : t(other.t), intg(other.intg) {
+    std::memcpy(buf_, other.buf_, sizeof(buf_));
+    if (key_atom_s* a = atom()) a->retain();
+}
+
+inline key_s::key_s(key_s&& other) noexcept : t(other.t), intg(other.intg) {
+    std::memcpy(buf_, other.buf_, sizeof(buf_));
+    std::memset(other.buf_, 0, sizeof(other.buf_));   // Leaves other as ""
+}
+
+inline key_s& key_s::operator=(const key_s& other) {
+    if (this != &other) {
+        if (key_atom_s* a = other.atom()) a->retain();
+        release_atom();
+        t = other.t;
+        intg = other.intg;
+        std::memcpy(buf_, other.buf_, sizeof(buf_));
+    }
+    return *this;
+}
+
+inline key_s& key_s::operator=(key_s&& other) noexcept {
+    if (this != &other) {
+        release_atom();
+        t = other.t;
+        intg = other.intg;
+        std::memcpy(buf_, other.buf_, sizeof(buf_));
+        std::memset(other.buf_, 0, sizeof(other.buf_));
+    }
+    return *this;
+}
+
+inline str_view_s key_s::str() const {
+    if (key_atom_s* a = atom()) {
+        return str_view_s(a->data(), a->size);
+    }
+    return str_view_s(buf_, static_cast<unsigned char>(buf_[inline_capacity]));
+}
+
+inline uint64_t key_s::hash() const {
+    if (key_atom_s* a = atom()) {
+        return a->hash;
+    }
+    return dict_hash_bytes(buf_, static_cast<unsigned char>(buf_[inline_capacity]));
+}
+
+inline key_atom_s* key_s::atom() const {
+    if (is_inline()) return nullptr;
+    key_atom_s* a;
+    std::memcpy(&a, buf_, sizeof(a));
+    return a;
+}
+
+inline void key_s::set_atom(key_atom_s* atom) {
+    std::memcpy(buf_, &atom, sizeof(atom));
+    buf_[inline_capacity] = static_cast<char>(atom_tag);
+}
+
+inline void key_s::release_atom() {
+    if (key_atom_s* a = atom()) a->release();
+}
+
+inline key_s key_pool_s::intern(str_view_s s) {
+    if (s.size <= key_s::inline_capacity) {
+        return key_s(s);
+    }
+    // The first occurrence builds the atom in place; later ones share it
+    return atoms.try_emplace(s).first->first;
+}
+
+// ==================== File I/O ====================
+
+// Fills `error` (if any) and returns false, for use in return statements
+inline bool json_set_error(json_error_s* error, const std::string& message, int sys_errno) {
+    if (error) {
+        *error = json_error_s();
+        error->message = message;
+        error->sys_errno = sys_errno;
+        if (sys_errno != 0) {
+            error->message += ": ";
+            error->message += std::strerror(sys_errno);
+        }
+    }
+    return false;
+}
+
+// Parse errors carry their position; lines are only counted on failure
+inline bool json_set_parse_error(json_error_s* error, const char* data, size_t offset) {
+    if (!error) return false;
+    *error = json_error_s();
+    error->offset = offset;
+    error->line = 1;
+    const char* line_start = data;
+    const char* end = data + offset;
+    while (const char* nl = static_cast<const char*>(std::memchr(line_start, '\n', static_cast<size_t>(end - line_start)))) {
+        ++error->line;
+        line_start = nl + 1;
+    }
+    error->column = static_cast<size_t>(end - line_start) + 1;
+    error->message = "parse error at line " + std::to_string(error->line) + ", column " +
+                     std::to_string(error->column) + " (offset " + std::to_string(offset) + ")";
+    return false;
+}
+
+inline bool dict_mapped_file_s::open(const std::string& path, json_error_s* error) {
+    close();
+#ifdef _WIN32
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return json_set_error(error, "cannot open " + path, errno);
+    char chunk[64 * 1024];
+    size_t n;
+    while ((n = std::fread(chunk, 1, sizeof(chunk), f)) > 0) {
+        buffer.append(chunk, n);
+    }
+    bool failed = std::ferror(f) != 0;
+    int err = errno;
+    std::fclose(f);
+    if (failed) {
+        buffer.clear();
+        return json_set_error(error, "cannot read " + path, err);
+    }
+#else
+    int flags = O_RDONLY;
+#ifdef O_CLOEXEC
+    flags |= O_CLOEXEC;
+#endif
+    int fd;
+    do {
+        fd = ::open(path.c_str(), flags);
+    } while (fd < 0 && errno == EINTR);
+    if (fd < 0) return json_set_error(error, "cannot open " + path, errno);
+    
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int err = errno;
+        ::close(fd);
+        return json_set_error(error, "cannot stat " + path, err);
+    }
+    if (S_ISREG(st.st_mode) && st.st_size > 0) {
+        size_t size = static_cast<size_t>(st.st_size);
+#ifdef POSIX_FADV_SEQUENTIAL
+        ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        void* p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        int err = errno;
+        ::close(fd);                     // The mapping keeps the file open
+        if (p == MAP_FAILED) return json_set_error(error, "cannot map " + path, err);
+        // The parser reads front to back: ask for aggressive readahead now,
+        // rather than one fault per page later
+#ifdef MADV_SEQUENTIAL
+        ::madvise(p, size, MADV_SEQUENTIAL);
+#endif
+#ifdef MADV_WILLNEED
+        ::madvise(p, size, MADV_WILLNEED);
+#endif
+        data_ = static_cast<const char*>(p);
+        size_ = size;
+        mapped = true;
+        return true;
+    }
+    
+    // Pipes, character devices and files that report no size
+    char chunk[64 * 1024];
+    for (;;) {
+        ssize_t n = ::read(fd, chunk, sizeof(chunk));
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int err = errno;
+            ::close(fd);
+            buffer.clear();
+            return json_set_error(error, "cannot read " + path, err);
+        }
+        if (n == 0) break;
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+    ::close(fd);
+#endif
+    data_ = buffer.data();
+    size_ = buffer.size();
+    return true;
+}
+
+inline void dict_mapped_file_s::close() {
+#ifndef _WIN32
+    if (mapped) {
+        ::munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    std::string().swap(buffer);
+    data_ = "";
+    size_ = 0;
+    mapped = false;
+}
+
+// ==================== dict_s Implementation ====================
+
+inline dict_s::dict_s() : obj(std::make_shared<map_t>()), valid(true), leaked(false) {}
+
+inline dict_s::dict_s(dict_arena* arena)
+    : obj(std::allocate_shared<map_t>(dict_allocator<map_t>(arena), allocator_type(arena))),
+      valid(true), leaked(false) {}
+
+// OPTIMIZATION #4: JSON Parsing Constructor
+inline dict_s::dict_s(const std::string& json_str)
+    : obj(std::make_shared<map_t>()), valid(false), leaked(false) {
+    valid = parse(json_str);
+}
+
+// Copy constructor
+// Shares the map unless it is leaked or lives in an arena. The map's copy
+// constructor copies every entry in one pass (slot for slot with the flat
+// table), always allocates from the heap, and shares the maps of the object
+// values that are not leaked themselves.
+inline dict_s::dict_s(const dict_s& other) : valid(other.valid), leaked(false) {
+    if (!other.obj) {
+        obj = std::make_shared<map_t>();
+    } else if (other.leaked || other.obj->get_allocator().arena) {
+        obj = std::make_shared<map_t>(*other.obj);
+    } else {
+        obj = other.obj;
+    }
+}
+
+// Move constructor - OPTIMIZATION #1: Move Semantics
+inline dict_s::dict_s(dict_s&& other) noexcept 
+    : obj(std::move(other.obj)), valid(other.valid), leaked(other.leaked) {
+    other.valid = false;
+    other.leaked = false;
+}
+
+inline dict_s::~dict_s() {}
+
+// Copy assignment
+inline dict_s& dict_s::operator=(const dict_s& other) {
+    if (this != &other) {
+        dict_s tmp(other);
+        obj = std::move(tmp.obj);
+        valid = other.valid;
+        leaked = false;
+    }
+    return *this;
+}
+
+// Move assignment - OPTIMIZATION #1: Move Semantics  
+inline dict_s& dict_s::operator=(dict_s&& other) noexcept {
+    if (this != &other) {
+        obj = std::move(other.obj);
+        valid = other.valid;
+        leaked = other.leaked;
+        other.valid = false;
+        other.leaked = false;
+    }
+    return *this;
+}
+
+// Gives `d` a map of its own without marking it leaked, for writes that hand
+// out no reference. The copy's object values share their maps in turn, so
+// this costs one level of the tree. The fence pairs with the release in the
+// other owner's reference drop: its reads of the map happen before our writes.
+inline void dict_unshare(dict_s& d) {
+    if (!d.obj) {
+        d.obj = std::make_shared<dict_s::map_t>();
+    } else if (d.obj.use_count() > 1) {
+        d.obj = std::make_shared<dict_s::map_t>(*d.obj);
+    } else {
+        std::atomic_thread_fence(std::memory_order_acquire);
+    }
+}
+
+inline void dict_s::detach() {
+    dict_unshare(*this);
+    leaked = true;
+}
+
+inline void dict_detach_all(val_s& v) {
+    if (v.t == json_object_t) {
+        if (v.obj) v.obj->detach_all();
+    } else if (v.t == json_array && v.layout == json_array_generic) {
+        for (val_s& e : v.arr) dict_detach_all(e);
+    }
+}
+
+inline void dict_s::detach_all() {
+    detach();
+    if (!obj) return;
+    for (auto it = obj->begin(); it != obj->end(); ++it) {
+        dict_detach_all(it->second);
+    }
+}
+
+#ifndef JSON_ORDERED
+// A hit costs one probe and no allocation; only a miss builds the key_s
+inline val_s& dict_s::operator[](str_view_s s) {
+    detach();
+    return obj->try_emplace(s).first->second;
+}
+
+inline val_s& dict_s::operator[](int32_t i) {
+    detach();
+    return obj->try_emplace(i).first->second;
+}
+
+inline val_s& dict_s::operator[](const key_s& k) {
+    detach();
+    return obj->try_emplace(k).first->second;
+}
+
+inline val_s* dict_s::find(str_view_s key) {
+    detach();
+    map_t::iterator it = obj->find(key);
+    return it == obj->end() ? nullptr : &it->second;
+}
+
+inline const val_s* dict_s::find(str_view_s key) const {
+    map_t::const_iterator it = static_cast<const map_t&>(*obj).find(key);
+    return it == obj->end() ? nullptr : &it->second;
+}
+
+inline val_s* dict_s::find(int32_t key) {
+    detach();
+    map_t::iterator it = obj->find(key);
+    return it == obj->end() ? nullptr : &it->second;
+}
+
+inline const val_s* dict_s::find(int32_t key) const {
+    map_t::const_iterator it = static_cast<const map_t&>(*obj).find(key);
+    return it == obj->end() ? nullptr : &it->second;
+}
+#else
+// std::map in C++11 has no heterogeneous lookup, so ordered mode builds a key
+inline val_s& dict_s::operator[](str_view_s s) {
+    detach();
+    return (*obj)[key_s(s)];
+}
+
+inline val_s& dict_s::operator[](int32_t i) {
+    detach();
+    return (*obj)[key_s(i)];
+}
+
+inline val_s& dict_s::operator[](const key_s& k) {
+    detach();
+    return (*obj)[k];
+}
+
+inline val_s* dict_s::find(str_view_s key) {
+    detach();
+    map_t::iterator it = obj->find(key_s(key));
+    return it == obj->end() ? nullptr : &it->second;
+}
+
+inline const val_s* dict_s::find(str_view_s key) const {
+    map_t::const_iterator it = static_cast<const map_t&>(*obj).find(key_s(key));
+    return it == obj->end() ? nullptr : &it->second;
+}
+
+inline val_s* dict_s::find(int32_t key) {
+    detach();
+    map_t::iterator it = obj->find(key_s(key));
+    return it == obj->end() ? nullptr : &it->second;
+}
+
+inline const val_s* dict_s::find(int32_t key) const {
+    map_t::const_iterator it = static_cast<const map_t&>(*obj).find(key_s(key));
+    return it == obj->end() ? nullptr : &it->second;
+}
+#endif
+
+inline void dict_s::set(str_view_s key, val_s value) {
+    dict_unshare(*this);
+#ifndef JSON_ORDERED
+    obj->try_emplace(key).first->second = std::move(value);
+#else
+    (*obj)[key_s(key)] = std::move(value);
+#endif
+}
+
+inline void dict_s::set(int32_t key, val_s value) {
+    dict_unshare(*this);
+#ifndef JSON_ORDERED
+    obj->try_emplace(key).first->second = std::move(value);
+#else
+    (*obj)[key_s(key)] = std::move(value);
+#endif
+}
+
+inline void dict_s::set(const key_s& key, val_s value) {
+    dict_unshare(*this);
+#ifndef JSON_ORDERED
+    obj->try_emplace(key).first->second = std::move(value);
+#else
+    (*obj)[key] = std::move(value);
+#endif
+}
+
+inline const val_s& dict_s::operator[](str_view_s s) const {
+    const val_s* v = find(s);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return *v;
+}
+
+inline const val_s& dict_s::operator[](int32_t i) const {
+    const val_s* v = find(i);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return *v;
+}
+
+// OPTIMIZATION #3: Serialization straight into a growable char buffer
+inline std::string dict_s::dump(int indent) const {
+    json_writer_s w;
+    w.buf.reserve(256);
+    dump_internal(w, indent, 0);
+    return std::move(w.buf);
+}
+
+inline bool dict_s::dump_to(const dict_sink_s& sink, int indent) const {
+    json_writer_s w(sink);
+    dump_internal(w, indent, 0);
+    return w.flush();
+}
+
+inline void dict_s::dump_internal(json_writer_s& w, int indent, int current_level) const {
+    w.put('{');
+    bool first = true;
+    
+    for (auto it = obj->begin(); it != obj->end(); ++it) {
+        if (!first) w.put(',');
+        first = false;
+        
+        if (indent >= 0) {
+            w.write_newline((current_level + 1) * indent);
+        }
+        
+        // Write key
+        if (it->first.t == json_k_string_t) {
+            w.write_string(it->first.str());
+        } else {
+            w.write_int(it->first.intg);
+        }
+        w.put(':');
+        if (indent >= 0) w.put(' ');
+        
+        json_write_value(w, it->second, indent, current_level);
+        w.maybe_flush();
+    }
+    
+    if (indent >= 0 && !first) {
+        w.write_newline(current_level * indent);
+    }
+    w.put('}');
+}
+
+// OPTIMIZATION #4: JSON Parsing
+inline bool dict_s::parse(const std::string& json_str) {
+    JSONParser parser(json_str);
+    return parser.parse(*this);
+}
+
+inline bool dict_s::load_file(const std::string& path, json_error_s* error) {
+    obj = std::make_shared<map_t>();
+    leaked = false;
+    dict_mapped_file_s file;
+    valid = file.open(path, error);
+    if (!valid) return false;
+    JSONParser parser(file.data(), file.size(), nullptr, nullptr, json_strings_copy);
+    valid = parser.parse(*this);
+    if (!valid) {
+        json_set_parse_error(error, file.data(), parser.offset());
+    }
+    return valid;
+}
+
+inline bool dict_s::save_file(const std::string& path, int indent, json_error_s* error) const {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return json_set_error(error, "cannot open " + path + " for writing", errno);
+    bool ok = dump_to(dict_sink_s(f), indent);
+    int err = ok ? 0 : errno;
+    if (std::fclose(f) != 0 && ok) {
+        ok = false;
+        err = errno;
+    }
+    if (!ok) return json_set_error(error, "cannot write " + path, err);
+    return true;
+}
+
+// ==================== doc_s Implementation ====================
+
+inline doc_s::doc_s() : arena(new dict_arena()), root(arena.get()), valid(true) {}
+
+inline doc_s::doc_s(const std::string& json_str) : arena(new dict_arena()), valid(false) {
+    valid = parse(json_str);
+}
+
+inline doc_s::doc_s(doc_s&& other) noexcept
+    : arena(std::move(other.arena)), keys(std::move(other.keys)), file(std::move(other.file)),
+      root(std::move(other.root)), valid(other.valid) {
+    other.valid = false;
+}
+
+inline doc_s& doc_s::operator=(doc_s&& other) noexcept {
+    if (this != &other) {
+        root.obj.reset();                // Drop references into our arena first
+        arena = std::move(other.arena);
+        keys = std::move(other.keys);
+        root = std::move(other.root);
+        file = std::move(other.file);
+        valid = other.valid;
+        other.valid = false;
+    }
+    return *this;
+}
+
+inline void doc_s::reset_root() {
+    if (!arena) {
+        arena.reset(new dict_arena());
+    }
+    root.obj.reset();                    // Drop references into the arena and file
+    arena->reset();
+    file.reset();
+    root = dict_s(arena.get());
+    // Keep the pool warm for documents with the same schema, but don't let
+    // a stream of unrelated documents grow it without bound
+    if (keys.size() > 4096) {
+        keys.clear();
+    }
+}
+
+inline bool doc_s::parse(const std::string& json_str) {
+    reset_root();
+    JSONParser parser(json_str, arena.get(), &keys);
+    valid = parser.parse(root);
+    return valid;
+}
+
+inline bool doc_s::parse_borrowed(const char* json, size_t size) {
+    reset_root();
+    JSONParser parser(json, size, arena.get(), &keys, json_strings_borrow);
+    valid = parser.parse(root);
+    return valid;
+}
+
+inline bool doc_s::parse_insitu(char* json, size_t size) {
+    reset_root();
+    JSONParser parser(json, size, arena.get(), &keys, json_strings_insitu);
+    valid = parser.parse(root);
+    return valid;
+}
+
+inline bool doc_s::load_file(const std::string& path, json_error_s* error) {
+    reset_root();
+    file.reset(new dict_mapped_file_s());
+    valid = file->open(path, error);
+    if (!valid) {
+        file.reset();
+        return false;
+    }
+    JSONParser parser(file->data(), file->size(), arena.get(), &keys, json_strings_borrow);
+    valid = parser.parse(root);
+    if (!valid) {
+        json_set_parse_error(error, file->data(), parser.offset());
+    }
+    return valid;
+}
+
+// ==================== Comparison Operators ====================
+
+// Inline keys and keys sharing an atom are equal exactly when their buffers
+// are; only atoms from different pools need the characters compared.
+inline bool operator==(const key_s& first, const key_s& second) {
+    if (first.t != second.t) return false;
+    if (first.t == json_k_integer_t) return first.intg == second.intg;
+    if (std::memcmp(first.buf_, second.buf_, sizeof(first.buf_)) == 0) return true;
+    key_atom_s* a = first.atom();
+    key_atom_s* b = second.atom();
+    return a && b && a->hash == b->hash && a->size == b->size &&
+           std::memcmp(a->data(), b->data(), a->size) == 0;
+}
+
+inline std::size_t json_key_hash::operator()(const key_s& k) const {
+    if (k.t == json_k_integer_t) {
+        return (*this)(k.intg);
+    }
+    return static_cast<std::size_t>(k.hash());
+}
+
+inline std::size_t json_key_hash::operator()(str_view_s s) const {
+    return static_cast<std::size_t>(dict_hash_bytes(s.data, s.size));
+}
+
+inline std::size_t json_key_hash::operator()(int32_t i) const {
+    return static_cast<std::size_t>((static_cast<uint32_t>(i) ^ dict_hash_seed()) * 0x9e3779b97f4a7c15ULL);
+}
+
+inline bool json_key_equal::operator()(const key_s& a, const key_s& b) const {
+    return a == b;
+}
+
+inline bool json_key_equal::operator()(const key_s& a, str_view_s b) const {
+    return a.t == json_k_string_t && a.str() == b;
+}
+
+inline bool json_key_equal::operator()(const key_s& a, int32_t b) const {
+    return a.t == json_k_integer_t && a.intg == b;
+}
+
+#ifdef JSON_ORDERED
+inline bool operator<(const key_s& first, const key_s& second) {
+    if (first.t < second.t) return true;
+    if (first.t > second.t) return false;
+    if (first.t == json_k_integer_t) {
+        return first.intg < second.intg;
+    }
+    if (first.t == json_k_string_t) {
+        str_view_s a = first.str();
+        str_view_s b = second.str();
+        int c = std::memcmp(a.data, b.data, std::min(a.size, b.size));
+        return c < 0 || (c == 0 && a.size < b.size);
+    }
+    return false;
+}
+#endif
+
+// ==================== Stream Operators (Backward Compatibility) ====================
+
+inline std::ostream& operator<<(std::ostream& os, const dict_t& dict) {
+    json_writer_s w;
+    dict.dump_internal(w, -1, 0);        // No indentation for backward compatibility
+    return os.write(w.buf.data(), static_cast<std::streamsize>(w.buf.size()));
+}
+
+inline std::ostream& operator<<(std::ostream& os, const val_t& val) {
+    json_writer_s w;
+    json_write_value(w, val, -1, -1);
+    return os.write(w.buf.data(), static_cast<std::streamsize>(w.buf.size()));
+}
+
+inline std::ostream& operator<<(std::ostream& os, const dict_key_t& k) {
+    json_writer_s w;
+    if (k.t == json_k_string_t) {
+        w.write_string(k.str());
+    } else {
+        w.write_int(k.intg);
+    }
+    return os.write(w.buf.data(), static_cast<std::streamsize>(w.buf.size()));
+}
+
+// ==================== Number Parsing ====================
+//
+// Bounded, locale-independent JSON number parsing. Integers are accumulated
+// directly. Decimals with up to 19 significant digits are converted with
+// Clinger's fast path when both the mantissa and the power of ten are exact
+// doubles, and otherwise with the Eisel-Lemire algorithm, which is correctly
+// rounded or reports that it cannot decide. The rare undecided or longer
+// inputs fall back to strtod on a NUL-terminated copy, using the C locale's
+// decimal point whatever the current locale is.
+
+// Truncated 128-bit mantissas of 5^q for q in [-342, 308], high word first
+inline const uint64_t* json_pow5_128() {
+    static const uint64_t table[] = {
+        0xeef453d6923bd65aULL, 0x113faa2906a13b3fULL, 0x9558b4661b6565f8ULL, 0x4ac7ca59a424c507ULL,
+        0xbaaee17fa23ebf76ULL, 0x5d79bcf00d2df649ULL, 0xe95a99df8ace6f53ULL, 0xf4d82c2c107973dcULL,
+        0x91d8a02bb6c10594ULL, 0x79071b9b8a4be869ULL, 0xb64ec836a47146f9ULL, 0x9748e2826cdee284ULL,
+        0xe3e27a444d8d98b7ULL, 0xfd1b1b2308169b25ULL, 0x8e6d8c6ab0787f72ULL, 0xfe30f0f5e50e20f7ULL,
+        0xb208ef855c969f4fULL, 0xbdbd2d335e51a935ULL, 0xde8b2b66b3bc4723ULL, 0xad2c788035e61382ULL,
+        0x8b16fb203055ac76ULL, 0x4c3bcb5021afcc31ULL, 0xaddcb9e83c6b1793ULL, 0xdf4abe242a1bbf3dULL,
+        0xd953e8624b85dd78ULL, 0xd71d6dad34a2af0dULL, 0x87d4713d6f33aa6bULL, 0x8672648c40e5ad68ULL,
+        0xa9c98d8ccb009506ULL, 0x680efdaf511f18c2ULL, 0xd43bf0effdc0ba48ULL, 0x0212bd1b2566def2ULL,
+        0x84a57695fe98746dULL, 0x014bb630f7604b57ULL, 0xa5ced43b7e3e9188ULL, 0x419ea3bd35385e2dULL,
+        0xcf42894a5dce35eaULL, 0x52064cac828675b9ULL, 0x818995ce7aa0e1b2ULL, 0x7343efebd1940993ULL,
+        0xa1ebfb4219491a1fULL, 0x1014ebe6c5f90bf8ULL, 0xca66fa129f9b60a6ULL, 0xd41a26e077774ef6ULL,
+        0xfd00b897478238d0ULL, 0x8920b098955522b4ULL, 0x9e20735e8cb16382ULL, 0x55b46e5f5d5535b0ULL,
+        0xc5a890362fddbc62ULL, 0xeb2189f734aa831dULL, 0xf712b443bbd52b7bULL, 0xa5e9ec7501d523e4ULL,
+        0x9a6bb0aa55653b2dULL, 0x47b233c92125366eULL, 0xc1069cd4eabe89f8ULL, 0x999ec0bb696e840aULL,
+        0xf148440a256e2c76ULL, 0xc00670ea43ca250dULL, 0x96cd2a865764dbcaULL, 0x380406926a5e5728ULL,
+        0xbc807527ed3e12bcULL, 0xc605083704f5ecf2ULL, 0xeba09271e88d976bULL, 0xf7864a44c633682eULL,
+        0x93445b8731587ea3ULL, 0x7ab3ee6afbe0211dULL, 0xb8157268fdae9e4cULL, 0x5960ea05bad82964ULL,
+        0xe61acf033d1a45dfULL, 0x6fb92487298e33bdULL, 0x8fd0c16206306babULL, 0xa5d3b6d479f8e056ULL,
+        0xb3c4f1ba87bc8696ULL, 0x8f48a4899877186cULL, 0xe0b62e2929aba83cULL, 0x331acdabfe94de87ULL,
+        0x8c71dcd9ba0b4925ULL, 0x9ff0c08b7f1d0b14ULL, 0xaf8e5410288e1b6fULL, 0x07ecf0ae5ee44dd9ULL,
+        0xdb71e91432b1a24aULL, 0xc9e82cd9f69d6150ULL, 0x892731ac9faf056eULL, 0xbe311c083a225cd2ULL,
+        0xab70fe17c79ac6caULL, 0x6dbd630a48aaf406ULL, 0xd64d3d9db981787dULL, 0x092cbbccdad5b108ULL,
+        0x85f0468293f0eb4eULL, 0x25bbf56008c58ea5ULL, 0xa76c582338ed2621ULL, 0xaf2af2b80af6f24eULL,
+        0xd1476e2c07286faaULL, 0x1af5af660db4aee1ULL, 0x82cca4db847945caULL, 0x50d98d9fc890ed4dULL,
+        0xa37fce126597973cULL, 0xe50ff107bab528a0ULL, 0xcc5fc196fefd7d0cULL, 0x1e53ed49a96272c8ULL,
+        0xff77b1fcbebcdc4fULL, 0x25e8e89c13bb0f7aULL, 0x9faacf3df73609b1ULL, 0x77b191618c54e9acULL,
+        0xc795830d75038c1dULL, 0xd59df5b9ef6a2417ULL, 0xf97ae3d0d2446f25ULL, 0x4b0573286b44ad1dULL,
+        0x9becce62836ac577ULL, 0x4ee367f9430aec32ULL, 0xc2e801fb244576d5ULL, 0x229c41f793cda73fULL,
+        0xf3a20279ed56d48aULL, 0x6b43527578c1110fULL, 0x9845418c345644d6ULL, 0x830a13896b78aaa9ULL,
+        0xbe5691ef416bd60cULL, 0x23cc986bc656d553ULL, 0xedec366b11c6cb8fULL, 0x2cbfbe86b7ec8aa8ULL,
+        0x94b3a202eb1c3f39ULL, 0x7bf7d71432f3d6a9ULL, 0xb9e08a83a5e34f07ULL, 0xdaf5ccd93fb0cc53ULL,
+        0xe858ad248f5c22c9ULL, 0xd1b3400f8f9cff68ULL, 0x91376c36d99995beULL, 0x23100809b9c21fa1ULL,
+        0xb58547448ffffb2dULL, 0xabd40a0c2832a78aULL, 0xe2e69915b3fff9f9ULL, 0x16c90c8f323f516cULL,
+        0x8dd01fad907ffc3bULL, 0xae3da7d97f6792e3ULL, 0xb1442798f49ffb4aULL, 0x99cd11cfdf41779cULL,
+        0xdd95317f31c7fa1dULL, 0x40405643d711d583ULL, 0x8a7d3eef7f1cfc52ULL, 0x482835ea666b2572ULL,
+        0xad1c8eab5ee43b66ULL, 0xda3243650005eecfULL, 0xd863b256369d4a40ULL, 0x90bed43e40076a82ULL,
+        0x873e4f75e2224e68ULL, 0x5a7744a6e804a291ULL, 0xa90de3535aaae202ULL, 0x711515d0a205cb36ULL,
+        0xd3515c2831559a83ULL, 0x0d5a5b44ca873e03ULL, 0x8412d9991ed58091ULL, 0xe858790afe9486c2ULL,
+        0xa5178fff668ae0b6ULL, 0x626e974dbe39a872ULL, 0xce5d73ff402d98e3ULL, 0xfb0a3d212dc8128fULL,
+        0x80fa687f881c7f8eULL, 0x7ce66634bc9d0b99ULL, 0xa139029f6a239f72ULL, 0x1c1fffc1ebc44e80ULL,
+        0xc987434744ac874eULL, 0xa327ffb266b56220ULL, 0xfbe9141915d7a922ULL, 0x4bf1ff9f0062baa8ULL,
+        0x9d71ac8fada6c9b5ULL, 0x6f773fc3603db4a9ULL, 0xc4ce17b399107c22ULL, 0xcb550fb4384d21d3ULL,
+        0xf6019da07f549b2bULL, 0x7e2a53a146606a48ULL, 0x99c102844f94e0fbULL, 0x2eda7444cbfc426dULL,
+        0xc0314325637a1939ULL, 0xfa911155fefb5308ULL, 0xf03d93eebc589f88ULL, 0x793555ab7eba27caULL,
+        0x96267c7535b763b5ULL, 0x4bc1558b2f3458deULL, 0xbbb01b9283253ca2ULL, 0x9eb1aaedfb016f16ULL,
+        0xea9c227723ee8bcbULL, 0x465e15a979c1cadcULL, 0x92a1958a7675175fULL, 0x0bfacd89ec191ec9ULL,
+        0xb749faed14125d36ULL, 0xcef980ec671f667bULL, 0xe51c79a85916f484ULL, 0x82b7e12780e7401aULL,
+        0x8f31cc0937ae58d2ULL, 0xd1b2ecb8b0908810ULL, 0xb2fe3f0b8599ef07ULL, 0x861fa7e6dcb4aa15ULL,
+        0xdfbdcece67006ac9ULL, 0x67a791e093e1d49aULL, 0x8bd6a141006042bdULL, 0xe0c8bb2c5c6d24e0ULL,
+        0xaecc49914078536dULL, 0x58fae9f773886e18ULL, 0xda7f5bf590966848ULL, 0xaf39a475506a899eULL,
+        0x888f99797a5e012dULL, 0x6d8406c952429603ULL, 0xaab37fd7d8f58178ULL, 0xc8e5087ba6d33b83ULL,
+        0xd5605fcdcf32e1d6ULL, 0xfb1e4a9a90880a64ULL, 0x855c3be0a17fcd26ULL, 0x5cf2eea09a55067fULL,
+        0xa6b34ad8c9dfc06fULL, 0xf42faa48c0ea481eULL, 0xd0601d8efc57b08bULL, 0xf13b94daf124da26ULL,
+        0x823c12795db6ce57ULL, 0x76c53d08d6b70858ULL, 0xa2cb1717b52481edULL, 0x54768c4b0c64ca6eULL,
+        0xcb7ddcdda26da268ULL, 0xa9942f5dcf7dfd09ULL, 0xfe5d54150b090b02ULL, 0xd3f93b35435d7c4cULL,
+        0x9efa548d26e5a6e1ULL, 0xc47bc5014a1a6dafULL, 0xc6b8e9b0709f109aULL, 0x359ab6419ca1091bULL,
+        0xf867241c8cc6d4c0ULL, 0xc30163d203c94b62ULL, 0x9b407691d7fc44f8ULL, 0x79e0de63425dcf1dULL,
+        0xc21094364dfb5636ULL, 0x985915fc12f542e4ULL, 0xf294b943e17a2bc4ULL, 0x3e6f5b7b17b2939dULL,
+        0x979cf3ca6cec5b5aULL, 0xa705992ceecf9c42ULL, 0xbd8430bd08277231ULL, 0x50c6ff782a838353ULL,
+        0xece53cec4a314ebdULL, 0xa4f8bf5635246428ULL, 0x940f4613ae5ed136ULL, 0x871b7795e136be99ULL,
+        0xb913179899f68584ULL, 0x28e2557b59846e3fULL, 0xe757dd7ec07426e5ULL, 0x331aeada2fe589cfULL,
+        0x9096ea6f3848984fULL, 0x3ff0d2c85def7621ULL, 0xb4bca50b065abe63ULL, 0x0fed077a756b53a9ULL,
+        0xe1ebce4dc7f16dfbULL, 0xd3e8495912c62894ULL, 0x8d3360f09cf6e4bdULL, 0x64712dd7abbbd95cULL,
+        0xb080392cc4349decULL, 0xbd8d794d96aacfb3ULL, 0xdca04777f541c567ULL, 0xecf0d7a0fc5583a0ULL,
+        0x89e42caaf9491b60ULL, 0xf41686c49db57244ULL, 0xac5d37d5b79b6239ULL, 0x311c2875c522ced5ULL,
+        0xd77485cb25823ac7ULL, 0x7d633293366b828bULL, 0x86a8d39ef77164bcULL, 0xae5dff9c02033197ULL,
+        0xa8530886b54dbdebULL, 0xd9f57f830283fdfcULL, 0xd267caa862a12d66ULL, 0xd072df63c324fd7bULL,
+        0x8380dea93da4bc60ULL, 0x4247cb9e59f71e6dULL, 0xa46116538d0deb78ULL, 0x52d9be85f074e608ULL,
+        0xcd795be870516656ULL, 0x67902e276c921f8bULL, 0x806bd9714632dff6ULL, 0x00ba1cd8a3db53b6ULL,
+        0xa086cfcd97bf97f3ULL, 0x80e8a40eccd228a4ULL, 0xc8a883c0fdaf7df0ULL, 0x6122cd128006b2cdULL,
+        0xfad2a4b13d1b5d6cULL, 0x796b805720085f81ULL, 0x9cc3a6eec6311a63ULL, 0xcbe3303674053bb0ULL,
+        0xc3f490aa77bd60fcULL, 0xbedbfc4411068a9cULL, 0xf4f1b4d515acb93bULL, 0xee92fb5515482d44ULL,
+        0x991711052d8bf3c5ULL, 0x751bdd152d4d1c4aULL, 0xbf5cd54678eef0b6ULL, 0xd262d45a78a0635dULL,
+        0xef340a98172aace4ULL, 0x86fb897116c87c34ULL, 0x9580869f0e7aac0eULL, 0xd45d35e6ae3d4da0ULL,
+        0xbae0a846d2195712ULL, 0x8974836059cca109ULL, 0xe998d258869facd7ULL, 0x2bd1a438703fc94bULL,
+        0x91ff83775423cc06ULL, 0x7b6306a34627ddcfULL, 0xb67f6455292cbf08ULL, 0x1a3bc84c17b1d542ULL,
+        0xe41f3d6a7377eecaULL, 0x20caba5f1d9e4a93ULL, 0x8e938662882af53eULL, 0x547eb47b7282ee9cULL,
+        0xb23867fb2a35b28dULL, 0xe99e619a4f23aa43ULL, 0xdec681f9f4c31f31ULL, 0x6405fa00e2ec94d4ULL,
+        0x8b3c113c38f9f37eULL, 0xde83bc408dd3dd04ULL, 0xae0b158b4738705eULL, 0x9624ab50b148d445ULL,
+        0xd98ddaee19068c76ULL, 0x3badd624dd9b0957ULL, 0x87f8a8d4cfa417c9ULL, 0xe54ca5d70a80e5d6ULL,
+        0xa9f6d30a038d1dbcULL, 0x5e9fcf4ccd211f4cULL, 0xd47487cc8470652bULL, 0x7647c3200069671fULL,
+        0x84c8d4dfd2c63f3bULL, 0x29ecd9f40041e073ULL, 0xa5fb0a17c777cf09ULL, 0xf468107100525890ULL,
+        0xcf79cc9db955c2ccULL, 0x7182148d4066eeb4ULL, 0x81ac1fe293d599bfULL, 0xc6f14cd848405530ULL,
+        0xa21727db38cb002fULL, 0xb8ada00e5a506a7cULL, 0xca9cf1d206fdc03bULL, 0xa6d90811f0e4851cULL,
+        0xfd442e4688bd304aULL, 0x908f4a166d1da663ULL, 0x9e4a9cec15763e2eULL, 0x9a598e4e043287feULL,
+        0xc5dd44271ad3cdbaULL, 0x40eff1e1853f29fdULL, 0xf7549530e188c128ULL, 0xd12bee59e68ef47cULL,
+        0x9a94dd3e8cf578b9ULL, 0x82bb74f8301958ceULL, 0xc13a148e3032d6e7ULL, 0xe36a52363c1faf01ULL,
+        0xf18899b1bc3f8ca1ULL, 0xdc44e6c3cb279ac1ULL, 0x96f5600f15a7b7e5ULL, 0x29ab103a5ef8c0b9ULL,
+        0xbcb2b812db11a5deULL, 0x7415d448f6b6f0e7ULL, 0xebdf661791d60f56ULL, 0x111b495b3464ad21ULL,
+        0x936b9fcebb25c995ULL, 0xcab10dd900beec34ULL, 0xb84687c269ef3bfbULL, 0x3d5d514f40eea742ULL,
+        0xe65829b3046b0afaULL, 0x0cb4a5a3112a5112ULL, 0x8ff71a0fe2c2e6dcULL, 0x47f0e785eaba72abULL,
+        0xb3f4e093db73a093ULL, 0x59ed216765690f56ULL, 0xe0f218b8d25088b8ULL, 0x306869c13ec3532cULL,
+        0x8c974f7383725573ULL, 0x1e414218c73a13fbULL, 0xafbd2350644eeacfULL, 0xe5d1929ef90898faULL,
+        0xdbac6c247d62a583ULL, 0xdf45f746b74abf39ULL, 0x894bc396ce5da772ULL, 0x6b8bba8c328eb783ULL,
+        0xab9eb47c81f5114fULL, 0x066ea92f3f326564ULL, 0xd686619ba27255a2ULL, 0xc80a537b0efefebdULL,
+        0x8613fd0145877585ULL, 0xbd06742ce95f5f36ULL, 0xa798fc4196e952e7ULL, 0x2c48113823b73704ULL,
+        0xd17f3b51fca3a7a0ULL, 0xf75a15862ca504c5ULL, 0x82ef85133de648c4ULL, 0x9a984d73dbe722fbULL,
+        0xa3ab66580d5fdaf5ULL, 0xc13e60d0d2e0ebbaULL, 0xcc963fee10b7d1b3ULL, 0x318df905079926a8ULL,
+        0xffbbcfe994e5c61fULL, 0xfdf17746497f7052ULL, 0x9fd561f1fd0f9bd3ULL, 0xfeb6ea8bedefa633ULL,
+        0xc7caba6e7c5382c8ULL, 0xfe64a52ee96b8fc0ULL, 0xf9bd690a1b68637bULL, 0x3dfdce7aa3c673b0ULL,
+        0x9c1661a651213e2dULL, 0x06bea10ca65c084eULL, 0xc31bfa0fe5698db8ULL, 0x486e494fcff30a62ULL,
+        0xf3e2f893dec3f126ULL, 0x5a89dba3c3efccfaULL, 0x986ddb5c6b3a76b7ULL, 0xf89629465a75e01cULL,
+        0xbe89523386091465ULL, 0xf6bbb397f1135823ULL, 0xee2ba6c0678b597fULL, 0x746aa07ded582e2cULL,
+        0x94db483840b717efULL, 0xa8c2a44eb4571cdcULL, 0xba121a4650e4ddebULL, 0x92f34d62616ce413ULL,
+        0xe896a0d7e51e1566ULL, 0x77b020baf9c81d17ULL, 0x915e2486ef32cd60ULL, 0x0ace1474dc1d122eULL,
+        0xb5b5ada8aaff80b8ULL, 0x0d819992132456baULL, 0xe3231912d5bf60e6ULL, 0x10e1fff697ed6c69ULL,
+        0x8df5efabc5979c8fULL, 0xca8d3ffa1ef463c1ULL, 0xb1736b96b6fd83b3ULL, 0xbd308ff8a6b17cb2ULL,
+        0xddd0467c64bce4a0ULL, 0xac7cb3f6d05ddbdeULL, 0x8aa22c0dbef60ee4ULL, 0x6bcdf07a423aa96bULL,
+        0xad4ab7112eb3929dULL, 0x86c16c98d2c953c6ULL, 0xd89d64d57a607744ULL, 0xe871c7bf077ba8b7ULL,
+        0x87625f056c7c4a8bULL, 0x11471cd764ad4972ULL, 0xa93af6c6c79b5d2dULL, 0xd598e40d3dd89bcfULL,
+        0xd389b47879823479ULL, 0x4aff1d108d4ec2c3ULL, 0x843610cb4bf160cbULL, 0xcedf722a585139baULL,
+        0xa54394fe1eedb8feULL, 0xc2974eb4ee658828ULL, 0xce947a3da6a9273eULL, 0x733d226229feea32ULL,
+        0x811ccc668829b887ULL, 0x0806357d5a3f525fULL, 0xa163ff802a3426a8ULL, 0xca07c2dcb0cf26f7ULL,
+        0xc9bcff6034c13052ULL, 0xfc89b393dd02f0b5ULL, 0xfc2c3f3841f17c67ULL, 0xbbac2078d443ace2ULL,
+        0x9d9ba7832936edc0ULL, 0xd54b944b84aa4c0dULL, 0xc5029163f384a931ULL, 0x0a9e795e65d4df11ULL,
+        0xf64335bcf065d37dULL, 0x4d4617b5ff4a16d5ULL, 0x99ea0196163fa42eULL, 0x504bced1bf8e4e45ULL,
+        0xc06481fb9bcf8d39ULL, 0xe45ec2862f71e1d6ULL, 0xf07da27a82c37088ULL, 0x5d767327bb4e5a4cULL,
+        0x964e858c91ba2655ULL, 0x3a6a07f8d510f86fULL, 0xbbe226efb628afeaULL, 0x890489f70a55368bULL,
+        0xeadab0aba3b2dbe5ULL, 0x2b45ac74ccea842eULL, 0x92c8ae6b464fc96fULL, 0x3b0b8bc90012929dULL,
+        0xb77ada0617e3bbcbULL, 0x09ce6ebb40173744ULL, 0xe55990879ddcaabdULL, 0xcc420a6a101d0515ULL,
+        0x8f57fa54c2a9eab6ULL, 0x9fa946824a12232dULL, 0xb32df8e9f3546564ULL, 0x47939822dc96abf9ULL,
+        0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL, 0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL,
+        0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL, 0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL,
+        0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL, 0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL,
+        0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL, 0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL,
+        0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL, 0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL,
+        0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL, 0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL,
+        0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL, 0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL,
+        0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL, 0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL,
+        0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL, 0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL,
+        0xc24452da229b021bULL, 0xfbe85badce996168ULL, 0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL,
+        0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL, 0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL,
+        0xed246723473e3813ULL, 0x290123e9aab23b68ULL, 0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL,
+        0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL, 0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL,
+        0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL, 0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL,
+        0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL, 0x8d590723948a535fULL, 0x579c487e5a38ad0eULL,
+        0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL, 0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL,
+        0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL, 0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL,
+        0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL, 0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL,
+        0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL, 0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL,
+        0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL, 0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL,
+        0xcdb02555653131b6ULL, 0x3792f412cb06794dULL, 0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL,
+        0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL, 0xc8de047564d20a8bULL, 0xf245825a5a445275ULL,
+        0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL, 0x9ced737bb6c4183dULL, 0x55464dd69685606bULL,
+        0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL, 0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL,
+        0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL, 0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL,
+        0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL, 0x95a8637627989aadULL, 0xdde7001379a44aa8ULL,
+        0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL, 0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL,
+        0x9226712162ab070dULL, 0xcab3961304ca70e8ULL, 0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL,
+        0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL, 0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL,
+        0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL, 0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL,
+        0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL, 0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL,
+        0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL, 0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL,
+        0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL, 0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL,
+        0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL, 0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL,
+        0xcfb11ead453994baULL, 0x67de18eda5814af2ULL, 0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL,
+        0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL, 0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL,
+        0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL, 0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL,
+        0xc612062576589ddaULL, 0x95364afe032a819eULL, 0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL,
+        0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL, 0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL,
+        0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL, 0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL,
+        0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL, 0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL,
+        0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL, 0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL,
+        0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL, 0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL,
+        0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL, 0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL,
+        0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL, 0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL,
+        0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL, 0x89705f4136b4a597ULL, 0x31680a88f8953031ULL,
+        0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL, 0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL,
+        0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL, 0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL,
+        0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL, 0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL,
+        0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL, 0xccccccccccccccccULL, 0xcccccccccccccccdULL,
+        0x8000000000000000ULL, 0x0000000000000000ULL, 0xa000000000000000ULL, 0x0000000000000000ULL,
+        0xc800000000000000ULL, 0x0000000000000000ULL, 0xfa00000000000000ULL, 0x0000000000000000ULL,
+        0x9c40000000000000ULL, 0x0000000000000000ULL, 0xc350000000000000ULL, 0x0000000000000000ULL,
+        0xf424000000000000ULL, 0x0000000000000000ULL, 0x9896800000000000ULL, 0x0000000000000000ULL,
+        0xbebc200000000000ULL, 0x0000000000000000ULL, 0xee6b280000000000ULL, 0x0000000000000000ULL,
+        0x9502f90000000000ULL, 0x0000000000000000ULL, 0xba43b74000000000ULL, 0x0000000000000000ULL,
+        0xe8d4a51000000000ULL, 0x0000000000000000ULL, 0x9184e72a00000000ULL, 0x0000000000000000ULL,
+        0xb5e620f480000000ULL, 0x0000000000000000ULL, 0xe35fa931a0000000ULL, 0x0000000000000000ULL,
+        0x8e1bc9bf04000000ULL, 0x0000000000000000ULL, 0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL,
+        0xde0b6b3a76400000ULL, 0x0000000000000000ULL, 0x8ac7230489e80000ULL, 0x0000000000000000ULL,
+        0xad78ebc5ac620000ULL, 0x0000000000000000ULL, 0xd8d726b7177a8000ULL, 0x0000000000000000ULL,
+        0x878678326eac9000ULL, 0x0000000000000000ULL, 0xa968163f0a57b400ULL, 0x0000000000000000ULL,
+        0xd3c21bcecceda100ULL, 0x0000000000000000ULL, 0x84595161401484a0ULL, 0x0000000000000000ULL,
+        0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL, 0xcecb8f27f4200f3aULL, 0x0000000000000000ULL,
+        0x813f3978f8940984ULL, 0x4000000000000000ULL, 0xa18f07d736b90be5ULL, 0x5000000000000000ULL,
+        0xc9f2c9cd04674edeULL, 0xa400000000000000ULL, 0xfc6f7c4045812296ULL, 0x4d00000000000000ULL,
+        0x9dc5ada82b70b59dULL, 0xf020000000000000ULL, 0xc5371912364ce305ULL, 0x6c28000000000000ULL,
+        0xf684df56c3e01bc6ULL, 0xc732000000000000ULL, 0x9a130b963a6c115cULL, 0x3c7f400000000000ULL,
+        0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL, 0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL,
+        0x96769950b50d88f4ULL, 0x1314448000000000ULL, 0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL,
+        0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL, 0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL,
+        0xb7abc627050305adULL, 0xf14a3d9e40000000ULL, 0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL,
+        0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL, 0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL,
+        0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL, 0x8c213d9da502de45ULL, 0x4526f422cc340000ULL,
+        0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL, 0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL,
+        0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL, 0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL,
+        0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL, 0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL,
+        0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL, 0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL,
+        0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL, 0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL,
+        0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL, 0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL,
+        0x9f4f2726179a2245ULL, 0x01d762422c946590ULL, 0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL,
+        0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL, 0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL,
+        0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL, 0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL,
+        0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL, 0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL,
+        0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL, 0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL,
+        0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL, 0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL,
+        0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL, 0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL,
+        0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL, 0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL,
+        0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL, 0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL,
+        0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL, 0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL,
+        0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL, 0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL,
+        0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL, 0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL,
+        0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL, 0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL,
+        0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL, 0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL,
+        0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL, 0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL,
+        0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL, 0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL,
+        0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL, 0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL,
+        0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL, 0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL,
+        0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL, 0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL,
+        0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL, 0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL,
+        0x924d692ca61be758ULL, 0x593c2626705f9c56ULL, 0xb6e0c377cfa2e12eULL, 0x6f8b2fb00c77836cULL,
+        0xe498f455c38b997aULL, 0x0b6dfb9c0f956447ULL, 0x8edf98b59a373fecULL, 0x4724bd4189bd5eacULL,
+        0xb2977ee300c50fe7ULL, 0x58edec91ec2cb657ULL, 0xdf3d5e9bc0f653e1ULL, 0x2f2967b66737e3edULL,
+        0x8b865b215899f46cULL, 0xbd79e0d20082ee74ULL, 0xae67f1e9aec07187ULL, 0xecd8590680a3aa11ULL,
+        0xda01ee641a708de9ULL, 0xe80e6f4820cc9495ULL, 0x884134fe908658b2ULL, 0x3109058d147fdcddULL,
+        0xaa51823e34a7eedeULL, 0xbd4b46f0599fd415ULL, 0xd4e5e2cdc1d1ea96ULL, 0x6c9e18ac7007c91aULL,
+        0x850fadc09923329eULL, 0x03e2cf6bc604ddb0ULL, 0xa6539930bf6bff45ULL, 0x84db8346b786151cULL,
+        0xcfe87f7cef46ff16ULL, 0xe612641865679a63ULL, 0x81f14fae158c5f6eULL, 0x4fcb7e8f3f60c07eULL,
+        0xa26da3999aef7749ULL, 0xe3be5e330f38f09dULL, 0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc5ULL,
+        0xfdcb4fa002162a63ULL, 0x73d9732fc7c8f7f6ULL, 0x9e9f11c4014dda7eULL, 0x2867e7fddcdd9afaULL,
+        0xc646d63501a1511dULL, 0xb281e1fd541501b8ULL, 0xf7d88bc24209a565ULL, 0x1f225a7ca91a4226ULL,
+        0x9ae757596946075fULL, 0x3375788de9b06958ULL, 0xc1a12d2fc3978937ULL, 0x0052d6b1641c83aeULL,
+        0xf209787bb47d6b84ULL, 0xc0678c5dbd23a49aULL, 0x9745eb4d50ce6332ULL, 0xf840b7ba963646e0ULL,
+        0xbd176620a501fbffULL, 0xb650e5a93bc3d898ULL, 0xec5d3fa8ce427affULL, 0xa3e51f138ab4cebeULL,
+        0x93ba47c980e98cdfULL, 0xc66f336c36b10137ULL, 0xb8a8d9bbe123f017ULL, 0xb80b0047445d4184ULL,
+        0xe6d3102ad96cec1dULL, 0xa60dc059157491e5ULL, 0x9043ea1ac7e41392ULL, 0x87c89837ad68db2fULL,
+        0xb454e4a179dd1877ULL, 0x29babe4598c311fbULL, 0xe16a1dc9d8545e94ULL, 0xf4296dd6fef3d67aULL,
+        0x8ce2529e2734bb1dULL, 0x1899e4a65f58660cULL, 0xb01ae745b101e9e4ULL, 0x5ec05dcff72e7f8fULL,
+        0xdc21a1171d42645dULL, 0x76707543f4fa1f73ULL, 0x899504ae72497ebaULL, 0x6a06494a791c53a8ULL,
+        0xabfa45da0edbde69ULL, 0x0487db9d17636892ULL, 0xd6f8d7509292d603ULL, 0x45a9d2845d3c42b6ULL,
+        0x865b86925b9bc5c2ULL, 0x0b8a2392ba45a9b2ULL, 0xa7f26836f282b732ULL, 0x8e6cac7768d7141eULL,
+        0xd1ef0244af2364ffULL, 0x3207d795430cd926ULL, 0x8335616aed761f1fULL, 0x7f44e6bd49e807b8ULL,
+        0xa402b9c5a8d3a6e7ULL, 0x5f16206c9c6209a6ULL, 0xcd036837130890a1ULL, 0x36dba887c37a8c0fULL,
+        0x802221226be55a64ULL, 0xc2494954da2c9789ULL, 0xa02aa96b06deb0fdULL, 0xf2db9baa10b7bd6cULL,
+        0xc83553c5c8965d3dULL, 0x6f92829494e5acc7ULL, 0xfa42a8b73abbf48cULL, 0xcb772339ba1f17f9ULL,
+        0x9c69a97284b578d7ULL, 0xff2a760414536efbULL, 0xc38413cf25e2d70dULL, 0xfef5138519684abaULL,
+        0xf46518c2ef5b8cd1ULL, 0x7eb258665fc25d69ULL, 0x98bf2f79d5993802ULL, 0xef2f773ffbd97a61ULL,
+        0xbeeefb584aff8603ULL, 0xaafb550ffacfd8faULL, 0xeeaaba2e5dbf6784ULL, 0x95ba2a53f983cf38ULL,
+        0x952ab45cfa97a0b2ULL, 0xdd945a747bf26183ULL, 0xba756174393d88dfULL, 0x94f971119aeef9e4ULL,
+        0xe912b9d1478ceb17ULL, 0x7a37cd5601aab85dULL, 0x91abb422ccb812eeULL, 0xac62e055c10ab33aULL,
+        0xb616a12b7fe617aaULL, 0x577b986b314d6009ULL, 0xe39c49765fdf9d94ULL, 0xed5a7e85fda0b80bULL,
+        0x8e41ade9fbebc27dULL, 0x14588f13be847307ULL, 0xb1d219647ae6b31cULL, 0x596eb2d8ae258fc8ULL,
+        0xde469fbd99a05fe3ULL, 0x6fca5f8ed9aef3bbULL, 0x8aec23d680043beeULL, 0x25de7bb9480d5854ULL,
+        0xada72ccc20054ae9ULL, 0xaf561aa79a10ae6aULL, 0xd910f7ff28069da4ULL, 0x1b2ba1518094da04ULL,
+        0x87aa9aff79042286ULL, 0x90fb44d2f05d0842ULL, 0xa99541bf57452b28ULL, 0x353a1607ac744a53ULL,
+        0xd3fa922f2d1675f2ULL, 0x42889b8997915ce8ULL, 0x847c9b5d7c2e09b7ULL, 0x69956135febada11ULL,
+        0xa59bc234db398c25ULL, 0x43fab9837e699095ULL, 0xcf02b2c21207ef2eULL, 0x94f967e45e03f4bbULL,
+        0x8161afb94b44f57dULL, 0x1d1be0eebac278f5ULL, 0xa1ba1ba79e1632dcULL, 0x6462d92a69731732ULL,
+        0xca28a291859bbf93ULL, 0x7d7b8f7503cfdcfeULL, 0xfcb2cb35e702af78ULL, 0x5cda735244c3d43eULL,
+        0x9defbf01b061adabULL, 0x3a0888136afa64a7ULL, 0xc56baec21c7a1916ULL, 0x088aaa1845b8fdd0ULL,
+        0xf6c69a72a3989f5bULL, 0x8aad549e57273d45ULL, 0x9a3c2087a63f6399ULL, 0x36ac54e2f678864bULL,
+        0xc0cb28a98fcf3c7fULL, 0x84576a1bb416a7ddULL, 0xf0fdf2d3f3c30b9fULL, 0x656d44a2a11c51d5ULL,
+        0x969eb7c47859e743ULL, 0x9f644ae5a4b1b325ULL, 0xbc4665b596706114ULL, 0x873d5d9f0dde1feeULL,
+        0xeb57ff22fc0c7959ULL, 0xa90cb506d155a7eaULL, 0x9316ff75dd87cbd8ULL, 0x09a7f12442d588f2ULL,
+        0xb7dcbf5354e9beceULL, 0x0c11ed6d538aeb2fULL, 0xe5d3ef282a242e81ULL, 0x8f1668c8a86da5faULL,
+        0x8fa475791a569d10ULL, 0xf96e017d694487bcULL, 0xb38d92d760ec4455ULL, 0x37c981dcc395a9acULL,
+        0xe070f78d3927556aULL, 0x85bbe253f47b1417ULL, 0x8c469ab843b89562ULL, 0x93956d7478ccec8eULL,
+        0xaf58416654a6babbULL, 0x387ac8d1970027b2ULL, 0xdb2e51bfe9d0696aULL, 0x06997b05fcc0319eULL,
+        0x88fcf317f22241e2ULL, 0x441fece3bdf81f03ULL, 0xab3c2fddeeaad25aULL, 0xd527e81cad7626c3ULL,
+        0xd60b3bd56a5586f1ULL, 0x8a71e223d8d3b074ULL, 0x85c7056562757456ULL, 0xf6872d5667844e49ULL,
+        0xa738c6bebb12d16cULL, 0xb428f8ac016561dbULL, 0xd106f86e69d785c7ULL, 0xe13336d701beba52ULL,
+        0x82a45b450226b39cULL, 0xecc0024661173473ULL, 0xa34d721642b06084ULL, 0x27f002d7f95d0190ULL,
+        0xcc20ce9bd35c78a5ULL, 0x31ec038df7b441f4ULL, 0xff290242c83396ceULL, 0x7e67047175a15271ULL,
+        0x9f79a169bd203e41ULL, 0x0f0062c6e984d386ULL, 0xc75809c42c684dd1ULL, 0x52c07b78a3e60868ULL,
+        0xf92e0c3537826145ULL, 0xa7709a56ccdf8a82ULL, 0x9bbcc7a142b17ccbULL, 0x88a66076400bb691ULL,
+        0xc2abf989935ddbfeULL, 0x6acff893d00ea435ULL, 0xf356f7ebf83552feULL, 0x0583f6b8c4124d43ULL,
+        0x98165af37b2153deULL, 0xc3727a337a8b704aULL, 0xbe1bf1b059e9a8d6ULL, 0x744f18c0592e4c5cULL,
+        0xeda2ee1c7064130cULL, 0x1162def06f79df73ULL, 0x9485d4d1c63e8be7ULL, 0x8addcb5645ac2ba8ULL,
+        0xb9a74a0637ce2ee1ULL, 0x6d953e2bd7173692ULL, 0xe8111c87c5c1ba99ULL, 0xc8fa8db6ccdd0437ULL,
+        0x910ab1d4db9914a0ULL, 0x1d9c9892400a22a2ULL, 0xb54d5e4a127f59c8ULL, 0x2503beb6d00cab4bULL,
+        0xe2a0b5dc971f303aULL, 0x2e44ae64840fd61dULL, 0x8da471a9de737e24ULL, 0x5ceaecfed289e5d2ULL,
+        0xb10d8e1456105dadULL, 0x7425a83e872c5f47ULL, 0xdd50f1996b947518ULL, 0xd12f124e28f77719ULL,
+        0x8a5296ffe33cc92fULL, 0x82bd6b70d99aaa6fULL, 0xace73cbfdc0bfb7bULL, 0x636cc64d1001550bULL,
+        0xd8210befd30efa5aULL, 0x3c47f7e05401aa4eULL, 0x8714a775e3e95c78ULL, 0x65acfaec34810a71ULL,
+        0xa8d9d1535ce3b396ULL, 0x7f1839a741a14d0dULL, 0xd31045a8341ca07cULL, 0x1ede48111209a050ULL,
+        0x83ea2b892091e44dULL, 0x934aed0aab460432ULL, 0xa4e4b66b68b65d60ULL, 0xf81da84d5617853fULL,
+        0xce1de40642e3f4b9ULL, 0x36251260ab9d668eULL, 0x80d2ae83e9ce78f3ULL, 0xc1d72b7c6b426019ULL,
+        0xa1075a24e4421730ULL, 0xb24cf65b8612f81fULL, 0xc94930ae1d529cfcULL, 0xdee033f26797b627ULL,
+        0xfb9b7cd9a4a7443cULL, 0x169840ef017da3b1ULL, 0x9d412e0806e88aa5ULL, 0x8e1f289560ee864eULL,
+        0xc491798a08a2ad4eULL, 0xf1a6f2bab92a27e2ULL, 0xf5b5d7ec8acb58a2ULL, 0xae10af696774b1dbULL,
+        0x9991a6f3d6bf1765ULL, 0xacca6da1e0a8ef29ULL, 0xbff610b0cc6edd3fULL, 0x17fd090a58d32af3ULL,
+        0xeff394dcff8a948eULL, 0xddfc4b4cef07f5b0ULL, 0x95f83d0a1fb69cd9ULL, 0x4abdaf101564f98eULL,
+        0xbb764c4ca7a4440fULL, 0x9d6d1ad41abe37f1ULL, 0xea53df5fd18d5513ULL, 0x84c86189216dc5edULL,
+        0x92746b9be2f8552cULL, 0x32fd3cf5b4e49bb4ULL, 0xb7118682dbb66a77ULL, 0x3fbc8c33221dc2a1ULL,
+        0xe4d5e82392a40515ULL, 0x0fabaf3feaa5334aULL, 0x8f05b1163ba6832dULL, 0x29cb4d87f2a7400eULL,
+        0xb2c71d5bca9023f8ULL, 0x743e20e9ef511012ULL, 0xdf78e4b2bd342cf6ULL, 0x914da9246b255416ULL,
+        0x8bab8eefb6409c1aULL, 0x1ad089b6c2f7548eULL, 0xae9672aba3d0c320ULL, 0xa184ac2473b529b1ULL,
+        0xda3c0f568cc4f3e8ULL, 0xc9e5d72d90a2741eULL, 0x8865899617fb1871ULL, 0x7e2fa67c7a658892ULL,
+        0xaa7eebfb9df9de8dULL, 0xddbb901b98feeab7ULL, 0xd51ea6fa85785631ULL, 0x552a74227f3ea565ULL,
+        0x8533285c936b35deULL, 0xd53a88958f87275fULL, 0xa67ff273b8460356ULL, 0x8a892abaf368f137ULL,
+        0xd01fef10a657842cULL, 0x2d2b7569b0432d85ULL, 0x8213f56a67f6b29bULL, 0x9c3b29620e29fc73ULL,
+        0xa298f2c501f45f42ULL, 0x8349f3ba91b47b8fULL, 0xcb3f2f7642717713ULL, 0x241c70a936219a73ULL,
+        0xfe0efb53d30dd4d7ULL, 0xed238cd383aa0110ULL, 0x9ec95d1463e8a506ULL, 0xf4363804324a40aaULL,
+        0xc67bb4597ce2ce48ULL, 0xb143c6053edcd0d5ULL, 0xf81aa16fdc1b81daULL, 0xdd94b7868e94050aULL,
+        0x9b10a4e5e9913128ULL, 0xca7cf2b4191c8326ULL, 0xc1d4ce1f63f57d72ULL, 0xfd1c2f611f63a3f0ULL,
+        0xf24a01a73cf2dccfULL, 0xbc633b39673c8cecULL, 0x976e41088617ca01ULL, 0xd5be0503e085d813ULL,
+        0xbd49d14aa79dbc82ULL, 0x4b2d8644d8a74e18ULL, 0xec9c459d51852ba2ULL, 0xddf8e7d60ed1219eULL,
+        0x93e1ab8252f33b45ULL, 0xcabb90e5c942b503ULL, 0xb8da1662e7b00a17ULL, 0x3d6a751f3b936243ULL,
+        0xe7109bfba19c0c9dULL, 0x0cc512670a783ad4ULL, 0x906a617d450187e2ULL, 0x27fb2b80668b24c5ULL,
+        0xb484f9dc9641e9daULL, 0xb1f9f660802dedf6ULL, 0xe1a63853bbd26451ULL, 0x5e7873f8a0396973ULL,
+        0x8d07e33455637eb2ULL, 0xdb0b487b6423e1e8ULL, 0xb049dc016abc5e5fULL, 0x91ce1a9a3d2cda62ULL,
+        0xdc5c5301c56b75f7ULL, 0x7641a140cc7810fbULL, 0x89b9b3e11b6329baULL, 0xa9e904c87fcb0a9dULL,
+        0xac2820d9623bf429ULL, 0x546345fa9fbdcd44ULL, 0xd732290fbacaf133ULL, 0xa97c177947ad4095ULL,
+        0x867f59a9d4bed6c0ULL, 0x49ed8eabcccc485dULL, 0xa81f301449ee8c70ULL, 0x5c68f256bfff5a74ULL,
+        0xd226fc195c6a2f8cULL, 0x73832eec6fff3111ULL, 0x83585d8fd9c25db7ULL, 0xc831fd53c5ff7eabULL,
+        0xa42e74f3d032f525ULL, 0xba3e7ca8b77f5e55ULL, 0xcd3a1230c43fb26fULL, 0x28ce1bd2e55f35ebULL,
+        0x80444b5e7aa7cf85ULL, 0x7980d163cf5b81b3ULL, 0xa0555e361951c366ULL, 0xd7e105bcc332621fULL,
+        0xc86ab5c39fa63440ULL, 0x8dd9472bf3fefaa7ULL, 0xfa856334878fc150ULL, 0xb14f98f6f0feb951ULL,
+        0x9c935e00d4b9d8d2ULL, 0x6ed1bf9a569f33d3ULL, 0xc3b8358109e84f07ULL, 0x0a862f80ec4700c8ULL,
+        0xf4a642e14c6262c8ULL, 0xcd27bb612758c0faULL, 0x98e7e9cccfbd7dbdULL, 0x8038d51cb897789cULL,
+        0xbf21e44003acdd2cULL, 0xe0470a63e6bd56c3ULL, 0xeeea5d5004981478ULL, 0x1858ccfce06cac74ULL,
+        0x95527a5202df0ccbULL, 0x0f37801e0c43ebc8ULL, 0xbaa718e68396cffdULL, 0xd30560258f54e6baULL,
+        0xe950df20247c83fdULL, 0x47c6b82ef32a2069ULL, 0x91d28b7416cdd27eULL, 0x4cdc331d57fa5441ULL,
+        0xb6472e511c81471dULL, 0xe0133fe4adf8e952ULL, 0xe3d8f9e563a198e5ULL, 0x58180fddd97723a6ULL,
+        0x8e679c2f5e44ff8fULL, 0x570f09eaa7ea7648ULL
+
+    };
+    return table;
+}
+
+static const int json_pow5_min = -342;
+static const int json_pow5_max = 308;
+
+// Result of json_parse_number: an int64 when the literal is an integer that
+// fits, a double otherwise (fractions, exponents, integers beyond int64)
+struct json_number_s {
+    bool is_int;
+    int64_t intg;
+    double dbl;
+};
+
+inline unsigned json_ctz64(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long i;
+#ifdef _WIN64
+    _BitScanForward64(&i, x);
+#else
+    if (_BitScanForward(&i, static_cast<unsigned long>(x))) return static_cast<unsigned>(i);
+    _BitScanForward(&i, static_cast<unsigned long>(x >> 32));
+    return 32 + static_cast<unsigned>(i);
+#endif
+    return static_cast<unsigned>(i);
+#else
+    return static_cast<unsigned>(__builtin_ctzll(x));
+#endif
+}
+
+inline unsigned json_clz64(uint64_t x) {
+#ifdef _MSC_VER
+    unsigned long i;
+#ifdef _WIN64
+    _BitScanReverse64(&i, x);
+#else
+    if (_BitScanReverse(&i, static_cast<unsigned long>(x >> 32))) return 31 - static_cast<unsigned>(i);
+    _BitScanReverse(&i, static_cast<unsigned long>(x));
+    return 63 - static_cast<unsigned>(i);
+#endif
+    return 63 - static_cast<unsigned>(i);
+#else
+    return static_cast<unsigned>(__builtin_clzll(x));
+#endif
+}
+
+#if defined(__SIZEOF_INT128__)
+// __extension__ keeps -Wpedantic quiet about the non-standard type
+__extension__ typedef unsigned __int128 json_uint128_t;
+#endif
+
+// Full 64x64 -> 128-bit product
+inline void json_mul128(uint64_t a, uint64_t b, uint64_t& hi, uint64_t& lo) {
+#if defined(__SIZEOF_INT128__)
+    json_uint128_t r = static_cast<json_uint128_t>(a) * b;
+    hi = static_cast<uint64_t>(r >> 64);
+    lo = static_cast<uint64_t>(r);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    lo = _umul128(a, b, &hi);
+#else
+    uint64_t a_lo = a & 0xFFFFFFFFu, a_hi = a >> 32;
+    uint64_t b_lo = b & 0xFFFFFFFFu, b_hi = b >> 32;
+    uint64_t ll = a_lo * b_lo, lh = a_lo * b_hi, hl = a_hi * b_lo, hh = a_hi * b_hi;
+    uint64_t mid = (ll >> 32) + (lh & 0xFFFFFFFFu) + (hl & 0xFFFFFFFFu);
+    lo = (mid << 32) | (ll & 0xFFFFFFFFu);
+    hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+#endif
+}
+
+inline double json_make_double(uint64_t mantissa, int64_t exponent, bool negative) {
+    uint64_t bits = mantissa | (static_cast<uint64_t>(exponent) << 52) |
+                    (static_cast<uint64_t>(negative) << 63);
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// w * 10^q, correctly rounded, for a nonzero w and q in the table's range.
+// Returns false when the result cannot be decided from 128 bits of 5^q or
+// overflows; the caller then takes the slow path.
+inline bool json_eisel_lemire(uint64_t w, int64_t q, bool negative, double& out) {
+    int64_t exponent = (((152170 + 65536) * q) >> 16) + 1024 + 63;
+    int lz = static_cast<int>(json_clz64(w));
+    w <<= lz;
+    const uint64_t* pow5 = json_pow5_128() + 2 * (q - json_pow5_min);
+    
+    uint64_t upper, lower;
+    json_mul128(w, pow5[0], upper, lower);
+    if ((upper & 0x1FF) == 0x1FF) {
+        // The truncated table entry may matter: add the low word's product
+        uint64_t upper2, lower2;
+        json_mul128(w, pow5[1], upper2, lower2);
+        lower += upper2;
+        if (upper2 > lower) upper++;
+        if ((upper & 0x1FF) == 0x1FF && lower + 1 == 0 && lower2 + w < lower2) {
+            return false;
+        }
+    }
+    
+    uint64_t upperbit = upper >> 63;
+    uint64_t mantissa = upper >> (upperbit + 9);
+    lz += static_cast<int>(1 ^ upperbit);
+    int64_t real_exponent = exponent - lz;
+    
+    if (real_exponent <= 0) {
+        // Subnormal, or zero once shifted below the smallest exponent
+        if (-real_exponent + 1 >= 64) {
+            out = negative ? -0.0 : 0.0;
+            return true;
+        }
+        mantissa >>= -real_exponent + 1;
+        mantissa += mantissa & 1;
+        mantissa >>= 1;
+        real_exponent = mantissa < (uint64_t(1) << 52) ? 0 : 1;
+        out = json_make_double(mantissa & ~(uint64_t(1) << 52), real_exponent, negative);
+        return true;
+    }
+    
+    // Exactly halfway between two doubles (only the rounding bit set below
+    // the mantissa): round to even instead of up. Only possible for small |q|.
+    if (lower <= 1 && q >= -4 && q <= 23 && (mantissa & 3) == 1 &&
+        (mantissa << (upperbit + 9)) == upper) {
+        mantissa &= ~uint64_t(1);
+    }
+    mantissa += mantissa & 1;
+    mantissa >>= 1;
+    if (mantissa >= (uint64_t(1) << 53)) {
+        mantissa = uint64_t(1) << 52;
+        real_exponent++;
+    }
+    mantissa &= ~(uint64_t(1) << 52);
+    if (real_exponent > 2046) return false;
+    out = json_make_double(mantissa, real_exponent, negative);
+    return true;
+}
+
+// strtod on [p, p + n) with '.' as the decimal point in any locale
+inline double json_strtod_c(const char* p, size_t n) {
+    char local[128];
+    std::string heap;
+    char* buf = local;
+    if (n >= sizeof(local)) {
+        heap.resize(n + 1);
+        buf = &heap[0];
+    }
+    std::memcpy(buf, p, n);
+    buf[n] = '\0';
+    
+    char point = *std::localeconv()->decimal_point;
+    if (point != '.') {
+        char* dot = static_cast<char*>(std::memchr(buf, '.', n));
+        if (dot) *dot = point;
+    }
+    return std::strtod(buf, nullptr);
+}
+
+inline bool json_is_digit(char c) {
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+// Parses the JSON number starting at p without reading past `end`. Returns
+// the byte after the number, or nullptr when the input is not a valid JSON
+// number or its magnitude overflows a double.
+inline const char* json_parse_number(const char* p, const char* end, json_number_s& out) {
+    static const double exact_pow10[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    const char* start = p;
+    bool negative = false;
+    if (p < end && *p == '-') {
+        negative = true;
+        p++;
+    }
+    if (p >= end || !json_is_digit(*p)) return nullptr;
+    
+    // Integer part; a leading zero must stand alone
+    uint64_t mantissa = 0;
+    int digits = 0;                      // Significant digits in mantissa
+    if (*p == '0') {
+        p++;
+        if (p < end && json_is_digit(*p)) return nullptr;
+    } else {
+        while (p < end && json_is_digit(*p) && digits < 19) {
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            digits++;
+            p++;
+        }
+    }
+    
+    int64_t exp10 = 0;
+    bool is_int = true;
+    if (p < end && *p == '.') {
+        is_int = false;
+        p++;
+        if (p >= end || !json_is_digit(*p)) return nullptr;
+        while (p < end && json_is_digit(*p)) {
+            if (mantissa != 0 || *p != '0') {
+                if (digits >= 19) break;
+                digits++;
+            }
+            mantissa = mantissa * 10 + static_cast<uint64_t>(*p - '0');
+            exp10--;
+            p++;
+        }
+    }
+    
+    bool truncated = p < end && json_is_digit(*p);
+    if (truncated) {
+        // More than 19 significant digits: validate the rest and let strtod
+        // round the full literal
+        while (p < end && (json_is_digit(*p) || *p == '.')) {
+            if (*p == '.') {
+                if (!is_int) return nullptr;
+                is_int = false;
+                if (p + 1 >= end || !json_is_digit(p[1])) return nullptr;
+            }
+            p++;
+        }
+    }
+    
+    if (p < end && (*p == 'e' || *p == 'E')) {
+        is_int = false;
+        p++;
+        bool exp_negative = false;
+        if (p < end && (*p == '+' || *p == '-')) {
+            exp_negative = *p == '-';
+            p++;
+        }
+        if (p >= end || !json_is_digit(*p)) return nullptr;
+        int64_t e = 0;
+        while (p < end && json_is_digit(*p)) {
+            if (e < 100000) e = e * 10 + (*p - '0');   // Saturates well past any double
+            p++;
+        }
+        exp10 += exp_negative ? -e : e;
+    }
+    
+    if (truncated) {
+        out.is_int = false;
+        out.dbl = json_strtod_c(start, static_cast<size_t>(p - start));
+        return std::fabs(out.dbl) <= std::numeric_limits<double>::max() ? p : nullptr;
+    }
+    
+    if (is_int) {
+        // Integers beyond int64 become the nearest double rather than wrapping
+        const uint64_t int64_limit = static_cast<uint64_t>(INT64_MAX);
+        if (mantissa <= int64_limit + (negative ? 1 : 0)) {
+            out.is_int = true;
+            out.intg = negative ? static_cast<int64_t>(0 - mantissa) : static_cast<int64_t>(mantissa);
+            return p;
+        }
+        out.is_int = false;
+        out.dbl = negative ? -static_cast<double>(mantissa) : static_cast<double>(mantissa);
+        return p;
+    }
+    
+    out.is_int = false;
+    if (mantissa == 0 || exp10 < json_pow5_min - 19) {
+        out.dbl = negative ? -0.0 : 0.0;
+        return p;
+    }
+    if (exp10 > json_pow5_max) return nullptr;
+    
+#if !defined(FLT_EVAL_METHOD) || FLT_EVAL_METHOD == 0
+    // Both operands are exact doubles, so one IEEE operation rounds correctly
+    // (not with x87 extended precision, where it could round twice)
+    if (mantissa <= (uint64_t(1) << 53) && exp10 >= -22 && exp10 <= 22) {
+        double d = static_cast<double>(mantissa);
+        d = exp10 < 0 ? d / exact_pow10[-exp10] : d * exact_pow10[exp10];
+        out.dbl = negative ? -d : d;
+        return p;
+    }
+#endif
+    if (exp10 >= json_pow5_min && json_eisel_lemire(mantissa, exp10, negative, out.dbl)) {
+        return p;
+    }
+    out.dbl = json_strtod_c(start, static_cast<size_t>(p - start));
+    return std::fabs(out.dbl) <= std::numeric_limits<double>::max() ? p : nullptr;
+}
+
+// ==================== JSON Scanning ====================
+//
+// Block scanners used by the parser. Each returns a pointer to the first
+// byte in [p, end) that stops the scan, or `end`. Full blocks are tested with
+// SIMD (32 bytes with AVX2, 16 with SSE2 or NEON); the tail shorter than a
+// block, and every byte on other targets, goes through the scalar loop, so
+// no load ever reads past `end`.
+
+// JSON whitespace is exactly these four bytes, independent of the locale
+inline bool json_is_space(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+// Bytes that end a plain run inside a string: the closing quote, an escape,
+// or a control character (not allowed unescaped in JSON strings)
+inline bool json_is_string_special(char c) {
+    return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+}
+
+#ifdef DICT_HAVE_NEON
+// One bit per byte is not available on NEON; narrow to 4 bits per byte
+inline uint64_t json_neon_mask(uint8x16_t m) {
+    return vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(m), 4)), 0);
+}
+#endif
+
+inline const char* json_scan_string(const char* p, const char* end) {
+#if defined(DICT_HAVE_AVX2)
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i max_ctrl = _mm256_set1_epi8(0x1F);
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, quote), _mm256_cmpeq_epi8(v, backslash)),
+            _mm256_cmpeq_epi8(_mm256_max_epu8(v, max_ctrl), max_ctrl));
+        uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(m));
+        if (bits) return p + flat_ctz(bits);
+        p += 32;
+    }
+#endif
+#if defined(DICT_HAVE_SSE2)
+    const __m128i quote16 = _mm_set1_epi8('"');
+    const __m128i backslash16 = _mm_set1_epi8('\\');
+    const __m128i max_ctrl16 = _mm_set1_epi8(0x1F);
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, quote16), _mm_cmpeq_epi8(v, backslash16)),
+            _mm_cmpeq_epi8(_mm_max_epu8(v, max_ctrl16), max_ctrl16));
+        uint32_t bits = static_cast<uint32_t>(_mm_movemask_epi8(m));
+        if (bits) return p + flat_ctz(bits);
+        p += 16;
+    }
+#elif defined(DICT_HAVE_NEON)
+    const uint8x16_t quote16 = vdupq_n_u8('"');
+    const uint8x16_t backslash16 = vdupq_n_u8('\\');
+    const uint8x16_t min_plain = vdupq_n_u8(0x20);
+    while (end - p >= 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, quote16), vceqq_u8(v, backslash16)),
+                                vcltq_u8(v, min_plain));
+        uint64_t bits = json_neon_mask(m);
+        if (bits) return p + (__builtin_ctzll(bits) >> 2);
+        p += 16;
+    }
+#endif
+    while (p < end && !json_is_string_special(*p)) p++;
+    return p;
+}
+
+inline const char* json_skip_space(const char* p, const char* end) {
+    // Tokens are usually separated by zero or one space; only long runs
+    // (pretty-printed indentation) reach the block loop
+    if (p < end && !json_is_space(*p)) return p;
+#if defined(DICT_HAVE_AVX2)
+    const __m256i sp = _mm256_set1_epi8(' ');
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    while (end - p >= 32) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i m = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, nl)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, tab)));
+        uint32_t bits = ~static_cast<uint32_t>(_mm256_movemask_epi8(m));
+        if (bits) return p + flat_ctz(bits);
+        p += 32;
+    }
+#endif
+#if defined(DICT_HAVE_SSE2)
+    const __m128i sp16 = _mm_set1_epi8(' ');
+    const __m128i nl16 = _mm_set1_epi8('\n');
+    const __m128i cr16 = _mm_set1_epi8('\r');
+    const __m128i tab16 = _mm_set1_epi8('\t');
+    while (end - p >= 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i m = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, sp16), _mm_cmpeq_epi8(v, nl16)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, cr16), _mm_cmpeq_epi8(v, tab16)));
+        uint32_t bits = ~static_cast<uint32_t>(_mm_movemask_epi8(m)) & 0xFFFFu;
+        if (bits) return p + flat_ctz(bits);
+        p += 16;
+    }
+#elif defined(DICT_HAVE_NEON)
+    const uint8x16_t sp16 = vdupq_n_u8(' ');
+    const uint8x16_t nl16 = vdupq_n_u8('\n');
+    const uint8x16_t cr16 = vdupq_n_u8('\r');
+    const uint8x16_t tab16 = vdupq_n_u8('\t');
+    while (end - p >= 16) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p));
+        uint8x16_t m = vorrq_u8(vorrq_u8(vceqq_u8(v, sp16), vceqq_u8(v, nl16)),
+                                vorrq_u8(vceqq_u8(v, cr16), vceqq_u8(v, tab16)));
+        uint64_t bits = ~json_neon_mask(m);
+        if (bits) return p + (__builtin_ctzll(bits) >> 2);
+        p += 16;
+    }
+#endif
+    while (p < end && json_is_space(*p)) p++;
+    return p;
+}
+
+// ==================== Serializer ====================
+//
+// Integers are formatted two digits at a time from a lookup table. Doubles
+// use Grisu2 (Loitsch, "Printing Floating-Point Numbers Quickly and
+// Accurately with Integers"): the shortest digit string that parses back to
+// the same double in nearly every case, and always a string that
+// round-trips. Doubles always keep a '.' or an exponent, so they parse back
+// as doubles; NaN and infinities, which JSON cannot express, are written as
+// null.
+
+inline const char* json_digit_pairs() {
+    return "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+           "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+           "8081828384858687888990919293949596979899";
+}
+
+// Writes the decimal digits of v ending just before `end`; returns the start
+inline char* json_format_uint_backward(char* end, uint64_t v) {
+    const char* pairs = json_digit_pairs();
+    while (v >= 100) {
+        unsigned i = static_cast<unsigned>(v % 100) * 2;
+        v /= 100;
+        *--end = pairs[i + 1];
+        *--end = pairs[i];
+    }
+    if (v >= 10) {
+        unsigned i = static_cast<unsigned>(v) * 2;
+        *--end = pairs[i + 1];
+        *--end = pairs[i];
+    } else {
+        *--end = static_cast<char>('0' + v);
+    }
+    return end;
+}
+
+// Formats v into out (at least 20 bytes); returns the end of the text
+inline char* json_format_int(char* out, int64_t v) {
+    char tmp[20];
+    uint64_t u = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+    char* start = json_format_uint_backward(tmp + sizeof(tmp), u);
+    if (v < 0) *out++ = '-';
+    size_t n = static_cast<size_t>(tmp + sizeof(tmp) - start);
+    std::memcpy(out, start, n);
+    return out + n;
+}
+
+// Floating-point value f * 2^e with a 64-bit significand
+struct json_diyfp_s {
+    uint64_t f;
+    int e;
+    
+    json_diyfp_s(uint64_t f_, int e_) : f(f_), e(e_) {}
+    
+    // Upper 64 bits of the 128-bit product, rounded
+    static json_diyfp_s mul(const json_diyfp_s& x, const json_diyfp_s& y) {
+        uint64_t hi, lo;
+        json_mul128(x.f, y.f, hi, lo);
+        return json_diyfp_s(hi + (lo >> 63), x.e + y.e + 64);
+    }
+    
+    static json_diyfp_s normalize(json_diyfp_s x) {
+        int shift = static_cast<int>(json_clz64(x.f));
+        return json_diyfp_s(x.f << shift, x.e - shift);
+    }
+};
+
+struct json_cached_power_s {
+    uint64_t f;
+    int e;
+    int k;                               // f * 2^e ~= 10^k
+};
+
+// Cached powers of ten for Grisu2, 10^k for k = -300, -292, ..., 324
+inline const json_cached_power_s& json_cached_power(int index) {
+    static const json_cached_power_s table[] = {
+        { 0xAB70FE17C79AC6CAULL, -1060, -300 }, { 0xFF77B1FCBEBCDC4FULL, -1034, -292 },
+        { 0xBE5691EF416BD60CULL, -1007, -284 }, { 0x8DD01FAD907FFC3CULL,  -980, -276 },
+        { 0xD3515C2831559A83ULL,  -954, -268 }, { 0x9D71AC8FADA6C9B5ULL,  -927, -260 },
+        { 0xEA9C227723EE8BCBULL,  -901, -252 }, { 0xAECC49914078536DULL,  -874, -244 },
+        { 0x823C12795DB6CE57ULL,  -847, -236 }, { 0xC21094364DFB5637ULL,  -821, -228 },
+        { 0x9096EA6F3848984FULL,  -794, -220 }, { 0xD77485CB25823AC7ULL,  -768, -212 },
+        { 0xA086CFCD97BF97F4ULL,  -741, -204 }, { 0xEF340A98172AACE5ULL,  -715, -196 },
+        { 0xB23867FB2A35B28EULL,  -688, -188 }, { 0x84C8D4DFD2C63F3BULL,  -661, -180 },
+        { 0xC5DD44271AD3CDBAULL,  -635, -172 }, { 0x936B9FCEBB25C996ULL,  -608, -164 },
+        { 0xDBAC6C247D62A584ULL,  -582, -156 }, { 0xA3AB66580D5FDAF6ULL,  -555, -148 },
+        { 0xF3E2F893DEC3F126ULL,  -529, -140 }, { 0xB5B5ADA8AAFF80B8ULL,  -502, -132 },
+        { 0x87625F056C7C4A8BULL,  -475, -124 }, { 0xC9BCFF6034C13053ULL,  -449, -116 },
+        { 0x964E858C91BA2655ULL,  -422, -108 }, { 0xDFF9772470297EBDULL,  -396, -100 },
+        { 0xA6DFBD9FB8E5B88FULL,  -369,  -92 }, { 0xF8A95FCF88747D94ULL,  -343,  -84 },
+        { 0xB94470938FA89BCFULL,  -316,  -76 }, { 0x8A08F0F8BF0F156BULL,  -289,  -68 },
+        { 0xCDB02555653131B6ULL,  -263,  -60 }, { 0x993FE2C6D07B7FACULL,  -236,  -52 },
+        { 0xE45C10C42A2B3B06ULL,  -210,  -44 }, { 0xAA242499697392D3ULL,  -183,  -36 },
+        { 0xFD87B5F28300CA0EULL,  -157,  -28 }, { 0xBCE5086492111AEBULL,  -130,  -20 },
+        { 0x8CBCCC096F5088CCULL,  -103,  -12 }, { 0xD1B71758E219652CULL,   -77,   -4 },
+        { 0x9C40000000000000ULL,   -50,    4 }, { 0xE8D4A51000000000ULL,   -24,   12 },
+        { 0xAD78EBC5AC620000ULL,     3,   20 }, { 0x813F3978F8940984ULL,    30,   28 },
+        { 0xC097CE7BC90715B3ULL,    56,   36 }, { 0x8F7E32CE7BEA5C70ULL,    83,   44 },
+        { 0xD5D238A4ABE98068ULL,   109,   52 }, { 0x9F4F2726179A2245ULL,   136,   60 },
+        { 0xED63A231D4C4FB27ULL,   162,   68 }, { 0xB0DE65388CC8ADA8ULL,   189,   76 },
+        { 0x83C7088E1AAB65DBULL,   216,   84 }, { 0xC45D1DF942711D9AULL,   242,   92 },
+        { 0x924D692CA61BE758ULL,   269,  100 }, { 0xDA01EE641A708DEAULL,   295,  108 },
+        { 0xA26DA3999AEF774AULL,   322,  116 }, { 0xF209787BB47D6B85ULL,   348,  124 },
+        { 0xB454E4A179DD1877ULL,   375,  132 }, { 0x865B86925B9BC5C2ULL,   402,  140 },
+        { 0xC83553C5C8965D3DULL,   428,  148 }, { 0x952AB45CFA97A0B3ULL,   455,  156 },
+        { 0xDE469FBD99A05FE3ULL,   481,  164 }, { 0xA59BC234DB398C25ULL,   508,  172 },
+        { 0xF6C69A72A3989F5CULL,   534,  180 }, { 0xB7DCBF5354E9BECEULL,   561,  188 },
+        { 0x88FCF317F22241E2ULL,   588,  196 }, { 0xCC20CE9BD35C78A5ULL,   614,  204 },
+        { 0x98165AF37B2153DFULL,   641,  212 }, { 0xE2A0B5DC971F303AULL,   667,  220 },
+        { 0xA8D9D1535CE3B396ULL,   694,  228 }, { 0xFB9B7CD9A4A7443CULL,   720,  236 },
+        { 0xBB764C4CA7A44410ULL,   747,  244 }, { 0x8BAB8EEFB6409C1AULL,   774,  252 },
+        { 0xD01FEF10A657842CULL,   800,  260 }, { 0x9B10A4E5E9913129ULL,   827,  268 },
+        { 0xE7109BFBA19C0C9DULL,   853,  276 }, { 0xAC2820D9623BF429ULL,   880,  284 },
+        { 0x80444B5E7AA7CF85ULL,   907,  292 }, { 0xBF21E44003ACDD2DULL,   933,  300 },
+        { 0x8E679C2F5E44FF8FULL,   960,  308 }, { 0xD433179D9C8CB841ULL,   986,  316 },
+        { 0x9E19DB92B4E31BA9ULL,  1013,  324 }
+    };
+    return table[index];
+}
+
+// Grisu2 keeps the scaled boundaries' exponent in [alpha, gamma]
+static const int json_grisu_alpha = -60;
+static const int json_grisu_gamma = -32;
+
+// Rounds the last digit towards w while staying inside the boundaries
+inline void json_grisu_round(char* buf, int len, uint64_t dist, uint64_t delta,
+                             uint64_t rest, uint64_t ten_k) {
+    while (rest < dist && delta - rest >= ten_k &&
+           (rest + ten_k < dist || dist - rest > rest + ten_k - dist)) {
+        buf[len - 1]--;
+        rest += ten_k;
+    }
+}
+
+// Generates the shortest digits of a value in [m_minus, m_plus]
+inline void json_grisu_digits(char* buf, int& len, int& exp10,
+                              json_diyfp_s m_minus, json_diyfp_s w, json_diyfp_s m_plus) {
+    uint64_t delta = m_plus.f - m_minus.f;
+    uint64_t dist = m_plus.f - w.f;
+    const int shift = -m_plus.e;
+    const uint64_t one = uint64_t(1) << shift;
+    
+    uint32_t p1 = static_cast<uint32_t>(m_plus.f >> shift);   // Integral part
+    uint64_t p2 = m_plus.f & (one - 1);                        // Fractional part
+    
+    uint32_t pow10 = 1;
+    int n = 1;
+    while (n < 10 && p1 >= pow10 * 10) {
+        pow10 *= 10;
+        n++;
+    }
+    
+    while (n > 0) {
+        uint32_t d = p1 / pow10;
+        p1 %= pow10;
+        buf[len++] = static_cast<char>('0' + d);
+        n--;
+        uint64_t rest = (static_cast<uint64_t>(p1) << shift) + p2;
+        if (rest <= delta) {
+            exp10 += n;
+            json_grisu_round(buf, len, dist, delta, rest, static_cast<uint64_t>(pow10) << shift);
+            return;
+        }
+        pow10 /= 10;
+    }
+    
+    int m = 0;
+    for (;;) {
+        p2 *= 10;
+        buf[len++] = static_cast<char>('0' + (p2 >> shift));
+        p2 &= one - 1;
+        m++;
+        delta *= 10;
+        dist *= 10;
+        if (p2 <= delta) break;
+    }
+    exp10 -= m;
+    json_grisu_round(buf, len, dist, delta, p2, one);
+}
+
+// Shortest digits of a positive finite v: v ~= digits * 10^exp10
+inline void json_grisu2(char* buf, int& len, int& exp10, double v) {
+    uint64_t bits;
+    std::memcpy(&bits, &v, sizeof(bits));
+    const uint64_t hidden = uint64_t(1) << 52;
+    const int biased = static_cast<int>(bits >> 52);
+    const uint64_t fraction = bits & (hidden - 1);
+    
+    json_diyfp_s x = biased == 0 ? json_diyfp_s(fraction, 1 - 1075)
+                                 : json_diyfp_s(fraction + hidden, biased - 1075);
+    // The lower boundary is closer when v is a power of two
+    bool lower_closer = fraction == 0 && biased > 1;
+    json_diyfp_s m_plus = json_diyfp_s::normalize(json_diyfp_s(2 * x.f + 1, x.e - 1));
+    json_diyfp_s m_minus = lower_closer ? json_diyfp_s(4 * x.f - 1, x.e - 2)
+                                        : json_diyfp_s(2 * x.f - 1, x.e - 1);
+    m_minus = json_diyfp_s(m_minus.f << (m_minus.e - m_plus.e), m_plus.e);
+    x = json_diyfp_s::normalize(x);
+    
+    // Pick a cached 10^k that brings m_plus's exponent into [alpha, gamma]
+    int f = json_grisu_alpha - m_plus.e - 1;
+    int k = (f * 78913) / (1 << 18) + (f > 0 ? 1 : 0);        // ceil(f * log10(2))
+    const json_cached_power_s& cached = json_cached_power((300 + k + 7) / 8);
+    json_diyfp_s c(cached.f, cached.e);
+    
+    json_diyfp_s w = json_diyfp_s::mul(x, c);
+    json_diyfp_s w_minus = json_diyfp_s::mul(m_minus, c);
+    json_diyfp_s w_plus = json_diyfp_s::mul(m_plus, c);
+    
+    // Shrink the interval by one unit on each side to stay conservative
+    len = 0;
+    exp10 = -cached.k;
+    json_grisu_digits(buf, len, exp10, json_diyfp_s(w_minus.f + 1, w_minus.e), w,
+                      json_diyfp_s(w_plus.f - 1, w_plus.e));
+}
+
+// Formats v into out (at least 32 bytes); returns the end of the text.
+// Plain notation from 1e-4 up to 1e15, scientific otherwise.
+inline char* json_format_double(char* out, double v) {
+    if (v != v || v - v != 0) {          // NaN or infinity
+        std::memcpy(out, "null", 4);
+        return out + 4;
+    }
+    if (std::signbit(v)) {
+        *out++ = '-';
+        v = -v;
+    }
+    if (v == 0) {
+        std::memcpy(out, "0.0", 3);
+        return out + 3;
+    }
+    
+    char* digits = out;
+    int len, exp10;
+    json_grisu2(digits, len, exp10, v);
+    
+    const int point = len + exp10;       // Decimal point position in the digits
+    if (len <= point && point <= 15) {
+        // 1234000.0
+        std::memset(digits + len, '0', static_cast<size_t>(point - len));
+        digits[point] = '.';
+        digits[point + 1] = '0';
+        return digits + point + 2;
+    }
+    if (0 < point && point <= 15) {
+        // 12.34
+        std::memmove(digits + point + 1, digits + point, static_cast<size_t>(len - point));
+        digits[point] = '.';
+        return digits + len + 1;
+    }
+    if (-4 < point && point <= 0) {
+        // 0.001234
+        std::memmove(digits + 2 - point, digits, static_cast<size_t>(len));
+        digits[0] = '0';
+        digits[1] = '.';
+        std::memset(digits + 2, '0', static_cast<size_t>(-point));
+        return digits + 2 - point + len;
+    }
+    // 1.234e+56
+    char* p = digits + 1;
+    if (len > 1) {
+        std::memmove(digits + 2, digits + 1, static_cast<size_t>(len - 1));
+        digits[1] = '.';
+        p = digits + len + 1;
+    }
+    *p++ = 'e';
+    int e = point - 1;
+    *p++ = e < 0 ? '-' : '+';
+    return json_format_int(p, e < 0 ? -e : e);
+}
+
+inline void json_writer_s::write_int(int64_t v) {
+    char tmp[24];
+    buf.append(tmp, static_cast<size_t>(json_format_int(tmp, v) - tmp));
+}
+
+inline void json_writer_s::write_uint(uint64_t v) {
+    char tmp[20];
+    char* start = json_format_uint_backward(tmp + sizeof(tmp), v);
+    buf.append(start, static_cast<size_t>(tmp + sizeof(tmp) - start));
+}
+
+inline void json_writer_s::write_double(double v) {
+    char tmp[40];
+    buf.append(tmp, static_cast<size_t>(json_format_double(tmp, v) - tmp));
+}
+
+inline void json_writer_s::write_string(str_view_s s) {
+    static const char hex[] = "0123456789abcdef";
+    const char* p = s.data;
+    const char* end = s.data + s.size;
+    put('"');
+    while (p < end) {
+        // Plain runs are copied in one go; the scanner stops at the bytes
+        // that need escaping
+        const char* run_end = json_scan_string(p, end);
+        buf.append(p, static_cast<size_t>(run_end - p));
+        if (run_end == end) break;
+        char c = *run_end;
+        put('\\');
+        switch (c) {
+            case '"': put('"'); break;
+            case '\\': put('\\'); break;
+            case '\b': put('b'); break;
+            case '\f': put('f'); break;
+            case '\n': put('n'); break;
+            case '\r': put('r'); break;
+            case '\t': put('t'); break;
+            default:
+                write("u00", 3);
+                put(hex[(c >> 4) & 0xF]);
+                put(hex[c & 0xF]);
+                break;
+        }
+        p = run_end + 1;
+    }
+    put('"');
+}
+
+inline bool json_writer_s::flush() {
+    if (sink && !failed && !buf.empty()) {
+        failed = !sink->write(buf.data(), buf.size());
+    }
+    buf.clear();
+    return !failed;
+}
+
+inline void json_writer_s::write_newline(int spaces) {
+    put('\n');
+    buf.append(static_cast<size_t>(spaces), ' ');
+}
+
+inline dict_sink_s::dict_sink_s(int fd) : chunk_size(64 * 1024) {
+    callback = [fd](const char* data, size_t size) {
+        while (size > 0) {
+#ifdef _WIN32
+            int n = _write(fd, data, static_cast<unsigned>(size));
+#else
+            ssize_t n = ::write(fd, data, size);
+#endif
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    };
+}
+
+inline dict_sink_s::dict_sink_s(FILE* file) : chunk_size(64 * 1024) {
+    callback = [file](const char* data, size_t size) {
+        return std::fwrite(data, 1, size, file) == size;
+    };
+}
+
+inline dict_sink_s::dict_sink_s(std::ostream& os) : chunk_size(64 * 1024) {
+    std::ostream* out = &os;
+    callback = [out](const char* data, size_t size) {
+        out->write(data, static_cast<std::streamsize>(size));
+        return static_cast<bool>(*out);
+    };
+}
+
+inline dict_sink_s::dict_sink_s(callback_t cb) : chunk_size(64 * 1024), callback(std::move(cb)) {}
+
+inline void json_write_value(json_writer_s& w, const val_s& val, int indent, int level) {
+    switch (val.t) {
+        case json_null_t:
+            w.write("null", 4);
+            break;
+        case json_bool_t:
+            if (val.boolean) w.write("true", 4); else w.write("false", 5);
+            break;
+        case json_integer_t:
+            w.write_int(val.intg);
+            break;
+        case json_double_t:
+            w.write_double(val.dbl);
+            break;
+        case json_string_t:
+            w.write_string(val.str_view());
+            break;
+        case json_array:
+            w.put('[');
+            if (val.layout == json_array_int) {
+                for (size_t i = 0; i < val.arr_intg.size(); ++i) {
+                    if (i > 0) w.put(',');
+                    w.write_int(val.arr_intg[i]);
+                    w.maybe_flush();
+                }
+            } else if (val.layout == json_array_double) {
+                for (size_t i = 0; i < val.arr_dbl.size(); ++i) {
+                    if (i > 0) w.put(',');
+                    w.write_double(val.arr_dbl[i]);
+                    w.maybe_flush();
+                }
+            } else if (val.layout == json_array_bool) {
+                for (size_t i = 0; i < val.arr_bool.size(); ++i) {
+                    if (i > 0) w.put(',');
+                    if (val.arr_bool[i]) w.write("true", 4); else w.write("false", 5);
+                    w.maybe_flush();
+                }
+            } else {
+                for (size_t i = 0; i < val.arr.size(); ++i) {
+                    if (i > 0) w.put(',');
+                    json_write_value(w, val.arr[i], indent, level);
+                    w.maybe_flush();
+                }
+            }
+            w.put(']');
+            break;
+        case json_object_t:
+            if (val.obj) {
+                val.obj->dump_internal(w, indent, level + 1);
+            } else {
+                w.write("{}", 2);
+            }
+            break;
+    }
+}
+
+// ==================== JSON Parser Implementation ====================
+
+inline JSONParser::JSONParser(const std::string& json, dict_arena* arena, key_pool_s* pool) 
+    : begin(json.c_str()), cursor(json.c_str()), end(json.c_str() + json.size()), arena(arena),
+      pool(pool ? pool : &local_pool), mode(json_strings_copy),
+      splice_at(nullptr), splice_end(nullptr), splice_val(nullptr) {}
+
+inline JSONParser::JSONParser(const char* data, size_t size, dict_arena* arena, key_pool_s* pool,
+                              json_string_modes mode)
+    : begin(data), cursor(data), end(data + size), arena(arena),
+      pool(pool ? pool : &local_pool), mode(mode),
+      splice_at(nullptr), splice_end(nullptr), splice_val(nullptr) {}
+
+// Nested objects come from the arena when parsing into a doc_s, and from the
+// heap otherwise
+inline std::shared_ptr<dict_s> JSONParser::make_dict() {
+    if (arena) {
+        return std::allocate_shared<dict_s>(dict_allocator<dict_s>(arena), arena);
+    }
+    return std::make_shared<dict_s>();
+}
+
+inline void JSONParser::skip_whitespace() {
+    cursor = json_skip_space(cursor, end);
+}
+
+inline bool JSONParser::parse(dict_s& dict) {
+    skip_whitespace();
+    return parse_object(dict);
+}
+
+inline bool JSONParser::parse(val_s& val) {
+    skip_whitespace();
+    return parse_value(val);
+}
+
+inline bool JSONParser::parse_value(val_s& val) {
+    skip_whitespace();
+    if (cursor >= end) return false;
+    
+    if (cursor == splice_at) {
+        val = std::move(*splice_val);
+        cursor = splice_end;
+        return true;
+    }
+    if (*cursor == '{') {
+        val.set_type(json_object_t);
+        val.obj = make_dict();
+        return parse_object(*val.obj);
+    } else if (*cursor == '[') {
+        return parse_array(val);
+    } else if (*cursor == '"') {
+        if (mode != json_strings_copy) return parse_borrowed_string(val);
+        val.set_type(json_string_t);
+        return parse_string(val.str);
+    } else if (*cursor == 't' || *cursor == 'f' || *cursor == 'n') {
+        return parse_literal(val);
+    } else if (*cursor == '-' || json_is_digit(*cursor)) {
+        return parse_number(val);
+    }
+    
+    return false;
+}
+
+inline bool JSONParser::parse_object(dict_s& dict) {
+    skip_whitespace();
+    if (cursor >= end || *cursor != '{') return false;
+    cursor++; // Skip '{'
+    
+    skip_whitespace();
+    if (cursor < end && *cursor == '}') {
+        cursor++;
+        return true; // Empty object
+    }
+    
+    while (cursor < end) {
+        if (!parse_member(dict)) return false;
+        
+        skip_whitespace();
+        if (cursor >= end) return false;
+        
+        if (*cursor == '}') {
+            cursor++;
+            return true;
+        } else if (*cursor == ',') {
+            cursor++;
+        } else {
+            return false;
+        }
+    }
+    
+    return false;
+}
+
+// Parses one `key: value` member at the cursor into `dict`
+inline bool JSONParser::parse_member(dict_s& dict) {
+    skip_whitespace();
+    if (cursor >= end) return false;
+    
+    // Parse key. It is interned before the value is parsed, since
+    // nested objects reuse key_buf.
+    key_s key;
+    int key_int = 0;
+    bool is_string_key = true;
+    
+    if (*cursor == '"') {
+        // Keys without escapes are interned straight from the input
+        const char* run_end = json_scan_string(cursor + 1, end);
+        if (run_end < end && *run_end == '"') {
+            key = pool->intern(str_view_s(cursor + 1, run_end - (cursor + 1)));
+            cursor = run_end + 1;
+        } else {
+            if (!parse_string(key_buf)) return false;
+            key = pool->intern(key_buf);
+        }
+    } else if (json_is_digit(*cursor) || *cursor == '-') {
+        // Integer key (an extension to JSON); must fit in int32_t
+        json_number_s num;
+        const char* next = json_parse_number(cursor, end, num);
+        if (!next || !num.is_int || num.intg < INT32_MIN || num.intg > INT32_MAX) return false;
+        key_int = static_cast<int>(num.intg);
+        cursor = next;
+        is_string_key = false;
+    } else {
+        return false;
+    }
+    
+    skip_whitespace();
+    if (cursor >= end || *cursor != ':') return false;
+    cursor++; // Skip ':'
+    
+    // Parse value
+    val_s val;
+    if (!parse_value(val)) return false;
+    
+    // Store in dict
+    if (is_string_key) {
+        dict.set(key, std::move(val));
+    } else {
+        dict.set(key_int, std::move(val));
+    }
+    return true;
+}
+
+inline bool JSONParser::parse_members(dict_s& dict) {
+    while (true) {
+        if (!parse_member(dict)) return false;
+        skip_whitespace();
+        if (cursor >= end) return true;
+        if (*cursor != ',') return false;
+        cursor++;
+    }
+}
+
+inline bool JSONParser::parse_elements(val_s& val) {
+    val.set_type(json_array);
+    val.arr = val_s::array_t(dict_allocator<val_s>(arena));
+    while (true) {
+        val_s item;
+        if (!parse_value(item)) return false;
+        val.push_back(std::move(item));
+        skip_whitespace();
+        if (cursor >= end) return true;
+        if (*cursor != ',') return false;
+        cursor++;
+    }
+}
+
+inline bool JSONParser::parse_array(val_s& val) {
+    skip_whitespace();
+    if (cursor >= end || *cursor != '[') return false;
+    cursor++; // Skip '['
+    
+    val.set_type(json_array);
+    val.arr = val_s::array_t(dict_allocator<val_s>(arena));
+    
+    skip_whitespace();
+    if (cursor < end && *cursor == ']') {
+        cursor++;
+        return true; // Empty array
+    }
+    
+    while (cursor < end) {
+        val_s item;
+        if (!parse_value(item)) return false;
+        val.push_back(std::move(item));     // Packs homogeneous scalar arrays
+        
+        skip_whitespace();
+        if (cursor >= end) return false;
+        
+        if (*cursor == ']') {
+            cursor++;
+            return true;
+        } else if (*cursor == ',') {
+            cursor++;
+        } else {
+            return false;
+        }
+    }
+    
+    return false;
+}
+
+// Reads four hex digits at p, if there are four before `end`
+inline bool json_read_hex4(const char* p, const char* end, uint32_t& out) {
+    if (end - p < 4) return false;
+    out = 0;
+    for (int i = 0; i < 4; i++) {
+        char c = p[i];
+        uint32_t d;
+        if (c >= '0' && c <= '9') d = static_cast<uint32_t>(c - '0');
+        else if (c >= 'a' && c <= 'f') d = static_cast<uint32_t>(c - 'a' + 10);
+        else if (c >= 'A' && c <= 'F') d = static_cast<uint32_t>(c - 'A' + 10);
+        else return false;
+        out = (out << 4) | d;
+    }
+    return true;
+}
+
+// Character a single-character escape (the byte after '\\') stands for, or
+// 0 if it is not one
+inline char json_unescape_char(char c) {
+    switch (c) {
+        case '"': return '"';
+        case '\\': return '\\';
+        case '/': return '/';
+        case 'b': return '\b';
+        case 'f': return '\f';
+        case 'n': return '\n';
+        case 'r': return '\r';
+        case 't': return '\t';
+        default: return 0;
+    }
+}
+
+// Writes code point `cp` as 1 to 4 bytes of UTF-8 and returns the count
+inline size_t json_encode_utf8(uint32_t cp, char* out) {
+    if (cp < 0x80) {
+        out[0] = static_cast<char>(cp);
+        return 1;
+    } else if (cp < 0x800) {
+        out[0] = static_cast<char>(0xC0 | (cp >> 6));
+        out[1] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 2;
+    } else if (cp < 0x10000) {
+        out[0] = static_cast<char>(0xE0 | (cp >> 12));
+        out[1] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out[2] = static_cast<char>(0x80 | (cp & 0x3F));
+        return 3;
+    }
+    out[0] = static_cast<char>(0xF0 | (cp >> 18));
+    out[1] = static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+    out[2] = static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+    out[3] = static_cast<char>(0x80 | (cp & 0x3F));
+    return 4;
+}
+
+// Decodes \uXXXX with p on the 'u', combining a surrogate pair into one
+// code point. Returns a pointer to the last hex digit, or nullptr if the
+// escape is malformed.
+inline const char* json_decode_unicode_escape(const char* p, const char* end, uint32_t& cp) {
+    if (!json_read_hex4(p + 1, end, cp)) return nullptr;
+    p += 4;
+    if (cp >= 0xD800 && cp <= 0xDBFF) {
+        uint32_t low;
+        if (end - p < 3 || p[1] != '\\' || p[2] != 'u' ||
+            !json_read_hex4(p + 3, end, low) || low < 0xDC00 || low > 0xDFFF) {
+            return nullptr;
+        }
+        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        p += 6;
+    } else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+        return nullptr;                  // Unpaired low surrogate
+    }
+    return p;
+}
+
+// Decodes the string whose opening quote is at p into `out`. Returns the
+// position after the closing quote, or nullptr for a malformed or
+// unterminated string.
+inline const char* json_decode_string(const char* p, const char* end, std::string& out) {
+    if (p >= end || *p != '"') return nullptr;
+    p++; // Skip opening '"'
+    
+    out.clear();
+    while (p < end) {
+        // Append the whole run up to the next quote, escape or control byte
+        const char* run_end = json_scan_string(p, end);
+        out.append(p, run_end - p);
+        p = run_end;
+        if (p >= end) return nullptr;
+        
+        if (*p == '"') {
+            return p + 1;
+        } else if (*p == '\\') {
+            p++;
+            if (p >= end) return nullptr;
+            if (*p == 'u') {
+                uint32_t cp;
+                p = json_decode_unicode_escape(p, end, cp);
+                if (!p) return nullptr;
+                char utf8[4];
+                out.append(utf8, json_encode_utf8(cp, utf8));
+            } else {
+                char c = json_unescape_char(*p);
+                if (!c) return nullptr;
+                out += c;
+            }
+            p++;
+        } else {
+            return nullptr;              // Unescaped control character
+        }
+    }
+    
+    return nullptr;
+}
+
+inline bool JSONParser::parse_string(std::string& str) {
+    const char* next = json_decode_string(cursor, end, str);
+    if (!next) return false;
+    cursor = next;
+    return true;
+}
+
+// Leaves the cursor on the last hex digit like the single-character escapes
+inline bool JSONParser::parse_unicode_escape(uint32_t& cp) {
+    const char* last = json_decode_unicode_escape(cursor, end, cp);
+    if (!last) return false;
+    cursor = last;
+    return true;
+}
+
+// String value in one of the zero-copy modes. Strings without escapes, the
+// common case, become a view of the input as is. Escaped ones are decoded
+// in place when the input is writable: every escape is at least as long as
+// what it decodes to, so the output never overtakes the cursor. Read-only
+// input is decoded into the arena instead (into an owned string without one).
+inline bool JSONParser::parse_borrowed_string(val_s& val) {
+    const char* start = cursor + 1;
+    const char* run_end = json_scan_string(start, end);
+    if (run_end < end && *run_end == '"') {
+        val.borrow(str_view_s(start, run_end - start));
+        cursor = run_end + 1;
+        return true;
+    }
+    
+    if (mode != json_strings_insitu) {
+        if (!parse_string(key_buf)) return false;
+        if (!arena) {
+            val = key_buf;
+            return true;
+        }
+        char* copy = static_cast<char*>(arena->allocate(key_buf.size(), 1));
+        std::memcpy(copy, key_buf.data(), key_buf.size());
+        val.borrow(str_view_s(copy, key_buf.size()));
+        return true;
+    }
+    
+    // The caller handed over a writable buffer (see the constructor)
+    char* out = const_cast<char*>(run_end);
+    cursor = run_end;
+    while (cursor < end) {
+        if (*cursor == '"') {
+            val.borrow(str_view_s(start, out - start));
+            cursor++;
+            return true;
+        } else if (*cursor == '\\') {
+            cursor++;
+            if (cursor >= end) return false;
+            if (*cursor == 'u') {
+                uint32_t cp;
+                if (!parse_unicode_escape(cp)) return false;
+                out += json_encode_utf8(cp, out);
+            } else {
+                char c = json_unescape_char(*cursor);
+                if (!c) return false;
+                *out++ = c;
+            }
+            cursor++;
+        } else {
+            return false;                // Unescaped control character
+        }
+        
+        run_end = json_scan_string(cursor, end);
+        std::memmove(out, cursor, run_end - cursor);
+        out += run_end - cursor;
+        cursor = run_end;
+    }
+    
+    return false;
+}
+
+inline bool JSONParser::parse_number(val_s& val) {
+    json_number_s num;
+    const char* next = json_parse_number(cursor, end, num);
+    if (!next) return false;
+    
+    if (num.is_int) {
+        val.set_type(json_integer_t);
+        val.intg = num.intg;
+    } else {
+        val.set_type(json_double_t);
+        val.dbl = num.dbl;
+    }
+    cursor = next;
+    return true;
+}
+
+inline bool JSONParser::parse_literal(val_s& val) {
+    if (cursor + 4 <= end && std::strncmp(cursor, "null", 4) == 0) {
+        val.set_type(json_null_t);
+        cursor += 4;
+        return true;
+    } else if (cursor + 4 <= end && std::strncmp(cursor, "true", 4) == 0) {
+        val.set_type(json_bool_t);
+        val.boolean = true;
+        cursor += 4;
+        return true;
+    } else if (cursor + 5 <= end && std::strncmp(cursor, "false", 5) == 0) {
+        val.set_type(json_bool_t);
+        val.boolean = false;
+        cursor += 5;
+        return true;
+    }
+    return false;
+}
+
+// ==================== lazy_doc_s Implementation ====================
+
+// Steps over the string starting at the quote at p, checking escapes the way
+// the parser does. Returns the position after the closing quote, or nullptr.
+inline const char* json_skip_string(const char* p, const char* end) {
+    p++;
+    while (true) {
+        p = json_scan_string(p, end);
+        if (p >= end) return nullptr;
+        if (*p == '"') return p + 1;
+        if (*p != '\\' || ++p >= end) return nullptr;
+        if (*p == 'u') {
+            uint32_t cp;
+            p = json_decode_unicode_escape(p, end, cp);
+            if (!p) return nullptr;
+        } else if (!json_unescape_char(*p)) {
+            return nullptr;
+        }
+        p++;
+    }
+}
+
+// Validates a number without converting it. Exponents and very long
+// mantissas go through json_parse_number, since whether they are valid
+// depends on the value overflowing.
+inline const char* json_skip_number(const char* p, const char* end) {
+    const char* start = p;
+    if (p < end && *p == '-') p++;
+    if (p >= end || !json_is_digit(*p)) return nullptr;
+    if (*p == '0') {
+        p++;
+    } else {
+        while (p < end && json_is_digit(*p)) p++;
+    }
+    if (p < end && *p == '.') {
+        const char* digits = ++p;
+        while (p < end && json_is_digit(*p)) p++;
+        if (p == digits) return nullptr;
+    }
+    if ((p < end && (*p == 'e' || *p == 'E')) || p - start > 300) {
+        json_number_s num;
+        return json_parse_number(start, end, num);
+    }
+    return p;
+}
+
+// Steps over a scalar already known to be valid
+inline const char* json_skip_scalar(const char* p, const char* end) {
+    if (*p == '"') {
+        p++;
+        while (true) {
+            p = json_scan_string(p, end);
+            if (*p == '"') return p + 1;
+            p += 2;                      // Backslash and the byte after it
+        }
+    }
+    while (p < end && *p != ',' && *p != '}' && *p != ']' && !json_is_space(*p)) p++;
+    return p;
+}
+
+inline lazy_doc_s::lazy_doc_s(const std::string& json)
+    : valid(false), text(json), root_begin(0), root_end(0), arena(new dict_arena()) {
+    build_index();
+}
+
+inline lazy_doc_s::lazy_doc_s(std::string&& json)
+    : valid(false), text(std::move(json)), root_begin(0), root_end(0), arena(new dict_arena()) {
+    build_index();
+}
+
+inline void lazy_doc_s::build_index() {
+    const char* begin = text.data();
+    const char* end = begin + text.size();
+    const char* p = json_skip_space(begin, end);
+    const char* after = index_value(p, end);
+    valid = after && json_skip_space(after, end) == end;
+    if (valid) {
+        root_begin = static_cast<size_t>(p - begin);
+        root_end = static_cast<size_t>(after - begin);
+    } else {
+        nodes.clear();
+    }
+}
+
+// Validates the value at p with the parser's grammar (integer keys
+// included) and appends a node for every object and array, in document
+// order. Returns the position after the value, or nullptr.
+inline const char* lazy_doc_s::index_value(const char* p, const char* end) {
+    if (p >= end) return nullptr;
+    
+    if (*p == '{' || *p == '[') {
+        bool is_object = *p == '{';
+        char close = is_object ? '}' : ']';
+        size_t n = nodes.size();
+        size_t count = 0;
+        nodes.push_back(node_s());
+        
+        p = json_skip_space(p + 1, end);
+        if (p < end && *p == close) {
+            p++;
+        } else {
+            while (true) {
+                if (is_object) {
+                    if (p >= end) return nullptr;
+                    if (*p == '"') {
+                        p = json_skip_string(p, end);
+                    } else {
+                        json_number_s num;
+                        p = json_parse_number(p, end, num);
+                        if (p && (!num.is_int || num.intg < INT32_MIN || num.intg > INT32_MAX)) return nullptr;
+                    }
+                    if (!p) return nullptr;
+                    p = json_skip_space(p, end);
+                    if (p >= end || *p != ':') return nullptr;
+                    p = json_skip_space(p + 1, end);
+                }
+                p = index_value(p, end);
+                if (!p) return nullptr;
+                count++;
+                p = json_skip_space(p, end);
+                if (p >= end) return nullptr;
+                if (*p == close) {
+                    p++;
+                    break;
+                }
+                if (*p != ',') return nullptr;
+                p = json_skip_space(p + 1, end);
+            }
+        }
+        nodes[n].end = static_cast<size_t>(p - text.data());
+        nodes[n].next = nodes.size();
+        nodes[n].count = count;
+        return p;
+    } else if (*p == '"') {
+        return json_skip_string(p, end);
+    } else if (*p == 't') {
+        return end - p >= 4 && std::memcmp(p, "true", 4) == 0 ? p + 4 : nullptr;
+    } else if (*p == 'f') {
+        return end - p >= 5 && std::memcmp(p, "false", 5) == 0 ? p + 5 : nullptr;
+    } else if (*p == 'n') {
+        return end - p >= 4 && std::memcmp(p, "null", 4) == 0 ? p + 4 : nullptr;
+    }
+    return json_skip_number(p, end);
+}
+
+inline lazy_val_s lazy_doc_s::make(size_t begin, size_t end, size_t node) const {
+    lazy_val_s v;
+    v.doc = this;
+    v.begin = begin;
+    v.end = end;
+    v.node = node;
+    return v;
+}
+
+inline lazy_val_s lazy_doc_s::root() const {
+    if (!valid) return lazy_val_s();
+    char c = text[root_begin];
+    return make(root_begin, root_end, c == '{' || c == '[' ? 0 : npos);
+}
+
+// Member table of an object or array, built by one pass over its direct
+// children; nested containers are stepped over using their index nodes
+inline lazy_doc_s::table_s& lazy_doc_s::table(const lazy_val_s& v) const {
+    std::unordered_map<size_t, table_s>::iterator it = tables.find(v.node);
+    if (it != tables.end()) return it->second;
+    
+    table_s& t = tables[v.node];
+    const char* base = text.data();
+    const char* end = base + v.end;
+    bool is_object = base[v.begin] == '{';
+    if (is_object) t.keys.reserve(nodes[v.node].count);
+    t.items.reserve(nodes[v.node].count);
+    size_t next = v.node + 1;
+    const char* p = json_skip_space(base + v.begin + 1, end);
+    while (*p != '}' && *p != ']') {
+        key_s key;
+        if (is_object) {
+            if (*p == '"') {
+                const char* run_end = json_scan_string(p + 1, end);
+                const char* key_end = *run_end == '"' ? run_end + 1 : json_skip_scalar(p, end);
+                if (run_end + 1 == key_end) {
+                    key = keys.intern(str_view_s(p + 1, run_end - (p + 1)));
+                } else {
+                    val_s unescaped;             // Rare: decode with the parser
+                    JSONParser parser(p, key_end - p, nullptr, nullptr, json_strings_copy);
+                    parser.parse(unescaped);
+                    key = keys.intern(unescaped.str);
+                }
+                p = key_end;
+            } else {
+                json_number_s num;
+                p = json_parse_number(p, end, num);
+                key = key_s(static_cast<int32_t>(num.intg));
+            }
+            p = json_skip_space(json_skip_space(p, end) + 1, end);   // Past ':'
+        }
+        
+        size_t begin = static_cast<size_t>(p - base);
+        lazy_val_s child;
+        if (*p == '{' || *p == '[') {
+            child = make(begin, nodes[next].end, next);
+            next = nodes[next].next;
+            p = base + child.end;
+        } else {
+            p = json_skip_scalar(p, end);
+            child = make(begin, static_cast<size_t>(p - base), npos);
+        }
+        if (is_object) t.keys.push_back(std::move(key));
+        t.items.push_back(child);
+        
+        p = json_skip_space(p, end);
+        if (*p == ',') p = json_skip_space(p + 1, end);
+    }
+    return t;
+}
+
+// Searches from the back so the last of duplicate keys wins, as in dict_s
+template<typename Q>
+lazy_val_s lazy_doc_s::table_s::find(const Q& key) {
+    if (index.empty() && ++lookups > hash_after && keys.size() > hash_after) {
+        build_index();
+    }
+    if (!index.empty()) {
+        auto it = index.find(key);
+        return it == index.end() ? lazy_val_s() : items[it->second];
+    }
+    json_key_equal eq;
+    for (size_t i = keys.size(); i-- > 0;) {
+        if (eq(keys[i], key)) return items[i];
+    }
+    return lazy_val_s();
+}
+
+inline void lazy_doc_s::table_s::build_index() {
+    if (!index.empty()) return;
+    index.reserve(keys.size());
+    for (size_t i = 0; i < keys.size(); i++) index[keys[i]] = i;
+}
+
+inline json_value_types lazy_val_s::type() const {
+    if (!doc) return json_null_t;
+    switch (doc->text[begin]) {
+        case '{': return json_object_t;
+        case '[': return json_array;
+        case '"': return json_string_t;
+        case 't': case 'f': return json_bool_t;
+        case 'n': return json_null_t;
+        default: return get().t;         // Integer or double
+    }
+}
+
+inline lazy_val_s lazy_val_s::find(str_view_s key) const {
+    if (!doc || doc->text[begin] != '{') return lazy_val_s();
+    return doc->table(*this).find(key);
+}
+
+inline lazy_val_s lazy_val_s::find(int32_t key) const {
+    if (!doc || doc->text[begin] != '{') return lazy_val_s();
+    return doc->table(*this).find(key);
+}
+
+inline lazy_val_s lazy_val_s::operator[](str_view_s key) const {
+    lazy_val_s v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return v;
+}
+
+inline lazy_val_s lazy_val_s::operator[](int32_t key) const {
+    lazy_val_s v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return v;
+}
+
+inline lazy_val_s lazy_val_s::at(size_t index) const {
+    if (!doc || doc->text[begin] != '[') {
+        throw std::out_of_range("Value is not an array");
+    }
+    const lazy_doc_s::table_s& t = doc->table(*this);
+    if (index >= t.items.size()) {
+        throw std::out_of_range("Array index out of range");
+    }
+    return t.items[index];
+}
+
+inline size_t lazy_val_s::size() const {
+    if (!doc || node == lazy_doc_s::npos) return 0;
+    return doc->table(*this).size();
+}
+
+inline const val_s& lazy_val_s::get() const {
+    if (!doc) {
+        throw std::out_of_range("Empty lazy_val_s");
+    }
+    std::unordered_map<size_t, val_s>::iterator it = doc->values.find(begin);
+    if (it != doc->values.end()) return it->second;
+    
+    val_s& v = doc->values[begin];
+    JSONParser parser(doc->text.data() + begin, end - begin, doc->arena.get(), &doc->keys,
+                      json_strings_borrow);
+    parser.parse(v);                     // Already validated
+    return v;
+}
+
+inline dict_s lazy_val_s::to_dict() const {
+    if (!doc || doc->text[begin] != '{') {
+        throw std::domain_error("Value is not an object");
+    }
+    dict_s d;
+    JSONParser parser(doc->text.data() + begin, end - begin, nullptr, nullptr, json_strings_copy);
+    d.valid = parser.parse(d);
+    return d;
+}
+
+inline str_view_s lazy_val_s::raw() const {
+    if (!doc) return str_view_s("", 0);
+    return str_view_s(doc->text.data() + begin, end - begin);
+}
+
+// ==================== Tape Parser Implementation ====================
+
+// Bitmasks of one 64-byte block of input, bit i for byte i
+struct json_block_s {
+    uint64_t quote;
+    uint64_t backslash;
+    uint64_t op;                         // { } [ ] : ,
+    uint64_t space;                      // JSON whitespace
+};
+
+#ifdef DICT_HAVE_NEON
+// json_neon_mask gives 4 bits per byte; keep one
+inline uint64_t json_neon_bits16(uint8x16_t m) {
+    uint64_t x = json_neon_mask(m) & 0x1111111111111111ULL;
+    x = (x | (x >> 3)) & 0x0303030303030303ULL;
+    x = (x | (x >> 6)) & 0x000F000F000F000FULL;
+    x = (x | (x >> 12)) & 0x000000FF000000FFULL;
+    return (x | (x >> 24)) & 0xFFFF;
+}
+#endif
+
+// '[' and ']' differ from '{' and '}' only in bit 5, so OR-ing 0x20 lets
+// two compares find all four brackets
+inline void json_classify_block(const char* p, json_block_s& b) {
+#if defined(DICT_HAVE_AVX2)
+    const __m256i quote = _mm256_set1_epi8('"');
+    const __m256i backslash = _mm256_set1_epi8('\\');
+    const __m256i lower = _mm256_set1_epi8(0x20);
+    const __m256i open = _mm256_set1_epi8('{');
+    const __m256i close = _mm256_set1_epi8('}');
+    const __m256i colon = _mm256_set1_epi8(':');
+    const __m256i comma = _mm256_set1_epi8(',');
+    const __m256i sp = _mm256_set1_epi8(' ');
+    const __m256i nl = _mm256_set1_epi8('\n');
+    const __m256i cr = _mm256_set1_epi8('\r');
+    const __m256i tab = _mm256_set1_epi8('\t');
+    b.quote = b.backslash = b.op = b.space = 0;
+    for (int half = 0; half < 2; half++) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + half * 32));
+        __m256i l = _mm256_or_si256(v, lower);
+        __m256i op = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(l, open), _mm256_cmpeq_epi8(l, close)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, colon), _mm256_cmpeq_epi8(v, comma)));
+        __m256i space = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, sp), _mm256_cmpeq_epi8(v, nl)),
+            _mm256_or_si256(_mm256_cmpeq_epi8(v, cr), _mm256_cmpeq_epi8(v, tab)));
+        int shift = half * 32;
+        b.quote |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, quote)))) << shift;
+        b.backslash |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, backslash)))) << shift;
+        b.op |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(op))) << shift;
+        b.space |= uint64_t(static_cast<uint32_t>(_mm256_movemask_epi8(space))) << shift;
+    }
+#elif defined(DICT_HAVE_SSE2)
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i lower = _mm_set1_epi8(0x20);
+    const __m128i open = _mm_set1_epi8('{');
+    const __m128i close = _mm_set1_epi8('}');
+    const __m128i colon = _mm_set1_epi8(':');
+    const __m128i comma = _mm_set1_epi8(',');
+    const __m128i sp = _mm_set1_epi8(' ');
+    const __m128i nl = _mm_set1_epi8('\n');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i tab = _mm_set1_epi8('\t');
+    b.quote = b.backslash = b.op = b.space = 0;
+    for (int quarter = 0; quarter < 4; quarter++) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + quarter * 16));
+        __m128i l = _mm_or_si128(v, lower);
+        __m128i op = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(l, open), _mm_cmpeq_epi8(l, close)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, colon), _mm_cmpeq_epi8(v, comma)));
+        __m128i space = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, nl)),
+            _mm_or_si128(_mm_cmpeq_epi8(v, cr), _mm_cmpeq_epi8(v, tab)));
+        int shift = quarter * 16;
+        b.quote |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, quote)))) << shift;
+        b.backslash |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, backslash)))) << shift;
+        b.op |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(op))) << shift;
+        b.space |= uint64_t(static_cast<uint16_t>(_mm_movemask_epi8(space))) << shift;
+    }
+#elif defined(DICT_HAVE_NEON)
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t lower = vdupq_n_u8(0x20);
+    const uint8x16_t open = vdupq_n_u8('{');
+    const uint8x16_t close = vdupq_n_u8('}');
+    const uint8x16_t colon = vdupq_n_u8(':');
+    const uint8x16_t comma = vdupq_n_u8(',');
+    const uint8x16_t sp = vdupq_n_u8(' ');
+    const uint8x16_t nl = vdupq_n_u8('\n');
+    const uint8x16_t cr = vdupq_n_u8('\r');
+    const uint8x16_t tab = vdupq_n_u8('\t');
+    b.quote = b.backslash = b.op = b.space = 0;
+    for (int quarter = 0; quarter < 4; quarter++) {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(p + quarter * 16));
+        uint8x16_t l = vorrq_u8(v, lower);
+        uint8x16_t op = vorrq_u8(vorrq_u8(vceqq_u8(l, open), vceqq_u8(l, close)),
+                                 vorrq_u8(vceqq_u8(v, colon), vceqq_u8(v, comma)));
+        uint8x16_t space = vorrq_u8(vorrq_u8(vceqq_u8(v, sp), vceqq_u8(v, nl)),
+                                    vorrq_u8(vceqq_u8(v, cr), vceqq_u8(v, tab)));
+        int shift = quarter * 16;
+        b.quote |= json_neon_bits16(vceqq_u8(v, quote)) << shift;
+        b.backslash |= json_neon_bits16(vceqq_u8(v, backslash)) << shift;
+        b.op |= json_neon_bits16(op) << shift;
+        b.space |= json_neon_bits16(space) << shift;
+    }
+#else
+    b.quote = b.backslash = b.op = b.space = 0;
+    for (int i = 0; i < 64; i++) {
+        char c = p[i];
+        uint64_t bit = uint64_t(1) << i;
+        if (c == '"') b.quote |= bit;
+        else if (c == '\\') b.backslash |= bit;
+        else if ((c | 0x20) == '{' || (c | 0x20) == '}' || c == ':' || c == ',') b.op |= bit;
+        else if (json_is_space(c)) b.space |= bit;
+    }
+#endif
+}
+
+// Bytes escaped by a backslash: the byte after each odd-length run of
+// backslashes. Runs starting at even and odd positions are told apart with
+// one addition, so there is no loop over backslashes. `carry` is set when
+// the block ends in an unfinished escape and clears it for the next block.
+inline uint64_t json_escaped_mask(uint64_t backslash, uint64_t& carry) {
+    const uint64_t even_bits = 0x5555555555555555ULL;
+    backslash &= ~carry;
+    uint64_t follows_escape = (backslash << 1) | carry;
+    uint64_t odd_starts = backslash & ~even_bits & ~follows_escape;
+    uint64_t even_runs = odd_starts + backslash;
+    carry = even_runs < backslash ? 1 : 0;
+    return (even_bits ^ (even_runs << 1)) & follows_escape;
+}
+
+// Bit i set when an odd number of bits at or below i are set
+inline uint64_t json_prefix_xor(uint64_t x) {
+    x ^= x << 1;
+    x ^= x << 2;
+    x ^= x << 4;
+    x ^= x << 8;
+    x ^= x << 16;
+    x ^= x << 32;
+    return x;
+}
+
+inline bool json_tape_s::stage1(const char* data, size_t size) {
+    if (structurals.size() < size + 1) structurals.resize(size + 1);
+    uint32_t* out = structurals.data();
+    uint64_t escape_carry = 0;
+    uint64_t prev_in_string = 0;         // All ones while inside a string
+    uint64_t prev_scalar = 0;
+    
+    for (size_t base = 0; base < size; base += 64) {
+        json_block_s b;
+        if (size - base >= 64) {
+            json_classify_block(data + base, b);
+        } else {
+            char tail[64];               // Padded with whitespace
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, data + base, size - base);
+            json_classify_block(tail, b);
+        }
+        
+        uint64_t quote = b.quote & ~json_escaped_mask(b.backslash, escape_carry);
+        uint64_t in_string = json_prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(in_string) >> 63);
+        // In a string from the byte after the opening quote to the closing one
+        uint64_t string_tail = in_string ^ quote;
+        
+        // Scalars and opening quotes start where a non-quote scalar byte
+        // does not precede them
+        uint64_t scalar = ~(b.op | b.space);
+        uint64_t nonquote_scalar = scalar & ~quote;
+        uint64_t follows_scalar = (nonquote_scalar << 1) | prev_scalar;
+        prev_scalar = nonquote_scalar >> 63;
+        
+        uint64_t bits = (b.op | (scalar & ~follows_scalar)) & ~string_tail;
+        while (bits) {
+            *out++ = static_cast<uint32_t>(base + json_ctz64(bits));
+            bits &= bits - 1;
+        }
+    }
+    structural_count = static_cast<size_t>(out - structurals.data());
+    return prev_in_string == 0;          // Unterminated string
+}
+
+inline str_view_s json_tape_s::string_at(size_t offset) const {
+    uint32_t n;
+    std::memcpy(&n, strings.data() + offset, sizeof(n));
+    return str_view_s(strings.data() + offset + sizeof(n), n);
+}
+
+// Unescapes the string whose opening quote is at p into `strings` and
+// appends its tape word. The raw string ends before `limit` (the next
+// structural), which bounds the space needed. Returns the byte after the
+// closing quote, or nullptr.
+inline const char* json_tape_s::write_string(const char* p, const char* end, size_t limit) {
+    size_t need = string_bytes + sizeof(uint32_t) + limit + 1;
+    if (need > strings.size()) strings.resize(std::max(need, strings.size() * 2));
+    char* start = strings.data() + string_bytes + sizeof(uint32_t);
+    char* out = start;
+    p++;
+    while (true) {
+        const char* run_end = json_scan_string(p, end);
+        std::memcpy(out, p, run_end - p);
+        out += run_end - p;
+        p = run_end;
+        if (p >= end) return nullptr;
+        if (*p == '"') break;
+        if (*p != '\\' || ++p >= end) return nullptr;
+        if (*p == 'u') {
+            uint32_t cp;
+            p = json_decode_unicode_escape(p, end, cp);
+            if (!p) return nullptr;
+            out += json_encode_utf8(cp, out);
+        } else {
+            char c = json_unescape_char(*p);
+            if (!c) return nullptr;
+            *out++ = c;
+        }
+        p++;
+    }
+    uint32_t n = static_cast<uint32_t>(out - start);
+    std::memcpy(start - sizeof(uint32_t), &n, sizeof(n));
+    *out = '\0';
+    tape.push_back((uint64_t(json_tape_string) << 56) | string_bytes);
+    string_bytes += sizeof(uint32_t) + n + 1;
+    return p + 1;
+}
+
+inline void json_tape_s::close_container(char type) {
+    size_t first = open.back();
+    uint64_t count = std::min<uint64_t>(counts.back(), 0xFFFFFF);
+    open.pop_back();
+    counts.pop_back();
+    tape.push_back((uint64_t(static_cast<uint8_t>(type)) << 56) | first);
+    tape[first] |= (count << 32) | tape.size();
+}
+
+inline bool json_tape_s::parse(const char* data, size_t size) {
+    valid = size <= UINT32_MAX && stage1(data, size) && stage2(data, size);
+    return valid;
+}
+
+// Checks the grammar while appending to the tape. Scalars are validated in
+// full, and must be followed only by whitespace up to the next structural.
+inline bool json_tape_s::stage2(const char* data, size_t size) {
+    const char* end = data + size;
+    const uint32_t* idx = structurals.data();
+    const uint32_t* idx_end = idx + structural_count;
+    tape.clear();
+    open.clear();
+    counts.clear();
+    string_bytes = 0;
+    tape.reserve(structural_count + 2);
+    
+    const char* p;
+    const char* after;
+    
+value:
+    if (idx == idx_end) return false;
+    p = data + *idx++;
+    switch (*p) {
+        case '{':
+            open.push_back(tape.size());
+            counts.push_back(0);
+            tape.push_back(uint64_t(json_tape_object) << 56);
+            if (idx < idx_end && data[*idx] == '}') {
+                idx++;
+                close_container(json_tape_object_end);
+                goto after_value;
+            }
+            goto key;
+        case '[':
+            open.push_back(tape.size());
+            counts.push_back(0);
+            tape.push_back(uint64_t(json_tape_array) << 56);
+            if (idx < idx_end && data[*idx] == ']') {
+                idx++;
+                close_container(json_tape_array_end);
+                goto after_value;
+            }
+            goto value;
+        case '"':
+            after = write_string(p, end, (idx < idx_end ? data + *idx : end) - p);
+            break;
+        case 't':
+            after = end - p >= 4 && std::memcmp(p, "true", 4) == 0 ? p + 4 : nullptr;
+            tape.push_back(uint64_t(json_tape_true) << 56);
+            break;
+        case 'f':
+            after = end - p >= 5 && std::memcmp(p, "false", 5) == 0 ? p + 5 : nullptr;
+            tape.push_back(uint64_t(json_tape_false) << 56);
+            break;
+        case 'n':
+            after = end - p >= 4 && std::memcmp(p, "null", 4) == 0 ? p + 4 : nullptr;
+            tape.push_back(uint64_t(json_tape_null) << 56);
+            break;
+        default: {
+            json_number_s num;
+            after = json_parse_number(p, end, num);
+            if (!after) return false;
+            uint64_t bits;
+            if (num.is_int) {
+                tape.push_back(uint64_t(json_tape_int) << 56);
+                bits = static_cast<uint64_t>(num.intg);
+            } else {
+                tape.push_back(uint64_t(json_tape_double) << 56);
+                std::memcpy(&bits, &num.dbl, sizeof(bits));
+            }
+            tape.push_back(bits);
+            break;
+        }
+    }
+    if (!after || json_skip_space(after, end) != (idx < idx_end ? data + *idx : end)) return false;
+    
+after_value:
+    if (open.empty()) return idx == idx_end;
+    counts.back()++;
+    if (idx == idx_end) return false;
+    {
+        char c = data[*idx++];
+        bool in_object = type_of(tape[open.back()]) == json_tape_object;
+        if (c == ',') {
+            if (in_object) goto key;
+            goto value;
+        }
+        if (c != (in_object ? '}' : ']')) return false;
+        close_container(c);
+        goto after_value;
+    }
+    
+key:
+    if (idx == idx_end) return false;
+    p = data + *idx++;
+    if (*p == '"') {
+        after = write_string(p, end, (idx < idx_end ? data + *idx : end) - p);
+    } else {
+        // Integer key (an extension to JSON); must fit in int32_t
+        json_number_s num;
+        after = json_parse_number(p, end, num);
+        if (!after || !num.is_int || num.intg < INT32_MIN || num.intg > INT32_MAX) return false;
+        tape.push_back(uint64_t(json_tape_int) << 56);
+        tape.push_back(static_cast<uint64_t>(num.intg));
+    }
+    if (!after || idx == idx_end || json_skip_space(after, end) != data + *idx || data[*idx] != ':') return false;
+    idx++;
+    goto value;
+}
+
+// Builds the value at tape index i into `out`; returns the index after it
+inline size_t json_tape_s::build(size_t i, val_s& out, key_pool_s& pool) const {
+    uint64_t w = tape[i];
+    switch (type_of(w)) {
+        case json_tape_object: {
+            size_t close = static_cast<uint32_t>(w) - 1;
+            out.set_type(json_object_t);
+            out.obj = std::make_shared<dict_s>();
+            size_t j = i + 1;
+            while (j < close) {
+                key_s key;
+                if (type_of(tape[j]) == json_tape_string) {
+                    key = pool.intern(string_at(payload_of(tape[j])));
+                    j++;
+                } else {
+                    key = key_s(static_cast<int32_t>(tape[j + 1]));
+                    j += 2;
+                }
+                val_s val;
+                j = build(j, val, pool);
+                out.obj->set(key, std::move(val));
+            }
+            return close + 1;
+        }
+        case json_tape_array: {
+            size_t close = static_cast<uint32_t>(w) - 1;
+            out.set_type(json_array);
+            size_t j = i + 1;
+            while (j < close) {
+                val_s item;
+                j = build(j, item, pool);
+                out.push_back(std::move(item));     // Packs homogeneous scalar arrays
+            }
+            return close + 1;
+        }
+        case json_tape_string: {
+            str_view_s sv = string_at(payload_of(w));
+            out = std::string(sv.data, sv.size);
+            return i + 1;
+        }
+        case json_tape_int:
+            out = static_cast<int64_t>(tape[i + 1]);
+            return i + 2;
+        case json_tape_double: {
+            double d;
+            std::memcpy(&d, &tape[i + 1], sizeof(d));
+            out = d;
+            return i + 2;
+        }
+        case json_tape_true: out = true; return i + 1;
+        case json_tape_false: out = false; return i + 1;
+        default: out.set_type(json_null_t); return i + 1;
+    }
+}
+
+inline size_t tape_val_s::next() const {
+    uint64_t w = tape->tape[index];
+    switch (json_tape_s::type_of(w)) {
+        case json_tape_object:
+        case json_tape_array: return static_cast<uint32_t>(w);
+        case json_tape_int:
+        case json_tape_double: return index + 2;
+        default: return index + 1;
+    }
+}
+
+inline json_value_types tape_val_s::type() const {
+    if (!tape) return json_null_t;
+    switch (json_tape_s::type_of(tape->tape[index])) {
+        case json_tape_object: return json_object_t;
+        case json_tape_array: return json_array;
+        case json_tape_string: return json_string_t;
+        case json_tape_int: return json_integer_t;
+        case json_tape_double: return json_double_t;
+        case json_tape_true:
+        case json_tape_false: return json_bool_t;
+        default: return json_null_t;
+    }
+}
+
+// Objects are searched linearly from the back, so the last of duplicate
+// keys wins as in dict_s
+inline tape_val_s tape_val_s::find(str_view_s key) const {
+    if (!is_object()) return tape_val_s();
+    const std::vector<uint64_t>& t = tape->tape;
+    size_t close = next() - 1;
+    tape_val_s found;
+    for (size_t j = index + 1; j < close;) {
+        bool match = json_tape_s::type_of(t[j]) == json_tape_string &&
+                     tape->string_at(json_tape_s::payload_of(t[j])) == key;
+        j += json_tape_s::type_of(t[j]) == json_tape_string ? 1 : 2;
+        tape_val_s v(tape, j);
+        if (match) found = v;
+        j = v.next();
+    }
+    return found;
+}
+
+inline tape_val_s tape_val_s::find(int32_t key) const {
+    if (!is_object()) return tape_val_s();
+    const std::vector<uint64_t>& t = tape->tape;
+    size_t close = next() - 1;
+    tape_val_s found;
+    for (size_t j = index + 1; j < close;) {
+        bool match = json_tape_s::type_of(t[j]) == json_tape_int &&
+                     static_cast<int32_t>(t[j + 1]) == key;
+        j += json_tape_s::type_of(t[j]) == json_tape_string ? 1 : 2;
+        tape_val_s v(tape, j);
+        if (match) found = v;
+        j = v.next();
+    }
+    return found;
+}
+
+inline tape_val_s tape_val_s::operator[](str_view_s key) const {
+    tape_val_s v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return v;
+}
+
+inline tape_val_s tape_val_s::operator[](int32_t key) const {
+    tape_val_s v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return v;
+}
+
+inline tape_val_s tape_val_s::at(size_t i) const {
+    if (!is_array()) {
+        throw std::out_of_range("Value is not an array");
+    }
+    size_t close = next() - 1;
+    size_t j = index + 1;
+    for (; i > 0 && j < close; i--) j = tape_val_s(tape, j).next();
+    if (j >= close) {
+        throw std::out_of_range("Array index out of range");
+    }
+    return tape_val_s(tape, j);
+}
+
+inline size_t tape_val_s::size() const {
+    if (!is_object() && !is_array()) return 0;
+    return static_cast<size_t>((tape->tape[index] >> 32) & 0xFFFFFF);
+}
+
+inline int64_t tape_val_s::intg() const {
+    if (type() != json_integer_t) {
+        throw std::domain_error("Value is not an integer");
+    }
+    return static_cast<int64_t>(tape->tape[index + 1]);
+}
+
+inline double tape_val_s::dbl() const {
+    json_value_types t = type();
+    if (t == json_integer_t) return static_cast<double>(intg());
+    if (t != json_double_t) {
+        throw std::domain_error("Value is not a number");
+    }
+    double d;
+    std::memcpy(&d, &tape->tape[index + 1], sizeof(d));
+    return d;
+}
+
+inline bool tape_val_s::boolean() const {
+    if (type() != json_bool_t) {
+        throw std::domain_error("Value is not a bool");
+    }
+    return json_tape_s::type_of(tape->tape[index]) == json_tape_true;
+}
+
+inline str_view_s tape_val_s::str_view() const {
+    if (type() != json_string_t) {
+        throw std::domain_error("Value is not a string");
+    }
+    return tape->string_at(json_tape_s::payload_of(tape->tape[index]));
+}
+
+inline val_s tape_val_s::to_val() const {
+    val_s v;
+    if (tape) {
+        key_pool_s pool;
+        tape->build(index, v, pool);
+    }
+    return v;
+}
+
+inline dict_s tape_val_s::to_dict() const {
+    if (!is_object()) {
+        throw std::domain_error("Value is not an object");
+    }
+    val_s v = to_val();
+    dict_s d(std::move(*v.obj));
+    return d;
+}
+
+// ==================== NDJSON Reader Implementation ====================
+
+inline ndjson_reader_s::ndjson_reader_s(const char* d, size_t size, const ndjson_options_s& opts)
+    : data(d), end(d + size), options(opts), split(d), split_line(1), claimed(0), consumed(0),
+      running(0), stopping(false), current_pos(0) {
+    size_t n = options.threads;
+    if (n == 0) {
+        n = std::thread::hardware_concurrency();
+        if (n == 0) n = 1;
+    }
+    if (options.batch_bytes == 0) options.batch_bytes = 1;
+    if (options.max_pending == 0) options.max_pending = 4 * n;
+    current.index = 0;
+    running = n;
+    workers.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        workers.emplace_back(&ndjson_reader_s::work, this);
+    }
+}
+
+inline ndjson_reader_s::~ndjson_reader_s() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    work_cv.notify_all();
+    for (std::thread& t : workers) {
+        t.join();
+    }
+}
+
+inline void ndjson_reader_s::work() {
+    key_pool_s pool;                     // Atoms are refcounted atomically, so
+                                         // records may outlive the worker
+    std::unique_lock<std::mutex> lock(mutex);
+    for (;;) {
+        work_cv.wait(lock, [this] {
+            return stopping || split == end || claimed - consumed < options.max_pending;
+        });
+        if (stopping || split == end) break;
+        
+        // Claim the next batch, extended to the end of its last line. Lines
+        // are counted here, while the position is still serialized, so that
+        // every record gets its line number even when completing out of order.
+        const char* begin = split;
+        const char* stop = end;
+        if (static_cast<size_t>(end - begin) > options.batch_bytes) {
+            const char* nl = static_cast<const char*>(
+                std::memchr(begin + options.batch_bytes, '\n', static_cast<size_t>(end - begin) - options.batch_bytes));
+            stop = nl ? nl + 1 : end;
+        }
+        size_t line = split_line;
+        for (const char* p = begin; (p = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(stop - p)))); ++p) {
+            ++split_line;
+        }
+        split = stop;
+        batch_s batch;
+        batch.index = claimed++;
+        lock.unlock();
+        
+        try {
+            parse_batch(begin, stop, line, batch, pool);
+        } catch (...) {
+            lock.lock();
+            if (!failure) failure = std::current_exception();
+            stopping = true;
+            break;
+        }
+        
+        lock.lock();
+        done.push_back(std::move(batch));
+        ready_cv.notify_one();
+    }
+    --running;
+    lock.unlock();
+    ready_cv.notify_all();               // next() may be waiting for the end
+    work_cv.notify_all();                // Others may be waiting after a failure
+}
+
+inline void ndjson_reader_s::parse_batch(const char* p, const char* stop, size_t line,
+                                          batch_s& batch, key_pool_s& pool) {
+    while (p < stop) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', static_cast<size_t>(stop - p)));
+        const char* line_end = nl ? nl : stop;
+        const char* first = json_skip_space(p, line_end);
+        if (first < line_end) {
+            batch.records.emplace_back();
+            ndjson_record_s& rec = batch.records.back();
+            rec.line = line;
+            rec.offset = static_cast<size_t>(p - data);
+            size_t len = static_cast<size_t>(line_end - first);
+            JSONParser parser(first, len, nullptr, &pool, json_strings_copy);
+            rec.doc.valid = parser.parse(rec.doc) &&
+                            json_skip_space(first + parser.offset(), line_end) == line_end;
+        }
+        p = line_end + 1;
+        ++line;
+    }
+}
+
+inline bool ndjson_reader_s::next(ndjson_record_s& record) {
+    while (current_pos == current.records.size()) {
+        std::unique_lock<std::mutex> lock(mutex);
+        std::deque<batch_s>::iterator it = done.end();
+        for (;;) {
+            if (failure) std::rethrow_exception(failure);
+            if (options.ordered) {
+                for (it = done.begin(); it != done.end() && it->index != consumed; ++it) {}
+            } else {
+                it = done.begin();
+            }
+            if (it != done.end()) break;
+            if (running == 0) return false;    // Everything parsed and drained
+            ready_cv.wait(lock);
+        }
+        current = std::move(*it);
+        done.erase(it);
+        current_pos = 0;
+        ++consumed;
+        lock.unlock();
+        work_cv.notify_one();
+    }
+    record = std::move(current.records[current_pos++]);
+    return true;
+}
+
+// ==================== Parallel Parsing ====================
+
+// Runs f(0) .. f(jobs - 1) on up to `threads` threads, the caller included,
+// handing out jobs in order as threads become free. The first exception
+// thrown by a job stops the rest and is rethrown here.
+template<typename F>
+inline void dict_parallel_for(size_t threads, size_t jobs, F f) {
+    std::atomic<size_t> next(0);
+    std::exception_ptr failure;
+    std::mutex failure_mutex;
+    auto run = [&]() {
+        try {
+            for (size_t job; (job = next.fetch_add(1)) < jobs;) {
+                f(job);
+            }
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(failure_mutex);
+            if (!failure) failure = std::current_exception();
+            next = jobs;
+        }
+    };
+    std::vector<std::thread> pool;
+    size_t n = std::min(threads, jobs);
+    for (size_t i = 1; i < n; i++) {
+        try {
+            pool.emplace_back(run);
+        } catch (const std::system_error&) {
+            break;                       // Make do with the threads we have
+        }
+    }
+    run();
+    for (std::thread& t : pool) {
+        t.join();
+    }
+    if (failure) std::rethrow_exception(failure);
+}
+
+// Visits the structural characters ({}[]:,) outside strings in [begin, end),
+// classifying 64 bytes at a time like the tape parser. `in_string` and
+// `escaped` give the state at `begin`. visit(p) returns false to stop.
+template<typename F>
+inline void json_scan_structurals(const char* begin, const char* end, bool in_string, bool escaped, F visit) {
+    uint64_t escape_carry = escaped ? 1 : 0;
+    uint64_t prev_in_string = in_string ? ~uint64_t(0) : 0;
+    for (const char* p = begin; p < end; p += 64) {
+        json_block_s b;
+        if (end - p >= 64) {
+            json_classify_block(p, b);
+        } else {
+            char tail[64];
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, p, static_cast<size_t>(end - p));
+            json_classify_block(tail, b);
+        }
+        uint64_t quote = b.quote & ~json_escaped_mask(b.backslash, escape_carry);
+        uint64_t strings = json_prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(strings) >> 63);
+        for (uint64_t bits = b.op & ~strings; bits; bits &= bits - 1) {
+            if (!visit(p + json_ctz64(bits))) return;
+        }
+    }
+}
+
+// Pre-scan summary of one slice of the input. The string state at the start
+// of a slice is only known once the slices before it are summarized, so the
+// nesting depth is tracked for both cases: index 0 assumes the slice starts
+// outside a string, index 1 inside.
+struct json_slice_s {
+    const char* begin;
+    bool escaped;                        // First byte follows an odd run of backslashes
+    int64_t delta[2];                    // Depth change across the slice
+    int64_t low[2];                      // Lowest depth, relative to the start
+    bool ends_in_string[2];
+    // Resolved in order after the scan
+    bool in_string;
+    int64_t depth;                       // Open containers at `begin`
+};
+
+inline void json_summarize_slice(const char* data, const char* end, json_slice_s& slice) {
+    const char* p = slice.begin;
+    while (p > data && p[-1] == '\\') --p;
+    slice.escaped = ((slice.begin - p) & 1) != 0;
+    
+    int64_t depth[2] = { 0, 0 }, low[2] = { 0, 0 };
+    uint64_t escape_carry = slice.escaped ? 1 : 0;
+    uint64_t prev_in_string = 0;
+    for (p = slice.begin; p < end; p += 64) {
+        json_block_s b;
+        if (end - p >= 64) {
+            json_classify_block(p, b);
+        } else {
+            char tail[64];
+            std::memset(tail, ' ', sizeof(tail));
+            std::memcpy(tail, p, static_cast<size_t>(end - p));
+            json_classify_block(tail, b);
+        }
+        uint64_t quote = b.quote & ~json_escaped_mask(b.backslash, escape_carry);
+        uint64_t strings = json_prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = static_cast<uint64_t>(static_cast<int64_t>(strings) >> 63);
+        // Structurals are never quotes, so starting inside a string simply
+        // swaps which of them count
+        for (int s = 0; s < 2; s++) {
+            for (uint64_t bits = b.op & (s ? strings : ~strings); bits; bits &= bits - 1) {
+                char c = static_cast<char>(p[json_ctz64(bits)] | 0x20);
+                if (c == '{') {
+                    depth[s]++;
+                } else if (c == '}' && --depth[s] < low[s]) {
+                    low[s] = depth[s];
+                }
+            }
+        }
+    }
+    for (int s = 0; s < 2; s++) {
+        slice.delta[s] = depth[s];
+        slice.low[s] = low[s];
+        slice.ends_in_string[s] = (prev_in_string != 0) != (s != 0);
+    }
+}
+
+inline bool dict_s::parse_parallel(const std::string& json_str, size_t threads) {
+    return parse_parallel(json_str.data(), json_str.size(), threads);
+}
+
+inline bool dict_s::parse_parallel(const char* data, size_t size, size_t threads) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    const size_t min_slice = 256 * 1024;
+    size_t slices = std::min(threads * 4, size / min_slice);
+    if (threads < 2 || size < 1024 * 1024) {
+        slices = 0;
+    }
+    auto sequential = [&]() {
+        JSONParser parser(data, size, nullptr, nullptr, json_strings_copy);
+        return parser.parse(*this);
+    };
+    if (slices < 2) return sequential();
+    
+    // Pass 1: string state and depth at every slice start
+    const char* end = data + size;
+    std::vector<json_slice_s> sl(slices);
+    for (size_t k = 0; k < slices; k++) {
+        sl[k].begin = data + size / slices * k;
+    }
+    dict_parallel_for(threads, slices, [&](size_t k) {
+        json_summarize_slice(data, k + 1 < slices ? sl[k + 1].begin : end, sl[k]);
+    });
+    bool in_string = false;
+    int64_t depth = 0, target = INT64_MAX;
+    for (size_t k = 0; k < slices; k++) {
+        int s = in_string ? 1 : 0;
+        sl[k].in_string = in_string;
+        sl[k].depth = depth;
+        // The region from the second slice start to the last one lies in a
+        // single container: the one at the lowest depth reached there
+        if (k >= 1 && k + 1 < slices) target = std::min(target, depth + sl[k].low[s]);
+        depth += sl[k].delta[s];
+        in_string = sl[k].ends_in_string[s];
+    }
+    target = std::min(target, sl[slices - 1].depth);
+    if (in_string || depth != 0 || target < 1) return sequential();
+    
+    // Pass 2: the container's brackets, and the first comma between its
+    // children after each slice start
+    std::vector<const char*> splits(slices, nullptr);
+    const char* open = nullptr;
+    const char* close = nullptr;
+    dict_parallel_for(threads, slices, [&](size_t k) {
+        int64_t d = sl[k].depth;
+        if (k == 0) {
+            // The container is the last one opened at the target depth
+            json_scan_structurals(data, sl[1].begin, false, false, [&](const char* p) {
+                char c = static_cast<char>(*p | 0x20);
+                if (c == '{' && ++d == target) open = p;
+                else if (c == '}') d--;
+                return true;
+            });
+            return;
+        }
+        bool last = k + 1 == slices;
+        json_scan_structurals(sl[k].begin, end, sl[k].in_string, sl[k].escaped, [&](const char* p) {
+            char c = static_cast<char>(*p | 0x20);
+            if (c == '{') {
+                d++;
+            } else if (c == '}') {
+                if (d-- == target) {
+                    if (last) close = p;
+                    return false;
+                }
+            } else if (*p == ',' && d == target && !splits[k]) {
+                splits[k] = p;
+                return last;             // The last slice goes on to the close
+            }
+            return true;
+        });
+    });
+    if (!open || !close || (*open == '{') != (*close == '}')) return sequential();
+    
+    std::vector<const char*> cuts(1, open);
+    for (const char* split : splits) {
+        if (split && split > cuts.back() && split < close) cuts.push_back(split);
+    }
+    cuts.push_back(close);
+    size_t parts = cuts.size() - 1;
+    if (parts < 2) return sequential();
+    
+    // Pass 3: parse the slices of the container concurrently
+    bool is_object = *open == '{';
+    std::vector<dict_s> members(is_object ? parts : 0);
+    std::vector<val_s> elements(is_object ? 0 : parts);
+    std::unique_ptr<bool[]> ok(new bool[parts]);
+    dict_parallel_for(threads, parts, [&](size_t i) {
+        JSONParser parser(cuts[i] + 1, static_cast<size_t>(cuts[i + 1] - cuts[i] - 1), nullptr, nullptr,
+                          json_strings_copy);
+        ok[i] = is_object ? parser.parse_members(members[i]) : parser.parse_elements(elements[i]);
+    });
+    for (size_t i = 0; i < parts; i++) {
+        if (!ok[i]) return sequential();   // Let the sequential parser report it
+    }
+    
+    // Stitch the slices in input order; later duplicate keys win, as in parse()
+    val_s container;
+    dict_s* target_dict = this;
+    bool is_root = json_skip_space(data, end) == open;
+    if (is_object) {
+        if (!is_root) {
+            container.set_type(json_object_t);
+            container.obj = std::make_shared<dict_s>();
+            target_dict = container.obj.get();
+        }
+        dict_unshare(*target_dict);
+#ifndef JSON_ORDERED
+        size_t total = target_dict->obj->size();
+        for (const dict_s& m : members) total += m.obj->size();
+        target_dict->obj->reserve(total);
+#endif
+        for (dict_s& m : members) {
+            for (auto& kv : *m.obj) {
+                target_dict->set(kv.first, std::move(kv.second));
+            }
+        }
+    } else {
+        if (is_root) return sequential(); // Not an object: let parse() reject it
+        bool same_layout = true;
+        size_t total = 0;
+        for (const val_s& e : elements) {
+            same_layout = same_layout && e.layout == elements[0].layout;
+            total += e.size();
+        }
+        container = std::move(elements[0]);
+        if (same_layout && container.layout != json_array_generic) {
+            // Homogeneous scalars stay packed
+            for (size_t i = 1; i < parts; i++) {
+                const val_s& e = elements[i];
+                switch (container.layout) {
+                    case json_array_int: container.arr_intg.insert(container.arr_intg.end(), e.arr_intg.begin(), e.arr_intg.end()); break;
+                    case json_array_double: container.arr_dbl.insert(container.arr_dbl.end(), e.arr_dbl.begin(), e.arr_dbl.end()); break;
+                    default: container.arr_bool.insert(container.arr_bool.end(), e.arr_bool.begin(), e.arr_bool.end()); break;
+                }
+            }
+        } else {
+            container.unpack();
+            std::vector<size_t> offsets(parts, container.arr.size());
+            for (size_t i = 1; i + 1 < parts; i++) {
+                offsets[i + 1] = offsets[i] + elements[i].size();
+            }
+            container.arr.resize(total);
+            dict_parallel_for(threads, parts - 1, [&](size_t job) {
+                val_s& e = elements[job + 1];
+                e.unpack();
+                std::move(e.arr.begin(), e.arr.end(), container.arr.begin() + offsets[job + 1]);
+                e = val_s();
+            });
+        }
+    }
+    if (is_root) return true;
+    
+    // Parse the rest of the document around the container
+    JSONParser parser(data, size, nullptr, nullptr, json_strings_copy);
+    parser.splice(open, close + 1, &container);
+    return parser.parse(*this);
+}
+
+// ==================== Push Parser Implementation ====================
+
+inline bool json_is_number_char(char c) {
+    return json_is_digit(c) || c == '-' || c == '+' || c == '.' || c == 'e' || c == 'E';
+}
+
+inline void json_push_parser_s::reset() {
+    root = dict_s();
+    stack.clear();
+    state = json_push_more;
+    consumed = 0;
+    token = token_none;
+    token_escape = false;
+    token_offset = 0;
+    pending.clear();
+    if (pool.size() > 4096) {
+        pool.clear();
+    }
+}
+
+inline json_push_status json_push_parser_s::feed(const char* data, size_t size) {
+    if (state != json_push_more) return state;
+    const char* p = data;
+    const char* end = data + size;
+    
+    // Complete the token the last chunk ended in
+    if (token != token_none) {
+        const char* token_end = scan_token(p, end, true);
+        if (!token_end) {
+            pending.append(p, end);
+            consumed += size;
+            return state;
+        }
+        pending.append(p, token_end);
+        if (!finish_token(pending.data(), pending.data() + pending.size())) {
+            consumed = token_offset;
+            return state = json_push_error;
+        }
+        token = token_none;
+        pending.clear();
+        p = token_end;
+    }
+    
+    while (true) {
+        p = json_skip_space(p, end);
+        if (p == end) break;
+        char c = *p;
+        
+        if (stack.empty()) {
+            if (c != '{') break;
+            open(true);
+            p++;
+            continue;
+        }
+        frame_s& f = stack.back();
+        token_e start = token_none;
+        switch (f.expect) {
+            case expect_first_key:
+                if (c == '}') {
+                    close();
+                    p++;
+                    break;
+                }
+                // Fall through
+            case expect_key:
+                if (c == '"') start = token_string;
+                else if (c == '-' || json_is_digit(c)) start = token_number;
+                else goto fail;
+                break;
+            case expect_colon:
+                if (c != ':') goto fail;
+                f.expect = expect_value;
+                p++;
+                break;
+            case expect_first_value:
+                if (c == ']') {
+                    close();
+                    p++;
+                    break;
+                }
+                // Fall through
+            case expect_value:
+                if (c == '{' || c == '[') {
+                    open(c == '{');
+                    p++;
+                } else if (c == '"') {
+                    start = token_string;
+                } else if (c == '-' || json_is_digit(c)) {
+                    start = token_number;
+                } else if (c == 't' || c == 'f' || c == 'n') {
+                    start = token_literal;
+                } else {
+                    goto fail;
+                }
+                break;
+            case expect_next:
+                if (c == ',') {
+                    f.expect = f.dict ? expect_key : expect_value;
+                } else if (c == (f.dict ? '}' : ']')) {
+                    close();
+                } else {
+                    goto fail;
+                }
+                p++;
+                break;
+        }
+        if (state == json_push_done) {
+            consumed += static_cast<size_t>(p - data);
+            return state;
+        }
+        if (start == token_none) continue;
+        
+        token = start;
+        token_escape = false;
+        const char* token_end = scan_token(p, end, false);
+        if (!token_end) {
+            // Cut by the end of the chunk: keep it for the next feed()
+            token_offset = consumed + static_cast<size_t>(p - data);
+            pending.assign(p, end);
+            p = end;
+            break;
+        }
+        if (!finish_token(p, token_end)) goto fail;
+        token = token_none;
+        p = token_end;
+    }
+    if (p == end) {
+        consumed += size;
+        return state;
+    }
+    
+fail:
+    consumed += static_cast<size_t>(p - data);
+    return state = json_push_error;
+}
+
+// Finds the end of the current token, starting at its first byte or, when
+// `resumed`, at the start of a new chunk. Returns nullptr if the chunk ends
+// first. Strings end after the closing quote; malformed escapes and control
+// bytes are left for finish_token() to reject.
+inline const char* json_push_parser_s::scan_token(const char* p, const char* end, bool resumed) {
+    if (token == token_string) {
+        const char* q = resumed ? p : p + 1;
+        if (token_escape) {
+            if (q >= end) return nullptr;
+            q++;
+            token_escape = false;
+        }
+        while (true) {
+            q = json_scan_string(q, end);
+            if (q >= end) return nullptr;
+            if (*q == '"') return q + 1;
+            if (*q != '\\') return q + 1;
+            if (q + 1 >= end) {
+                token_escape = true;
+                return nullptr;
+            }
+            q += 2;
+        }
+    }
+    bool number = token == token_number;
+    while (p < end && (number ? json_is_number_char(*p) : (*p >= 'a' && *p <= 'z'))) {
+        p++;
+    }
+    return p < end ? p : nullptr;
+}
+
+inline bool json_push_parser_s::finish_token(const char* begin, const char* end) {
+    frame_s& f = stack.back();
+    if (f.expect == expect_first_key || f.expect == expect_key) {
+        if (token == token_string) {
+            // Keys without escapes are interned straight from the input
+            if (json_scan_string(begin + 1, end) == end - 1 && end - begin >= 2 && end[-1] == '"') {
+                f.key = pool.intern(str_view_s(begin + 1, static_cast<size_t>(end - begin - 2)));
+            } else {
+                if (json_decode_string(begin, end, scratch) != end) return false;
+                f.key = pool.intern(scratch);
+            }
+        } else {
+            json_number_s num;
+            if (json_parse_number(begin, end, num) != end || !num.is_int ||
+                num.intg < INT32_MIN || num.intg > INT32_MAX) {
+                return false;
+            }
+            f.key = key_s(static_cast<int32_t>(num.intg));
+        }
+        f.expect = expect_colon;
+        return true;
+    }
+    
+    val_s val;
+    size_t n = static_cast<size_t>(end - begin);
+    if (token == token_string) {
+        val.set_type(json_string_t);
+        if (json_decode_string(begin, end, val.str) != end) return false;
+    } else if (token == token_number) {
+        json_number_s num;
+        if (json_parse_number(begin, end, num) != end) return false;
+        if (num.is_int) {
+            val.set_type(json_integer_t);
+            val.intg = num.intg;
+        } else {
+            val.set_type(json_double_t);
+            val.dbl = num.dbl;
+        }
+    } else if (n == 4 && std::memcmp(begin, "null", 4) == 0) {
+        val.set_type(json_null_t);
+    } else if ((n == 4 && std::memcmp(begin, "true", 4) == 0) || (n == 5 && std::memcmp(begin, "false", 5) == 0)) {
+        val.set_type(json_bool_t);
+        val.boolean = n == 4;
+    } else {
+        return false;
+    }
+    deliver(std::move(val));
+    return true;
+}
+
+inline void json_push_parser_s::deliver(val_s&& val) {
+    frame_s& f = stack.back();
+    if (f.dict) {
+        f.dict->set(f.key, std::move(val));
+    } else {
+        f.value.push_back(std::move(val));   // Packs homogeneous scalar arrays
+    }
+    f.expect = expect_next;
+}
+
+inline void json_push_parser_s::open(bool is_object) {
+    stack.emplace_back();
+    frame_s& f = stack.back();
+    f.dict = nullptr;
+    if (is_object) {
+        if (stack.size() == 1) {
+            f.dict = &root;
+        } else {
+            f.value.set_type(json_object_t);
+            f.value.obj = std::make_shared<dict_s>();
+            f.dict = f.value.obj.get();
+        }
+        f.expect = expect_first_key;
+    } else {
+        f.value.set_type(json_array);
+        f.expect = expect_first_value;
+    }
+}
+
+inline void json_push_parser_s::close() {
+    if (stack.size() == 1) {
+        stack.pop_back();
+        state = json_push_done;
+        return;
+    }
+    val_s value = std::move(stack.back().value);
+    stack.pop_back();
+    deliver(std::move(value));
+}
+
+// ==================== Binary Format Implementation ====================
+
+// Little-endian loads and stores, written with shifts so they give the same
+// bytes on any host; compilers turn them into plain (or byte-swapped) moves.
+inline uint64_t dict_bin_load(const char* p, size_t width) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; i++) {
+        v |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    }
+    return v;
+}
+
+inline void dict_bin_store(char* p, uint64_t v, size_t width) {
+    for (size_t i = 0; i < width; i++) {
+        p[i] = static_cast<char>(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+inline int64_t dict_bin_load_int(const char* p, size_t width) {
+    switch (width) {
+        case 1: return static_cast<int8_t>(p[0]);
+        case 2: return static_cast<int16_t>(dict_bin_load(p, 2));
+        case 4: return static_cast<int32_t>(dict_bin_load(p, 4));
+        default: return static_cast<int64_t>(dict_bin_load(p, 8));
+    }
+}
+
+inline double dict_bin_load_double(const char* p, size_t width) {
+    if (width == 4) {
+        uint32_t bits = static_cast<uint32_t>(dict_bin_load(p, 4));
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+    uint64_t bits = dict_bin_load(p, 8);
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// True if `d` survives a round trip through float bit for bit, so it can be
+// stored in 4 bytes
+inline bool dict_bin_fits_float(double d) {
+    if (!(std::fabs(d) <= FLT_MAX)) return false;   // Also NaN
+    double back = static_cast<float>(d);
+    return std::memcmp(&back, &d, sizeof(d)) == 0;
+}
+
+// Smallest of 1/2/4/8 bytes that holds `v`
+inline size_t dict_bin_int_width(int64_t v) {
+    if (v == static_cast<int8_t>(v)) return 1;
+    if (v == static_cast<int16_t>(v)) return 2;
+    if (v == static_cast<int32_t>(v)) return 4;
+    return 8;
+}
+
+inline size_t dict_bin_tag_width(uint8_t tag) {
+    return size_t(1) << (tag - dict_bin_int8);
+}
+
+// Varint of checked data
+inline uint64_t dict_bin_read_varint(const char*& p) {
+    uint64_t v = 0;
+    for (unsigned shift = 0;; shift += 7) {
+        uint8_t b = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return v;
+    }
+}
+
+// Varint of untrusted data: false if it is truncated or longer than 64 bits
+inline bool dict_bin_check_varint(const char*& p, const char* end, uint64_t& v) {
+    v = 0;
+    for (unsigned shift = 0; shift < 64 && p < end; shift += 7) {
+        uint8_t b = static_cast<uint8_t>(*p++);
+        v |= static_cast<uint64_t>(b & 0x7F) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+// Growing output buffer of the binary encoders
+struct dict_byte_writer_s {
+    std::string out;
+    size_t size;
+    
+    dict_byte_writer_s() : out(256, '\0'), size(0) {}
+    
+    // Room for `n` more bytes at out[size]
+    char* reserve(size_t n) {
+        if (out.size() - size < n) {
+            out.resize(std::max(out.size() * 2, size + n));
+        }
+        return &out[size];
+    }
+    void put_byte(uint8_t b) {
+        *reserve(1) = static_cast<char>(b);
+        size++;
+    }
+    void put_bytes(const char* p, size_t n) {
+        std::memcpy(reserve(n), p, n);
+        size += n;
+    }
+    void put_le(uint64_t v, size_t width) {
+        dict_bin_store(reserve(width), v, width);
+        size += width;
+    }
+    void put_be(uint64_t v, size_t width) {
+        char* p = reserve(width);
+        for (size_t i = 0; i < width; i++) {
+            p[i] = static_cast<char>(static_cast<uint8_t>(v >> (8 * (width - 1 - i))));
+        }
+        size += width;
+    }
+    std::string take() {
+        out.resize(size);
+        return std::move(out);
+    }
+};
+
+// Appends the binary encoding
+struct dict_bin_writer_s : dict_byte_writer_s {
+    void put_varint(uint64_t v) {
+        char* p = reserve(10);
+        char* start = p;
+        for (; v >= 0x80; v >>= 7) {
+            *p++ = static_cast<char>(static_cast<uint8_t>(v | 0x80));
+        }
+        *p++ = static_cast<char>(static_cast<uint8_t>(v));
+        size += static_cast<size_t>(p - start);
+    }
+    void put_string(str_view_s s) {
+        put_byte(dict_bin_string);
+        put_varint(s.size);
+        put_bytes(s.data, s.size);
+    }
+    void put_int(int64_t v) {
+        size_t width = dict_bin_int_width(v);
+        static const uint8_t tags[] = { 0, dict_bin_int8, dict_bin_int16, 0, dict_bin_int32, 0, 0, 0, dict_bin_int64 };
+        put_byte(tags[width]);
+        put_le(static_cast<uint64_t>(v), width);
+    }
+    void put_double(double d, size_t width) {
+        if (width == 4) {
+            float f = static_cast<float>(d);
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            put_le(bits, 4);
+        } else {
+            uint64_t bits;
+            std::memcpy(&bits, &d, sizeof(bits));
+            put_le(bits, 8);
+        }
+    }
+    
+    // Writes the tag and count of an object or array, leaving room for the
+    // body size; returns where to patch it
+    size_t open_container(dict_bin_types tag, size_t count) {
+        put_byte(tag);
+        size_t at = size;
+        put_le(0, 4);
+        put_varint(count);
+        return at;
+    }
+    void close_container(size_t at) {
+        size_t body = size - at - 4;
+        if (body > 0xFFFFFFFFu) {
+            throw std::length_error("Binary container larger than 4 GB");
+        }
+        dict_bin_store(&out[at], body, 4);
+    }
+    
+    void put_object(const dict_s& d);
+    void put_value(const val_s& val);
+};
+
+inline void dict_bin_writer_s::put_object(const dict_s& d) {
+    size_t at = open_container(dict_bin_object, d.obj->size());
+    for (auto it = d.obj->begin(); it != d.obj->end(); ++it) {
+        if (it->first.t == json_k_string_t) {
+            put_string(it->first.str());
+        } else {
+            put_byte(dict_bin_int32);
+            put_le(static_cast<uint32_t>(it->first.intg), 4);
+        }
+        put_value(it->second);
+    }
+    close_container(at);
+}
+
+inline void dict_bin_writer_s::put_value(const val_s& val) {
+    switch (val.t) {
+        case json_null_t:
+            put_byte(dict_bin_null);
+            break;
+        case json_bool_t:
+            put_byte(val.boolean ? dict_bin_true : dict_bin_false);
+            break;
+        case json_integer_t:
+            put_int(val.intg);
+            break;
+        case json_double_t:
+            if (dict_bin_fits_float(val.dbl)) {
+                put_byte(dict_bin_float32);
+                put_double(val.dbl, 4);
+            } else {
+                put_byte(dict_bin_double);
+                put_double(val.dbl, 8);
+            }
+            break;
+        case json_string_t:
+            put_string(val.str_view());
+            break;
+        case json_object_t:
+            if (val.obj) {
+                put_object(*val.obj);
+            } else {
+                close_container(open_container(dict_bin_object, 0));
+            }
+            break;
+        case json_array:
+            if (val.layout == json_array_int) {
+                // One width for the whole array, fitting its widest element
+                size_t width = 1;
+                for (int64_t x : val.arr_intg) width = std::max(width, dict_bin_int_width(x));
+                put_byte(dict_bin_int_array);
+                put_varint(val.arr_intg.size());
+                put_byte(static_cast<uint8_t>(width));
+                char* p = reserve(val.arr_intg.size() * width);
+                for (int64_t x : val.arr_intg) {
+                    dict_bin_store(p, static_cast<uint64_t>(x), width);
+                    p += width;
+                }
+                size += val.arr_intg.size() * width;
+            } else if (val.layout == json_array_double) {
+                size_t width = 4;
+                for (double x : val.arr_dbl) {
+                    if (!dict_bin_fits_float(x)) {
+                        width = 8;
+                        break;
+                    }
+                }
+                put_byte(dict_bin_double_array);
+                put_varint(val.arr_dbl.size());
+                put_byte(static_cast<uint8_t>(width));
+                reserve(val.arr_dbl.size() * width);
+                for (double x : val.arr_dbl) put_double(x, width);
+            } else if (val.layout == json_array_bool) {
+                put_byte(dict_bin_bool_array);
+                put_varint(val.arr_bool.size());
+                char* p = reserve(val.arr_bool.size());
+                for (uint8_t b : val.arr_bool) *p++ = b ? 1 : 0;
+                size += val.arr_bool.size();
+            } else {
+                size_t at = open_container(dict_bin_array, val.arr.size());
+                for (const val_s& item : val.arr) put_value(item);
+                close_container(at);
+            }
+            break;
+    }
+}
+
+inline std::string dict_s::dump_binary() const {
+    dict_bin_writer_s w;
+    w.put_bytes("DCB\x01", 4);
+    w.put_object(*this);
+    return w.take();
+}
+
+// Checks an object key at `p`; returns the byte after it or nullptr
+inline const char* dict_bin_check_key(const char* p, const char* end) {
+    if (p >= end) return nullptr;
+    uint8_t tag = static_cast<uint8_t>(*p++);
+    if (tag == dict_bin_int32) {
+        return end - p >= 4 ? p + 4 : nullptr;
+    }
+    uint64_t n;
+    if (tag != dict_bin_string || !dict_bin_check_varint(p, end, n) || n > static_cast<uint64_t>(end - p)) {
+        return nullptr;
+    }
+    return p + n;
+}
+
+// Checks the value at `p`, which must end by `end`; returns the byte after it
+// or nullptr if it is malformed
+inline const char* dict_bin_check(const char* p, const char* end) {
+    if (p >= end) return nullptr;
+    uint8_t tag = static_cast<uint8_t>(*p++);
+    uint64_t n;
+    switch (tag) {
+        case dict_bin_null:
+        case dict_bin_false:
+        case dict_bin_true:
+            return p;
+        case dict_bin_int8:
+        case dict_bin_int16:
+        case dict_bin_int32:
+        case dict_bin_int64: {
+            size_t width = dict_bin_tag_width(tag);
+            return static_cast<size_t>(end - p) >= width ? p + width : nullptr;
+        }
+        case dict_bin_float32:
+            return end - p >= 4 ? p + 4 : nullptr;
+        case dict_bin_double:
+            return end - p >= 8 ? p + 8 : nullptr;
+        case dict_bin_string:
+            if (!dict_bin_check_varint(p, end, n) || n > static_cast<uint64_t>(end - p)) return nullptr;
+            return p + n;
+        case dict_bin_object:
+        case dict_bin_array: {
+            if (end - p < 4) return nullptr;
+            uint64_t body = dict_bin_load(p, 4);
+            p += 4;
+            if (body > static_cast<uint64_t>(end - p)) return nullptr;
+            const char* stop = p + body;
+            if (!dict_bin_check_varint(p, stop, n)) return nullptr;
+            // Every member takes at least a byte, so a bogus count fails fast
+            for (; n > 0; n--) {
+                if (tag == dict_bin_object && !(p = dict_bin_check_key(p, stop))) return nullptr;
+                if (!(p = dict_bin_check(p, stop))) return nullptr;
+            }
+            return p == stop ? p : nullptr;
+        }
+        case dict_bin_int_array:
+        case dict_bin_double_array: {
+            if (!dict_bin_check_varint(p, end, n) || p == end) return nullptr;
+            size_t width = static_cast<uint8_t>(*p++);
+            if (width != 4 && width != 8 && (tag == dict_bin_double_array || (width != 1 && width != 2))) {
+                return nullptr;
+            }
+            if (n > static_cast<uint64_t>(end - p) / width) return nullptr;
+            return p + n * width;
+        }
+        case dict_bin_bool_array:
+            if (!dict_bin_check_varint(p, end, n) || n > static_cast<uint64_t>(end - p)) return nullptr;
+            for (const char* stop = p + n; p < stop; p++) {
+                if (static_cast<uint8_t>(*p) > 1) return nullptr;
+            }
+            return p;
+        default:
+            return nullptr;
+    }
+}
+
+// Byte after the (checked) value or key at `p`
+inline const char* dict_bin_skip(const char* p) {
+    uint8_t tag = static_cast<uint8_t>(*p++);
+    uint64_t n;
+    switch (tag) {
+        case dict_bin_int8:
+        case dict_bin_int16:
+        case dict_bin_int32:
+        case dict_bin_int64:
+            return p + dict_bin_tag_width(tag);
+        case dict_bin_float32:
+            return p + 4;
+        case dict_bin_double:
+            return p + 8;
+        case dict_bin_string:
+            n = dict_bin_read_varint(p);
+            return p + n;
+        case dict_bin_object:
+        case dict_bin_array:
+            return p + 4 + dict_bin_load(p, 4);
+        case dict_bin_int_array:
+        case dict_bin_double_array:
+            n = dict_bin_read_varint(p);
+            return p + 1 + n * static_cast<uint8_t>(*p);
+        case dict_bin_bool_array:
+            n = dict_bin_read_varint(p);
+            return p + n;
+        default:
+            return p;
+    }
+}
+
+inline const char* dict_bin_build(const char* p, val_s& out, key_pool_s& pool);
+
+// Adds the members of the (checked) object at `p` to `d`
+inline const char* dict_bin_build_members(const char* p, dict_s& d, key_pool_s& pool) {
+    p += 5;
+    uint64_t n = dict_bin_read_varint(p);
+#ifndef JSON_ORDERED
+    d.obj->reserve(d.obj->size() + static_cast<size_t>(n));
+#endif
+    for (; n > 0; n--) {
+        key_s key;
+        if (static_cast<uint8_t>(*p++) == dict_bin_string) {
+            uint64_t size = dict_bin_read_varint(p);
+            key = pool.intern(str_view_s(p, static_cast<size_t>(size)));
+            p += size;
+        } else {
+            key = key_s(static_cast<int32_t>(dict_bin_load(p, 4)));
+            p += 4;
+        }
+        // Nested values are built into other maps, so the slot stays put
+        p = dict_bin_build(p, d[key], pool);
+    }
+    d.leaked = false;                    // The slots were filled; none escaped
+    return p;
+}
+
+// Builds the (checked) value at `p` into `out`; returns the byte after it
+inline const char* dict_bin_build(const char* p, val_s& out, key_pool_s& pool) {
+    uint8_t tag = static_cast<uint8_t>(*p);
+    const char* q = p + 1;
+    uint64_t n;
+    switch (tag) {
+        case dict_bin_false:
+        case dict_bin_true:
+            out = tag == dict_bin_true;
+            return q;
+        case dict_bin_int8:
+        case dict_bin_int16:
+        case dict_bin_int32:
+        case dict_bin_int64:
+            out = dict_bin_load_int(q, dict_bin_tag_width(tag));
+            return q + dict_bin_tag_width(tag);
+        case dict_bin_float32:
+            out = dict_bin_load_double(q, 4);
+            return q + 4;
+        case dict_bin_double:
+            out = dict_bin_load_double(q, 8);
+            return q + 8;
+        case dict_bin_string:
+            n = dict_bin_read_varint(q);
+            out.set_type(json_string_t);
+            out.str.assign(q, static_cast<size_t>(n));
+            return q + n;
+        case dict_bin_object:
+            out.set_type(json_object_t);
+            out.obj = std::make_shared<dict_s>();
+            return dict_bin_build_members(p, *out.obj, pool);
+        case dict_bin_array: {
+            const char* stop = dict_bin_skip(p);
+            out.set_type(json_array);
+            q += 4;
+            for (n = dict_bin_read_varint(q); n > 0; n--) {
+                val_s item;
+                q = dict_bin_build(q, item, pool);
+                out.push_back(std::move(item));     // Packs homogeneous scalar arrays
+            }
+            return stop;
+        }
+        case dict_bin_int_array:
+        case dict_bin_double_array:
+        case dict_bin_bool_array: {
+            // The first element selects the packed layout, the rest are
+            // written straight into it
+            out.set_type(json_array);
+            n = dict_bin_read_varint(q);
+            size_t width = tag == dict_bin_bool_array ? 1 : static_cast<uint8_t>(*q++);
+            if (n == 0) return q;
+            val_s first;
+            if (tag == dict_bin_int_array) first = dict_bin_load_int(q, width);
+            else if (tag == dict_bin_double_array) first = dict_bin_load_double(q, width);
+            else first = *q != 0;
+            out.push_back(std::move(first));
+            size_t count = static_cast<size_t>(n);
+            if (tag == dict_bin_int_array) {
+                out.arr_intg.resize(count);
+                for (size_t i = 1; i < count; i++) out.arr_intg[i] = dict_bin_load_int(q + i * width, width);
+            } else if (tag == dict_bin_double_array) {
+                out.arr_dbl.resize(count);
+                for (size_t i = 1; i < count; i++) out.arr_dbl[i] = dict_bin_load_double(q + i * width, width);
+            } else {
+                out.arr_bool.assign(q, q + count);
+            }
+            return q + count * width;
+        }
+        default:
+            out.set_type(json_null_t);
+            return q;
+    }
+}
+
+inline bool dict_s::parse_binary(const char* data, size_t size) {
+    obj = std::make_shared<map_t>();
+    leaked = false;
+    bin_doc_s doc(data, size);
+    valid = doc.valid;
+    if (valid) {
+        key_pool_s pool;
+        dict_bin_build_members(data + 4, *this, pool);
+    }
+    return valid;
+}
+
+inline bin_doc_s::bin_doc_s(const char* d, size_t size) : valid(false), data(d) {
+    valid = size > 4 && std::memcmp(d, "DCB\x01", 4) == 0 &&
+            static_cast<uint8_t>(d[4]) == dict_bin_object &&
+            dict_bin_check(d + 4, d + size) == d + size;
+}
+
+inline json_value_types bin_val_s::type() const {
+    if (!p) return json_null_t;
+    switch (tag()) {
+        case dict_bin_object: return json_object_t;
+        case dict_bin_array: return json_array;
+        case dict_bin_string: return json_string_t;
+        case dict_bin_int8:
+        case dict_bin_int16:
+        case dict_bin_int32:
+        case dict_bin_int64: return json_integer_t;
+        case dict_bin_float32:
+        case dict_bin_double: return json_double_t;
+        case dict_bin_false:
+        case dict_bin_true: return json_bool_t;
+        case dict_bin_int_array: return index == npos ? json_array : json_integer_t;
+        case dict_bin_double_array: return index == npos ? json_array : json_double_t;
+        case dict_bin_bool_array: return index == npos ? json_array : json_bool_t;
+        default: return json_null_t;
+    }
+}
+
+inline json_array_layouts bin_val_s::layout() const {
+    if (!p || index != npos) return json_array_generic;
+    switch (tag()) {
+        case dict_bin_int_array: return json_array_int;
+        case dict_bin_double_array: return json_array_double;
+        case dict_bin_bool_array: return json_array_bool;
+        default: return json_array_generic;
+    }
+}
+
+// Objects are searched linearly from the back, so the last of duplicate
+// keys wins as in dict_s
+inline bin_val_s bin_val_s::member(const char* key, size_t size, int32_t intg, bool is_int) const {
+    if (!is_object()) return bin_val_s();
+    const char* q = p + 5;
+    bin_val_s found;
+    for (uint64_t n = dict_bin_read_varint(q); n > 0; n--) {
+        bool match;
+        if (static_cast<uint8_t>(*q++) == dict_bin_string) {
+            uint64_t len = dict_bin_read_varint(q);
+            match = !is_int && len == size && std::memcmp(q, key, size) == 0;
+            q += len;
+        } else {
+            match = is_int && static_cast<int32_t>(dict_bin_load(q, 4)) == intg;
+            q += 4;
+        }
+        if (match) found = bin_val_s(q, npos);
+        q = dict_bin_skip(q);
+    }
+    return found;
+}
+
+inline bin_val_s bin_val_s::find(str_view_s key) const {
+    return member(key.data, key.size, 0, false);
+}
+
+inline bin_val_s bin_val_s::find(int32_t key) const {
+    return member(nullptr, 0, key, true);
+}
+
+inline bin_val_s bin_val_s::operator[](str_view_s key) const {
+    bin_val_s v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return v;
+}
+
+inline bin_val_s bin_val_s::operator[](int32_t key) const {
+    bin_val_s v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return v;
+}
+
+inline bin_val_s bin_val_s::at(size_t i) const {
+    if (!is_array()) {
+        throw std::out_of_range("Value is not an array");
+    }
+    if (i >= size()) {
+        throw std::out_of_range("Array index out of range");
+    }
+    if (tag() != dict_bin_array) return bin_val_s(p, i);
+    const char* q = p + 5;
+    dict_bin_read_varint(q);
+    for (; i > 0; i--) q = dict_bin_skip(q);
+    return bin_val_s(q, npos);
+}
+
+inline size_t bin_val_s::size() const {
+    if (!is_object() && !is_array()) return 0;
+    const char* q = p + (tag() == dict_bin_object || tag() == dict_bin_array ? 5 : 1);
+    return static_cast<size_t>(dict_bin_read_varint(q));
+}
+
+inline int64_t bin_val_s::intg() const {
+    if (type() != json_integer_t) {
+        throw std::domain_error("Value is not an integer");
+    }
+    if (index == npos) return dict_bin_load_int(p + 1, dict_bin_tag_width(tag()));
+    const char* q = p + 1;
+    dict_bin_read_varint(q);
+    size_t width = static_cast<uint8_t>(*q++);
+    return dict_bin_load_int(q + index * width, width);
+}
+
+inline double bin_val_s::dbl() const {
+    json_value_types t = type();
+    if (t == json_integer_t) return static_cast<double>(intg());
+    if (t != json_double_t) {
+        throw std::domain_error("Value is not a number");
+    }
+    if (index == npos) return dict_bin_load_double(p + 1, tag() == dict_bin_float32 ? 4 : 8);
+    const char* q = p + 1;
+    dict_bin_read_varint(q);
+    size_t width = static_cast<uint8_t>(*q++);
+    return dict_bin_load_double(q + index * width, width);
+}
+
+inline bool bin_val_s::boolean() const {
+    if (type() != json_bool_t) {
+        throw std::domain_error("Value is not a bool");
+    }
+    if (index == npos) return tag() == dict_bin_true;
+    const char* q = p + 1;
+    dict_bin_read_varint(q);
+    return q[index] != 0;
+}
+
+inline str_view_s bin_val_s::str_view() const {
+    if (type() != json_string_t) {
+        throw std::domain_error("Value is not a string");
+    }
+    const char* q = p + 1;
+    uint64_t n = dict_bin_read_varint(q);
+    return str_view_s(q, static_cast<size_t>(n));
+}
+
+inline val_s bin_val_s::to_val() const {
+    val_s v;
+    if (!p) return v;
+    if (index != npos) {
+        json_value_types t = type();
+        if (t == json_integer_t) v = intg();
+        else if (t == json_double_t) v = dbl();
+        else v = boolean();
+        return v;
+    }
+    key_pool_s pool;
+    dict_bin_build(p, v, pool);
+    return v;
+}
+
+inline dict_s bin_val_s::to_dict() const {
+    if (!is_object()) {
+        throw std::domain_error("Value is not an object");
+    }
+    val_s v = to_val();
+    dict_s d(std::move(*v.obj));
+    return d;
+}
+
+// ==================== MessagePack / CBOR Implementation ====================
+
+// Big-endian load, as both formats store numbers
+inline uint64_t dict_load_be(const char* p, size_t width) {
+    uint64_t v = 0;
+    for (size_t i = 0; i < width; i++) {
+        v = (v << 8) | static_cast<uint8_t>(p[i]);
+    }
+    return v;
+}
+
+inline double dict_float_bits(uint32_t bits) {
+    float f;
+    std::memcpy(&f, &bits, sizeof(f));
+    return f;
+}
+
+inline double dict_double_bits(uint64_t bits) {
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+// IEEE-754 half precision, which CBOR encoders may use for short floats
+inline double dict_half_bits(uint16_t h) {
+    int exp = (h >> 10) & 0x1F;
+    int mant = h & 0x3FF;
+    double v;
+    if (exp == 0) {
+        v = std::ldexp(mant, -24);
+    } else if (exp != 31) {
+        v = std::ldexp(mant + 1024, exp - 25);
+    } else {
+        v = mant ? std::numeric_limits<double>::quiet_NaN() : std::numeric_limits<double>::infinity();
+    }
+    return (h & 0x8000) ? -v : v;
+}
+
+// One decoded item header of either format
+struct dict_wire_item_s {
+    enum kind_e { kind_null, kind_false, kind_true, kind_int, kind_double,
+                  kind_string, kind_array, kind_map, kind_tag, kind_break };
+    
+    kind_e kind;
+    int64_t intg;
+    double dbl;
+    uint64_t size;                       // String bytes, array items or map pairs
+    size_t header;                       // Bytes before the payload
+    int major;                           // Strings: 2 for bytes, 3 for text (CBOR major types)
+    bool indefinite;
+};
+
+// Unsigned integers beyond int64_t become doubles, as in the JSON parser
+inline void dict_wire_set_uint(dict_wire_item_s& it, uint64_t v) {
+    if (v > static_cast<uint64_t>(INT64_MAX)) {
+        it.kind = dict_wire_item_s::kind_double;
+        it.dbl = static_cast<double>(v);
+    } else {
+        it.kind = dict_wire_item_s::kind_int;
+        it.intg = static_cast<int64_t>(v);
+    }
+}
+
+inline json_push_status dict_msgpack_item(const char* p, const char* end, dict_wire_item_s& it) {
+    typedef dict_wire_item_s item;
+    if (p == end) return json_push_more;
+    uint8_t b = static_cast<uint8_t>(*p);
+    it.header = 1;
+    it.major = 3;
+    it.indefinite = false;
+    if (b <= 0x7F || b >= 0xE0) {                     // Positive and negative fixint
+        it.kind = item::kind_int;
+        it.intg = static_cast<int8_t>(b);
+        return json_push_done;
+    }
+    if (b <= 0xBF) {                                  // fixmap, fixarray, fixstr
+        it.kind = b <= 0x8F ? item::kind_map : b <= 0x9F ? item::kind_array : item::kind_string;
+        it.size = b <= 0x9F ? (b & 0x0F) : (b & 0x1F);
+        return json_push_done;
+    }
+    size_t width;
+    bool is_uint = false;
+    switch (b) {
+        case 0xC0: it.kind = item::kind_null; return json_push_done;
+        case 0xC2: it.kind = item::kind_false; return json_push_done;
+        case 0xC3: it.kind = item::kind_true; return json_push_done;
+        case 0xC4: case 0xC5: case 0xC6:              // bin 8/16/32
+            it.kind = item::kind_string;
+            it.major = 2;
+            width = size_t(1) << (b - 0xC4);
+            break;
+        case 0xCA: it.kind = item::kind_double; width = 4; break;
+        case 0xCB: it.kind = item::kind_double; width = 8; break;
+        case 0xCC: case 0xCD: case 0xCE: case 0xCF:   // uint 8..64
+            it.kind = item::kind_int;
+            is_uint = true;
+            width = size_t(1) << (b - 0xCC);
+            break;
+        case 0xD0: case 0xD1: case 0xD2: case 0xD3:   // int 8..64
+            it.kind = item::kind_int;
+            width = size_t(1) << (b - 0xD0);
+            break;
+        case 0xD9: case 0xDA: case 0xDB:              // str 8/16/32
+            it.kind = item::kind_string;
+            width = size_t(1) << (b - 0xD9);
+            break;
+        case 0xDC: it.kind = item::kind_array; width = 2; break;
+        case 0xDD: it.kind = item::kind_array; width = 4; break;
+        case 0xDE: it.kind = item::kind_map; width = 2; break;
+        case 0xDF: it.kind = item::kind_map; width = 4; break;
+        default: return json_push_error;              // Extension types, 0xC1
+    }
+    if (static_cast<size_t>(end - p - 1) < width) return json_push_more;
+    uint64_t v = dict_load_be(p + 1, width);
+    it.header = 1 + width;
+    switch (it.kind) {
+        case item::kind_int:
+            if (is_uint) {
+                dict_wire_set_uint(it, v);
+                break;
+            }
+            it.intg = width == 1 ? static_cast<int8_t>(v) : width == 2 ? static_cast<int16_t>(v) :
+                      width == 4 ? static_cast<int32_t>(v) : static_cast<int64_t>(v);
+            break;
+        case item::kind_double:
+            it.dbl = width == 4 ? dict_float_bits(static_cast<uint32_t>(v)) : dict_double_bits(v);
+            break;
+        default:
+            it.size = v;
+            break;
+    }
+    return json_push_done;
+}
+
+inline json_push_status dict_cbor_item(const char* p, const char* end, dict_wire_item_s& it) {
+    typedef dict_wire_item_s item;
+    if (p == end) return json_push_more;
+    uint8_t b = static_cast<uint8_t>(*p);
+    int major = b >> 5;
+    unsigned info = b & 0x1F;
+    uint64_t arg = info;
+    it.header = 1;
+    it.major = major;
+    it.indefinite = false;
+    if (info >= 24 && info <= 27) {
+        size_t width = size_t(1) << (info - 24);
+        if (static_cast<size_t>(end - p - 1) < width) return json_push_more;
+        arg = dict_load_be(p + 1, width);
+        it.header = 1 + width;
+    } else if (info == 31) {
+        if (major == 7) {
+            it.kind = item::kind_break;
+            return json_push_done;
+        }
+        if (major < 2 || major > 5) return json_push_error;
+        it.indefinite = true;
+    } else if (info > 27) {
+        return json_push_error;
+    }
+    switch (major) {
+        case 0:
+            dict_wire_set_uint(it, arg);
+            break;
+        case 1:                                       // -1 - arg
+            if (arg > static_cast<uint64_t>(INT64_MAX)) {
+                it.kind = item::kind_double;
+                it.dbl = -1.0 - static_cast<double>(arg);
+            } else {
+                it.kind = item::kind_int;
+                it.intg = -1 - static_cast<int64_t>(arg);
+            }
+            break;
+        case 2:
+        case 3:
+            it.kind = item::kind_string;
+            it.size = arg;
+            break;
+        case 4:
+            it.kind = item::kind_array;
+            it.size = arg;
+            break;
+        case 5:
+            it.kind = item::kind_map;
+            it.size = arg;
+            break;
+        case 6:                                       // Tags are dropped, the item stays
+            it.kind = item::kind_tag;
+            break;
+        default:
+            switch (info) {
+                case 20: it.kind = item::kind_false; break;
+                case 21: it.kind = item::kind_true; break;
+                case 22:
+                case 23: it.kind = item::kind_null; break;   // null, undefined
+                case 25: it.kind = item::kind_double; it.dbl = dict_half_bits(static_cast<uint16_t>(arg)); break;
+                case 26: it.kind = item::kind_double; it.dbl = dict_float_bits(static_cast<uint32_t>(arg)); break;
+                case 27: it.kind = item::kind_double; it.dbl = dict_double_bits(arg); break;
+                default: return json_push_error;      // Other simple values
+            }
+            break;
+    }
+    return json_push_done;
+}
+
+template<dict_wire_formats F>
+inline json_push_status dict_wire_item(const char* p, const char* end, dict_wire_item_s& it) {
+    return F == dict_format_msgpack ? dict_msgpack_item(p, end, it) : dict_cbor_item(p, end, it);
+}
+
+inline json_push_status dict_wire_scanner_s::scan(const char* data, size_t size) {
+    return format == dict_format_msgpack ? scan_items<dict_format_msgpack>(data, size)
+                                         : scan_items<dict_format_cbor>(data, size);
+}
+
+template<dict_wire_formats F>
+inline json_push_status dict_wire_scanner_s::scan_items(const char* data, size_t size) {
+    typedef dict_wire_item_s item;
+    while (!started || !stack.empty()) {
+        // Tags are read as part of the item they apply to
+        dict_wire_item_s it;
+        size_t tags = 0;
+        json_push_status st;
+        while ((st = dict_wire_item<F>(data + pos + tags, data + size, it)) == json_push_done &&
+               it.kind == item::kind_tag) {
+            tags += it.header;
+        }
+        if (st != json_push_done) return st;
+        frame_s* top = stack.empty() ? nullptr : &stack.back();
+        if (tags && ((top && top->chunks >= 0) || it.kind == item::kind_break)) return json_push_error;
+        it.header += tags;
+        
+        if (it.kind == item::kind_break) {
+            if (!top || !top->indefinite || (top->is_map && top->index % 2)) return json_push_error;
+            pos += it.header;
+            stack.pop_back();
+        } else {
+            if (!top) {
+                if (it.kind != item::kind_map) return json_push_error;
+            } else if (top->chunks >= 0) {
+                if (it.kind != item::kind_string || it.indefinite || it.major != top->chunks) return json_push_error;
+            } else if (top->is_map && top->index % 2 == 0) {
+                bool text = it.kind == item::kind_string && it.major == 3 && !it.indefinite;
+                bool int_key = it.kind == item::kind_int && it.intg >= INT32_MIN && it.intg <= INT32_MAX;
+                if (!text && !int_key) return json_push_error;
+            }
+            // The whole item has to be here before the state moves on
+            uint64_t payload = it.kind == item::kind_string && !it.indefinite ? it.size : 0;
+            if (size - pos - it.header < payload) return json_push_more;
+            if (it.kind == item::kind_map && !it.indefinite && it.size > UINT64_MAX / 2) return json_push_error;
+            pos += it.header + static_cast<size_t>(payload);
+            started = true;
+            if (top) {
+                top->index++;
+                top->remaining--;
+            }
+            if (it.kind == item::kind_array || it.kind == item::kind_map) {
+                frame_s f = { it.kind == item::kind_map ? it.size * 2 : it.size, 0,
+                              it.kind == item::kind_map, it.indefinite, -1 };
+                stack.push_back(f);
+            } else if (it.kind == item::kind_string && it.indefinite) {
+                frame_s f = { 0, 0, false, true, it.major };
+                stack.push_back(f);
+            }
+        }
+        while (!stack.empty() && !stack.back().indefinite && stack.back().remaining == 0) {
+            stack.pop_back();
+        }
+    }
+    return json_push_done;
+}
+
+template<dict_wire_formats F>
+const char* dict_wire_build(const char* p, const char* end, val_s& out, key_pool_s& pool);
+
+// Adds the members of the (checked) map whose header is `it` to `d`
+template<dict_wire_formats F>
+const char* dict_wire_build_members(const char* p, const char* end, const dict_wire_item_s& it,
+                                    dict_s& d, key_pool_s& pool) {
+    typedef dict_wire_item_s item;
+#ifndef JSON_ORDERED
+    if (!it.indefinite) d.obj->reserve(d.obj->size() + static_cast<size_t>(it.size));
+#endif
+    for (uint64_t n = 0; it.indefinite || n < it.size; n++) {
+        dict_wire_item_s k;
+        do {
+            dict_wire_item<F>(p, end, k);
+            p += k.header;
+        } while (k.kind == item::kind_tag);
+        if (k.kind == item::kind_break) break;
+        key_s key;
+        if (k.kind == item::kind_string) {
+            key = pool.intern(str_view_s(p, static_cast<size_t>(k.size)));
+            p += k.size;
+        } else {
+            key = key_s(static_cast<int32_t>(k.intg));
+        }
+        // Nested values are built into other maps, so the slot stays put
+        p = dict_wire_build<F>(p, end, d[key], pool);
+    }
+    d.leaked = false;                    // The slots were filled; none escaped
+    return p;
+}
+
+// Builds the (checked) item at `p` into `out`; returns the byte after it
+template<dict_wire_formats F>
+const char* dict_wire_build(const char* p, const char* end, val_s& out, key_pool_s& pool) {
+    typedef dict_wire_item_s item;
+    dict_wire_item_s it;
+    do {
+        dict_wire_item<F>(p, end, it);
+        p += it.header;
+    } while (it.kind == item::kind_tag);
+    switch (it.kind) {
+        case item::kind_false: out = false; break;
+        case item::kind_true: out = true; break;
+        case item::kind_int: out = it.intg; break;
+        case item::kind_double: out = it.dbl; break;
+        case item::kind_string:
+            out.set_type(json_string_t);
+            if (!it.indefinite) {
+                out.str.assign(p, static_cast<size_t>(it.size));
+                p += it.size;
+                break;
+            }
+            out.str.clear();
+            for (dict_wire_item_s chunk;;) {
+                dict_wire_item<F>(p, end, chunk);
+                p += chunk.header;
+                if (chunk.kind == item::kind_break) break;
+                out.str.append(p, static_cast<size_t>(chunk.size));
+                p += chunk.size;
+            }
+            break;
+        case item::kind_array:
+            out.set_type(json_array);
+            for (uint64_t n = 0; it.indefinite || n < it.size; n++) {
+                if (it.indefinite && static_cast<uint8_t>(*p) == 0xFF) {
+                    p++;
+                    break;
+                }
+                val_s element;
+                p = dict_wire_build<F>(p, end, element, pool);
+                out.push_back(std::move(element));    // Packs homogeneous scalar arrays
+            }
+            break;
+        case item::kind_map:
+            out.set_type(json_object_t);
+            out.obj = std::make_shared<dict_s>();
+            p = dict_wire_build_members<F>(p, end, it, *out.obj, pool);
+            break;
+        default:
+            out.set_type(json_null_t);
+            break;
+    }
+    return p;
+}
+
+// Builds a checked message into `d`, whose map must be empty
+template<dict_wire_formats F>
+void dict_wire_build_root(const char* p, const char* end, dict_s& d) {
+    key_pool_s pool;
+    dict_wire_item_s it;
+    do {
+        dict_wire_item<F>(p, end, it);
+        p += it.header;
+    } while (it.kind == dict_wire_item_s::kind_tag);
+    dict_wire_build_members<F>(p, end, it, d, pool);
+}
+
+inline void dict_wire_build_root(dict_wire_formats format, const char* p, const char* end, dict_s& d) {
+    if (format == dict_format_msgpack) {
+        dict_wire_build_root<dict_format_msgpack>(p, end, d);
+    } else {
+        dict_wire_build_root<dict_format_cbor>(p, end, d);
+    }
+}
+
+inline bool dict_wire_parse(dict_wire_formats format, const char* data, size_t size, dict_s& d) {
+    d.obj = std::make_shared<dict_s::map_t>();
+    d.leaked = false;
+    dict_wire_scanner_s scanner(format);
+    d.valid = scanner.scan(data, size) == json_push_done && scanner.pos == size;
+    if (d.valid) {
+        dict_wire_build_root(format, data, data + size, d);
+    }
+    return d.valid;
+}
+
+inline bool dict_s::parse_msgpack(const char* data, size_t size) {
+    return dict_wire_parse(dict_format_msgpack, data, size, *this);
+}
+
+inline bool dict_s::parse_cbor(const char* data, size_t size) {
+    return dict_wire_parse(dict_format_cbor, data, size, *this);
+}
+
+// MessagePack encoder: the shortest form of every integer and length
+struct dict_msgpack_writer_s : dict_byte_writer_s {
+    void put_head(uint8_t tag, uint64_t v, size_t width) {
+        put_byte(tag);
+        put_be(v, width);
+    }
+    void put_int(int64_t v) {
+        if (v >= -32 && v <= 127) {
+            put_byte(static_cast<uint8_t>(v));
+        } else if (v >= 0) {
+            uint64_t u = static_cast<uint64_t>(v);
+            if (u <= 0xFF) put_head(0xCC, u, 1);
+            else if (u <= 0xFFFF) put_head(0xCD, u, 2);
+            else if (u <= 0xFFFFFFFF) put_head(0xCE, u, 4);
+            else put_head(0xCF, u, 8);
+        } else {
+            uint64_t u = static_cast<uint64_t>(v);
+            if (v >= INT8_MIN) put_head(0xD0, u, 1);
+            else if (v >= INT16_MIN) put_head(0xD1, u, 2);
+            else if (v >= INT32_MIN) put_head(0xD2, u, 4);
+            else put_head(0xD3, u, 8);
+        }
+    }
+    void put_double(double d) {
+        if (dict_bin_fits_float(d)) {
+            float f = static_cast<float>(d);
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            put_head(0xCA, bits, 4);
+        } else {
+            uint64_t bits;
+            std::memcpy(&bits, &d, sizeof(bits));
+            put_head(0xCB, bits, 8);
+        }
+    }
+    void put_length(size_t n, uint8_t fix, size_t fix_limit, uint8_t tag8, uint8_t tag16, uint8_t tag32) {
+        if (n < fix_limit) put_byte(static_cast<uint8_t>(fix | n));
+        else if (tag8 && n <= 0xFF) put_head(tag8, n, 1);
+        else if (n <= 0xFFFF) put_head(tag16, n, 2);
+        else if (n <= 0xFFFFFFFFu) put_head(tag32, n, 4);
+        else throw std::length_error("MessagePack item larger than 4 GB");
+    }
+    void put_string(str_view_s s) {
+        put_length(s.size, 0xA0, 32, 0xD9, 0xDA, 0xDB);
+        put_bytes(s.data, s.size);
+    }
+    void put_array(size_t n) { put_length(n, 0x90, 16, 0, 0xDC, 0xDD); }
+    void put_map(size_t n) { put_length(n, 0x80, 16, 0, 0xDE, 0xDF); }
+    void put_null() { put_byte(0xC0); }
+    void put_bool(bool b) { put_byte(b ? 0xC3 : 0xC2); }
+};
+
+// CBOR encoder, preferred serialization except that floats use at least 4 bytes
+struct dict_cbor_writer_s : dict_byte_writer_s {
+    void put_head(int major, uint64_t arg) {
+        uint8_t m = static_cast<uint8_t>(major << 5);
+        if (arg < 24) put_byte(static_cast<uint8_t>(m | arg));
+        else if (arg <= 0xFF) { put_byte(m | 24); put_be(arg, 1); }
+        else if (arg <= 0xFFFF) { put_byte(m | 25); put_be(arg, 2); }
+        else if (arg <= 0xFFFFFFFFu) { put_byte(m | 26); put_be(arg, 4); }
+        else { put_byte(m | 27); put_be(arg, 8); }
+    }
+    void put_int(int64_t v) {
+        if (v >= 0) put_head(0, static_cast<uint64_t>(v));
+        else put_head(1, ~static_cast<uint64_t>(v));    // -1 - v
+    }
+    void put_double(double d) {
+        if (dict_bin_fits_float(d)) {
+            float f = static_cast<float>(d);
+            uint32_t bits;
+            std::memcpy(&bits, &f, sizeof(bits));
+            put_byte(0xFA);
+            put_be(bits, 4);
+        } else {
+            uint64_t bits;
+            std::memcpy(&bits, &d, sizeof(bits));
+            put_byte(0xFB);
+            put_be(bits, 8);
+        }
+    }
+    void put_string(str_view_s s) {
+        put_head(3, s.size);
+        put_bytes(s.data, s.size);
+    }
+    void put_array(size_t n) { put_head(4, n); }
+    void put_map(size_t n) { put_head(5, n); }
+    void put_null() { put_byte(0xF6); }
+    void put_bool(bool b) { put_byte(b ? 0xF5 : 0xF4); }
+};
+
+template<typename W>
+void dict_wire_put_object(W& w, const dict_s& d);
+
+template<typename W>
+void dict_wire_put_value(W& w, const val_s& val) {
+    switch (val.t) {
+        case json_null_t: w.put_null(); break;
+        case json_bool_t: w.put_bool(val.boolean); break;
+        case json_integer_t: w.put_int(val.intg); break;
+        case json_double_t: w.put_double(val.dbl); break;
+        case json_string_t: w.put_string(val.str_view()); break;
+        case json_object_t:
+            if (val.obj) {
+                dict_wire_put_object(w, *val.obj);
+            } else {
+                w.put_map(0);
+            }
+            break;
+        case json_array:
+            w.put_array(val.size());
+            if (val.layout == json_array_int) {
+                for (int64_t x : val.arr_intg) w.put_int(x);
+            } else if (val.layout == json_array_double) {
+                for (double x : val.arr_dbl) w.put_double(x);
+            } else if (val.layout == json_array_bool) {
+                for (uint8_t b : val.arr_bool) w.put_bool(b != 0);
+            } else {
+                for (const val_s& item : val.arr) dict_wire_put_value(w, item);
+            }
+            break;
+    }
+}
+
+template<typename W>
+void dict_wire_put_object(W& w, const dict_s& d) {
+    w.put_map(d.obj->size());
+    for (auto it = d.obj->begin(); it != d.obj->end(); ++it) {
+        if (it->first.t == json_k_string_t) {
+            w.put_string(it->first.str());
+        } else {
+            w.put_int(it->first.intg);
+        }
+        dict_wire_put_value(w, it->second);
+    }
+}
+
+inline std::string dict_s::dump_msgpack() const {
+    dict_msgpack_writer_s w;
+    dict_wire_put_object(w, *this);
+    return w.take();
+}
+
+inline std::string dict_s::dump_cbor() const {
+    dict_cbor_writer_s w;
+    dict_wire_put_object(w, *this);
+    return w.take();
+}
+
+inline void wire_decoder_s::feed(const char* data, size_t size) {
+    if (state != json_push_error) {
+        buf.append(data, size);
+    }
+}
+
+inline json_push_status wire_decoder_s::next(dict_s& out) {
+    if (state == json_push_error) return state;
+    // Drop consumed messages once they are most of the buffer
+    if (start > 0 && start * 2 >= buf.size()) {
+        buf.erase(0, start);
+        dropped += start;
+        start = 0;
+    }
+    json_push_status st = scanner.scan(buf.data() + start, buf.size() - start);
+    if (st == json_push_error) return state = st;
+    if (st == json_push_more) return st;
+    out.obj = std::make_shared<dict_s::map_t>();
+    out.valid = true;
+    dict_wire_build_root(scanner.format, buf.data() + start, buf.data() + start + scanner.pos, out);
+    start += scanner.pos;
+    scanner.reset();
+    return json_push_done;
+}
+
+// ==================== Persistent Dict Implementation ====================
+
+// Hash bits consumed per trie level; 13 levels cover all 64 bits
+static const unsigned pdict_bits = 5;
 
-// Comparison operators
-#ifndef JSON_ORDERED
-bool operator==(const key_s& first, const key_s& second);
+inline unsigned pdict_slot(uint64_t hash, unsigned shift) {
+    return static_cast<unsigned>(hash >> shift) & 31u;
+}
+
+inline unsigned pdict_index(uint32_t bitmap, uint32_t bit) {
+    uint32_t below = bitmap & (bit - 1);
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcount(below));
 #else
-bool operator<(const key_s& first, const key_s& second);
+    unsigned n = 0;
+    for (; below; below &= below - 1) n++;
+    return n;
 #endif
+}
 
-// Stream operators
-std::ostream& operator<<(std::ostream& os, const dict_t& dict);
-std::ostream& operator<<(std::ostream& os, const val_t& val);
-std::ostream& operator<<(std::ostream& os, const dict_key_t& k);
-
-// Template implementations for generic arrays
+inline pdict_node_s::ptr_t pdict_leaf(uint64_t hash, const key_s& key, val_s&& value) {
+    std::shared_ptr<pdict_node_s> leaf = std::make_shared<pdict_node_s>();
+    leaf->hash = hash;
+    leaf->items.emplace_back(key, std::move(value));
+    return leaf;
+}
 
-template<typename T>
-val_s& val_s::operator=(const std::vector<T>& assign) {
-    t = json_array;
-    arr.clear();
-    for (const auto& item : assign) {
-        auto v = std::make_shared<val_s>();
-        *v = item;
-        arr.push_back(v);
+// Branch (and chain of branches, while the hashes agree) holding two leaves
+// with different hashes
+inline pdict_node_s::ptr_t pdict_merge(const pdict_node_s::ptr_t& a, const pdict_node_s::ptr_t& b,
+                                       unsigned shift) {
+    std::shared_ptr<pdict_node_s> branch = std::make_shared<pdict_node_s>();
+    unsigned sa = pdict_slot(a->hash, shift);
+    unsigned sb = pdict_slot(b->hash, shift);
+    if (sa == sb) {
+        branch->bitmap = 1u << sa;
+        branch->children.push_back(pdict_merge(a, b, shift + pdict_bits));
+    } else {
+        branch->bitmap = (1u << sa) | (1u << sb);
+        branch->children.push_back(sa < sb ? a : b);
+        branch->children.push_back(sa < sb ? b : a);
     }
-    return *this;
+    return branch;
 }
 
-template<typename T>
-void val_s::push_back(const T& val) {
-    if (t != json_array) {
-        t = json_array;
-        arr.clear();
+// Path copy of `node` with `key` set; `added` tells whether the key is new
+inline pdict_node_s::ptr_t pdict_set(const pdict_node_s::ptr_t& node, unsigned shift, uint64_t hash,
+                                     const key_s& key, val_s&& value, bool& added) {
+    if (!node) {
+        added = true;
+        return pdict_leaf(hash, key, std::move(value));
+    }
+    if (node->is_leaf()) {
+        if (node->hash != hash) {
+            added = true;
+            return pdict_merge(node, pdict_leaf(hash, key, std::move(value)), shift);
+        }
+        std::shared_ptr<pdict_node_s> leaf = std::make_shared<pdict_node_s>(*node);
+        for (auto& item : leaf->items) {
+            if (item.first == key) {
+                item.second = std::move(value);
+                added = false;
+                return leaf;
+            }
+        }
+        leaf->items.emplace_back(key, std::move(value));
+        added = true;
+        return leaf;
     }
-    auto v = std::make_shared<val_s>();
-    *v = val;
-    arr.push_back(v);
+    uint32_t bit = 1u << pdict_slot(hash, shift);
+    unsigned at = pdict_index(node->bitmap, bit);
+    std::shared_ptr<pdict_node_s> branch = std::make_shared<pdict_node_s>(*node);
+    if (node->bitmap & bit) {
+        branch->children[at] = pdict_set(node->children[at], shift + pdict_bits, hash, key,
+                                         std::move(value), added);
+    } else {
+        branch->bitmap |= bit;
+        branch->children.insert(branch->children.begin() + at, pdict_leaf(hash, key, std::move(value)));
+        added = true;
+    }
+    return branch;
 }
 
-// JSON Parser class
-class JSONParser {
-private:
-    const char* cursor;
-    const char* end;
-    
-    void skip_whitespace();
-    bool parse_value(val_s& val);
-    bool parse_object(dict_s& dict);
-    bool parse_array(val_s& val);
-    bool parse_string(std::string& str);
-    bool parse_number(val_s& val);
-    bool parse_literal(val_s& val);
+// Path copy of `node` without `key`; returns `node` itself when the key is
+// missing. A branch left with a single leaf is replaced by that leaf, so
+// every version has the same shape as one built from scratch.
+template<typename K>
+pdict_node_s::ptr_t pdict_erase(const pdict_node_s::ptr_t& node, unsigned shift, uint64_t hash,
+                                const K& key) {
+    if (!node) return node;
+    json_key_equal eq;
+    if (node->is_leaf()) {
+        if (node->hash != hash) return node;
+        for (size_t i = 0; i < node->items.size(); i++) {
+            if (!eq(node->items[i].first, key)) continue;
+            if (node->items.size() == 1) return pdict_node_s::ptr_t();
+            std::shared_ptr<pdict_node_s> leaf = std::make_shared<pdict_node_s>(*node);
+            leaf->items.erase(leaf->items.begin() + static_cast<std::ptrdiff_t>(i));
+            return leaf;
+        }
+        return node;
+    }
+    uint32_t bit = 1u << pdict_slot(hash, shift);
+    if (!(node->bitmap & bit)) return node;
+    unsigned at = pdict_index(node->bitmap, bit);
+    pdict_node_s::ptr_t child = pdict_erase(node->children[at], shift + pdict_bits, hash, key);
+    if (child == node->children[at]) return node;
     
-public:
-    JSONParser(const std::string& json);
-    bool parse(dict_s& dict);
-    bool parse(val_s& val);
-};
+    if (!child) {
+        if (node->children.size() == 1) return child;
+        if (node->children.size() == 2 && node->children[at ^ 1]->is_leaf()) {
+            return node->children[at ^ 1];
+        }
+    } else if (child->is_leaf() && node->children.size() == 1) {
+        return child;
+    }
+    std::shared_ptr<pdict_node_s> branch = std::make_shared<pdict_node_s>(*node);
+    if (child) {
+        branch->children[at] = std::move(child);
+    } else {
+        branch->bitmap &= ~bit;
+        branch->children.erase(branch->children.begin() + at);
+    }
+    return branch;
+}
 
-// ==================== val_s Implementation ====================
+inline persistent_dict_s::persistent_dict_s(const dict_s& d) : count(0) {
+    json_key_hash hasher;
+    for (auto it = d.obj->begin(); it != d.obj->end(); ++it) {
+        bool added = false;
+        val_s value(it->second);
+        root = pdict_set(root, 0, hasher(it->first), it->first, std::move(value), added);
+        count += added;
+    }
+}
+
+inline persistent_dict_s persistent_dict_s::set(const key_s& key, val_s value) const {
+    bool added = false;
+    pdict_node_s::ptr_t r = pdict_set(root, 0, json_key_hash()(key), key, std::move(value), added);
+    return persistent_dict_s(std::move(r), count + added);
+}
+
+template<typename K>
+persistent_dict_s persistent_dict_s::erase_key(const K& key, uint64_t hash) const {
+    pdict_node_s::ptr_t r = pdict_erase(root, 0, hash, key);
+    if (r == root) return *this;
+    return persistent_dict_s(std::move(r), count - 1);
+}
+
+inline persistent_dict_s persistent_dict_s::erase(str_view_s key) const {
+    return erase_key(key, json_key_hash()(key));
+}
 
-inline val_s::val_s() : t(json_null_t), intg(0), dbl(0.0), boolean(false) {}
+inline persistent_dict_s persistent_dict_s::erase(int32_t key) const {
+    return erase_key(key, json_key_hash()(key));
+}
 
-inline val_s::val_s(const val_s& other) 
-    : t(other.t), str(other.str), intg(other.intg), dbl(other.dbl), boolean(other.boolean) {
-    if (other.obj) {
-        obj = std::make_shared<dict_s>(*other.obj);
+template<typename K>
+const val_s* persistent_dict_s::find_key(const K& key, uint64_t hash) const {
+    json_key_equal eq;
+    const pdict_node_s* node = root.get();
+    unsigned shift = 0;
+    while (node && !node->is_leaf()) {
+        uint32_t bit = 1u << pdict_slot(hash, shift);
+        if (!(node->bitmap & bit)) return nullptr;
+        node = node->children[pdict_index(node->bitmap, bit)].get();
+        shift += pdict_bits;
     }
-    // Deep copy array
-    for (const auto& item : other.arr) {
-        arr.push_back(std::make_shared<val_s>(*item));
+    if (!node || node->hash != hash) return nullptr;
+    for (const auto& item : node->items) {
+        if (eq(item.first, key)) return &item.second;
     }
+    return nullptr;
 }
 
-// Move constructor - OPTIMIZATION #1: Move Semantics
-inline val_s::val_s(val_s&& other) noexcept
-    : t(other.t), obj(std::move(other.obj)), str(std::move(other.str)), 
-      intg(other.intg), dbl(other.dbl), boolean(other.boolean), arr(std::move(other.arr)) {
-    other.t = json_null_t;
+inline const val_s* persistent_dict_s::find(str_view_s key) const {
+    return find_key(key, json_key_hash()(key));
 }
 
-inline val_s::~val_s() {}
+inline const val_s* persistent_dict_s::find(int32_t key) const {
+    return find_key(key, json_key_hash()(key));
+}
 
-// Copy assignment
-inline val_s& val_s::operator=(const val_s& other) {
-    if (this != &other) {
-        t = other.t;
-        str = other.str;
-        intg = other.intg;
-        dbl = other.dbl;
-        boolean = other.boolean;
-        
-        if (other.obj) {
-            obj = std::make_shared<dict_s>(*other.obj);
-        } else {
-            obj.reset();
+inline const val_s& persistent_dict_s::operator[](str_view_s key) const {
+    const val_s* v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return *v;
+}
+
+inline const val_s& persistent_dict_s::operator[](int32_t key) const {
+    const val_s* v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return *v;
+}
+
+template<typename F>
+void pdict_for_each(const pdict_node_s* node, F& f) {
+    if (node->is_leaf()) {
+        for (const auto& item : node->items) f(item.first, item.second);
+        return;
+    }
+    for (const auto& child : node->children) pdict_for_each(child.get(), f);
+}
+
+template<typename F>
+void persistent_dict_s::for_each(F f) const {
+    if (root) pdict_for_each(root.get(), f);
+}
+
+inline dict_s persistent_dict_s::to_dict() const {
+    dict_s d;
+#ifndef JSON_ORDERED
+    d.obj->reserve(count);
+#endif
+    for_each([&d](const key_s& key, const val_s& value) {
+        d.set(key, value);
+    });
+    return d;
+}
+
+// ==================== Concurrent Dict Implementation ====================
+
+inline void dict_rw_lock_s::lock_shared() {
+    for (unsigned spins = 0;; spins++) {
+        uint32_t s = state.load(std::memory_order_relaxed);
+        if (!(s & writer) &&
+            state.compare_exchange_weak(s, s + 1, std::memory_order_acquire, std::memory_order_relaxed)) {
+            return;
         }
-        
-        arr.clear();
-        for (const auto& item : other.arr) {
-            arr.push_back(std::make_shared<val_s>(*item));
+        if (spins >= 64) std::this_thread::yield();
+    }
+}
+
+inline void dict_rw_lock_s::lock() {
+    for (unsigned spins = 0;; spins++) {
+        uint32_t s = state.load(std::memory_order_relaxed);
+        if (!(s & writer) &&
+            state.compare_exchange_weak(s, s | writer, std::memory_order_acquire, std::memory_order_relaxed)) {
+            break;
         }
+        if (spins >= 64) std::this_thread::yield();
+    }
+    // New readers now wait; let the ones inside drain
+    for (unsigned spins = 0; state.load(std::memory_order_acquire) != writer; spins++) {
+        if (spins >= 64) std::this_thread::yield();
     }
-    return *this;
 }
 
-// Move assignment - OPTIMIZATION #1: Move Semantics
-inline val_s& val_s::operator=(val_s&& other) noexcept {
-    if (this != &other) {
-        t = other.t;
-        obj = std::move(other.obj);
-        str = std::move(other.str);
-        intg = other.intg;
-        dbl = other.dbl;
-        boolean = other.boolean;
-        arr = std::move(other.arr);
-        other.t = json_null_t;
+// RAII guards for dict_rw_lock_s
+struct dict_shared_guard_s {
+    dict_rw_lock_s& lock;
+    explicit dict_shared_guard_s(dict_rw_lock_s& l) : lock(l) { lock.lock_shared(); }
+    ~dict_shared_guard_s() { lock.unlock_shared(); }
+};
+
+struct dict_unique_guard_s {
+    dict_rw_lock_s& lock;
+    explicit dict_unique_guard_s(dict_rw_lock_s& l) : lock(l) { lock.lock(); }
+    ~dict_unique_guard_s() { lock.unlock(); }
+};
+
+inline size_t dict_shard_count(size_t count) {
+    if (count == 0) {
+        count = 16 * std::max<size_t>(1, std::thread::hardware_concurrency());
     }
-    return *this;
+    size_t n = 1;
+    while (n < count) n <<= 1;
+    return n;
 }
 
-// Type-specific assignments
-inline val_s& val_s::operator=(int64_t assign) {
-    t = json_integer_t;
-    intg = assign;
-    return *this;
+inline concurrent_dict_s::concurrent_dict_s(size_t count) : shards(dict_shard_count(count)) {}
+
+// Shards take bits the shard's own table does not index by: the high half
+// of a multiplicative mix
+inline concurrent_dict_s::shard_s& concurrent_dict_s::shard_for(size_t hash) const {
+    uint64_t mixed = static_cast<uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+    size_t i = static_cast<size_t>(mixed >> 32) & (shards.size() - 1);
+    return const_cast<shard_s&>(shards[i]);
 }
 
-inline val_s& val_s::operator=(int assign) {
-    return (*this) = static_cast<int64_t>(assign);
+template<typename K>
+bool concurrent_dict_s::find_key(const K& key, val_s* out) const {
+    size_t hash = json_key_hash()(key);
+    shard_s& sh = shard_for(hash);
+    dict_shared_guard_s guard(sh.lock);
+    const dict_s::map_t& map = *sh.map.obj;
+#ifndef JSON_ORDERED
+    dict_s::map_t::const_iterator it = map.find(key, hash);
+#else
+    dict_s::map_t::const_iterator it = map.find(key_s(key));
+#endif
+    if (it == map.end()) return false;
+    if (out) *out = it->second;
+    return true;
 }
 
-inline val_s& val_s::operator=(const std::string& assign) {
-    t = json_string_t;
-    str = assign;
-    return *this;
+inline bool concurrent_dict_s::find(str_view_s key, val_s& out) const { return find_key(key, &out); }
+inline bool concurrent_dict_s::find(int32_t key, val_s& out) const { return find_key(key, &out); }
+inline bool concurrent_dict_s::contains(str_view_s key) const { return find_key(key, nullptr); }
+inline bool concurrent_dict_s::contains(int32_t key) const { return find_key(key, nullptr); }
+
+inline val_s concurrent_dict_s::get(str_view_s key) const {
+    val_s v;
+    if (!find_key(key, &v)) {
+        throw std::out_of_range("Key not found");
+    }
+    return v;
 }
 
-inline val_s& val_s::operator=(const char* assign) {
-    return (*this) = std::string(assign);
+inline val_s concurrent_dict_s::get(int32_t key) const {
+    val_s v;
+    if (!find_key(key, &v)) {
+        throw std::out_of_range("Key not found");
+    }
+    return v;
 }
 
-inline val_s& val_s::operator=(double assign) {
-    t = json_double_t;
-    dbl = assign;
-    return *this;
+// Entry for `key` in a locked shard, inserted if missing; the key is hashed
+// once for both the shard and its table
+template<typename K>
+std::pair<dict_s::map_t::iterator, bool> dict_shard_emplace(dict_s& map, const K& key, size_t hash) {
+#ifndef JSON_ORDERED
+    return map.obj->try_emplace(key, hash);
+#else
+    (void)hash;
+    return map.obj->emplace(std::piecewise_construct, std::forward_as_tuple(key), std::forward_as_tuple());
+#endif
 }
 
-inline val_s& val_s::operator=(bool assign) {
-    t = json_bool_t;
-    boolean = assign;
-    return *this;
+template<typename K>
+void concurrent_dict_s::set_key(const K& key, val_s&& value) {
+    size_t hash = json_key_hash()(key);
+    shard_s& sh = shard_for(hash);
+    dict_unique_guard_s guard(sh.lock);
+    dict_shard_emplace(sh.map, key, hash).first->second = std::move(value);
 }
 
-inline val_s& val_s::operator=(const dict_s& assign) {
-    t = json_object_t;
-    obj = std::make_shared<dict_s>(assign);
-    return *this;
+inline void concurrent_dict_s::set(str_view_s key, val_s value) { set_key(key, std::move(value)); }
+inline void concurrent_dict_s::set(int32_t key, val_s value) { set_key(key, std::move(value)); }
+
+template<typename K>
+bool concurrent_dict_s::insert_key(const K& key, val_s&& value) {
+    size_t hash = json_key_hash()(key);
+    shard_s& sh = shard_for(hash);
+    dict_unique_guard_s guard(sh.lock);
+    std::pair<dict_s::map_t::iterator, bool> r = dict_shard_emplace(sh.map, key, hash);
+    if (r.second) r.first->second = std::move(value);
+    return r.second;
 }
 
-inline val_s& val_s::operator[](const std::string& key) {
-    return (*obj)[key];
+inline bool concurrent_dict_s::insert(str_view_s key, val_s value) { return insert_key(key, std::move(value)); }
+inline bool concurrent_dict_s::insert(int32_t key, val_s value) { return insert_key(key, std::move(value)); }
+
+template<typename K>
+bool concurrent_dict_s::erase_key(const K& key) {
+    shard_s& sh = shard_for(json_key_hash()(key));
+    dict_unique_guard_s guard(sh.lock);
+#ifndef JSON_ORDERED
+    return sh.map.obj->erase(key) != 0;
+#else
+    return sh.map.obj->erase(key_s(key)) != 0;
+#endif
 }
 
-inline val_s& val_s::operator[](int32_t i) {
-    return (*obj)[i];
+inline bool concurrent_dict_s::erase(str_view_s key) { return erase_key(key); }
+inline bool concurrent_dict_s::erase(int32_t key) { return erase_key(key); }
+
+template<typename K, typename F>
+void concurrent_dict_s::update_key(const K& key, F& f) {
+    size_t hash = json_key_hash()(key);
+    shard_s& sh = shard_for(hash);
+    dict_unique_guard_s guard(sh.lock);
+    f(dict_shard_emplace(sh.map, key, hash).first->second);
 }
 
-inline val_s& val_s::operator[](size_t i) {
-    if (t != json_array || i >= arr.size()) {
-        throw std::out_of_range("Array index out of range");
+template<typename F>
+void concurrent_dict_s::update(str_view_s key, F f) { update_key(key, f); }
+
+template<typename F>
+void concurrent_dict_s::update(int32_t key, F f) { update_key(key, f); }
+
+inline size_t concurrent_dict_s::size() const {
+    size_t n = 0;
+    for (const shard_s& sh : shards) {
+        dict_shared_guard_s guard(sh.lock);
+        n += sh.map.obj->size();
     }
-    return *arr[i];
+    return n;
 }
 
-// OPTIMIZATION #2: Generic Arrays - Array access methods
-inline val_s& val_s::at(size_t index) {
-    if (t != json_array || index >= arr.size()) {
-        throw std::out_of_range("Array index out of range");
+template<typename F>
+void concurrent_dict_s::for_each(F f) const {
+    for (const shard_s& sh : shards) {
+        dict_shared_guard_s guard(sh.lock);
+        for (auto it = sh.map.obj->begin(); it != sh.map.obj->end(); ++it) {
+            f(it->first, it->second);
+        }
     }
-    return *arr[index];
 }
 
-inline const val_s& val_s::at(size_t index) const {
-    if (t != json_array || index >= arr.size()) {
-        throw std::out_of_range("Array index out of range");
+inline dict_s concurrent_dict_s::to_dict() const {
+    dict_s d;
+    for_each([&d](const key_s& key, const val_s& value) {
+        d.set(key, value);
+    });
+    return d;
+}
+
+// ==================== Snapshot Holder Implementation ====================
+
+// Epochs start at 1; slot epoch 0 means idle
+inline snapshot_holder_s::snapshot_holder_s(dict_s initial)
+    : current(new snapshot_version_s(std::move(initial), 1)), epoch(1), latest(1), slots(nullptr),
+      retired(nullptr), retired_size(0), next_number(2) {}
+
+inline snapshot_holder_s::~snapshot_holder_s() {
+    delete current.load();
+    while (retired) {
+        snapshot_version_s* next = retired->next;
+        delete retired;
+        retired = next;
+    }
+    snapshot_slot_s* s = slots.load();
+    while (s) {
+        snapshot_slot_s* next = s->next;
+        delete s;
+        s = next;
     }
-    return *arr[index];
 }
 
-inline size_t val_s::size() const {
-    if (t == json_array) {
-        return arr.size();
+// Reuses a slot given up by a destroyed reader, or pushes a new one. Slots
+// are never unlinked, so reclaim() can walk the list without locking.
+inline snapshot_slot_s* snapshot_holder_s::acquire_slot() {
+    for (snapshot_slot_s* s = slots.load(std::memory_order_acquire); s; s = s->next) {
+        bool expected = false;
+        if (!s->owned.load(std::memory_order_relaxed) &&
+            s->owned.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            return s;
+        }
     }
-    return 0;
+    snapshot_slot_s* s = new snapshot_slot_s();
+    snapshot_slot_s* head = slots.load(std::memory_order_relaxed);
+    do {
+        s->next = head;
+    } while (!slots.compare_exchange_weak(head, s, std::memory_order_release, std::memory_order_relaxed));
+    return s;
 }
 
-inline void val_s::push_back(const val_s& val) {
-    if (t != json_array) {
-        t = json_array;
-        arr.clear();
+// The order of the swap, the epoch bump and the slot scan is what makes
+// reclamation safe; all three and the readers' pin steps are seq_cst. A
+// reader that loaded the old version published its slot epoch before the
+// swap, so the scan sees an epoch older than `retired_at`.
+inline uint64_t snapshot_holder_s::publish(dict_s doc) {
+    std::unique_ptr<snapshot_version_s> fresh(new snapshot_version_s(std::move(doc), 0));
+    std::lock_guard<std::mutex> guard(writer);
+    fresh->number = next_number++;
+    uint64_t number = fresh->number;
+    snapshot_version_s* old = current.exchange(fresh.release());
+    latest.store(number, std::memory_order_release);
+    old->retired_at = epoch.fetch_add(1) + 1;
+    old->next = retired;
+    retired = old;
+    retired_size++;
+    reclaim_locked();
+    return number;
+}
+
+inline uint64_t snapshot_holder_s::publish_json(const std::string& json) {
+    dict_s doc;
+    if (!doc.parse(json)) return 0;
+    return publish(std::move(doc));
+}
+
+inline size_t snapshot_holder_s::reclaim() {
+    std::lock_guard<std::mutex> guard(writer);
+    return reclaim_locked();
+}
+
+inline size_t snapshot_holder_s::retired_count() const {
+    std::lock_guard<std::mutex> guard(writer);
+    return retired_size;
+}
+
+// Every version retired at or after the oldest pinned epoch may still be
+// in use; the rest are freed
+inline size_t snapshot_holder_s::reclaim_locked() {
+    uint64_t oldest = UINT64_MAX;
+    for (snapshot_slot_s* s = slots.load(); s; s = s->next) {
+        uint64_t e = s->epoch.load();
+        if (e != 0 && e < oldest) oldest = e;
+    }
+    snapshot_version_s** link = &retired;
+    while (*link) {
+        snapshot_version_s* v = *link;
+        if (v->retired_at <= oldest) {
+            *link = v->next;
+            delete v;
+            retired_size--;
+        } else {
+            link = &v->next;
+        }
     }
-    arr.push_back(std::make_shared<val_s>(val));
+    return retired_size;
 }
 
-// ==================== dict_s Implementation ====================
+inline snapshot_pin_s snapshot_reader_s::pin() {
+    if (depth++ == 0) {
+        slot->epoch.store(holder.epoch.load());
+    }
+    return snapshot_pin_s(this, holder.current.load());
+}
 
-inline dict_s::dict_s() : obj(std::make_shared<map_t>()), valid(true) {}
+inline void snapshot_reader_s::unpin() {
+    if (--depth == 0) {
+        slot->epoch.store(0, std::memory_order_release);
+    }
+}
 
-// OPTIMIZATION #4: JSON Parsing Constructor
-inline dict_s::dict_s(const std::string& json_str) : obj(std::make_shared<map_t>()), valid(false) {
-    valid = parse(json_str);
+inline snapshot_pin_s::~snapshot_pin_s() {
+    if (reader) reader->unpin();
 }
 
-// Copy constructor
-inline dict_s::dict_s(const dict_s& other) : valid(other.valid) {
-    obj = std::make_shared<map_t>();
-    if (other.obj) {
-        for (const auto& pair : *other.obj) {
-            key_s new_key = pair.first;
-            val_s new_val = pair.second;  // Uses copy constructor
-            (*obj)[new_key] = new_val;
+// ==================== Frozen Dict Implementation ====================
+//
+// Buffer layout, in 64-bit words. A value slot is two words: the type in
+// byte 0, the array layout in byte 1 and a size (string bytes, members or
+// elements) in the upper half of the first; the scalar, or the offset of the
+// characters, elements or object block, in the second. An object block is
+// the bucket count r (with the spill count in its upper half), r 32-bit
+// displacements packed two per word, then one 4-word entry per member: a
+// 16-byte key and the value slot. Members whose key hash equals another
+// member's spill: they follow the table's entries and are searched in turn
+// on a miss. Characters and bool elements are addressed by byte offset,
+// everything else by word offset.
+//
+// Entry keys are laid out like key_s, so a probe is one 16-byte compare:
+// string keys of up to 15 bytes in place with the length in the last byte;
+// longer ones as byte offset and 32-bit length, and integer keys as the
+// int32, each marked by a tag in the last byte. The characters of an
+// object's long keys follow its entries.
+
+static const unsigned char dict_frozen_long_key = 0xFF;
+static const unsigned char dict_frozen_int_key = 0xFE;
+
+inline void dict_frozen_short_key(str_view_s s, char* out) {
+    std::memset(out, 0, 16);
+    if (s.size) std::memcpy(out, s.data, s.size);
+    out[15] = static_cast<char>(s.size);
+}
+
+inline void dict_frozen_int_key_bytes(int32_t i, char* out) {
+    std::memset(out, 0, 16);
+    std::memcpy(out, &i, sizeof(i));
+    out[15] = static_cast<char>(dict_frozen_int_key);
+}
+
+inline uint32_t dict_frozen_bucket(uint64_t hash, uint32_t r) {
+    return static_cast<uint32_t>(((hash >> 32) * r) >> 32);
+}
+
+inline uint32_t dict_frozen_position(uint64_t hash, uint32_t disp, uint32_t n) {
+    uint64_t x = (hash ^ disp) * 0xbf58476d1ce4e5b9ULL;
+    return static_cast<uint32_t>(((x >> 32) * n) >> 32);
+}
+
+inline uint64_t dict_frozen_size(size_t n) {
+    if (n >= 0xFFFFFFFFULL) {
+        throw std::length_error("Value too large to freeze");
+    }
+    return n;
+}
+
+// Hash and displace: buckets are placed largest first, each with the first
+// displacement that sends all of its members to free positions. false if
+// some bucket found none within the limit; the caller retries with more,
+// smaller buckets. owner[p] is the member placed at position p.
+inline bool dict_frozen_place(const std::vector<uint64_t>& hashes, uint32_t r,
+                              std::vector<uint32_t>& disp, std::vector<uint32_t>& owner) {
+    const uint32_t none = 0xFFFFFFFFU;
+    uint32_t n = static_cast<uint32_t>(hashes.size());
+    std::vector<uint32_t> start(r + 1, 0);
+    for (uint32_t i = 0; i < n; i++) start[dict_frozen_bucket(hashes[i], r) + 1]++;
+    for (uint32_t b = 0; b < r; b++) start[b + 1] += start[b];
+    std::vector<uint32_t> grouped(n);
+    std::vector<uint32_t> fill(start.begin(), start.end() - 1);
+    for (uint32_t i = 0; i < n; i++) grouped[fill[dict_frozen_bucket(hashes[i], r)]++] = i;
+    std::vector<uint32_t> order(r);
+    for (uint32_t b = 0; b < r; b++) order[b] = b;
+    std::stable_sort(order.begin(), order.end(), [&start](uint32_t a, uint32_t b) {
+        return start[a + 1] - start[a] > start[b + 1] - start[b];
+    });
+    
+    disp.assign(r, 0);
+    owner.assign(n, none);
+    uint64_t limit = std::min<uint64_t>(1024 + 32 * static_cast<uint64_t>(n), none);
+    for (uint32_t b : order) {
+        uint32_t first = start[b], last = start[b + 1];
+        if (first == last) break;
+        uint32_t d = 0;
+        for (;; d++) {
+            if (d == limit) return false;
+            uint32_t i = first;
+            for (; i < last; i++) {
+                uint32_t p = dict_frozen_position(hashes[grouped[i]], d, n);
+                if (owner[p] != none) break;
+                owner[p] = grouped[i];
+            }
+            if (i == last) break;
+            while (i-- > first) owner[dict_frozen_position(hashes[grouped[i]], d, n)] = none;
         }
+        disp[b] = d;
     }
+    return true;
 }
 
-// Move constructor - OPTIMIZATION #1: Move Semantics
-inline dict_s::dict_s(dict_s&& other) noexcept 
-    : obj(std::move(other.obj)), valid(other.valid) {
-    other.valid = false;
+template<typename Hash>
+inline frozen_dict_hashed_s<Hash>::frozen_dict_hashed_s() : words(2, 0) {
+    words[0] = json_object_t;            // Empty root object
 }
 
-inline dict_s::~dict_s() {}
+template<typename Hash>
+inline frozen_dict_hashed_s<Hash>::frozen_dict_hashed_s(const dict_s& d) : words(2, 0) {
+    freeze_object(d, 0);
+}
 
-// Copy assignment
-inline dict_s& dict_s::operator=(const dict_s& other) {
-    if (this != &other) {
-        valid = other.valid;
-        obj = std::make_shared<map_t>();
-        if (other.obj) {
-            for (const auto& pair : *other.obj) {
-                (*obj)[pair.first] = pair.second;
+inline frozen_dict_s dict_s::freeze() const {
+    return frozen_dict_s(*this);
+}
+
+template<typename Hash>
+inline uint64_t frozen_dict_hashed_s<Hash>::append_bytes(str_view_s s) {
+    size_t at = words.size();
+    words.resize(at + (s.size + 7) / 8, 0);
+    if (s.size) std::memcpy(&words[at], s.data, s.size);
+    return static_cast<uint64_t>(at) * sizeof(uint64_t);
+}
+
+// Writes the slot at word `slot` last: appending may move the buffer
+template<typename Hash>
+inline void frozen_dict_hashed_s<Hash>::freeze_value(const val_s& v, size_t slot) {
+    uint64_t head = static_cast<uint64_t>(v.t);
+    uint64_t payload = 0;
+    switch (v.t) {
+        case json_bool_t:
+            payload = v.boolean ? 1 : 0;
+            break;
+        case json_integer_t:
+            payload = static_cast<uint64_t>(v.intg);
+            break;
+        case json_double_t:
+            std::memcpy(&payload, &v.dbl, sizeof(payload));
+            break;
+        case json_string_t: {
+            str_view_s s = v.str_view();
+            head |= dict_frozen_size(s.size) << 32;
+            payload = append_bytes(s);
+            break;
+        }
+        case json_object_t:
+            if (v.obj) {
+                freeze_object(*v.obj, slot);
+                return;
+            }
+            break;
+        case json_array: {
+            size_t n = v.size();
+            head |= static_cast<uint64_t>(v.layout) << 8 | dict_frozen_size(n) << 32;
+            payload = words.size();
+            switch (v.layout) {
+                case json_array_int:
+                    words.insert(words.end(), v.arr_intg.begin(), v.arr_intg.end());
+                    break;
+                case json_array_double:
+                    words.resize(payload + n);
+                    if (n) std::memcpy(&words[payload], v.arr_dbl.data(), n * sizeof(double));
+                    break;
+                case json_array_bool:
+                    payload = append_bytes(str_view_s(reinterpret_cast<const char*>(v.arr_bool.data()), n));
+                    break;
+                default:
+                    words.resize(payload + 2 * n, 0);
+                    for (size_t i = 0; i < n; i++) freeze_value(v.arr[i], payload + 2 * i);
+                    break;
             }
+            break;
         }
+        default:
+            break;
     }
-    return *this;
+    words[slot] = head;
+    words[slot + 1] = payload;
 }
 
-// Move assignment - OPTIMIZATION #1: Move Semantics  
-inline dict_s& dict_s::operator=(dict_s&& other) noexcept {
-    if (this != &other) {
-        obj = std::move(other.obj);
-        valid = other.valid;
-        other.valid = false;
+template<typename Hash>
+inline void frozen_dict_hashed_s<Hash>::freeze_object(const dict_s& d, size_t slot) {
+    std::vector<const std::pair<const key_s, val_s>*> members;
+    if (d.obj) {
+        members.reserve(d.obj->size());
+        for (const auto& kv : *d.obj) members.push_back(&kv);
     }
-    return *this;
+    uint32_t n = static_cast<uint32_t>(dict_frozen_size(members.size()));
+    if (n == 0) {
+        words[slot] = json_object_t;
+        words[slot + 1] = 0;
+        return;
+    }
+    
+    std::vector<uint64_t> hashes(n);
+    for (uint32_t i = 0; i < n; i++) hashes[i] = Hash()(members[i]->first);
+    std::vector<uint32_t> by_hash(n);
+    for (uint32_t i = 0; i < n; i++) by_hash[i] = i;
+    std::sort(by_hash.begin(), by_hash.end(), [&hashes](uint32_t a, uint32_t b) {
+        return hashes[a] < hashes[b] || (hashes[a] == hashes[b] && a < b);
+    });
+    std::vector<uint32_t> placed, spilled;
+    std::vector<uint64_t> placed_hashes;
+    placed.reserve(n);
+    placed_hashes.reserve(n);
+    for (uint32_t k = 0; k < n; k++) {
+        uint32_t i = by_hash[k];
+        if (k > 0 && hashes[i] == hashes[by_hash[k - 1]]) {
+            spilled.push_back(i);
+        } else {
+            placed.push_back(i);
+            placed_hashes.push_back(hashes[i]);
+        }
+    }
+    uint32_t table = static_cast<uint32_t>(placed.size());
+    std::vector<uint32_t> disp, owner;
+    uint32_t r = table / 2 + 1;
+    while (!dict_frozen_place(placed_hashes, r, disp, owner)) {
+        if (r > 0x7FFFFFFFU) {
+            throw std::runtime_error("No perfect hash found, cannot freeze");
+        }
+        r *= 2;
+    }
+    std::vector<uint32_t> order(n);
+    for (uint32_t p = 0; p < table; p++) order[p] = placed[owner[p]];
+    std::copy(spilled.begin(), spilled.end(), order.begin() + table);
+    
+    size_t block = words.size();
+    size_t entries = block + 1 + (r + 1) / 2;
+    words.resize(entries + 4 * static_cast<size_t>(n), 0);
+    words[block] = r | static_cast<uint64_t>(n - table) << 32;
+    for (uint32_t b = 0; b < r; b++) words[block + 1 + b / 2] |= static_cast<uint64_t>(disp[b]) << (b % 2 * 32);
+    for (uint32_t p = 0; p < n; p++) {
+        const key_s& k = members[order[p]]->first;
+        char key[16];
+        if (k.t == json_k_integer_t) {
+            dict_frozen_int_key_bytes(k.intg, key);
+        } else if (k.str().size < 16) {
+            dict_frozen_short_key(k.str(), key);
+        } else {
+            str_view_s s = k.str();
+            uint64_t offset = append_bytes(s);
+            uint32_t size = static_cast<uint32_t>(s.size);
+            std::memset(key, 0, sizeof(key));
+            std::memcpy(key, &offset, sizeof(offset));
+            std::memcpy(key + 8, &size, sizeof(size));
+            key[15] = static_cast<char>(dict_frozen_long_key);
+        }
+        std::memcpy(&words[entries + 4 * static_cast<size_t>(p)], key, sizeof(key));
+    }
+    for (uint32_t p = 0; p < n; p++) {
+        freeze_value(members[order[p]]->second, entries + 4 * static_cast<size_t>(p) + 2);
+    }
+    words[slot] = static_cast<uint64_t>(json_object_t) | static_cast<uint64_t>(n) << 32;
+    words[slot + 1] = block;
+}
+
+template<typename Hash>
+inline json_value_types frozen_val_hashed_s<Hash>::type() const {
+    if (!words) return json_null_t;
+    json_value_types t = static_cast<json_value_types>(words[slot] & 0xFF);
+    if (index == npos) return t;
+    switch (static_cast<json_array_layouts>((words[slot] >> 8) & 0xFF)) {
+        case json_array_int: return json_integer_t;
+        case json_array_double: return json_double_t;
+        default: return json_bool_t;
+    }
+}
+
+template<typename Hash>
+inline json_array_layouts frozen_val_hashed_s<Hash>::layout() const {
+    if (!is_array()) return json_array_generic;
+    return static_cast<json_array_layouts>((words[slot] >> 8) & 0xFF);
+}
+
+// `probe` is the entry key to match, or nullptr for a long string key
+// compared through its characters
+template<typename Hash>
+inline bool frozen_val_hashed_s<Hash>::entry_matches(size_t e, const char* probe, str_view_s long_key) const {
+    const char* stored = reinterpret_cast<const char*>(words + e);
+    if (probe) return std::memcmp(stored, probe, 16) == 0;
+    uint64_t offset;
+    uint32_t size;
+    std::memcpy(&offset, stored, sizeof(offset));
+    std::memcpy(&size, stored + 8, sizeof(size));
+    return static_cast<unsigned char>(stored[15]) == dict_frozen_long_key && size == long_key.size &&
+           std::memcmp(bytes(offset), long_key.data, size) == 0;
+}
+
+// The bucket's displacement gives the only position in the table the key
+// can be at, so a lookup is one key comparison, plus one per spilled member
+// on a miss.
+template<typename Hash>
+inline frozen_val_hashed_s<Hash> frozen_val_hashed_s<Hash>::member(uint64_t hash, const char* probe, str_view_s long_key) const {
+    if (!is_object()) return frozen_val_hashed_s<Hash>();
+    uint32_t n = static_cast<uint32_t>(words[slot] >> 32);
+    if (n == 0) return frozen_val_hashed_s<Hash>();
+    size_t block = static_cast<size_t>(words[slot + 1]);
+    uint32_t r = static_cast<uint32_t>(words[block]);
+    uint32_t table = n - static_cast<uint32_t>(words[block] >> 32);
+    size_t entries = block + 1 + (r + 1) / 2;
+    uint32_t b = dict_frozen_bucket(hash, r);
+    uint32_t d = static_cast<uint32_t>(words[block + 1 + b / 2] >> (b % 2 * 32));
+    size_t e = entries + 4 * static_cast<size_t>(dict_frozen_position(hash, d, table));
+    if (entry_matches(e, probe, long_key)) return frozen_val_hashed_s<Hash>(words, e + 2, npos);
+    for (uint32_t p = table; p < n; p++) {
+        e = entries + 4 * static_cast<size_t>(p);
+        if (entry_matches(e, probe, long_key)) return frozen_val_hashed_s<Hash>(words, e + 2, npos);
+    }
+    return frozen_val_hashed_s<Hash>();
+}
+
+template<typename Hash>
+inline frozen_val_hashed_s<Hash> frozen_val_hashed_s<Hash>::find(str_view_s key) const {
+    uint64_t hash = Hash()(key);
+    if (key.size >= 16) return member(hash, nullptr, key);
+    char probe[16];
+    dict_frozen_short_key(key, probe);
+    return member(hash, probe, key);
 }
 
-inline val_s& dict_s::operator[](const std::string& s) {
-    key_s key;
-    key.t = json_k_string_t;
-    key.intg = 0;
-    key.str = s;
-    return (*obj)[key];
+template<typename Hash>
+inline frozen_val_hashed_s<Hash> frozen_val_hashed_s<Hash>::find(int32_t key) const {
+    char probe[16];
+    dict_frozen_int_key_bytes(key, probe);
+    return member(Hash()(key), probe, str_view_s(nullptr, 0));
 }
 
-inline val_s& dict_s::operator[](int32_t i) {
-    key_s key;
-    key.t = json_k_integer_t;
-    key.intg = i;
-    key.str = "";
-    return (*obj)[key];
+template<typename Hash>
+inline frozen_val_hashed_s<Hash> frozen_val_hashed_s<Hash>::operator[](str_view_s key) const {
+    frozen_val_hashed_s<Hash> v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return v;
 }
 
-// OPTIMIZATION #3: Optimized Serialization with String Buffer
-inline std::string dict_s::dump(int indent) const {
-    std::ostringstream oss;
-    oss.str().reserve(1024);  // Pre-allocate reasonable buffer
-    dump_internal(oss, indent, 0);
-    return oss.str();
+template<typename Hash>
+inline frozen_val_hashed_s<Hash> frozen_val_hashed_s<Hash>::operator[](int32_t key) const {
+    frozen_val_hashed_s<Hash> v = find(key);
+    if (!v) {
+        throw std::out_of_range("Key not found");
+    }
+    return v;
 }
 
-inline void dict_s::dump_internal(std::ostringstream& oss, int indent, int current_level) const {
-    oss << '{';
-    bool first = true;
-    
-    for (auto it = obj->begin(); it != obj->end(); ++it) {
-        if (!first) oss << ',';
-        first = false;
-        
-        if (indent >= 0) {
-            oss << '\n' << std::string((current_level + 1) * indent, ' ');
-        }
-        
-        // Write key
-        if (it->first.t == json_k_string_t) {
-            oss << '"' << it->first.str << '"';
-        } else {
-            oss << it->first.intg;
-        }
-        oss << ':';
-        if (indent >= 0) oss << ' ';
-        
-        // Write value
-        const val_s& val = it->second;
-        switch (val.t) {
-            case json_null_t:
-                oss << "null";
-                break;
-            case json_bool_t:
-                oss << (val.boolean ? "true" : "false");
-                break;
-            case json_integer_t:
-                oss << val.intg;
-                break;
-            case json_double_t:
-                oss << val.dbl;
-                break;
-            case json_string_t:
-                oss << '"' << val.str << '"';
-                break;
-            case json_array:
-                oss << '[';
-                for (size_t i = 0; i < val.arr.size(); ++i) {
-                    if (i > 0) oss << ',';
-                    const val_s& item = *val.arr[i];
-                    if (item.t == json_string_t) {
-                        oss << '"' << item.str << '"';
-                    } else if (item.t == json_integer_t) {
-                        oss << item.intg;
-                    } else if (item.t == json_double_t) {
-                        oss << item.dbl;
-                    } else if (item.t == json_bool_t) {
-                        oss << (item.boolean ? "true" : "false");
-                    } else if (item.t == json_null_t) {
-                        oss << "null";
-                    } else if (item.t == json_object_t && item.obj) {
-                        item.obj->dump_internal(oss, indent, current_level + 1);
-                    }
-                }
-                oss << ']';
-                break;
-            case json_object_t:
-                if (val.obj) {
-                    val.obj->dump_internal(oss, indent, current_level + 1);
-                } else {
-                    oss << "{}";
-                }
-                break;
-        }
+template<typename Hash>
+inline frozen_val_hashed_s<Hash> frozen_val_hashed_s<Hash>::at(size_t i) const {
+    if (!is_array()) {
+        throw std::out_of_range("Value is not an array");
     }
-    
-    if (indent >= 0 && !first) {
-        oss << '\n' << std::string(current_level * indent, ' ');
+    if (i >= size()) {
+        throw std::out_of_range("Array index out of range");
     }
-    oss << '}';
+    if (layout() != json_array_generic) return frozen_val_hashed_s<Hash>(words, slot, i);
+    return frozen_val_hashed_s<Hash>(words, static_cast<size_t>(words[slot + 1]) + 2 * i, npos);
 }
 
-// OPTIMIZATION #4: JSON Parsing
-inline bool dict_s::parse(const std::string& json_str) {
-    JSONParser parser(json_str);
-    return parser.parse(*this);
+template<typename Hash>
+inline size_t frozen_val_hashed_s<Hash>::size() const {
+    if (!is_object() && !is_array()) return 0;
+    return static_cast<size_t>(words[slot] >> 32);
 }
 
-// ==================== Comparison Operators ====================
-
-#ifndef JSON_ORDERED
-inline bool operator==(const key_s& first, const key_s& second) {
-    return (first.t == second.t &&
-            first.intg == second.intg &&
-            first.str == second.str);
+template<typename Hash>
+inline int64_t frozen_val_hashed_s<Hash>::intg() const {
+    if (type() != json_integer_t) {
+        throw std::domain_error("Value is not an integer");
+    }
+    if (index == npos) return static_cast<int64_t>(words[slot + 1]);
+    return static_cast<int64_t>(words[words[slot + 1] + index]);
 }
 
-inline std::size_t json_key_hash::operator()(const key_s& k) const {
-    using std::size_t;
-    using std::hash;
-    using std::string;
-    
-    return ((hash<int>()(k.t)
-         ^ (hash<string>()(k.str) << 1)) >> 1)
-         ^ (hash<int>()(k.intg) << 1);
-}
-#else
-inline bool operator<(const key_s& first, const key_s& second) {
-    if (first.t < second.t) return true;
-    if (first.t > second.t) return false;
-    if (first.t == json_k_integer_t) {
-        return first.intg < second.intg;
-    }
-    if (first.t == json_k_string_t) {
-        return first.str < second.str;
+template<typename Hash>
+inline double frozen_val_hashed_s<Hash>::dbl() const {
+    json_value_types t = type();
+    if (t == json_integer_t) return static_cast<double>(intg());
+    if (t != json_double_t) {
+        throw std::domain_error("Value is not a number");
     }
-    return false;
+    uint64_t bits = index == npos ? words[slot + 1] : words[words[slot + 1] + index];
+    double d;
+    std::memcpy(&d, &bits, sizeof(d));
+    return d;
 }
-#endif
 
-// ==================== Stream Operators (Backward Compatibility) ====================
+template<typename Hash>
+inline bool frozen_val_hashed_s<Hash>::boolean() const {
+    if (type() != json_bool_t) {
+        throw std::domain_error("Value is not a bool");
+    }
+    if (index == npos) return words[slot + 1] != 0;
+    return bytes(words[slot + 1])[index] != 0;
+}
 
-inline std::ostream& operator<<(std::ostream& os, const dict_t& dict) {
-    os << dict.dump(-1);  // No indentation for backward compatibility
-    return os;
+template<typename Hash>
+inline str_view_s frozen_val_hashed_s<Hash>::str_view() const {
+    if (type() != json_string_t) {
+        throw std::domain_error("Value is not a string");
+    }
+    return str_view_s(bytes(words[slot + 1]), static_cast<size_t>(words[slot] >> 32));
 }
 
-inline std::ostream& operator<<(std::ostream& os, const val_t& val) {
-    switch (val.t) {
-        case json_null_t:
-            os << "null";
-            break;
+template<typename Hash>
+inline val_s frozen_val_hashed_s<Hash>::to_val() const {
+    val_s v;
+    size_t n = size();
+    switch (type()) {
         case json_bool_t:
-            os << (val.boolean ? "true" : "false");
+            v = boolean();
             break;
         case json_integer_t:
-            os << val.intg;
+            v = intg();
             break;
         case json_double_t:
-            os << val.dbl;
-            break;
-        case json_string_t:
-            os << '"' << val.str << '"';
+            v = dbl();
             break;
-        case json_array:
-            os << '[';
-            for (size_t i = 0; i < val.arr.size(); ++i) {
-                if (i > 0) os << ',';
-                os << *val.arr[i];
-            }
-            os << ']';
+        case json_string_t: {
+            str_view_s s = str_view();
+            v.set_type(json_string_t);
+            v.str.assign(s.data, s.size);
             break;
+        }
         case json_object_t:
-            if (val.obj) {
-                os << *val.obj;
+            v.set_type(json_object_t);
+            v.obj = std::make_shared<dict_s>(to_dict());
+            break;
+        case json_array:
+            if (layout() == json_array_int) {
+                const uint64_t* p = words + words[slot + 1];
+                v = std::vector<int64_t>(p, p + n);
+            } else if (layout() == json_array_double) {
+                std::vector<double> items(n);
+                if (n) std::memcpy(items.data(), words + words[slot + 1], n * sizeof(double));
+                v = items;
+            } else if (layout() == json_array_bool) {
+                const char* p = bytes(words[slot + 1]);
+                v = std::vector<bool>(p, p + n);
             } else {
-                os << "{}";
+                v.set_type(json_array);
+                v.arr.reserve(n);
+                for (size_t i = 0; i < n; i++) v.arr.push_back(at(i).to_val());
             }
             break;
+        default:
+            break;
     }
-    return os;
+    return v;
 }
 
-inline std::ostream& operator<<(std::ostream& os, const dict_key_t& k) {
-    if (k.t == json_k_string_t) {
-        os << '"' << k.str << '"';
-    } else {
-        os << k.intg;
+template<typename Hash>
+inline dict_s frozen_val_hashed_s<Hash>::to_dict() const {
+    if (!is_object()) {
+        throw std::domain_error("Value is not an object");
     }
-    return os;
-}
-
-// ==================== JSON Parser Implementation ====================
-
-inline JSONParser::JSONParser(const std::string& json) 
-    : cursor(json.c_str()), end(json.c_str() + json.size()) {}
-
-inline void JSONParser::skip_whitespace() {
-    while (cursor < end && std::isspace(*cursor)) {
-        cursor++;
+    dict_s d;
+    size_t n = size();
+    if (n == 0) return d;
+    size_t block = static_cast<size_t>(words[slot + 1]);
+    uint32_t r = static_cast<uint32_t>(words[block]);
+    size_t entries = block + 1 + (static_cast<size_t>(r) + 1) / 2;
+    for (size_t i = 0; i < n; i++) {
+        size_t e = entries + 4 * i;
+        const char* k = reinterpret_cast<const char*>(words + e);
+        frozen_val_hashed_s<Hash> v(words, e + 2, npos);
+        unsigned char tag = static_cast<unsigned char>(k[15]);
+        if (tag == dict_frozen_int_key) {
+            int32_t key;
+            std::memcpy(&key, k, sizeof(key));
+            d.set(key, v.to_val());
+        } else if (tag == dict_frozen_long_key) {
+            uint64_t offset;
+            uint32_t size;
+            std::memcpy(&offset, k, sizeof(offset));
+            std::memcpy(&size, k + 8, sizeof(size));
+            d.set(str_view_s(bytes(offset), size), v.to_val());
+        } else {
+            d.set(str_view_s(k, tag), v.to_val());
+        }
     }
+    return d;
 }
 
-inline bool JSONParser::parse(dict_s& dict) {
-    skip_whitespace();
-    return parse_object(dict);
-}
+// ==================== Struct Mapping Implementation ====================
 
-inline bool JSONParser::parse(val_s& val) {
-    skip_whitespace();
-    return parse_value(val);
+// Validates and steps over the value at p without building anything, with
+// the parser's grammar (integer keys included). Returns the position after
+// the value, or nullptr.
+inline const char* json_skip_value(const char* p, const char* end) {
+    if (p >= end) return nullptr;
+    if (*p == '{' || *p == '[') {
+        bool is_object = *p == '{';
+        char close = is_object ? '}' : ']';
+        p = json_skip_space(p + 1, end);
+        if (p < end && *p == close) return p + 1;
+        while (true) {
+            if (is_object) {
+                if (p >= end) return nullptr;
+                if (*p == '"') {
+                    p = json_skip_string(p, end);
+                } else {
+                    json_number_s num;
+                    p = json_parse_number(p, end, num);
+                    if (p && (!num.is_int || num.intg < INT32_MIN || num.intg > INT32_MAX)) return nullptr;
+                }
+                if (!p) return nullptr;
+                p = json_skip_space(p, end);
+                if (p >= end || *p != ':') return nullptr;
+                p = json_skip_space(p + 1, end);
+            }
+            p = json_skip_value(p, end);
+            if (!p) return nullptr;
+            p = json_skip_space(p, end);
+            if (p >= end) return nullptr;
+            if (*p == close) return p + 1;
+            if (*p != ',') return nullptr;
+            p = json_skip_space(p + 1, end);
+        }
+    } else if (*p == '"') {
+        return json_skip_string(p, end);
+    } else if (*p == 't') {
+        return end - p >= 4 && std::memcmp(p, "true", 4) == 0 ? p + 4 : nullptr;
+    } else if (*p == 'f') {
+        return end - p >= 5 && std::memcmp(p, "false", 5) == 0 ? p + 5 : nullptr;
+    } else if (*p == 'n') {
+        return end - p >= 4 && std::memcmp(p, "null", 4) == 0 ? p + 4 : nullptr;
+    }
+    return json_skip_number(p, end);
 }
 
-inline bool JSONParser::parse_value(val_s& val) {
-    skip_whitespace();
-    if (cursor >= end) return false;
+// Visitor handed to dict_visit_fields(): parses the member value into the
+// field named `key`, if there is one
+struct JSONParser::field_matcher_s {
+    JSONParser* parser;
+    str_view_s key;
+    bool found;
+    bool ok;
     
-    if (*cursor == '{') {
-        val.t = json_object_t;
-        val.obj = std::make_shared<dict_s>();
-        return parse_object(*val.obj);
-    } else if (*cursor == '[') {
-        return parse_array(val);
-    } else if (*cursor == '"') {
-        val.t = json_string_t;
-        return parse_string(val.str);
-    } else if (*cursor == 't' || *cursor == 'f' || *cursor == 'n') {
-        return parse_literal(val);
-    } else if (*cursor == '-' || std::isdigit(*cursor)) {
-        return parse_number(val);
+    template<typename F>
+    void operator()(str_view_s name, F& field) {
+        if (!found && name == key) {
+            found = true;
+            ok = parser->parse_field(field);
+        }
     }
-    
-    return false;
-}
+};
 
-inline bool JSONParser::parse_object(dict_s& dict) {
+template<typename T>
+inline bool JSONParser::parse_struct(T& out) {
     skip_whitespace();
     if (cursor >= end || *cursor != '{') return false;
-    cursor++; // Skip '{'
-    
-    skip_whitespace();
+    cursor = json_skip_space(cursor + 1, end);
     if (cursor < end && *cursor == '}') {
         cursor++;
-        return true; // Empty object
+        return true;
     }
     
     while (cursor < end) {
-        skip_whitespace();
-        
-        // Parse key
-        std::string key_str;
-        int key_int = 0;
-        bool is_string_key = true;
-        
+        // Keys without escapes are matched in place; integer keys never
+        // name a field
+        field_matcher_s match = {this, str_view_s(nullptr, 0), false, true};
+        bool named = true;
         if (*cursor == '"') {
-            if (!parse_string(key_str)) return false;
-        } else if (std::isdigit(*cursor) || *cursor == '-') {
-            // Integer key
-            char* endptr;
-            key_int = std::strtol(cursor, &endptr, 10);
-            cursor = endptr;
-            is_string_key = false;
+            const char* run_end = json_scan_string(cursor + 1, end);
+            if (run_end < end && *run_end == '"') {
+                match.key = str_view_s(cursor + 1, run_end - (cursor + 1));
+                cursor = run_end + 1;
+            } else {
+                if (!parse_string(key_buf)) return false;
+                match.key = key_buf;
+            }
         } else {
-            return false;
+            json_number_s num;
+            const char* next = json_parse_number(cursor, end, num);
+            if (!next || !num.is_int || num.intg < INT32_MIN || num.intg > INT32_MAX) return false;
+            named = false;
+            cursor = next;
         }
         
         skip_whitespace();
         if (cursor >= end || *cursor != ':') return false;
-        cursor++; // Skip ':'
-        
-        // Parse value
-        val_s val;
-        if (!parse_value(val)) return false;
-        
-        // Store in dict
-        if (is_string_key) {
-            dict[key_str] = std::move(val);
-        } else {
-            dict[key_int] = std::move(val);
+        cursor = json_skip_space(cursor + 1, end);
+        if (named) dict_visit_fields(out, match);
+        if (!match.found) {
+            cursor = json_skip_value(cursor, end);
+            if (!cursor) return false;
+        } else if (!match.ok) {
+            return false;
         }
         
         skip_whitespace();
         if (cursor >= end) return false;
-        
         if (*cursor == '}') {
             cursor++;
             return true;
         } else if (*cursor == ',') {
-            cursor++;
+            cursor = json_skip_space(cursor + 1, end);
         } else {
             return false;
         }
@@ -721,114 +9102,226 @@ inline bool JSONParser::parse_object(dict_s& dict) {
     return false;
 }
 
-inline bool JSONParser::parse_array(val_s& val) {
-    skip_whitespace();
+inline bool JSONParser::parse_null() {
+    if (end - cursor >= 4 && std::memcmp(cursor, "null", 4) == 0) {
+        cursor += 4;
+        return true;
+    }
+    return false;
+}
+
+inline bool JSONParser::parse_field(bool& out) {
+    if (parse_null()) return true;
+    if (end - cursor >= 4 && std::memcmp(cursor, "true", 4) == 0) {
+        out = true;
+        cursor += 4;
+        return true;
+    } else if (end - cursor >= 5 && std::memcmp(cursor, "false", 5) == 0) {
+        out = false;
+        cursor += 5;
+        return true;
+    }
+    return false;
+}
+
+inline bool JSONParser::parse_field(std::string& out) {
+    if (parse_null()) return true;
+    return parse_string(out);
+}
+
+inline bool JSONParser::parse_field(dict_s& out) {
+    if (parse_null()) return true;
+    out = dict_s();
+    return parse_object(out);
+}
+
+// The number must be a whole value the field can hold. Numbers the parser
+// reads as doubles (exponents, beyond int64_t) are accepted if they are.
+// Unsigned fields read plain digits themselves, so that values above
+// INT64_MAX come back exact.
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value, bool>::type JSONParser::parse_field(T& out) {
+    if (parse_null()) return true;
+    if (std::is_unsigned<T>::value) {
+        const char* p = cursor;
+        uint64_t u = 0;
+        for (; p < end && *p >= '0' && *p <= '9'; p++) {
+            unsigned digit = static_cast<unsigned>(*p - '0');
+            if (u > (UINT64_MAX - digit) / 10) return false;
+            u = u * 10 + digit;
+        }
+        bool plain = p > cursor && (p - cursor == 1 || *cursor != '0') &&
+                     (p == end || (*p != '.' && *p != 'e' && *p != 'E'));
+        if (plain) {
+            if (u > static_cast<uint64_t>(std::numeric_limits<T>::max())) return false;
+            out = static_cast<T>(u);
+            cursor = p;
+            return true;
+        }
+    }
+    json_number_s num;
+    const char* next = json_parse_number(cursor, end, num);
+    if (!next) return false;
+    if (!num.is_int) {
+        if (num.dbl != std::floor(num.dbl) || num.dbl < static_cast<double>(std::numeric_limits<T>::min()) ||
+            num.dbl >= static_cast<double>(std::numeric_limits<T>::max()) + 1.0) {
+            return false;
+        }
+        out = static_cast<T>(num.dbl);
+    } else if (std::is_unsigned<T>::value) {
+        if (num.intg < 0 || static_cast<uint64_t>(num.intg) > static_cast<uint64_t>(std::numeric_limits<T>::max())) return false;
+        out = static_cast<T>(num.intg);
+    } else {
+        if (num.intg < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+            num.intg > static_cast<int64_t>(std::numeric_limits<T>::max())) {
+            return false;
+        }
+        out = static_cast<T>(num.intg);
+    }
+    cursor = next;
+    return true;
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, bool>::type JSONParser::parse_field(T& out) {
+    if (parse_null()) return true;
+    json_number_s num;
+    const char* next = json_parse_number(cursor, end, num);
+    if (!next) return false;
+    out = static_cast<T>(num.is_int ? static_cast<double>(num.intg) : num.dbl);
+    cursor = next;
+    return true;
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_class<T>::value, bool>::type JSONParser::parse_field(T& out) {
+    if (parse_null()) return true;
+    return parse_struct(out);
+}
+
+// Replaces the vector's elements; elements are parsed like fields
+template<typename T>
+inline bool JSONParser::parse_field(std::vector<T>& out) {
+    if (parse_null()) return true;
     if (cursor >= end || *cursor != '[') return false;
-    cursor++; // Skip '['
-    
-    val.t = json_array;
-    val.arr.clear();
-    
-    skip_whitespace();
+    out.clear();
+    cursor = json_skip_space(cursor + 1, end);
     if (cursor < end && *cursor == ']') {
         cursor++;
-        return true; // Empty array
+        return true;
     }
-    
     while (cursor < end) {
-        val_s item;
-        if (!parse_value(item)) return false;
-        val.arr.push_back(std::make_shared<val_s>(std::move(item)));
-        
+        T item = T();
+        if (!parse_field(item)) return false;
+        out.push_back(std::move(item));
         skip_whitespace();
         if (cursor >= end) return false;
-        
         if (*cursor == ']') {
             cursor++;
             return true;
         } else if (*cursor == ',') {
-            cursor++;
+            cursor = json_skip_space(cursor + 1, end);
         } else {
             return false;
         }
     }
-    
     return false;
 }
 
-inline bool JSONParser::parse_string(std::string& str) {
-    if (cursor >= end || *cursor != '"') return false;
-    cursor++; // Skip opening '"'
-    
-    str.clear();
-    while (cursor < end) {
-        if (*cursor == '"') {
-            cursor++;
-            return true;
-        } else if (*cursor == '\\') {
-            cursor++;
-            if (cursor >= end) return false;
-            switch (*cursor) {
-                case '"': str += '"'; break;
-                case '\\': str += '\\'; break;
-                case '/': str += '/'; break;
-                case 'b': str += '\b'; break;
-                case 'f': str += '\f'; break;
-                case 'n': str += '\n'; break;
-                case 'r': str += '\r'; break;
-                case 't': str += '\t'; break;
-                default: return false;
-            }
-            cursor++;
-        } else {
-            str += *cursor;
-            cursor++;
-        }
+template<typename T>
+inline bool dict_parse_struct(const std::string& json, T& out) {
+    JSONParser parser(json);
+    return parser.parse_struct(out);
+}
+
+inline void json_write_field(json_writer_s& w, bool v, int, int) {
+    if (v) w.write("true", 4); else w.write("false", 5);
+}
+
+inline void json_write_field(json_writer_s& w, const std::string& v, int, int) {
+    w.write_string(v);
+}
+
+inline void json_write_field(json_writer_s& w, const val_s& v, int indent, int level) {
+    json_write_value(w, v, indent, level);
+}
+
+inline void json_write_field(json_writer_s& w, const dict_s& v, int indent, int level) {
+    v.dump_internal(w, indent, level + 1);
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_integral<T>::value>::type
+json_write_field(json_writer_s& w, T v, int, int) {
+    if (std::is_unsigned<T>::value) {
+        w.write_uint(static_cast<uint64_t>(v));
+    } else {
+        w.write_int(static_cast<int64_t>(v));
     }
-    
-    return false;
 }
 
-inline bool JSONParser::parse_number(val_s& val) {
-    char* endptr;
-    
-    // Try integer first
-    long long int_val = std::strtoll(cursor, &endptr, 10);
-    
-    // Check if it's a float
-    if (endptr < end && (*endptr == '.' || *endptr == 'e' || *endptr == 'E')) {
-        double dbl_val = std::strtod(cursor, &endptr);
-        if (endptr == cursor) return false;
-        val.t = json_double_t;
-        val.dbl = dbl_val;
-        cursor = endptr;
-        return true;
+template<typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type
+json_write_field(json_writer_s& w, T v, int, int) {
+    w.write_double(static_cast<double>(v));
+}
+
+template<typename T>
+inline typename std::enable_if<std::is_class<T>::value>::type
+json_write_field(json_writer_s& w, const T& v, int indent, int level) {
+    json_write_struct(w, v, indent, level + 1);
+}
+
+// Arrays are written on one line, as json_write_value writes them
+template<typename T>
+inline void json_write_field(json_writer_s& w, const std::vector<T>& v, int indent, int level) {
+    w.put('[');
+    for (size_t i = 0; i < v.size(); i++) {
+        if (i > 0) w.put(',');
+        const T& item = v[i];
+        json_write_field(w, item, indent, level);
+        w.maybe_flush();
     }
-    
-    if (endptr == cursor) return false;
-    val.t = json_integer_t;
-    val.intg = int_val;
-    cursor = endptr;
-    return true;
+    w.put(']');
 }
 
-inline bool JSONParser::parse_literal(val_s& val) {
-    if (cursor + 4 <= end && std::strncmp(cursor, "null", 4) == 0) {
-        val.t = json_null_t;
-        cursor += 4;
-        return true;
-    } else if (cursor + 4 <= end && std::strncmp(cursor, "true", 4) == 0) {
-        val.t = json_bool_t;
-        val.boolean = true;
-        cursor += 4;
-        return true;
-    } else if (cursor + 5 <= end && std::strncmp(cursor, "false", 5) == 0) {
-        val.t = json_bool_t;
-        val.boolean = false;
-        cursor += 5;
-        return true;
+// Visitor handed to dict_visit_fields() by json_write_struct()
+struct json_field_writer_s {
+    json_writer_s& w;
+    int indent;
+    int level;
+    bool first;
+    
+    template<typename F>
+    void operator()(str_view_s name, const F& field) {
+        if (!first) w.put(',');
+        first = false;
+        if (indent >= 0) w.write_newline((level + 1) * indent);
+        w.write_string(name);
+        w.put(':');
+        if (indent >= 0) w.put(' ');
+        json_write_field(w, field, indent, level);
+        w.maybe_flush();
     }
-    return false;
+};
+
+template<typename T>
+inline void json_write_struct(json_writer_s& w, const T& obj, int indent, int level) {
+    w.put('{');
+    json_field_writer_s visit = {w, indent, level, true};
+    dict_visit_fields(obj, visit);
+    if (indent >= 0 && !visit.first) {
+        w.write_newline(level * indent);
+    }
+    w.put('}');
+}
+
+template<typename T>
+inline std::string dict_dump_struct(const T& obj, int indent) {
+    json_writer_s w;
+    w.buf.reserve(256);
+    json_write_struct(w, obj, indent, 0);
+    return std::move(w.buf);
 }
 
 #endif // DICT_CPP_H
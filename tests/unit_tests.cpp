@@ -27,6 +27,10 @@
 #include <sstream>
 #include <string>
 #include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <limits>
+#include <cstdio>
 #include "../include/dict/dict.h"
 
 // Simple test framework
@@ -70,6 +74,43 @@ int count_char(const std::string& str, char c) {
     return std::count(str.begin(), str.end(), c);
 }
 
+bool same_value(const val_t& a, const val_t& b);
+dict_t every_value_type();
+
+// Helper comparing two dicts member by member, whatever their table order
+bool same_dict(const dict_t& a, const dict_t& b) {
+    if (a.obj->size() != b.obj->size()) return false;
+    for (const auto& kv : *a.obj) {
+        const val_t* other = kv.first.t == json_k_integer_t ? b.find(kv.first.intg) : b.find(kv.first.str());
+        if (!other || !same_value(kv.second, *other)) return false;
+    }
+    return true;
+}
+
+// Helper comparing values exactly: type, packed layout and double bits
+bool same_value(const val_t& a, const val_t& b) {
+    if (a.t != b.t) return false;
+    switch (a.t) {
+        case json_object_t:
+            if (!a.obj || !b.obj) return (!a.obj || a.obj->obj->empty()) && (!b.obj || b.obj->obj->empty());
+            return same_dict(*a.obj, *b.obj);
+        case json_string_t: return a.str_view() == b.str_view();
+        case json_integer_t: return a.intg == b.intg;
+        case json_double_t: return std::memcmp(&a.dbl, &b.dbl, sizeof(double)) == 0;
+        case json_bool_t: return a.boolean == b.boolean;
+        case json_array:
+            if (a.layout != b.layout || a.size() != b.size()) return false;
+            for (size_t i = 0; i < a.size(); i++) {
+                if (a.layout == json_array_int && a.arr_intg[i] != b.arr_intg[i]) return false;
+                if (a.layout == json_array_double && std::memcmp(&a.arr_dbl[i], &b.arr_dbl[i], sizeof(double))) return false;
+                if (a.layout == json_array_bool && a.arr_bool[i] != b.arr_bool[i]) return false;
+                if (a.layout == json_array_generic && !same_value(a.arr[i], b.arr[i])) return false;
+            }
+            return true;
+        default: return true;
+    }
+}
+
 // ==================== TESTS ====================
 
 TEST(empty_dict_creation) {
@@ -234,6 +275,15 @@ TEST(copy_independence) {
     // b should still have the old value
     std::string result_b = dict_to_string(b);
     assert(result_b == "{\"copy\":{\"key\":10}}");
+    
+    // A reference taken before the copy writes to the original only
+    dict_t d;
+    d["user"]["name"] = "Alice";
+    val_t& u = d["user"];
+    dict_t c = d;
+    u["x"] = 1;
+    assert(d["user"]["x"].intg == 1);
+    assert(c["user"].find("x") == nullptr);
 }
 
 TEST(move_semantics) {
@@ -361,6 +411,1612 @@ TEST(large_integer_keys) {
     assert(count_char(result, ',') == 2);
 }
 
+TEST(value_type_switching) {
+    val_t v;
+    v = "text";
+    assert(v.is_string() && v.str == "text");
+    v = 42;
+    assert(v.is_int() && v.intg == 42);
+    v = std::vector<std::string>{"a", "b"};
+    assert(v.is_array() && v.size() == 2);
+    v = 2.5;
+    assert(v.is_double() && v.dbl == 2.5);
+    
+    val_t copy = v;
+    v = val_t();
+    assert(v.is_null());
+    assert(copy.is_double() && copy.dbl == 2.5);
+    
+    val_t moved = std::move(copy);
+    assert(moved.is_double());
+    assert(copy.is_null());
+}
+
+TEST(self_nested_assignment) {
+    val_t v;
+    v.push_back("inner");
+    v.push_back(1);
+    v = v.at(0);
+    assert(v.is_string() && v.str == "inner");
+}
+
+TEST(nested_access_creates_objects) {
+    dict_t d;
+    d["user"]["name"] = "Alice";
+    d["user"][7] = true;
+    assert(d["user"].is_object());
+    assert(d["user"]["name"].str == "Alice");
+    assert(d["user"][7].boolean == true);
+}
+
+TEST(arena_document_parsing) {
+    dict_t copy;
+    {
+        doc_s doc(R"({"name":"Alice","tags":["a","b"],"address":{"city":"NYC","zip":10001}})");
+        assert(doc.valid);
+        assert(doc.arena->bytes_used() > 0);
+        assert(doc["name"].str == "Alice");
+        assert(doc["tags"].size() == 2);
+        assert(doc["address"]["zip"].intg == 10001);
+        
+        copy = doc.root;  // Copies leave the arena
+        
+        // Re-parsing reuses the arena
+        assert(doc.parse(R"({"id":7})"));
+        assert(doc["id"].intg == 7);
+        assert(!doc.parse("{\"id\":"));
+        assert(!doc.valid);
+    }
+    assert(copy["address"]["city"].str == "NYC");
+    assert(copy["tags"].at(1).str == "b");
+}
+
+TEST(arena_allocation_alignment) {
+    dict_arena arena(256);
+    void* small = arena.allocate(3, 1);
+    void* aligned = arena.allocate(sizeof(double), alignof(double));
+    void* big = arena.allocate(10000, 16);
+    assert(small != nullptr);
+    assert(reinterpret_cast<uintptr_t>(aligned) % alignof(double) == 0);
+    assert(reinterpret_cast<uintptr_t>(big) % 16 == 0);
+    assert(arena.bytes_reserved() >= 10000);
+    arena.reset();
+    assert(arena.bytes_used() == 0);
+}
+
+TEST(packed_numeric_arrays) {
+    dict_t d;
+    d["ints"] = std::vector<int>{1, 2, 3};
+    d["dbls"] = std::vector<double>{1.5, 2.5};
+    d["flags"] = std::vector<bool>{true, false};
+    assert(d["ints"].layout == json_array_int);
+    assert(d["dbls"].layout == json_array_double);
+    assert(d["flags"].layout == json_array_bool);
+    assert(d["ints"].int_at(2) == 3);
+    assert(d["dbls"].dbl_at(1) == 2.5);
+    assert(d["flags"].bool_at(1) == false);
+    assert(dict_to_string(d).find("\"ints\":[1,2,3]") != std::string::npos);
+    
+    // Const access reads either layout by value and keeps the packing
+    const dict_t& cd = d;
+    assert(cd["ints"].at(0).intg == 1 && cd["dbls"].at(1).dbl == 2.5 && !cd["flags"].at(1).boolean);
+    assert(cd["ints"][static_cast<size_t>(2)].intg == 3);
+    int thrown = 0;
+    try { cd["flags"].at(5); } catch (const std::out_of_range&) { thrown++; }
+    assert(thrown == 1 && cd["ints"].layout == json_array_int && cd["flags"].layout == json_array_bool);
+    assert(dict_to_string(d).find("\"flags\":[true,false]") != std::string::npos);
+    
+    // Appending a matching scalar keeps the packed layout
+    d["ints"].push_back(4);
+    assert(d["ints"].layout == json_array_int);
+    assert(d["ints"].size() == 4);
+    
+    // A mismatching element switches to the generic layout
+    d["ints"].push_back("five");
+    assert(d["ints"].layout == json_array_generic);
+    assert(d["ints"].at(3).intg == 4);
+    assert(d["ints"].at(4).str == "five");
+    assert(val_to_string(d["ints"]) == "[1,2,3,4,\"five\"]");
+}
+
+TEST(parsed_arrays_are_packed) {
+    dict_t d(R"({"ints":[1,-2,3],"dbls":[0.5,1.5],"mixed":[1,2.5],"nested":[[1],[2]]})");
+    assert(d.valid);
+    assert(d["ints"].layout == json_array_int);
+    assert(d["ints"].int_at(1) == -2);
+    assert(d["dbls"].layout == json_array_double);
+    assert(d["mixed"].layout == json_array_generic);
+    assert(d["mixed"].at(0).is_int());
+    assert(d["mixed"].at(1).is_double());
+    assert(d["nested"].at(1).int_at(0) == 2);
+    
+    // Through a const reference every layout reads without unpacking
+    const val_t& ints = d["ints"];
+    assert(ints.at(0).intg == 1 && ints.at(1).is_int() && ints.at(1).intg == -2);
+    assert(ints.layout == json_array_int);
+    const dict_t& cd = d;
+    assert(cd["dbls"].at(1).dbl == 1.5 && cd["mixed"].at(1).dbl == 2.5);
+    assert(cd["nested"].at(0).at(0).intg == 1 && cd["nested"].at(1).layout == json_array_int);
+    
+    // Copies keep the layout and are independent
+    val_t copy = d["ints"];
+    assert(copy.layout == json_array_int);
+    assert(copy.at(0).intg == 1);   // Unpacks the copy only
+    assert(copy.layout == json_array_generic);
+    assert(d["ints"].layout == json_array_int);
+}
+
+#ifndef JSON_ORDERED
+TEST(flat_table_growth_and_erase) {
+    dict_t d;
+    for (int i = 0; i < 5000; i++) {
+        d["key_" + std::to_string(i)] = i;
+        d[i] = -i;
+    }
+    assert(d.obj->size() == 10000);
+    assert(d.obj->load_factor() <= d.obj->max_load_factor());
+    for (int i = 0; i < 5000; i++) {
+        assert(d["key_" + std::to_string(i)].intg == i);
+        assert(d[i].intg == -i);
+    }
+    
+    // Erase every other integer key; tombstones must not hide other keys
+    for (int i = 0; i < 5000; i += 2) {
+        key_s k;
+        k.t = json_k_integer_t;
+        k.intg = i;
+        assert(d.obj->erase(k) == 1);
+    }
+    assert(d.obj->size() == 7500);
+    size_t visited = 0;
+    for (const auto& pair : *d.obj) {
+        (void)pair;
+        visited++;
+    }
+    assert(visited == 7500);
+    
+    key_s missing;
+    missing.t = json_k_integer_t;
+    missing.intg = 2;
+    assert(d.obj->find(missing) == d.obj->end());
+    assert(d.obj->count(missing) == 0);
+    assert(d[3].intg == -3);
+}
+
+TEST(flat_table_reserve_and_rehash) {
+    dict_t::map_t m;
+    m.reserve(1000);
+    size_t cap = m.capacity();
+    assert(cap * m.max_load_factor() >= 1000);
+    for (int i = 0; i < 1000; i++) {
+        key_s k;
+        k.t = json_k_integer_t;
+        k.intg = i;
+        m[k] = i;
+    }
+    assert(m.capacity() == cap);  // No growth after reserve
+    
+    m.clear();
+    assert(m.empty());
+    m.rehash(0);
+    assert(m.capacity() == 0);
+    
+    // Tables smaller than one control group
+    m[key_s(str_view_s("a"))] = 1;
+    assert(m.capacity() == 4);
+    for (int i = 0; i < 4; i++) m[key_s(i)] = i;
+    assert(m.capacity() == 8 && m.size() == 5);
+    assert(m.erase(key_s(2)) == 1 && m.count(key_s(2)) == 0);
+    for (int i = 0; i < 4; i++) assert(i == 2 || m.at(key_s(i)).intg == i);
+    m.rehash(0);
+    assert(m.capacity() == 4 && m.size() == 4);
+    assert(m.at(key_s(str_view_s("a"))).intg == 1);
+}
+
+// Counts live instances and throws from the copy constructor once armed
+struct copy_thrower_s {
+    static int live;
+    static int copies_left;
+    
+    copy_thrower_s() { live++; }
+    copy_thrower_s(const copy_thrower_s&) {
+        if (copies_left-- == 0) throw std::runtime_error("copy failed");
+        live++;
+    }
+    ~copy_thrower_s() { live--; }
+};
+int copy_thrower_s::live = 0;
+int copy_thrower_s::copies_left = -1;
+
+TEST(flat_table_copy_is_exception_safe) {
+    typedef flat_map_s<key_s, copy_thrower_s, json_key_hash, json_key_equal,
+                       std::allocator<std::pair<const key_s, copy_thrower_s>>> map_t;
+    {
+        map_t a, b;
+        for (int i = 0; i < 100; i++) a[key_s(i)];
+        for (int i = 0; i < 10; i++) b[key_s(-i)];
+        a.erase(key_s(5));
+        
+        copy_thrower_s::copies_left = 50;
+        int thrown = 0;
+        try { map_t c(a); } catch (const std::runtime_error&) { thrown++; }
+        copy_thrower_s::copies_left = 50;
+        try { b = a; } catch (const std::runtime_error&) { thrown++; }
+        assert(thrown == 2);
+        assert(copy_thrower_s::live == 109);
+        assert(b.size() == 10 && b.count(key_s(-9)) == 1 && b.count(key_s(1)) == 0);
+        
+        copy_thrower_s::copies_left = -1;
+        b = a;
+        assert(b.size() == 99 && b.count(key_s(5)) == 0 && b.count(key_s(99)) == 1);
+        assert(copy_thrower_s::live == 198);
+    }
+    assert(copy_thrower_s::live == 0);
+}
+#endif
+
+TEST(read_only_lookups) {
+    dict_t d(R"({"id":7,"user":{"name":"Alice"},"3":"string three"})");
+    d[3] = "integer three";
+    
+    assert(d.find("id") != nullptr && d.find("id")->intg == 7);
+    assert(d.find("missing") == nullptr);
+    assert(!d.contains("missing"));
+    assert(d.obj->size() == 4);  // Probing did not insert
+    
+    std::string key = "user";
+    assert(d.contains(key));
+    assert(d.find(key)->find("name")->str == "Alice");
+    assert(d.find(3)->str == "integer three");
+    assert(d.find(str_view_s("3", 1))->str == "string three");
+    assert(d.find(4) == nullptr);
+    
+    const dict_t& cd = d;
+    assert(cd["id"].intg == 7);
+    assert(cd.get("user")["name"].str == "Alice");
+    assert(cd[3].str == "integer three");
+    
+    bool threw = false;
+    try {
+        cd["missing"];
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(d.obj->size() == 4);
+    
+#if __cplusplus >= 201703L
+    std::string_view sv = "id";
+    assert(d.contains(sv));
+#endif
+}
+
+TEST(key_interning_and_inline_keys) {
+    // Short keys live inline, long ones share a refcounted atom
+    key_s short_key(str_view_s("id"));
+    assert(short_key.is_inline() && short_key.atom() == nullptr);
+    assert(short_key.str() == str_view_s("id"));
+    assert(key_s(str_view_s("exactly_15_char")).is_inline());
+    
+    key_s long_key(str_view_s("a_rather_long_field_name"));
+    assert(!long_key.is_inline());
+    assert(long_key.str() == str_view_s("a_rather_long_field_name"));
+    
+    // to_string() copies the characters, as the old std::string member held them
+    std::string name = long_key.to_string();
+    assert(name == "a_rather_long_field_name" && short_key.to_string() == "id");
+    assert(key_s(7).to_string().empty());
+    key_s copy = long_key;
+    assert(copy.atom() == long_key.atom());
+    assert(long_key.atom()->refs.load() == 2);
+    key_s moved = std::move(copy);
+    assert(moved.atom() == long_key.atom() && copy.str().size == 0);
+    assert(long_key.atom()->refs.load() == 2);
+    
+    // Interning returns the same atom for every occurrence
+    key_pool_s pool;
+    key_s a = pool.intern("timestamp_in_milliseconds");
+    key_s b = pool.intern(std::string("timestamp_in_milliseconds"));
+    assert(a.atom() == b.atom() && pool.size() == 1);
+    assert(pool.intern("ts").is_inline() && pool.size() == 1);
+    pool.clear();
+    assert(a.str() == str_view_s("timestamp_in_milliseconds"));
+    
+    // Atoms from different pools still compare and hash by content
+    key_pool_s other;
+    key_s c = other.intern("timestamp_in_milliseconds");
+    assert(c.atom() != a.atom());
+    assert(a == c && json_key_hash()(a) == json_key_hash()(c));
+    assert(json_key_hash()(a) == json_key_hash()(str_view_s("timestamp_in_milliseconds")));
+    assert(!(a == long_key) && !(a == short_key));
+    assert(key_s(7) == key_s(7) && !(key_s(7) == key_s(8)));
+    
+    // A parsed array of objects shares one atom per field name
+    doc_s doc("{\"rows\":[{\"identifier_of_row\":1,\"id\":2},"
+              "{\"identifier_of_row\":3,\"id\":4},"
+              "{\"identifier_of_row\":5,\"nested_object_key\":{\"identifier_of_row\":6}}]}");
+    assert(doc.valid);
+    const val_s& rows = doc["rows"];
+    key_atom_s* shared = nullptr;
+    for (size_t i = 0; i < rows.size(); i++) {
+        const val_s row = rows.at(i);
+        for (const auto& pair : *row.obj->obj) {
+            if (pair.first.str() == str_view_s("identifier_of_row")) {
+                if (!shared) shared = pair.first.atom();
+                assert(pair.first.atom() == shared);
+            }
+        }
+    }
+    assert(shared != nullptr);
+    assert(rows.at(2)["nested_object_key"]["identifier_of_row"].intg == 6);
+    assert(rows.at(1)["identifier_of_row"].intg == 3);
+    
+    dict_t d("{\"escaped\\\"key_longer_than_15\":1}");
+    assert(d.valid && d.contains("escaped\"key_longer_than_15"));
+    assert(dict_t("{\"a_rather_long_field_name\":true}").dump() == "{\"a_rather_long_field_name\":true}");
+}
+
+TEST(string_and_whitespace_scanning) {
+    // Runs of every length around the 16- and 32-byte block sizes, with the
+    // escape placed at every offset
+    for (size_t len = 0; len < 80; len++) {
+        std::string plain(len, 'x');
+        for (size_t i = 0; i < len; i++) plain[i] = static_cast<char>('a' + i % 26);
+        dict_t d("{\"s\":\"" + plain + "\"}");
+        assert(d.valid && d["s"].str == plain);
+        
+        for (size_t at = 0; at <= len; at++) {
+            std::string json = "{\"s\":\"" + plain.substr(0, at) + "\\n" + plain.substr(at) + "\"}";
+            dict_t e(json);
+            assert(e.valid && e["s"].str == plain.substr(0, at) + "\n" + plain.substr(at));
+        }
+        
+        // Unescaped control characters are rejected wherever they appear
+        if (len > 0) {
+            std::string bad = plain;
+            bad[len / 2] = '\x01';
+            assert(!dict_t("{\"s\":\"" + bad + "\"}").valid);
+        }
+        // Unterminated strings fail instead of reading past the input
+        assert(!dict_t("{\"s\":\"" + plain).valid);
+        
+        std::string ws;
+        for (size_t i = 0; i < len; i++) ws += " \n\r\t"[i % 4];
+        dict_t w(ws + "{" + ws + "\"k\"" + ws + ":" + ws + "[1," + ws + "2]" + ws + "}" + ws);
+        assert(w.valid && w["k"].size() == 2 && w["k"].int_at(1) == 2);
+    }
+    
+    // Only JSON whitespace is skipped, whatever the locale considers a space
+    assert(!dict_t("{\v\"k\":1}").valid);
+    
+    dict_t pretty("{\"a\":{\"b\":[1,2,3]},\"c\":\"a somewhat longer string value\"}");
+    dict_t reparsed(pretty.dump(4));
+    assert(reparsed.valid && reparsed["c"].str == "a somewhat longer string value");
+    assert(reparsed["a"]["b"].size() == 3);
+}
+
+TEST(number_parsing) {
+    dict_t d("{\"i\":-42,\"max\":9223372036854775807,\"min\":-9223372036854775808,"
+             "\"big\":9223372036854775808,\"u64\":18446744073709551615,"
+             "\"pi\":3.141592653589793,\"tiny\":2.2250738585072011e-308,\"e\":1E+23,"
+             "\"long\":3.14159265358979323846264338327950288,\"under\":1e-400,\"z\":-0.0}");
+    assert(d.valid);
+    assert(d["i"].is_int() && d["i"].intg == -42);
+    assert(d["max"].is_int() && d["max"].intg == INT64_MAX);
+    assert(d["min"].is_int() && d["min"].intg == INT64_MIN);
+    // Integers beyond int64 become the nearest double instead of clamping
+    assert(d["big"].is_double() && d["big"].dbl == 9223372036854775808.0);
+    assert(d["u64"].is_double() && d["u64"].dbl == 18446744073709551615.0);
+    assert(d["pi"].dbl == 3.141592653589793);
+    assert(d["tiny"].dbl == 2.2250738585072011e-308);
+    assert(d["e"].dbl == 1e23);
+    assert(d["long"].dbl == 3.14159265358979323846264338327950288);
+    assert(d["under"].is_double() && d["under"].dbl == 0.0);
+    assert(d["z"].is_double() && std::signbit(d["z"].dbl));
+    
+    // Only JSON number syntax is accepted, and overflow is an error
+    const char* invalid[] = { "01", "1.", ".5", "-", "1e", "1e+", "+1", "0x10", "1.2.3", "1e400", "-1e400" };
+    for (const char* num : invalid) {
+        assert(!dict_t(std::string("{\"n\":") + num + "}").valid);
+    }
+    assert(!dict_t("{2147483648:1}").valid);
+    assert(dict_t("{-2147483648:1}").valid);
+    
+    // Never reads past the end of the range
+    const char digits[] = "12345.5e3";
+    json_number_s num;
+    assert(json_parse_number(digits, digits + 3, num) == digits + 3);
+    assert(num.is_int && num.intg == 123);
+    assert(json_parse_number(digits, digits + 6, num) == nullptr);   // "12345."
+    assert(json_parse_number(digits, digits + 7, num) == digits + 7);
+    assert(!num.is_int && num.dbl == 12345.5);
+    
+    // Independent of the decimal separator of the current locale
+    if (std::setlocale(LC_NUMERIC, "de_DE.UTF-8") || std::setlocale(LC_NUMERIC, "fr_FR.UTF-8")) {
+        dict_t l("{\"x\":2.5,\"y\":1.00000000000000011102230246251565404236316680908203125}");
+        std::setlocale(LC_NUMERIC, "C");
+        assert(l["x"].dbl == 2.5 && l["y"].dbl == 1.0000000000000002);
+    }
+}
+
+TEST(serializer_round_trip) {
+    dict_t d;
+    d["pi"] = 3.141592653589793;
+    d["tenth"] = 0.1;
+    d["whole"] = 2.0;
+    d["big"] = 1e300;
+    d["tiny"] = 5e-324;
+    d["neg"] = INT64_MIN;
+    d["quote"] = "say \"hi\"\\\n\t\x01";
+    d["nested"] = std::vector<int>{1, 2};
+    d["nested"].push_back("x");
+    val_s inner;
+    inner = std::vector<int>{3, 4};
+    d["nested"].push_back(std::move(inner));   // Arrays inside arrays are kept
+    
+    std::string json = d.dump();
+    dict_t back(json);
+    assert(back.valid);
+    assert(back["pi"].dbl == 3.141592653589793 && back["tenth"].dbl == 0.1);
+    assert(back["whole"].is_double() && back["whole"].dbl == 2.0);
+    assert(back["big"].dbl == 1e300 && back["tiny"].dbl == 5e-324);
+    assert(back["neg"].intg == INT64_MIN);
+    assert(back["quote"].str == "say \"hi\"\\\n\t\x01");
+    assert(back["nested"].size() == 4 && back["nested"].at(3).int_at(1) == 4);
+    assert(json.find("\"quote\":\"say \\\"hi\\\"\\\\\\n\\t\\u0001\"") != std::string::npos);
+    
+    // Shortest round-trip forms, and the same text through operator<<
+    const double samples[] = { 0.1, 0.3, 1.5, 100.0, 1e21, 1.7976931348623157e308, 1e-7, 0.0001, -0.0 };
+    const char* expected[] = { "0.1", "0.3", "1.5", "100.0", "1e+21", "1.7976931348623157e+308", "1e-7", "0.0001", "-0.0" };
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++) {
+        val_s v;
+        v = samples[i];
+        assert(val_to_string(v) == expected[i]);
+        dict_t one;
+        one["v"] = samples[i];
+        assert(one.dump() == std::string("{\"v\":") + expected[i] + "}");
+    }
+    val_s nan;
+    nan = std::numeric_limits<double>::quiet_NaN();
+    assert(val_to_string(nan) == "null");
+    
+    // \u escapes, including surrogate pairs, decode to UTF-8
+    dict_t u("{\"s\":\"\\u00e9\\u20ac\\ud83d\\ude00\\u0041\"}");
+    assert(u.valid && u["s"].str == "\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80" "A");
+    assert(!dict_t("{\"s\":\"\\ud83d\"}").valid && !dict_t("{\"s\":\"\\u12\"}").valid);
+    
+    dict_t pretty;
+    pretty["a"]["b"] = 1;
+    assert(pretty.dump(2) == "{\n  \"a\": {\n    \"b\": 1\n  }\n}");
+}
+
+TEST(dump_to_sinks) {
+    doc_s doc("{\"rows\":["
+              "{\"id\":1,\"name\":\"alpha\",\"tags\":[1,2,3]},"
+              "{\"id\":2,\"name\":\"beta\",\"scores\":[0.5,1.5]},"
+              "{\"id\":3,\"ok\":[true,false],\"mixed\":[1,\"x\",null]}]}");
+    assert(doc.valid);
+    for (int indent = -1; indent <= 2; indent += 3) {
+        std::string expected = doc.dump(indent);
+        
+        // A tiny chunk size forces a flush between almost every value
+        std::string out;
+        size_t calls = 0;
+        dict_sink_s cb(dict_sink_s::callback_t([&](const char* p, size_t n) {
+            out.append(p, n);
+            calls++;
+            return true;
+        }));
+        cb.chunk_size = 8;
+        assert(doc.dump_to(cb, indent));
+        assert(out == expected && calls > 10);
+        
+        std::ostringstream os;
+        assert(doc.root.dump_to(os, indent) && os.str() == expected);
+        
+        // FILE* and raw descriptor sinks
+        FILE* f = std::tmpfile();
+        assert(f != nullptr);
+        assert(doc.dump_to(f, indent));
+        std::fflush(f);
+        assert(doc.dump_to(fileno(f), indent));
+        std::rewind(f);
+        std::string twice(expected.size() * 2 + 1, '\0');
+        assert(std::fread(&twice[0], 1, twice.size(), f) == expected.size() * 2);
+        std::fclose(f);
+        assert(twice.compare(0, expected.size() * 2, expected + expected) == 0);
+    }
+    
+    // A failing sink stops the dump and is reported
+    size_t calls = 0;
+    dict_sink_s failing(dict_sink_s::callback_t([&](const char*, size_t) {
+        calls++;
+        return false;
+    }));
+    failing.chunk_size = 4;
+    assert(!doc.dump_to(failing) && calls == 1);
+    
+    std::ostringstream bad;
+    bad.setstate(std::ios::badbit);
+    assert(!doc.dump_to(bad));
+}
+
+TEST(zero_copy_parsing) {
+    const std::string json = "{\"name\":\"Alice\",\"esc\":\"a\\\"b\\\\c\\n\","
+                             "\"uni\":\"\\u00e9\\ud83d\\ude00!\",\"long_key_name_for_atoms\":\"x\","
+                             "\"list\":[\"p\",\"q\\tr\",1],\"obj\":{\"k\":\"\"}}";
+    doc_s copied(json);
+    assert(copied.valid);
+    
+    // Read-only input: plain strings point into it, escaped ones into the arena
+    doc_s borrowed;
+    assert(borrowed.parse_borrowed(json.data(), json.size()));
+    const val_s& name = borrowed["name"];
+    assert(name.is_string() && name.borrowed && name.str_view() == "Alice");
+    assert(name.str_view().data >= json.data() && name.str_view().data < json.data() + json.size());
+    assert(borrowed["esc"].str_view() == "a\"b\\c\n");
+    assert(borrowed["uni"].str_view() == "\xc3\xa9\xf0\x9f\x98\x80!");
+    assert(borrowed["list"].at(1).str_view() == "q\tr" && borrowed["obj"]["k"].str_view() == "");
+    assert(borrowed.dump() == copied.dump());
+    
+    // Writable input: escaped strings are decoded in place
+    std::vector<char> buf(json.begin(), json.end());
+    doc_s insitu;
+    assert(insitu.parse_insitu(buf.data(), buf.size()));
+    for (const char* k : { "name", "esc", "uni", "long_key_name_for_atoms" }) {
+        str_view_s v = insitu[k].str_view();
+        assert(insitu[k].borrowed && v.data >= buf.data() && v.data < buf.data() + buf.size());
+        assert(v == copied[k].str);
+    }
+    assert(insitu.dump() == copied.dump());
+    
+    // Copies own their strings; assigning makes a borrowed value owned
+    dict_t owned = insitu.root;
+    std::fill(buf.begin(), buf.end(), '?');
+    assert(!owned["esc"].borrowed && owned["esc"].str == "a\"b\\c\n");
+    assert(owned["list"].at(0).str == "p");
+    val_s v;
+    v.borrow("view");
+    v = std::string("mine");
+    assert(!v.borrowed && v.str == "mine");
+    v.borrow("view");
+    v.set_type(json_string_t);
+    assert(!v.borrowed && v.str.empty());
+    
+    // Malformed strings are rejected in both modes
+    const char* bad[] = { "{\"a\":\"x\\q\"}", "{\"a\":\"x\\ud800\"}", "{\"a\":\"unterminated" };
+    for (const char* text : bad) {
+        std::string t(text);
+        assert(!doc_s().parse_borrowed(t.data(), t.size()));
+        assert(!doc_s().parse_insitu(&t[0], t.size()));
+    }
+}
+
+TEST(lazy_document) {
+    const std::string json = R"( {"user":{"name":"Alice","tags":["a","b"],"address":{"city":"NYC"}},
+        "scores":[1,[2,3],{"x":4.5},"s\"q"], "a\"b":true, "caf\u00e9":null, "dup":1, "dup":2,
+        "long_field_name_over_inline":"v", 42:"answer", "empty":{}, "none":[]} )";
+    dict_lazy_t doc(json);
+    assert(doc.valid && doc.root().is_object() && doc.root().size() == 9);
+    
+    // Only the containers on the accessed path get member tables
+    assert(doc["user"]["name"].get().str_view() == "Alice");
+    assert(doc.indexed_containers() == 2);
+    assert(doc["user"]["tags"].at(1).get().str_view() == "b");
+    assert(doc["scores"].size() == 4 && doc["scores"][size_t(1)].at(0).get().intg == 2);
+    assert(doc["scores"].at(2)["x"].get().dbl == 4.5);
+    assert(doc["scores"].at(3).get().str_view() == "s\"q");
+    assert(doc["a\"b"].get().boolean && doc.find("caf\xc3\xa9").type() == json_null_t);
+    assert(doc["dup"].get().intg == 2 && doc[42].get().str_view() == "answer");
+    assert(doc["long_field_name_over_inline"].raw() == "\"v\"");
+    assert(doc["empty"].size() == 0 && doc["none"].size() == 0 && doc["none"].is_array());
+    
+    // Values are cached; objects searched often switch to a hash index
+    assert(&doc["user"]["name"].get() == &doc["user"]["name"].get());
+    for (int i = 0; i < 20; i++) {
+        assert(doc["dup"].get().intg == 2 && doc[42].raw() == "\"answer\"" && !doc.find("nope"));
+    }
+    dict_lazy_t small("{\"a\":1,\"b\":2}");
+    for (int i = 0; i < 20; i++) {
+        assert(small["a"].get().intg == 1 && small.find("b") && !small.find("c"));
+    }
+    
+    // Misses
+    assert(!doc.find("missing") && !doc["user"].find("zip") && !doc["scores"].find("x"));
+    bool threw = false;
+    try { doc["user"]["zip"]; } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { doc["scores"].at(4); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+    
+    // Subtrees convert to ordinary, independent dicts
+    dict_t user = doc["user"].to_dict();
+    assert(user.valid && user["address"]["city"].str == "NYC" && !user["name"].borrowed);
+    dict_t full(json);
+    assert(doc.to_dict().dump() == full.dump());
+    assert(doc["user"].get().obj->dump() == full["user"].obj->dump());
+    
+    // The index pass validates the whole input up front
+    const char* bad[] = { "{\"a\":1,}", "{\"a\":\"\\x\"}", "{\"a\":1} x", "{\"a\":[1,2}",
+                          "{\"a\"1}", "{\"a\":tru}", "{\"a\":\"open", "", "{\"a\":01}" };
+    for (const char* text : bad) {
+        dict_lazy_t b{std::string(text)};
+        assert(!b.valid && !b.root());
+    }
+    dict_lazy_t scalar("  [1, 2]  ");
+    assert(scalar.valid && scalar.root().at(1).get().intg == 2);
+    
+    // Bytes after the root are an error, where JSONParser ignores them
+    std::string trailing = "{\"a\":1} x";
+    dict_lazy_t strict(trailing);
+    assert(dict_t(trailing).valid && !strict.valid);
+    dict_lazy_t spaced("{\"a\":1} \n");
+    assert(spaced.valid && spaced["a"].get().intg == 1);
+}
+
+TEST(tape_parsing) {
+    // Stage 1 indexes structurals and token starts, never bytes inside strings
+    json_tape_s tape;
+    std::string small = "{\"a\":[1,\"b\\\"c,]\"], \"d\" : true}";
+    assert(tape.parse(small));
+    const uint32_t expected[] = { 0, 1, 4, 5, 6, 7, 8, 16, 17, 19, 23, 25, 29 };
+    assert(tape.structural_count == sizeof(expected) / sizeof(expected[0]));
+    for (size_t i = 0; i < tape.structural_count; i++) assert(tape.structurals[i] == expected[i]);
+    
+    // Stage 2 writes one word per value, two per number
+    const char types[] = "{\"[l\"]\"t}";
+    assert(tape.tape.size() == 10);
+    for (size_t i = 0, t = 0; i < tape.tape.size(); i++) {
+        if (i == 4) continue;            // The integer's value word
+        assert(json_tape_s::type_of(tape.tape[i]) == types[t++]);
+    }
+    assert(json_tape_s::payload_of(tape.tape[0]) >> 32 == 2);          // Member count
+    assert(static_cast<uint32_t>(tape.tape[0]) == tape.tape.size());    // Index after '}'
+    assert(tape["a"].at(1).str_view() == "b\"c,]" && tape["d"].boolean());
+    
+    // Queries straight off the tape
+    std::string json = R"({"id":7,"pi":3.25,"name":"caf\u00e9","ok":false,"none":null,
+        "list":[1,[2,3],{"k":"v"},"s"],"dup":1,"dup":2,12:"twelve","empty":{}})";
+    assert(tape.parse(json));                // Buffers are reused
+    tape_val_s root = tape.root();
+    assert(root.is_object() && root.size() == 10);
+    assert(root["id"].intg() == 7 && root["id"].dbl() == 7.0 && root["pi"].dbl() == 3.25);
+    assert(root["name"].str_view() == "caf\xc3\xa9" && !root["ok"].boolean());
+    assert(root["none"].type() == json_null_t && root["dup"].intg() == 2 && root[12].str_view() == "twelve");
+    assert(root["list"].size() == 4 && root["list"].at(1).at(1).intg() == 3);
+    assert(root["list"].at(2)["k"].str_view() == "v" && root["list"][size_t(3)].str_view() == "s");
+    assert(root["empty"].size() == 0 && !root.find("missing") && !root["list"].find("k"));
+    bool threw = false;
+    try { root["name"].intg(); } catch (const std::domain_error&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { root["list"].at(4); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+    
+    // The dict built from the tape matches the recursive parser's
+    dict_t d = tape.to_dict();
+    assert(d.dump() == dict_t(json).dump() && d["list"].at(1).int_at(0) == 2);
+    
+    // Escapes and strings crossing 64-byte block boundaries
+    for (size_t pad = 50; pad < 80; pad++) {
+        std::string text = "{\"" + std::string(pad, 'k') + "\":\"x\\\\\\\"y\\\\\",\"z\":[\"" + std::string(pad, ' ') + "\"]}";
+        assert(tape.parse(text));
+        assert(tape[std::string(pad, 'k')].str_view() == "x\\\"y\\" && tape["z"].at(0).str_view().size == pad);
+    }
+    
+    // Invalid input
+    const char* bad[] = { "", "  ", "{", "{\"a\":1,}", "[1 2]", "{\"a\" 1}", "{\"a\":tru}", "{\"a\":truex}",
+                          "[\"open]", "[1]x", "{\"a\":\"\\q\"}", "[01]", "[1e400]", "{\"a\":1}}", "[\"\x01\"]",
+                          "{3000000000:1}", "[-]", "{\"a\":[}]" };
+    for (const char* text : bad) {
+        assert(!tape.parse(std::string(text)) && !tape.root());
+    }
+    assert(tape.parse(std::string("  42  ")) && tape.root().intg() == 42);
+    
+    // Bytes after the root are an error, where JSONParser ignores them
+    std::string trailing = "{\"a\":1} x";
+    assert(dict_t(trailing).valid && !tape.parse(trailing));
+    assert(tape.parse(std::string("{\"a\":1} \n")) && tape["a"].intg() == 1);
+}
+
+TEST(file_loading) {
+    const char* path = "dict_test_load.json";
+    json_error_s error;
+    
+    // save_file and load_file round-trip
+    dict_t src(R"({"name":"caf\u00e9","tags":["a","b"],"n":[1,2.5,true],"nested":{"k":null}})");
+    assert(src.save_file(path, 2, &error));
+    dict_t loaded;
+    loaded["stale"] = 1;                     // Replaced, not merged
+    assert(loaded.load_file(path, &error) && loaded.valid);
+    assert(loaded.dump() == src.dump() && !loaded.contains("stale"));
+    
+    // doc_s keeps the mapping and borrows strings from it
+    doc_s doc;
+    assert(doc.load_file(path, &error) && doc.valid);
+    assert(doc["name"].borrowed && doc["name"].str_view() == "caf\xc3\xa9");
+    assert(doc.dump() == src.dump());
+    dict_t kept = doc.root;                  // Copies own their text
+    assert(doc.parse("{}") && doc.file == nullptr);
+    assert(kept["tags"].at(1).str_view() == "b");
+    
+    // Parse errors report where parsing stopped
+    FILE* f = std::fopen(path, "wb");
+    std::fputs("{\"a\": 1,\n \"b\": [1, 2,\n  x]}", f);
+    std::fclose(f);
+    assert(!loaded.load_file(path, &error) && !loaded.valid);
+    assert(error.offset == 24 && error.line == 3 && error.column == 3 && error.sys_errno == 0);
+    assert(error.message.find("line 3, column 3") != std::string::npos);
+    assert(!doc.load_file(path, &error) && !doc.valid && error.offset == 24);
+    
+    // Empty files are parse errors at offset 0, missing files I/O errors
+    f = std::fopen(path, "wb");
+    std::fclose(f);
+    assert(!loaded.load_file(path, &error) && error.offset == 0 && error.line == 1);
+    std::remove(path);
+    assert(!loaded.load_file(path, &error) && error.sys_errno == ENOENT);
+    assert(!loaded.load_file(path));         // The error is optional
+    assert(!src.save_file("no_such_dir/out.json", -1, &error) && error.sys_errno != 0);
+}
+
+TEST(ndjson_reader) {
+    std::string text;
+    for (int i = 0; i < 500; i++) {
+        if (i % 50 == 7) text += "\n";                       // Blank line, skipped
+        if (i % 100 == 13) text += "{\"broken\":\n";         // Invalid record
+        text += "{\"id\":" + std::to_string(i) + ",\"name\":\"row\"}";
+        text += (i % 3 == 0) ? "\r\n" : "\n";
+    }
+    text += "{\"id\":-1} trailing\n{\"id\":500}";           // No final newline
+    
+    for (size_t threads = 1; threads <= 4; threads++) {
+        ndjson_options_s options;
+        options.threads = threads;
+        options.batch_bytes = 100;                           // Many small batches
+        options.max_pending = 2;
+        ndjson_reader_s reader(text, options);
+        assert(reader.threads() == threads);
+        
+        ndjson_record_s rec;
+        int64_t expected_id = 0;
+        size_t invalid = 0, line = 0, records = 0;
+        while (reader.next(rec)) {
+            assert(rec.line > line);                         // Input order
+            assert(text.compare(rec.offset, 1, "{") == 0);
+            line = rec.line;
+            records++;
+            if (!rec.doc.valid) {
+                invalid++;
+                continue;
+            }
+            assert(rec.doc["id"].intg == expected_id++);
+        }
+        assert(records == 507 && invalid == 6 && expected_id == 501);
+        assert(!reader.next(rec));
+    }
+    
+    // Unordered: every record exactly once, with its line number
+    ndjson_options_s options;
+    options.threads = 3;
+    options.batch_bytes = 64;
+    options.ordered = false;
+    ndjson_reader_s reader(text, options);
+    std::vector<size_t> lines;
+    ndjson_record_s rec;
+    while (reader.next(rec)) {
+        if (rec.doc.valid) lines.push_back(rec.line);
+    }
+    std::vector<size_t> sorted = lines;
+    std::sort(sorted.begin(), sorted.end());
+    assert(sorted.size() == 501 && std::unique(sorted.begin(), sorted.end()) == sorted.end());
+    assert(sorted.back() == 517);
+    
+    // Empty input and early destruction
+    std::string empty;
+    ndjson_reader_s none(empty);
+    assert(!none.next(rec));
+    ndjson_reader_s abandoned(text, options);
+    assert(abandoned.next(rec));
+}
+
+TEST(parallel_parsing) {
+    // Children with brackets, commas and escaped quotes inside strings, so
+    // the pre-scan has to track string state to find the real boundaries
+    std::string rows, members, ints, mixed;
+    for (int64_t i = 0; i < 100000; i++) {
+        std::string sep = i ? "," : "";
+        if (i < 25000) rows += sep + "{\"id\":" + std::to_string(i) + ",\"s\":\"a,]}\\\"[{\\\\\",\"t\":[1,2.5,null]}";
+        if (i < 60000) members += sep + "\"k" + std::to_string(i % 40000) + "\":[\"" + std::to_string(i) + ",\"]";
+        ints += sep + std::to_string(1000000000 + i * 7);
+        mixed += sep + (i == 99999 ? std::string("\"last\"") : std::to_string(1000000000 + i));
+    }
+    const std::string docs[] = {
+        "{\"meta\":{\"n\":1},\"rows\":[" + rows + "],\"after\":true}",
+        "{" + members + "}",                                 // Root object, duplicate keys
+        "{\"ints\":[" + ints + "]}",                          // Stays packed
+        "{\"a\":{\"b\":[" + rows + ",\"tail\"]}}",                 // Deeper
+        "{\"mixed\":[" + mixed + "]}"
+    };
+    for (const std::string& json : docs) {
+        assert(json.size() > 1024 * 1024);
+        dict_t expected(json);
+        for (size_t threads = 2; threads <= 4; threads *= 2) {
+            dict_t d;
+            assert(d.parse_parallel(json, threads));
+            // Merging a split root object may change the table's iteration
+            // order, so compare it member by member
+            assert(d.obj->size() == expected.obj->size());
+            for (const auto& kv : *expected.obj) {
+                dict_t one, other;
+                one["v"] = kv.second;
+                other["v"] = d[kv.first.str()];
+                assert(one.dump() == other.dump());
+            }
+        }
+    }
+    dict_t d;
+    assert(d.parse_parallel(docs[0], 4));
+    assert(d["rows"].size() == 25000 && d["rows"][size_t(24999)]["id"].intg == 24999);
+    assert(d["rows"][size_t(12345)]["s"].str == "a,]}\"[{\\" && d["after"].boolean);
+    dict_t m;
+    assert(m.parse_parallel(docs[1], 4) && m.obj->size() == 40000 && m["k5"].at(0).str == "40005,");
+    dict_t packed;
+    assert(packed.parse_parallel(docs[2], 3) && packed["ints"].layout == json_array_int);
+    assert(packed["ints"].int_at(99999) == 1000000000 + 99999 * 7);
+    dict_t generic;
+    assert(generic.parse_parallel(docs[4], 3) && generic["mixed"].layout == json_array_generic);
+    assert(generic["mixed"].at(99998).intg == 1000099998 && generic["mixed"].at(99999).str == "last");
+    
+    // Invalid input fails like parse(), wherever the error is
+    std::string bad = docs[0];
+    bad[bad.find("},{", bad.size() / 2) + 1] = ' ';
+    dict_t b;
+    assert(!b.parse_parallel(bad, 4) && !dict_t().parse(bad));
+    bad = docs[0];
+    bad[bad.size() / 2] = '"';                                 // Shifts the string state
+    assert(b.parse_parallel(bad, 4) == dict_t().parse(bad));
+    assert(!b.parse_parallel(docs[0].substr(0, docs[0].size() - 2), 4));
+    assert(!b.parse_parallel("[" + ints + "]", 4));            // Root must be an object
+    
+    // Small inputs take the sequential path
+    dict_t small;
+    assert(small.parse_parallel(R"({"a":[1,2]})", 8) && small["a"].int_at(1) == 2);
+}
+
+TEST(push_parser) {
+    // JSON inputs from the tests above, valid and invalid
+    const std::string inputs[] = {
+        R"({"name":"Alice","age":25})",
+        "{\n    \"user\": {\n        \"name\": \"Bob\",\n        \"age\": 30\n    }\n}",
+        R"({"ints":[1,-2,3],"dbls":[0.5,1.5],"mixed":[1,2.5],"nested":[[1],[2]]})",
+        R"({"id":7,"user":{"name":"Alice"},"3":"string three"})",
+        "{\"escaped\\\"key_longer_than_15\":1}",
+        "{\"i\":-42,\"max\":9223372036854775807,\"min\":-9223372036854775808,"
+        "\"big\":9223372036854775808,\"pi\":3.141592653589793,\"e\":1E+23,\"under\":1e-400,\"z\":-0.0}",
+        "{\"s\":\"\\u00e9\\u20ac\\ud83d\\ude00\\u0041\"}",
+        "{\"name\":\"Alice\",\"esc\":\"a\\\"b\\\\c\\n\",\"list\":[\"p\",\"q\\tr\",1],\"obj\":{\"k\":\"\"}}",
+        R"( {"user":{"name":"Alice","tags":["a","b"],"address":{"city":"NYC"}},
+        "scores":[1,[2,3],{"x":4.5},"s\"q"], "a\"b":true, "caf\u00e9":null, "dup":1, "dup":2,
+        "long_field_name_over_inline":"v", 42:"answer", "empty":{}, "none":[]} )",
+        "{\"a\":\"x\\q\"}", "{\"a\":\"x\\ud800\"}", "{\"a\":\"unterminated",
+        "{\"a\":1,}", "{\"a\":[1,2}", "{\"a\"1}", "{\"a\":tru}", "{\"a\":truex}", "{\"a\":01}",
+        "{\"a\":[1e400]}", "{\"a\":[\"\x01\"]}", "{3000000000:1}", "{\"a\":[-]}", "{\"a\":[}]}", "[1]", ""
+    };
+    for (const std::string& json : inputs) {
+        dict_t expected;
+        bool valid = expected.parse(json);
+        // Two pieces, split at every byte boundary
+        for (size_t cut = 0; cut <= json.size(); cut++) {
+            json_push_parser_s parser;
+            json_push_status st = parser.feed(json.data(), cut);
+            if (st == json_push_more) st = parser.feed(json.data() + cut, json.size() - cut);
+            assert((st == json_push_done) == valid);
+            if (valid) assert(parser.root.dump() == expected.dump());
+        }
+        // One byte at a time
+        json_push_parser_s parser;
+        json_push_status st = json_push_more;
+        for (size_t i = 0; i < json.size() && st == json_push_more; i++) {
+            st = parser.feed(json.data() + i, 1);
+        }
+        assert((st == json_push_done) == valid);
+        if (valid) assert(parser.root.dump() == expected.dump());
+    }
+    
+    // Bytes after the document are left unconsumed; errors report their offset
+    json_push_parser_s parser;
+    assert(parser.feed("{\"a\":[1,") == json_push_more && parser.offset() == 8);
+    assert(parser.feed("2]} {\"next\":1}") == json_push_done && parser.offset() == 11);
+    assert(parser.root["a"].int_at(1) == 2 && parser.feed("x") == json_push_done);
+    parser.reset();
+    assert(parser.feed("{\"a\":\"long str") == json_push_more);
+    assert(parser.feed("ing\"  ,  ]") == json_push_error && parser.offset() == 23);
+    assert(parser.status() == json_push_error && parser.feed("}") == json_push_error);
+    parser.reset();
+    assert(parser.feed("{\"k\":\"\\") == json_push_more);
+    assert(parser.feed("x\"}") == json_push_error && parser.offset() == 5);
+    parser.reset();
+    assert(parser.feed("{}") == json_push_done && parser.root.obj->empty());
+}
+
+// Document with every value type, packed layout and key kind
+dict_t every_value_type() {
+    dict_t d;
+    d["null"] = val_t();
+    d["t"] = true;
+    d["f"] = false;
+    d["ints"] = std::vector<int64_t>{0, -1, 127, -128, 128, -32769, 1LL << 40,
+                                     INT64_MAX, INT64_MIN};
+    d["small_ints"] = std::vector<int>{1, 2, 3};
+    d["dbls"] = std::vector<double>{0.1, -0.0, 1e300, std::numeric_limits<double>::denorm_min()};
+    d["floats"] = std::vector<double>{1.5, -0.0, 0.25, 65536.0};
+    d["bools"] = std::vector<bool>{true, false, true};
+    d["i8"] = -5;
+    d["i16"] = 1000;
+    d["i32"] = -70000;
+    d["i64"] = INT64_MIN;
+    d["pi"] = 3.141592653589793;
+    d["nan"] = std::nan("");
+    d["empty"] = "";
+    d["zero byte"] = std::string("a\0b", 3);
+    d["long key beyond the inline buffer"] = std::string(300, 'x');
+    d[7] = "int key";
+    d[INT32_MIN] = "min key";
+    d["nested"]["deeper"]["list"].push_back(val_t());
+    d["nested"]["deeper"]["list"].push_back(std::string("s"));
+    d["nested"]["deeper"]["list"].push_back(val_t(d["ints"]));
+    d["nested"]["empty"] = dict_t();
+    d["unset_object"].set_type(json_object_t);
+    d["empty_array"].set_type(json_array);
+    return d;
+}
+
+TEST(binary_format) {
+    // Byte order and widths are fixed by the format, whatever the host
+    dict_t small, neg, flt;
+    small["a"] = 258;
+    neg[-2] = 0.1;
+    flt["f"] = -1.5;                     // Exact in 4 bytes
+    assert(small.dump_binary() == std::string("DCB\x01" "\x0a\x07\x00\x00\x00\x01" "\x09\x01" "a" "\x04\x02\x01", 16));
+    assert(neg.dump_binary() == std::string("DCB\x01" "\x0a\x0f\x00\x00\x00\x01" "\x05\xfe\xff\xff\xff"
+                                            "\x08\x9a\x99\x99\x99\x99\x99\xb9\x3f", 24));
+    assert(flt.dump_binary() == std::string("DCB\x01" "\x0a\x09\x00\x00\x00\x01" "\x09\x01" "f" "\x07\x00\x00\xc0\xbf", 18));
+    
+    dict_t d = every_value_type();
+    
+    std::string bytes = d.dump_binary();
+    dict_t back;
+    assert(back.parse_binary(bytes) && back.valid);
+    assert(same_dict(d, back));
+    assert(back["ints"].layout == json_array_int && back["dbls"].layout == json_array_double);
+    assert(back["bools"].layout == json_array_bool && back["nested"]["deeper"]["list"].layout == json_array_generic);
+    assert(back["zero byte"].str.size() == 3 && std::isnan(back["nan"].dbl));
+    
+    // Read in place
+    bin_doc_s doc(bytes);
+    assert(doc.valid && doc.root().is_object() && doc.root().size() == d.obj->size());
+    assert(doc["i8"].intg() == -5 && doc["i16"].intg() == 1000 && doc["i32"].intg() == -70000);
+    assert(doc["i64"].intg() == INT64_MIN && doc["pi"].dbl() == 3.141592653589793 && doc["i16"].dbl() == 1000.0);
+    assert(doc["t"].boolean() && !doc["f"].boolean() && doc["null"].type() == json_null_t && doc["null"]);
+    assert(doc.root()[7].str_view() == "int key" && doc.root()[INT32_MIN].str_view() == "min key");
+    assert(doc["zero byte"].str_view().size == 3 && doc["empty"].str_view().size == 0);
+    assert(!doc.find("missing") && !doc.root().contains(8) && !doc["t"].find("x"));
+    bin_val_s ints = doc["ints"];
+    assert(ints.is_array() && ints.layout() == json_array_int && ints.size() == 9);
+    assert(ints[size_t(4)].intg() == 128 && ints[size_t(7)].intg() == INT64_MAX && ints.at(8).intg() == INT64_MIN);
+    assert(ints.at(0).type() == json_integer_t && ints.at(0).layout() == json_array_generic);
+    assert(doc["floats"].at(0).dbl() == 1.5 && doc["floats"].at(3).dbl() == 65536.0 && doc["f"].type() == json_bool_t);
+    assert(doc["dbls"].at(2).dbl() == 1e300 && doc["bools"].at(1).type() == json_bool_t && !doc["bools"][size_t(1)].boolean());
+    bin_val_s list = doc["nested"]["deeper"]["list"];
+    assert(list.size() == 3 && list.layout() == json_array_generic && list.at(1).str_view() == "s");
+    assert(list.at(2).at(5).intg() == -32769 && list.at(2).to_val().int_at(5) == -32769);
+    assert(doc["nested"]["empty"].size() == 0 && doc["unset_object"].is_object() && doc["empty_array"].size() == 0);
+    assert(same_dict(doc.to_dict(), d) && ints.at(3).to_val().intg == -128);
+    bool threw = false;
+    try { doc["missing"]; } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { doc["pi"].intg(); } catch (const std::domain_error&) { threw = true; }
+    assert(threw);
+    threw = false;
+    try { ints.at(9); } catch (const std::out_of_range&) { threw = true; }
+    assert(threw);
+    
+    // Documents from the JSON tests survive a round trip
+    const std::string inputs[] = {
+        R"({"user":{"name":"Alice","tags":["a","b"],"address":{"city":"NYC"}},"scores":[1,[2,3],{"x":4.5}],"café":null})",
+        R"({"ints":[1,-2,3],"dbls":[0.5,1.5],"mixed":[1,2.5],"nested":[[1],[2]],"42":"answer",42:"int"})",
+        "{}"
+    };
+    for (const std::string& json : inputs) {
+        dict_t src(json), copy;
+        assert(src.valid && copy.parse_binary(src.dump_binary()) && same_dict(src, copy));
+    }
+    
+    // Truncated or corrupted input is rejected without reading out of bounds
+    for (size_t n = 0; n < bytes.size(); n++) {
+        std::string cut = bytes.substr(0, n);
+        assert(!bin_doc_s(cut).valid);
+        dict_t bad;
+        assert(!bad.parse_binary(cut) && !bad.valid && bad.obj->empty());
+    }
+    for (size_t i = 0; i < bytes.size(); i++) {
+        for (int flip : { 0x01, 0x80, 0xFF }) {
+            std::string corrupt = bytes;
+            corrupt[i] = static_cast<char>(corrupt[i] ^ flip);
+            bin_doc_s cd(corrupt);
+            if (cd.valid) cd.to_dict();
+        }
+    }
+    std::string trailing = bytes + "x", version = "DCB\x02" + bytes.substr(4);
+    assert(!bin_doc_s(trailing).valid && !bin_doc_s(version).valid);
+}
+
+TEST(msgpack_cbor) {
+    dict_t d = every_value_type();
+    for (int cbor = 0; cbor < 2; cbor++) {
+        std::string bytes = cbor ? d.dump_cbor() : d.dump_msgpack();
+        dict_t back;
+        assert((cbor ? back.parse_cbor(bytes) : back.parse_msgpack(bytes)) && back.valid);
+        assert(same_dict(d, back));
+        assert(back["ints"].layout == json_array_int && back["bools"].layout == json_array_bool);
+        assert(back[INT32_MIN].str == "min key" && back["i64"].intg == INT64_MIN);
+        // Every truncation is rejected
+        for (size_t n = 0; n < bytes.size(); n++) {
+            dict_t bad;
+            assert(!(cbor ? bad.parse_cbor(bytes.data(), n) : bad.parse_msgpack(bytes.data(), n)));
+            assert(!bad.valid && bad.obj->empty());
+        }
+    }
+    
+    // Encodings: shortest integers and lengths, floats in 4 bytes when exact
+    dict_t small, keyed, list;
+    small["a"] = 1;
+    keyed[1] = -1;
+    val_t& n = list["n"];
+    val_t item;
+    n.push_back(item = 300);
+    n.push_back(item = -200);
+    n.push_back(item = 1.5);
+    n.push_back(val_t());
+    n.push_back(item = true);
+    assert(small.dump_msgpack() == "\x81\xa1" "a\x01" && small.dump_cbor() == "\xa1\x61" "a\x01");
+    assert(keyed.dump_msgpack() == "\x81\x01\xff" && keyed.dump_cbor() == "\xa1\x01\x20");
+    assert(list.dump_msgpack() == std::string("\x81\xa1n\x95\xcd\x01\x2c\xd1\xff\x38\xca\x3f\xc0\x00\x00\xc0\xc3", 17));
+    assert(list.dump_cbor() == std::string("\xa1\x61n\x85\x19\x01\x2c\x38\xc7\xfa\x3f\xc0\x00\x00\xf6\xf5", 16));
+    
+    // Decoding forms the encoders never write
+    dict_t m;
+    const char mp[] = "\xde\x00\x03\xa1u\xcf\xff\xff\xff\xff\xff\xff\xff\xff"
+                      "\xd9\x01" "b\xc4\x02\x00\x01" "\xa1" "d\xcb\x3f\xb9\x99\x99\x99\x99\x99\x9a";
+    assert(m.parse_msgpack(mp, sizeof(mp) - 1));
+    assert(m["u"].is_double() && m["u"].dbl == 18446744073709551615.0);
+    assert(m["b"].str == std::string("\x00\x01", 2) && m["d"].dbl == 0.1);
+    dict_t c;
+    const char cb[] = "\xd9\xd9\xf7\xbf\x61" "a\x01\x61" "b\x9f\x02\x03\xff"
+                      "\x61h\xf9\x7b\xff\x61i\xf9\x7c\x00\x61n\x3b\xff\xff\xff\xff\xff\xff\xff\xff"
+                      "\x61s\x7f\x63str\x63" "eam\xff\x61x\x5f\x42\x01\x02\x43\x03\x04\x05\xff"
+                      "\x61t\xc1\x1a\x51\x4b\x67\xb0\x61u\xf7\xff";
+    assert(c.parse_cbor(cb, sizeof(cb) - 1));
+    assert(c["a"].intg == 1 && c["b"].layout == json_array_int && c["b"].int_at(1) == 3);
+    assert(c["h"].dbl == 65504.0 && std::isinf(c["i"].dbl) && c["n"].dbl == -18446744073709551616.0);
+    assert(c["s"].str == "stream" && c["x"].str == "\x01\x02\x03\x04\x05");
+    assert(c["t"].intg == 1363896240 && c["u"].is_null());
+    
+    // Rejected: extension types, non-map roots, keys that are not text or
+    // int32, trailing bytes, breaks in the wrong place, mixed string chunks
+    const std::string bad_msgpack[] = {
+        "\x81\xa1" "e\xd4\x01\x05", "\x91\x01", "\x81\xca\x3f\xc0\x01\x01\x01", "\x81\xce\x80\x01\x01\x01\x01",
+        "\x81\xc4\x01k\x01", "\x80\x01", "\xc1", std::string("\x81\x00\xc1", 3)
+    };
+    for (const std::string& bytes : bad_msgpack) {
+        dict_t bad;
+        assert(!bad.parse_msgpack(bytes) && !bad.valid);
+    }
+    const std::string bad_cbor[] = {
+        "\x82\x01\x02", "\xa1\xf9\x3c\x01\x01", "\xa1\x1a\x80\x01\x01\x01\x01", "\xa1\x41k\x01",
+        "\xbf\x61" "a\xff", "\xbf\xc1\xff", "\xa1\x61" "a\xf8\x20", "\xa1\x61" "a\x7f\x41k\xff",
+        "\xa1\x61" "a\x1c", "\xa1\x61" "a\x01\x01", "\xa1\x61" "a\x9f\x01", "\xff"
+    };
+    for (const std::string& bytes : bad_cbor) {
+        dict_t bad;
+        assert(!bad.parse_cbor(bytes) && !bad.valid);
+    }
+    
+    // Streaming: messages cut at arbitrary points come out whole and in order
+    for (int cbor = 0; cbor < 2; cbor++) {
+        dict_wire_formats format = cbor ? dict_format_cbor : dict_format_msgpack;
+        std::vector<dict_t> messages;
+        std::string stream;
+        for (int i = 0; i < 20; i++) {
+            dict_t msg = i % 4 ? dict_t() : every_value_type();
+            msg["seq"] = i;
+            msg["text"] = std::string(i * 10, 'z');
+            messages.push_back(msg);
+            stream += cbor ? msg.dump_cbor() : msg.dump_msgpack();
+        }
+        for (size_t chunk = 1; chunk <= 64; chunk = chunk * 3 + 1) {
+            wire_decoder_s decoder(format);
+            size_t got = 0;
+            for (size_t i = 0; i < stream.size(); i += chunk) {
+                decoder.feed(stream.data() + i, std::min(chunk, stream.size() - i));
+                dict_t out;
+                json_push_status st;
+                while ((st = decoder.next(out)) == json_push_done) {
+                    assert(same_dict(out, messages[got]));
+                    got++;
+                }
+                assert(st == json_push_more);
+            }
+            assert(got == messages.size() && decoder.buffered() == 0 && decoder.offset() == stream.size());
+        }
+        // A malformed message stops the stream at its bad item, for good
+        wire_decoder_s decoder(format);
+        std::string two = cbor ? messages[1].dump_cbor() + messages[2].dump_cbor()
+                               : messages[1].dump_msgpack() + messages[2].dump_msgpack();
+        decoder.feed(two);
+        decoder.feed(cbor ? "\xa1\x01\xfc" : "\x81\x01\xc1", 3);
+        dict_t out;
+        assert(decoder.next(out) == json_push_done && out["seq"].intg == 1);
+        assert(decoder.next(out) == json_push_done && out["seq"].intg == 2);
+        assert(decoder.next(out) == json_push_error && decoder.offset() == two.size() + 2);
+        decoder.feed(stream);
+        assert(decoder.next(out) == json_push_error && decoder.buffered() == 3);
+    }
+}
+
+TEST(copy_on_write) {
+    dict_t a(R"({"name":"base","db":{"host":"localhost","port":5432},"cache":{"ttl":60},"list":[1,2,3]})");
+    const dict_t& ca = a;
+    
+    // A parsed dict has handed out no references, so copies share its maps
+    dict_t b = a;
+    const dict_t& cb = b;
+    assert(!a.leaked && b.obj == a.obj);
+    assert(cb["db"].obj->obj == ca["db"].obj->obj);
+    
+    // A write detaches the maps on its path only
+    b["db"]["port"] = 6543;
+    assert(b.obj != a.obj && b.leaked);
+    assert(cb["db"].obj->obj != ca["db"].obj->obj);
+    assert(cb["cache"].obj->obj == ca["cache"].obj->obj);
+    assert(ca["db"]["port"].intg == 5432);
+    assert(cb["db"]["port"].intg == 6543);
+    
+    // A copy of a leaked dict copies its map but shares the maps below it
+    // that have not leaked
+    dict_t l = b;
+    const dict_t& cl = l;
+    assert(l.obj != b.obj && !l.leaked);
+    assert(cl["db"].obj->obj != cb["db"].obj->obj);
+    assert(cl["cache"].obj->obj == cb["cache"].obj->obj);
+    
+    // Non-const find() writes through, so it detaches too
+    dict_t c = a;
+    c.find("name")->str = "changed";
+    assert(ca["name"].str == "base");
+    assert(c["name"].str == "changed");
+    
+    // set() hands out no reference, so the dict stays shareable
+    dict_t s;
+    s.set("n", 1);
+    s.set(7, "seven");
+    dict_t s2 = s;
+    assert(!s.leaked && s2.obj == s.obj);
+    s2.set("n", 2);
+    assert(static_cast<const dict_t&>(s)["n"].intg == 1 && s2.get("n").intg == 2);
+    
+    // Values keep shared nested maps until written
+    dict_t d;
+    d = a;
+    val_t v = ca["cache"];
+    assert(v.obj->obj == ca["cache"].obj->obj);
+    v["ttl"] = 1;
+    assert(ca["cache"]["ttl"].intg == 60);
+    d["list"].push_back(4);
+    assert(ca["list"].size() == 3);
+    assert(d["list"].size() == 4);
+    
+    // Assigning a tree into itself copies it
+    dict_t e = a;
+    e["db"]["self"] = e;
+    e["cache"]["db"] = e["db"];
+    const dict_t& ce = e;
+    assert(ce["db"]["self"]["db"]["self"].is_null());
+    assert(ce["cache"]["db"]["self"]["name"].str == "base");
+    assert(ca["db"].find("self") == nullptr);
+    
+    val_t arr;
+    arr.push_back(val_t());
+    arr.at(0)["x"] = 1;
+    arr.at(0)["copy"] = arr;
+    assert(arr.at(0)["copy"].at(0)["copy"].is_null());
+    
+    // Copies of arena documents are copied to the heap at once
+    dict_t f;
+    {
+        doc_s doc(R"({"user":{"name":"Alice"},"n":1})");
+        f = doc.root;
+        assert(f.obj != doc.root.obj);
+    }
+    assert(f["user"]["name"].str == "Alice");
+}
+
+TEST(persistent_dict) {
+    dict_t base;
+    base["name"] = "tenant";
+    base[7] = 1.5;
+    base["limits"]["rps"] = 100;
+    
+    persistent_dict_s v1(base);
+    assert(v1.size() == 3);
+    assert(v1["name"].str == "tenant");
+    assert(v1[7].dbl == 1.5);
+    assert(v1["limits"]["rps"].intg == 100);
+    assert(!v1.contains("missing"));
+    
+    // Every version stays as it was
+    persistent_dict_s v2 = v1.set("name", val_t()).set(8, 2);
+    persistent_dict_s v3 = v2.erase("name").erase(7);
+    assert(v1.size() == 3 && v2.size() == 4 && v3.size() == 2);
+    assert(v1["name"].is_string() && v2["name"].is_null() && !v3.contains("name"));
+    assert(!v1.contains(8) && v2[8].intg == 2 && v3[8].intg == 2);
+    assert(same_dict(v1.to_dict(), base));
+    
+    // Erasing a missing key returns the same version
+    assert(v3.erase("nope").size() == 2);
+    assert(v3.erase(99).size() == 2);
+    
+    // Many versions against a reference map, with sharing checked by
+    // comparing every old version afterwards
+    std::vector<persistent_dict_s> versions(1);
+    std::vector<std::map<std::string, int64_t>> expect(1);
+    uint64_t seed = 12345;
+    for (int i = 0; i < 3000; i++) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        std::string key = "k" + std::to_string((seed >> 33) % 500);
+        std::map<std::string, int64_t> next = expect.back();
+        if ((seed >> 20) % 4 == 0) {
+            versions.push_back(versions.back().erase(key));
+            next.erase(key);
+        } else {
+            versions.push_back(versions.back().set(key, i));
+            next[key] = i;
+        }
+        expect.push_back(next);
+    }
+    for (size_t v = 0; v < versions.size(); v += 97) {
+        assert(versions[v].size() == expect[v].size());
+        for (const auto& kv : expect[v]) {
+            assert(versions[v][kv.first].intg == kv.second);
+        }
+        size_t seen = 0;
+        versions[v].for_each([&](const key_s& k, const val_s& val) {
+            assert(expect[v].at(k.str().to_string()) == val.intg);
+            seen++;
+        });
+        assert(seen == expect[v].size());
+    }
+    
+    // Erase everything back down to an empty map
+    persistent_dict_s all = versions.back();
+    for (const auto& kv : expect.back()) all = all.erase(kv.first);
+    assert(all.empty() && all.to_dict().obj->empty());
+}
+
+TEST(concurrent_dict) {
+    concurrent_dict_s d(8);
+    assert(d.shard_count() == 8);
+    d.set("name", "shared");
+    d.set(5, 1.5);
+    assert(d.size() == 2);
+    assert(d.get("name").str == "shared");
+    assert(d.get(5).dbl == 1.5);
+    assert(!d.contains("missing"));
+    assert(!d.insert("name", val_t()));
+    assert(d.insert("fresh", val_t()));
+    assert(d.erase("fresh") && !d.erase("fresh"));
+    bool threw = false;
+    try {
+        d.get("missing");
+    } catch (const std::out_of_range&) {
+        threw = true;
+    }
+    assert(threw);
+    
+    // Object values copied out are independent of the stored one
+    dict_t cfg;
+    cfg["port"] = 80;
+    val_t v;
+    v = cfg;
+    d.set("cfg", v);
+    val_t out;
+    assert(d.find("cfg", out));
+    d.update("cfg", [](val_t& x) { x["port"] = 8080; });
+    assert(out["port"].intg == 80);
+    assert(d.get("cfg")["port"].intg == 8080);
+    
+    // Writers on disjoint and shared keys, readers checking what they see
+    const int threads = 4, per_thread = 2000;
+    std::vector<std::thread> pool;
+    std::atomic<int> bad(0);
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t]() {
+            for (int i = 0; i < per_thread; i++) {
+                std::string key = "t" + std::to_string(t) + "_" + std::to_string(i);
+                d.set(key, i);
+                d.update("counter", [](val_t& x) { x = (x.is_null() ? 0 : x.intg) + 1; });
+                val_t seen;
+                if (!d.find(key, seen) || seen.intg != i) bad++;
+                if (i % 2) d.erase(key);
+                int other = (t + 1) % threads;
+                if (d.find("t" + std::to_string(other) + "_" + std::to_string(i), seen) && seen.intg != i) bad++;
+            }
+        });
+    }
+    for (std::thread& th : pool) th.join();
+    assert(bad == 0);
+    assert(d.get("counter").intg == threads * per_thread);
+    assert(d.size() == 4 + threads * per_thread / 2);
+    
+    dict_t all = d.to_dict();
+    assert(all.obj->size() == d.size());
+    assert(all["t2_10"].intg == 10 && all.find("t2_11") == nullptr);
+}
+
+TEST(snapshot_holder) {
+    dict_t initial;
+    initial["mode"] = "boot";
+    snapshot_holder_s holder(initial);
+    assert(holder.version() == 1);
+    
+    {
+        snapshot_reader_s reader(holder);
+        snapshot_pin_s first = reader.pin();
+        assert(first.number() == 1 && first->get("mode").str == "boot");
+        
+        // A pinned version survives later publishes
+        dict_t next;
+        next["mode"] = "live";
+        assert(holder.publish(next) == 2);
+        assert(holder.publish_json("{\"mode\":\"third\"}") == 3);
+        assert(holder.publish_json("{broken") == 0 && holder.version() == 3);
+        assert(holder.retired_count() == 2);
+        assert((*first)["mode"].str == "boot");
+        {
+            snapshot_pin_s inner = reader.pin();
+            assert(inner.number() == 3 && inner->get("mode").str == "third");
+        }
+        assert(holder.reclaim() == 2);
+    }
+    assert(holder.reclaim() == 0);
+    
+    // Stress: readers check every snapshot is whole while a writer keeps
+    // publishing; freed versions would show up under ASan
+    const int readers = 6, publishes = 1500;
+    std::atomic<bool> done(false);
+    std::atomic<int> bad(0);
+    std::atomic<long> reads(0);
+    std::vector<std::thread> pool;
+    for (int r = 0; r < readers; r++) {
+        pool.emplace_back([&]() {
+            snapshot_reader_s reader(holder);
+            uint64_t last = 0;
+            dict_t kept;
+            while (!done.load()) {
+                snapshot_pin_s snap = reader.pin();
+                uint64_t n = snap.number();
+                if (n < last) bad++;
+                last = n;
+                const val_t* items = snap->find("items");
+                const val_t* sum = snap->find("sum");
+                if (n > 3) {
+                    if (!items || !sum) {
+                        bad++;
+                        continue;
+                    }
+                    int64_t total = 0;
+                    for (size_t i = 0; i < items->size(); i++) total += items->int_at(i);
+                    if (total != sum->intg || snap->get("version").intg != static_cast<int64_t>(n)) bad++;
+                    if (n % 7 == 0) kept = *snap;     // Outlives the pin
+                }
+                reads++;
+            }
+            if (!kept.obj->empty() && !kept.contains("sum")) bad++;
+        });
+    }
+    for (int v = 4; v < 4 + publishes; v++) {
+        dict_t doc;
+        doc["version"] = v;
+        std::vector<int64_t> items(v % 50 + 1, v);
+        doc["items"] = items;
+        doc["sum"] = static_cast<int64_t>(items.size()) * v;
+        if (holder.publish(std::move(doc)) != static_cast<uint64_t>(v)) bad++;
+        if (v % 100 == 0) std::this_thread::yield();
+    }
+    done = true;
+    for (std::thread& th : pool) th.join();
+    assert(bad == 0);
+    assert(reads > 0);
+    assert(holder.version() == 3 + publishes);
+    assert(holder.reclaim() == 0);
+}
+
+// Gives every key starting with "same" one hash, so that a frozen dict
+// built with it has to spill those keys past its perfect hash table
+struct colliding_hash_s {
+    std::size_t operator()(const key_s& k) const {
+        return k.t == json_k_integer_t ? (*this)(k.intg) : (*this)(k.str());
+    }
+    std::size_t operator()(str_view_s s) const {
+        return s.size >= 4 && std::memcmp(s.data, "same", 4) == 0 ? 42 : json_key_hash()(s);
+    }
+    std::size_t operator()(int32_t i) const { return json_key_hash()(i); }
+};
+
+TEST(frozen_dict) {
+    dict_t d = every_value_type();
+    dict_frozen_t f = d.freeze();
+    assert(f.size() == d.obj->size());
+    assert(same_dict(f.to_dict(), d));
+    
+    // Reads in place, mirroring bin_val_s
+    assert(f["t"].boolean() && !f["f"].boolean() && f["null"].is_null());
+    assert(f["ints"].layout() == json_array_int && f["ints"].at(7).intg() == INT64_MAX);
+    assert(f["dbls"].at(2).dbl() == 1e300 && f["bools"].at(1).type() == json_bool_t);
+    assert(f["i8"].dbl() == -5.0 && f["pi"].dbl() == 3.141592653589793);
+    assert(f["zero byte"].str_view() == str_view_s("a\0b", 3) && f["empty"].str_view().size == 0);
+    assert(f[7].str_view() == "int key" && f[INT32_MIN].str_view() == "min key");
+    assert(f["nested"]["deeper"]["list"].at(2).at(3).intg() == -128);
+    assert(f["nested"]["deeper"]["list"].layout() == json_array_generic);
+    assert(f["unset_object"].is_object() && f["unset_object"].size() == 0);
+    
+    // Misses: no key, wrong key type, wrong value type
+    assert(!f.find("missing") && !f.contains(8) && !f.contains("7") && !f["t"].find("x"));
+    assert(!f["nested"]["empty"].find("x"));
+    int thrown = 0;
+    try { f["missing"]; } catch (const std::out_of_range&) { thrown++; }
+    try { f["ints"].at(9); } catch (const std::out_of_range&) { thrown++; }
+    try { f["pi"].at(0); } catch (const std::out_of_range&) { thrown++; }
+    try { f["pi"].intg(); } catch (const std::domain_error&) { thrown++; }
+    try { f["empty"].boolean(); } catch (const std::domain_error&) { thrown++; }
+    try { f["ints"].to_dict(); } catch (const std::domain_error&) { thrown++; }
+    assert(thrown == 6);
+    
+    // The frozen copy is independent of the source
+    d["t"] = false;
+    assert(f["t"].boolean());
+    assert(dict_frozen_t().size() == 0 && !dict_frozen_t().contains("a"));
+    
+    // Every member of a large object is found in one probe, from many
+    // threads at once
+    dict_t big;
+    for (int i = 0; i < 20000; i++) {
+        big["key_" + std::to_string(i)] = i;
+        big[i] = -i;
+    }
+    dict_frozen_t fb = big.freeze();
+    std::atomic<int> bad(0);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < 4; t++) {
+        pool.emplace_back([&fb, &bad, t]() {
+            for (int i = t; i < 20000; i += 4) {
+                frozen_val_s v = fb.find("key_" + std::to_string(i));
+                if (!v || v.intg() != i || fb[i].intg() != -i) bad++;
+                if (fb.contains("key_" + std::to_string(i + 20000)) || fb.contains(i + 20000)) bad++;
+            }
+        });
+    }
+    for (std::thread& th : pool) th.join();
+    assert(bad == 0);
+    assert(same_dict(fb.to_dict(), big));
+    
+    // Keys with equal hashes spill past the table and are still found,
+    // short and long ones alike
+    const char* same[] = { "same0", "same1 is a long key", "same2", "same3 is a long key", "same4" };
+    for (size_t size : {0, 3, 500}) {
+        dict_t c;
+        for (size_t i = 0; i < size; i++) c["k" + std::to_string(i)] = static_cast<int64_t>(i);
+        for (int i = 0; i < 4; i++) c[same[i]]["n"] = i;
+        frozen_dict_hashed_s<colliding_hash_s> fc(c);
+        assert(fc.size() == size + 4 && same_dict(fc.to_dict(), c));
+        for (int i = 0; i < 4; i++) assert(fc[same[i]]["n"].intg() == i);
+        for (size_t i = 0; i < size; i++) assert(fc["k" + std::to_string(i)].intg() == static_cast<int64_t>(i));
+        assert(!fc.contains(same[4]) && !fc.contains("k500"));
+    }
+}
+
+// Structs for struct_mapping
+struct mapped_point_s {
+    int32_t x;
+    double y;
+    std::vector<int64_t> path;
+};
+DICT_FIELDS(mapped_point_s, x, y, path)
+
+struct mapped_message_s {
+    int64_t id;
+    std::string name;
+    bool active;
+    uint8_t level;
+    mapped_point_s origin;
+    std::vector<mapped_point_s> points;
+    std::vector<std::string> tags;
+    val_t extra;
+    dict_t meta;
+};
+DICT_FIELDS(mapped_message_s, id, name, active, level, origin, points, tags, extra, meta)
+
+struct mapped_limits_s {
+    uint64_t u;
+    int64_t i;
+    uint32_t w;
+};
+DICT_FIELDS(mapped_limits_s, u, i, w)
+
+TEST(struct_mapping) {
+    std::string json = "{\"id\":42,\"skip\":{\"a\":[1,{\"b\":null}],\"c\":\"\\\"}\"},\"name\":\"caf\\u00e9\","
+                       "\"active\":true,\"level\":7,\"origin\":{\"x\":-1,\"y\":2,\"z\":true},"
+                       "\"points\":[{\"x\":1,\"y\":0.5,\"path\":[1,2]},{\"x\":2}],\"tags\":[\"a\",\"b\"],"
+                       "\"extra\":[1,\"two\"],\"meta\":{\"k\":1},\"n\\u0061me2\":1,7:[]}";
+    mapped_message_s m = mapped_message_s();
+    JSONParser parser(json);
+    assert(parser.parse_struct(m) && parser.offset() == json.size());
+    assert(m.id == 42 && m.name == "caf\xc3\xa9" && m.active && m.level == 7);
+    assert(m.origin.x == -1 && m.origin.y == 2.0 && m.origin.path.empty());
+    assert(m.points.size() == 2 && m.points[0].path.size() == 2 && m.points[1].x == 2);
+    assert(m.tags.size() == 2 && m.tags[1] == "b");
+    assert(m.extra.is_array() && m.extra.size() == 2 && m.meta["k"].intg == 1);
+    
+    // Round trip, compact and indented
+    mapped_message_s back = mapped_message_s();
+    assert(dict_parse_struct(dict_dump_struct(m), back) && dict_dump_struct(back) == dict_dump_struct(m));
+    assert(dict_parse_struct(dict_dump_struct(m, 2), back) && dict_dump_struct(back) == dict_dump_struct(m));
+    assert(dict_t(dict_dump_struct(m))["origin"]["y"].dbl == 2.0);
+    mapped_point_s p = {3, 0.25, {5}};
+    assert(dict_dump_struct(p) == "{\"x\":3,\"y\":0.25,\"path\":[5]}");
+    assert(dict_dump_struct(p, 2) == "{\n  \"x\": 3,\n  \"y\": 0.25,\n  \"path\": [5]\n}");
+    
+    // Missing and null members keep the field; whole doubles fit integers
+    mapped_point_s q = {9, 1.5, {}};
+    assert(dict_parse_struct(std::string("{\"y\":null,\"x\":1e2}"), q) && q.x == 100 && q.y == 1.5);
+    
+    // Values that do not fit the field, and malformed input
+    const char* bad[] = {
+        "{\"x\":1.5}", "{\"x\":3000000000}", "{\"x\":\"1\"}", "{\"path\":[1,true]}",
+        "{\"skip\":[1,}", "{\"skip\":tru}", "{\"x\":1", "[1]", "{\"x\" 1}", "{1.5:1}"
+    };
+    for (const char* b : bad) {
+        mapped_point_s r = mapped_point_s();
+        assert(!dict_parse_struct(std::string(b), r));
+    }
+    mapped_message_s l = mapped_message_s();
+    assert(!dict_parse_struct(std::string("{\"level\":256}"), l));
+    assert(!dict_parse_struct(std::string("{\"active\":1}"), l));
+    
+    // 64-bit limits round-trip exactly
+    mapped_limits_s lim = {UINT64_MAX, INT64_MIN, UINT32_MAX};
+    std::string text = dict_dump_struct(lim);
+    assert(text == "{\"u\":18446744073709551615,\"i\":-9223372036854775808,\"w\":4294967295}");
+    mapped_limits_s lim_back = mapped_limits_s();
+    assert(dict_parse_struct(text, lim_back));
+    assert(lim_back.u == UINT64_MAX && lim_back.i == INT64_MIN && lim_back.w == UINT32_MAX);
+    lim.u = static_cast<uint64_t>(INT64_MAX) + 1;
+    lim.i = INT64_MAX;
+    assert(dict_parse_struct(dict_dump_struct(lim), lim_back));
+    assert(lim_back.u == lim.u && lim_back.i == INT64_MAX);
+    assert(dict_parse_struct(std::string("{\"u\":1e3,\"w\":0}"), lim_back) && lim_back.u == 1000 && lim_back.w == 0);
+    const char* out_of_range[] = {
+        "{\"u\":18446744073709551616}", "{\"u\":-1}", "{\"u\":012}", "{\"w\":4294967296}",
+        "{\"i\":9223372036854775808}"
+    };
+    for (const char* b : out_of_range) {
+        mapped_limits_s r = mapped_limits_s();
+        assert(!dict_parse_struct(std::string(b), r));
+    }
+}
+
 // ==================== MAIN ====================
 
 int main() {
@@ -398,6 +2054,39 @@ int main() {
         RUN_TEST(numeric_string_keys);
         RUN_TEST(empty_string_key);
         RUN_TEST(large_integer_keys);
+        RUN_TEST(value_type_switching);
+        RUN_TEST(self_nested_assignment);
+        RUN_TEST(nested_access_creates_objects);
+        RUN_TEST(arena_document_parsing);
+        RUN_TEST(arena_allocation_alignment);
+        RUN_TEST(packed_numeric_arrays);
+        RUN_TEST(parsed_arrays_are_packed);
+#ifndef JSON_ORDERED
+        RUN_TEST(flat_table_growth_and_erase);
+        RUN_TEST(flat_table_reserve_and_rehash);
+        RUN_TEST(flat_table_copy_is_exception_safe);
+#endif
+        RUN_TEST(read_only_lookups);
+        RUN_TEST(key_interning_and_inline_keys);
+        RUN_TEST(string_and_whitespace_scanning);
+        RUN_TEST(number_parsing);
+        RUN_TEST(serializer_round_trip);
+        RUN_TEST(dump_to_sinks);
+        RUN_TEST(zero_copy_parsing);
+        RUN_TEST(lazy_document);
+        RUN_TEST(tape_parsing);
+        RUN_TEST(file_loading);
+        RUN_TEST(ndjson_reader);
+        RUN_TEST(parallel_parsing);
+        RUN_TEST(push_parser);
+        RUN_TEST(binary_format);
+        RUN_TEST(msgpack_cbor);
+        RUN_TEST(copy_on_write);
+        RUN_TEST(persistent_dict);
+        RUN_TEST(concurrent_dict);
+        RUN_TEST(snapshot_holder);
+        RUN_TEST(frozen_dict);
+        RUN_TEST(struct_mapping);
         
         total_tests = passed_tests;
         